@@ -0,0 +1,46 @@
+#ifndef BENCH_MAPS_H
+#define BENCH_MAPS_H
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include "WorldGenerator.h"
+#include "TileMap.h"
+#include "GlobalSettings.h"
+#include "TerrainRegistry.h"
+
+static constexpr uint64_t BENCH_SEED = 0x5EED; ///< Fixed seed, so every run generates the same maps.
+
+/**
+ * @brief Registers the map sizes every map benchmark runs at, as (columns, rows).
+ * @param bench The benchmark to parameterize.
+ */
+inline void mapSizes(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"cols", "rows"});
+    bench->Args({10, 6});
+    bench->Args({64, 64});
+    bench->Args({256, 256});
+    bench->Args({1024, 1024});
+    bench->Args({4096, 4096});
+}
+
+/**
+ * @brief Generates a world map of the benchmark's size from every terrain.
+ * @param state The benchmark state holding the size arguments.
+ * @return The generated map.
+ */
+inline TileMap makeBenchMap(const benchmark::State& state) {
+    TileMap map;
+    map.generateTiles(static_cast<int>(state.range(1)), static_cast<int>(state.range(0)),
+                      GlobalSettings::getInstance().getTileSize(), TerrainRegistry::getInstance().getAllTerrains(), BENCH_SEED);
+    return map;
+}
+
+/**
+ * @brief Sets the per-tile counters shared by the map benchmarks.
+ * @param state The benchmark state holding the size arguments.
+ */
+inline void setTilesProcessed(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+#endif // BENCH_MAPS_H
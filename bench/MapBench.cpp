@@ -0,0 +1,403 @@
+#include "BenchMaps.h"
+#include "Camera.h"
+#include "Game.h"
+#include "JobSystem.h"
+#include "MapPyramid.h"
+#include "Pathfinder.h"
+#include "UnitSystem.h"
+#include "VisibilityLayer.h"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace {
+    // Scratch folder for the serialization benchmarks, ending in a separator like MAP_PATH_PREFIX.
+    std::string benchPathPrefix() {
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / "wargame_bench";
+        std::filesystem::create_directories(dir);
+        return dir.string() + "/";
+    }
+
+    // Screen positions of tile centres, as seen through a camera at the origin with zoom 1.
+    std::vector<std::pair<int, int>> tileCentres(const benchmark::State& state, bool shuffled) {
+        const int tileSize = GlobalSettings::getInstance().getTileSize();
+        const int cols = static_cast<int>(state.range(0));
+        const int rows = static_cast<int>(state.range(1));
+        const size_t count = std::min<size_t>(static_cast<size_t>(cols) * rows, 1 << 20);
+
+        std::vector<std::pair<int, int>> points;
+        points.reserve(count);
+        std::mt19937 rng(1234);
+        for (size_t i = 0; i < count; i++) {
+            int col = shuffled ? static_cast<int>(rng() % cols) : static_cast<int>(i % cols);
+            int row = shuffled ? static_cast<int>(rng() % rows) : static_cast<int>(i / cols);
+            points.emplace_back(col * tileSize + tileSize / 2, row * tileSize + tileSize / 2);
+        }
+        return points;
+    }
+
+    void runLookups(benchmark::State& state, bool shuffled) {
+        TileMap map = makeBenchMap(state);
+        Camera camera(GlobalSettings::getInstance().getWindowWidth(), GlobalSettings::getInstance().getWindowHeight());
+        std::vector<std::pair<int, int>> points = tileCentres(state, shuffled);
+
+        for (auto _ : state) {
+            for (const auto& point : points) {
+                benchmark::DoNotOptimize(map.getTileAt(point.first, point.second, camera));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(points.size()));
+    }
+}
+
+// Generating a world from every terrain.
+static void BM_GenerateTiles(benchmark::State& state) {
+    const int tileSize = GlobalSettings::getInstance().getTileSize();
+    const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+
+    for (auto _ : state) {
+        TileMap map;
+        map.generateTiles(static_cast<int>(state.range(1)), static_cast<int>(state.range(0)), tileSize, terrains, BENCH_SEED);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+}
+BENCHMARK(BM_GenerateTiles)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Writing a heap map to a file.
+static void BM_SaveToFile(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    const std::string prefix = benchPathPrefix();
+
+    for (auto _ : state) {
+        map.saveToFile("save_bench.dat", prefix);
+    }
+    setTilesProcessed(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(std::filesystem::file_size(prefix + "save_bench.dat")));
+}
+BENCHMARK(BM_SaveToFile)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Reading a whole map file into memory.
+static void BM_LoadFromFile(benchmark::State& state) {
+    const std::string prefix = benchPathPrefix();
+    makeBenchMap(state).saveToFile("load_bench.dat", prefix);
+
+    for (auto _ : state) {
+        TileMap map;
+        map.loadFromFile("load_bench.dat", prefix);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(std::filesystem::file_size(prefix + "load_bench.dat")));
+}
+BENCHMARK(BM_LoadFromFile)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Memory-mapping a map file, for comparison with loading it.
+static void BM_OpenMapped(benchmark::State& state) {
+    const std::string prefix = benchPathPrefix();
+    makeBenchMap(state).saveToFile("mapped_bench.dat", prefix);
+
+    for (auto _ : state) {
+        TileMap map;
+        map.openMapped("mapped_bench.dat", prefix, false);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+}
+BENCHMARK(BM_OpenMapped)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Packing a map for the inner map cache.
+static void BM_PackTileMap(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+
+    for (auto _ : state) {
+        PackedTileMap packed = map.pack();
+        benchmark::DoNotOptimize(packed.bytes.data());
+    }
+    setTilesProcessed(state);
+    state.counters["ratio"] = static_cast<double>(map.pack().getMemoryUsage()) / static_cast<double>(map.getMemoryUsage());
+}
+BENCHMARK(BM_PackTileMap)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Unpacking a cached map when it is shown again.
+static void BM_UnpackTileMap(benchmark::State& state) {
+    PackedTileMap packed = makeBenchMap(state).pack();
+
+    for (auto _ : state) {
+        TileMap map(packed);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+}
+BENCHMARK(BM_UnpackTileMap)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Storing a world as a compressed archive entry; the archive is compacted away between runs.
+static void BM_SaveToArchiveCompressed(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    WorldArchive archive;
+    archive.open(benchPathPrefix() + "save_bench.wgar", true);
+
+    for (auto _ : state) {
+        map.saveToArchive(archive, WorldArchive::WORLD_KEY, false);
+        state.PauseTiming();
+        archive.compact();
+        state.ResumeTiming();
+    }
+    setTilesProcessed(state);
+    WorldArchive::EntryInfo info;
+    if (archive.getEntryInfo(WorldArchive::WORLD_KEY, info)) {
+        state.counters["ratio"] = static_cast<double>(info.storedSize) / static_cast<double>(info.rawSize);
+    }
+}
+BENCHMARK(BM_SaveToArchiveCompressed)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Reading a compressed archive entry into memory, for comparison with loading a map file.
+static void BM_LoadFromArchiveCompressed(benchmark::State& state) {
+    WorldArchive archive;
+    archive.open(benchPathPrefix() + "load_bench.wgar", true);
+    makeBenchMap(state).saveToArchive(archive, WorldArchive::WORLD_KEY, false);
+
+    for (auto _ : state) {
+        TileMap map;
+        map.loadFromArchive(archive, WorldArchive::WORLD_KEY);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+}
+BENCHMARK(BM_LoadFromArchiveCompressed)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Memory-mapping the world entry of an archive.
+static void BM_OpenMappedFromArchive(benchmark::State& state) {
+    WorldArchive archive;
+    archive.open(benchPathPrefix() + "mapped_bench.wgar", true);
+    makeBenchMap(state).saveToArchive(archive, WorldArchive::WORLD_KEY, true);
+
+    for (auto _ : state) {
+        TileMap map;
+        map.openMapped(archive, WorldArchive::WORLD_KEY, false);
+        benchmark::DoNotOptimize(map.getTile(0, 0));
+    }
+    setTilesProcessed(state);
+}
+BENCHMARK(BM_OpenMappedFromArchive)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// One territory simulation update, after a few hundred updates so the factions are attacking.
+static void BM_SimulationTick(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    TerritorySimulation simulation;
+    simulation.reset(map);
+    for (int i = 0; i < 300; i++) {
+        simulation.tick(map);
+    }
+
+    for (auto _ : state) {
+        simulation.tick(map);
+    }
+    // Large worlds are visited a window of rows at a time.
+    const int64_t cols = state.range(0);
+    const int64_t windowRows = std::max<int64_t>(1, static_cast<int64_t>(GlobalSettings::getInstance().getSimulationTilesPerTick()) / cols);
+    state.SetItemsProcessed(state.iterations() * cols * std::min(state.range(1), windowRows));
+}
+BENCHMARK(BM_SimulationTick)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Owner histograms of screen-sized regions, as a stats panel would ask for every frame.
+static void BM_CountRegion(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    map.getTerritoryIndex();
+
+    const int cols = static_cast<int>(state.range(0));
+    const int rows = static_cast<int>(state.range(1));
+    std::mt19937 rng(1234);
+    for (auto _ : state) {
+        int col = static_cast<int>(rng() % cols);
+        int row = static_cast<int>(rng() % rows);
+        benchmark::DoNotOptimize(TerritoryIndex::sumByOwner(map.countRegion(col, row, col + 256, row + 192)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CountRegion)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Fog-of-war upkeep for every faction after one simulation update, which rescans only the chunks it captured in.
+static void BM_VisibilityUpdate(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    TerritorySimulation simulation;
+    simulation.reset(map);
+    for (int i = 0; i < 300; i++) {
+        simulation.tick(map);
+    }
+
+    std::vector<int32_t> viewers;
+    for (const TerritorySimulation::Faction& faction : simulation.getFactions()) {
+        viewers.push_back(faction.ownerId);
+    }
+    VisibilityLayer visibility;
+    visibility.setViewers(viewers);
+    visibility.update(map);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        simulation.tick(map);
+        state.ResumeTiming();
+        visibility.update(map);
+    }
+    state.counters["viewers"] = static_cast<double>(viewers.size());
+}
+BENCHMARK(BM_VisibilityUpdate)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// One unit update with 100k units patrolling the world.
+static void BM_UnitTick(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    EntityRegistry entities;
+    UnitSystem units;
+    units.reset(map);
+    const int owners = static_cast<int>(map.getTerritoryIndex().getOwnerCounts().size());
+    units.spawnStartingUnits(entities, map, 100000 / std::max(1, owners) + 1);
+    for (int i = 0; i < 100; i++) {
+        units.tick(entities, map);
+    }
+
+    for (auto _ : state) {
+        units.tick(entities, map);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entities.getMovements().size()));
+    state.counters["units"] = static_cast<double>(entities.getEntityCount());
+}
+BENCHMARK(BM_UnitTick)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Hover picks and neighbourhood queries among 100k units, answered by the spatial hash.
+static void BM_EntitiesNearTile(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    EntityRegistry entities;
+    UnitSystem units;
+    units.reset(map);
+    const int owners = static_cast<int>(map.getTerritoryIndex().getOwnerCounts().size());
+    units.spawnStartingUnits(entities, map, 100000 / std::max(1, owners) + 1);
+
+    const int cols = static_cast<int>(state.range(0));
+    const int rows = static_cast<int>(state.range(1));
+    std::mt19937 rng(1234);
+    std::vector<EntityId> near;
+    for (auto _ : state) {
+        int col = static_cast<int>(rng() % cols);
+        int row = static_cast<int>(rng() % rows);
+        benchmark::DoNotOptimize(entities.getSpatialHash().findOnTile(col, row));
+        near.clear();
+        benchmark::DoNotOptimize(entities.getSpatialHash().queryNear(col, row, 4, near));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EntitiesNearTile)->Apply(mapSizes);
+
+// Scheduling and waiting for a parallel loop of empty chunks, to show what a job costs.
+static void BM_ParallelForOverhead(benchmark::State& state) {
+    JobSystem& jobs = JobSystem::getInstance();
+    const size_t chunks = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state) {
+        jobs.parallelFor(0, chunks, 1, [](size_t begin, size_t end) { benchmark::DoNotOptimize(begin + end); });
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParallelForOverhead)->Arg(16)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// Abstracting a whole map for hierarchical pathfinding.
+static void BM_PathfinderBuild(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+
+    for (auto _ : state) {
+        Pathfinder pathfinder;
+        pathfinder.refresh(map);
+        benchmark::DoNotOptimize(pathfinder.getNodeCount());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_PathfinderBuild)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Building every pyramid level for a new map.
+static void BM_PyramidBuild(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        MapPyramid pyramid;
+        pyramid.update(map);
+        bytes = pyramid.getMemoryUsage();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_PyramidBuild)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Bringing the pyramid up to date after a territory update, with the changed tiles the game journals every tick.
+static void BM_PyramidUpdate(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    TerritorySimulation simulation;
+    simulation.reset(map);
+    MapPyramid pyramid;
+    pyramid.update(map);
+    map.setChangeTracking(true);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        simulation.tick(map);
+        std::vector<uint32_t> changed = map.takeChangedTiles();
+        state.ResumeTiming();
+        pyramid.noteChangedTiles(map, changed);
+        pyramid.update(map);
+    }
+}
+BENCHMARK(BM_PyramidUpdate)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// A batch of queries up to a few chunks long, half of them for a faction, as units would ask each tick.
+static void BM_FindPaths(benchmark::State& state) {
+    TileMap map = makeBenchMap(state);
+    Pathfinder pathfinder;
+    pathfinder.refresh(map);
+
+    const int cols = static_cast<int>(state.range(0));
+    const int rows = static_cast<int>(state.range(1));
+    std::vector<PathRequest> requests(1024);
+    std::mt19937 rng(1234);
+    for (size_t i = 0; i < requests.size(); i++) {
+        PathRequest& request = requests[i];
+        request.startCol = static_cast<int>(rng() % cols);
+        request.startRow = static_cast<int>(rng() % rows);
+        request.goalCol = std::clamp(request.startCol + static_cast<int>(rng() % 256) - 128, 0, cols - 1);
+        request.goalRow = std::clamp(request.startRow + static_cast<int>(rng() % 256) - 128, 0, rows - 1);
+        request.ownerId = (i & 1) ? map.getOwnerIds()[static_cast<size_t>(request.startRow) * cols + request.startCol] : Pathfinder::ANY_OWNER;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pathfinder.findPaths(map, requests));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(requests.size()));
+}
+BENCHMARK(BM_FindPaths)->Apply(mapSizes)->Unit(benchmark::kMillisecond);
+
+// Looking up tiles under the cursor in row-major order.
+static void BM_GetTileAtScan(benchmark::State& state) {
+    runLookups(state, false);
+}
+BENCHMARK(BM_GetTileAtScan)->Apply(mapSizes);
+
+// Looking up tiles under the cursor at random positions.
+static void BM_GetTileAtRandom(benchmark::State& state) {
+    runLookups(state, true);
+}
+BENCHMARK(BM_GetTileAtRandom)->Apply(mapSizes);
+
+// Finding the terrain family used to generate an inner map, for every terrain.
+static void BM_GetMatchingTerrain(benchmark::State& state) {
+    const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+
+    for (auto _ : state) {
+        for (TerrainId terrainId : terrains) {
+            benchmark::DoNotOptimize(Game::getMatchingTerrain(terrainId));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(terrains.size()));
+}
+BENCHMARK(BM_GetMatchingTerrain);
@@ -0,0 +1,81 @@
+#include "BenchMaps.h"
+#include "TileRenderer.h"
+#include "Camera.h"
+#include <SDL.h>
+#include <filesystem>
+#include <memory>
+
+namespace {
+    // A software renderer drawing into an offscreen window-sized surface, under the dummy video driver.
+    SDL_Renderer* softwareRenderer() {
+        static SDL_Renderer* renderer = [] {
+            SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+            if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+                SDL_Log("SDL could not initialize! SDL Error: %s", SDL_GetError());
+                return static_cast<SDL_Renderer*>(nullptr);
+            }
+
+            const GlobalSettings& settings = GlobalSettings::getInstance();
+            SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, settings.getWindowWidth(), settings.getWindowHeight(),
+                                                                  32, SDL_PIXELFORMAT_RGBA32);
+            return surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+        }();
+        return renderer;
+    }
+
+    // Checks that every tile texture can be found from the working directory.
+    bool texturesFound() {
+        for (const auto& texture : GlobalSettings::getInstance().getTileTextures()) {
+            if (!std::filesystem::exists(texture.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Draws frames through a camera, moving it by `step` world pixels each frame (0 for a still view).
+    void runFrames(benchmark::State& state, float zoom, float step) {
+        SDL_Renderer* renderer = softwareRenderer();
+        if (!renderer) {
+            state.SkipWithError("Could not create a software renderer");
+            return;
+        }
+        if (!texturesFound()) {
+            state.SkipWithError("Tile textures not found; run from the build directory");
+            return;
+        }
+
+        const GlobalSettings& settings = GlobalSettings::getInstance();
+        const int tileSize = settings.getTileSize();
+        TileMap map = makeBenchMap(state);
+        TileRenderer tileRenderer(renderer, settings.getTileTextures());
+        Camera camera(settings.getWindowWidth(), settings.getWindowHeight());
+        camera.zoomAt(zoom, 0, 0);
+
+        float offset = 0.0f;
+        for (auto _ : state) {
+            camera.moveTo(offset, offset);
+            camera.clampTo(static_cast<float>(map.getNumCols()) * tileSize, static_cast<float>(map.getNumRows()) * tileSize);
+            tileRenderer.renderTiles(map, tileSize, camera);
+            offset = offset > 0.0f ? 0.0f : step; // Alternate so the view never runs off the map.
+        }
+    }
+}
+
+// Drawing an unchanged view, which reuses the cached terrain layer.
+static void BM_RenderTilesStill(benchmark::State& state) {
+    runFrames(state, 1.0f, 0.0f);
+}
+BENCHMARK(BM_RenderTilesStill)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Drawing while scrolling, which redraws the whole view every frame.
+static void BM_RenderTilesScrolling(benchmark::State& state) {
+    runFrames(state, 1.0f, 1.0f);
+}
+BENCHMARK(BM_RenderTilesScrolling)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
+
+// Scrolling fully zoomed out, where the most tiles are visible.
+static void BM_RenderTilesZoomedOut(benchmark::State& state) {
+    runFrames(state, Camera::MIN_ZOOM, 1.0f);
+}
+BENCHMARK(BM_RenderTilesZoomedOut)->Apply(mapSizes)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,47 @@
+#ifndef ARCHIVE_CONVERTER_H
+#define ARCHIVE_CONVERTER_H
+
+#include "WorldArchive.h"
+#include <string>
+
+/**
+ * @class ArchiveConverter
+ * @brief Imports a world saved as loose map files into a world archive.
+ *
+ * Before archives, a world was stored as its map file plus one file per visited inner
+ * map, named "<world>/tile_<x>_<y>.dat" after the pixel position of its parent tile.
+ * The world becomes the archive's mappable world entry and each inner map becomes a
+ * delta entry holding every tile, since those maps were not generated from a seed.
+ * The loose files are left in place.
+ */
+class ArchiveConverter {
+public:
+    /**
+     * @brief Checks whether a world still exists as a loose map file.
+     * @param mapFile The world map file name.
+     * @param mapPathPrefix The path prefix of the map files.
+     * @return True if the world map file exists.
+     */
+    static bool hasLegacyWorld(const std::string& mapFile, const std::string& mapPathPrefix);
+
+    /**
+     * @brief Imports a world map file and its inner map files, replacing those entries in the archive.
+     * @param mapFile The world map file name.
+     * @param mapPathPrefix The path prefix of the map files.
+     * @param archive The open archive to import into.
+     * @return True if the world was imported; unreadable inner maps are skipped with a warning.
+     */
+    static bool convert(const std::string& mapFile, const std::string& mapPathPrefix, WorldArchive& archive);
+
+private:
+    /**
+     * @brief Reads the parent tile position out of an inner map file name.
+     * @param name The file name, such as "tile_64_128.dat".
+     * @param x Output parameter receiving the x pixel position.
+     * @param y Output parameter receiving the y pixel position.
+     * @return True if the name has the inner map form.
+     */
+    static bool parseInnerMapName(const std::string& name, int& x, int& y);
+};
+
+#endif // ARCHIVE_CONVERTER_H
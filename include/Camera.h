@@ -0,0 +1,153 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+/**
+ * @class Camera
+ * @brief Maps between screen pixels and world pixels for a scrollable, zoomable view.
+ *
+ * The camera position is the world pixel shown at the top-left corner of the screen.
+ * At zoom 1 one world pixel covers one screen pixel.
+ */
+class Camera {
+public:
+    static constexpr float MIN_ZOOM = 0.002f; ///< Most zoomed-out scale; below a few pixels per tile the map is drawn from a MapPyramid.
+    static constexpr float MAX_ZOOM = 4.0f;  ///< Most zoomed-in scale.
+
+    /**
+     * @brief Constructs a camera at the world origin with zoom 1.
+     * @param viewportWidth The width of the screen area in pixels.
+     * @param viewportHeight The height of the screen area in pixels.
+     */
+    Camera(int viewportWidth, int viewportHeight);
+
+    /**
+     * @brief Converts a screen position to world pixels.
+     * @param screenX The x-coordinate on screen.
+     * @param screenY The y-coordinate on screen.
+     * @param worldX Output parameter receiving the world x-coordinate.
+     * @param worldY Output parameter receiving the world y-coordinate.
+     */
+    void screenToWorld(int screenX, int screenY, float& worldX, float& worldY) const;
+
+    /**
+     * @brief Converts a world position to screen pixels.
+     * @param worldX The world x-coordinate.
+     * @param worldY The world y-coordinate.
+     * @param screenX Output parameter receiving the x-coordinate on screen.
+     * @param screenY Output parameter receiving the y-coordinate on screen.
+     */
+    void worldToScreen(float worldX, float worldY, float& screenX, float& screenY) const;
+
+    /**
+     * @brief Converts a screen position to the grid cell under it.
+     * @param screenX The x-coordinate on screen.
+     * @param screenY The y-coordinate on screen.
+     * @param tileSize The size of each tile in world pixels.
+     * @param col Output parameter receiving the column (may be out of the map's bounds).
+     * @param row Output parameter receiving the row (may be out of the map's bounds).
+     */
+    void screenToTile(int screenX, int screenY, int tileSize, int& col, int& row) const;
+
+    /**
+     * @brief Computes the screen rectangle covered by a grid cell.
+     *
+     * Edges are rounded independently so neighbouring tiles never leave gaps.
+     *
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @param tileSize The size of each tile in world pixels.
+     * @param x Output parameter receiving the left edge on screen.
+     * @param y Output parameter receiving the top edge on screen.
+     * @param w Output parameter receiving the width on screen.
+     * @param h Output parameter receiving the height on screen.
+     */
+    void tileToScreen(int col, int row, int tileSize, int& x, int& y, int& w, int& h) const;
+
+    /**
+     * @brief Computes the range of grid cells visible on screen, clamped to the map.
+     * @param tileSize The size of each tile in world pixels.
+     * @param numCols The number of columns in the map.
+     * @param numRows The number of rows in the map.
+     * @param firstCol Output parameter receiving the first visible column.
+     * @param firstRow Output parameter receiving the first visible row.
+     * @param endCol Output parameter receiving one past the last visible column.
+     * @param endRow Output parameter receiving one past the last visible row.
+     */
+    void getVisibleTiles(int tileSize, int numCols, int numRows,
+                         int& firstCol, int& firstRow, int& endCol, int& endRow) const;
+
+    /**
+     * @brief Scrolls the view.
+     * @param screenDx The horizontal distance in screen pixels.
+     * @param screenDy The vertical distance in screen pixels.
+     */
+    void pan(float screenDx, float screenDy);
+
+    /**
+     * @brief Zooms the view while keeping the world point under a screen position fixed.
+     * @param factor The zoom multiplier (> 1 zooms in).
+     * @param screenX The x-coordinate on screen to zoom around.
+     * @param screenY The y-coordinate on screen to zoom around.
+     */
+    void zoomAt(float factor, int screenX, int screenY);
+
+    /**
+     * @brief Keeps the view inside a world of the given size.
+     * @param worldWidth The width of the world in world pixels.
+     * @param worldHeight The height of the world in world pixels.
+     */
+    void clampTo(float worldWidth, float worldHeight);
+
+    /**
+     * @brief Moves the camera to a world position at zoom 1.
+     * @param worldX The world x-coordinate for the top-left corner of the screen.
+     * @param worldY The world y-coordinate for the top-left corner of the screen.
+     */
+    void reset(float worldX = 0.0f, float worldY = 0.0f);
+
+    /**
+     * @brief Moves the camera without changing the zoom.
+     * @param worldX The world x-coordinate for the left edge of the screen.
+     * @param worldY The world y-coordinate for the top edge of the screen.
+     */
+    void moveTo(float worldX, float worldY);
+
+    /**
+     * @brief Gets the current zoom.
+     * @return Screen pixels per world pixel.
+     */
+    float getZoom() const;
+
+    /**
+     * @brief Gets the world x-coordinate at the left edge of the screen.
+     * @return The x-coordinate in world pixels.
+     */
+    float getX() const;
+
+    /**
+     * @brief Gets the world y-coordinate at the top edge of the screen.
+     * @return The y-coordinate in world pixels.
+     */
+    float getY() const;
+
+    /**
+     * @brief Gets the width of the screen area.
+     * @return The width in pixels.
+     */
+    int getViewportWidth() const;
+
+    /**
+     * @brief Gets the height of the screen area.
+     * @return The height in pixels.
+     */
+    int getViewportHeight() const;
+
+private:
+    float x = 0.0f; ///< World x-coordinate at the left edge of the screen.
+    float y = 0.0f; ///< World y-coordinate at the top edge of the screen.
+    float zoom = 1.0f; ///< Screen pixels per world pixel.
+    int viewportWidth; ///< Width of the screen area in pixels.
+    int viewportHeight; ///< Height of the screen area in pixels.
+};
+
+#endif // CAMERA_H
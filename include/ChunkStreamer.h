@@ -0,0 +1,124 @@
+#ifndef CHUNK_STREAMER_H
+#define CHUNK_STREAMER_H
+
+#include "TileMap.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ChunkStreamer
+ * @brief Streams the chunks of a memory-mapped TileMap around the camera.
+ *
+ * The world is divided into TileMap::CHUNK_SIZE square chunks. Each frame the
+ * streamer is told which tiles are visible; chunks in and around that area are paged
+ * in by a background thread so the render thread never waits on disk. Chunks are kept
+ * in least-recently-used order and, once the memory budget is exceeded, the oldest
+ * chunks outside the view are released back to the OS.
+ *
+ * Tile planes are row-major, so one page can hold tiles from several horizontally
+ * adjacent chunks. A page is only released when no tracked chunk uses it, which makes
+ * eviction conservative: resident memory can exceed the budget by page rounding.
+ */
+class ChunkStreamer {
+public:
+    static constexpr int PREFETCH_MARGIN = 1; ///< Chunks streamed beyond each edge of the view.
+
+    /**
+     * @brief Starts streaming for a map.
+     * @param tileMap The map to stream. Must stay mapped and unchanged in size while the streamer exists.
+     * @param memoryBudget The number of bytes of tile data to keep resident.
+     */
+    ChunkStreamer(const TileMap& tileMap, size_t memoryBudget);
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    /**
+     * @brief Requests the chunks around the visible tiles. Never blocks on I/O.
+     * @param firstCol The first visible column.
+     * @param firstRow The first visible row.
+     * @param endCol One past the last visible column.
+     * @param endRow One past the last visible row.
+     */
+    void update(int firstCol, int firstRow, int endCol, int endRow);
+
+    /**
+     * @brief Gets the number of chunks currently paged in.
+     * @return The resident chunk count.
+     */
+    size_t getResidentChunkCount() const;
+
+private:
+    /**
+     * @struct ChunkEntry
+     * @brief Streaming state of one tracked chunk.
+     */
+    struct ChunkEntry {
+        bool resident = false; ///< Whether the chunk has been paged in.
+        std::list<uint64_t>::iterator lruPosition; ///< Position in the LRU list.
+    };
+
+    const TileMap& tileMap; ///< The map being streamed.
+    const int chunkCols; ///< Number of chunk columns in the map.
+    const int chunkRows; ///< Number of chunk rows in the map.
+    const size_t maxChunks; ///< Number of chunks the budget allows.
+
+    mutable std::mutex mutex; ///< Guards all state below.
+    std::condition_variable wakeWorker; ///< Signals new requests or shutdown.
+    std::deque<uint64_t> pending; ///< Chunks waiting to be paged in, nearest first.
+    std::list<uint64_t> lru; ///< Tracked chunks, most recently wanted first.
+    std::unordered_map<uint64_t, ChunkEntry> chunks; ///< Tracked chunks by key.
+    size_t residentCount = 0; ///< Number of tracked chunks that are paged in.
+    int wantedFirstCx = 0; ///< First chunk column of the wanted area.
+    int wantedFirstCy = 0; ///< First chunk row of the wanted area.
+    int wantedEndCx = 0; ///< One past the last chunk column of the wanted area.
+    int wantedEndCy = 0; ///< One past the last chunk row of the wanted area.
+    bool stopping = false; ///< Set when the worker should exit.
+    std::thread worker; ///< Background paging thread.
+
+    /**
+     * @brief Background loop that pages in requested chunks and enforces the budget.
+     */
+    void workerLoop();
+
+    /**
+     * @brief Pages in every row of a chunk.
+     * @param cx The chunk column.
+     * @param cy The chunk row.
+     */
+    void pageInChunk(int cx, int cy) const;
+
+    /**
+     * @brief Computes the tile runs that can be released after a chunk is evicted.
+     *
+     * Each run covers the chunk's rows extended sideways across neighbouring chunks
+     * that are not tracked, so pages shared with tracked chunks are never released.
+     * Must be called with the mutex held.
+     *
+     * @param cx The chunk column.
+     * @param cy The chunk row.
+     * @param runs Output list of (first tile index, tile count) pairs.
+     */
+    void collectReleaseRuns(int cx, int cy, std::vector<std::pair<size_t, size_t>>& runs) const;
+
+    /**
+     * @brief Packs chunk coordinates into a key.
+     * @param cx The chunk column.
+     * @param cy The chunk row.
+     * @return The key.
+     */
+    static uint64_t makeKey(int cx, int cy);
+};
+
+#endif // CHUNK_STREAMER_H
@@ -0,0 +1,172 @@
+#ifndef COMPONENT_STORE_H
+#define COMPONENT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Handle of an entity: a slot index in the low bits and the slot's generation in the high bits.
+ *
+ * A destroyed entity's slot is reused with the next generation, so stale handles never match a new entity.
+ */
+typedef uint32_t EntityId;
+
+constexpr int ENTITY_INDEX_BITS = 24; ///< Bits of an EntityId holding the slot index.
+constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1; ///< Mask of the slot index.
+constexpr EntityId NO_ENTITY = UINT32_MAX; ///< Handle that never names an entity.
+
+/**
+ * @brief Gets the slot index of an entity.
+ * @param entity The entity.
+ * @return The index, below 2^ENTITY_INDEX_BITS.
+ */
+inline uint32_t entityIndex(EntityId entity) {
+    return entity & ENTITY_INDEX_MASK;
+}
+
+/**
+ * @class ComponentStore
+ * @brief Components of one type, kept contiguous as a sparse set.
+ *
+ * The components and the entities owning them are packed in two dense arrays, so systems
+ * iterate them linearly. A sparse array indexed by entity slot gives each entity's position
+ * in the dense arrays, so lookups, inserts and removals are O(1). Removal moves the last
+ * component into the hole, so the order of the dense arrays is not stable.
+ *
+ * @tparam T The component type.
+ */
+template <typename T>
+class ComponentStore {
+public:
+    /**
+     * @brief Checks whether an entity has a component in the store.
+     * @param entity The entity.
+     * @return True if the entity has one.
+     */
+    bool contains(EntityId entity) const {
+        uint32_t index = entityIndex(entity);
+        return index < sparse.size() && sparse[index] != ABSENT && owners[sparse[index]] == entity;
+    }
+
+    /**
+     * @brief Gets an entity's component.
+     * @param entity The entity.
+     * @return The component, or nullptr if the entity has none. Invalidated by insert() and remove().
+     */
+    T* get(EntityId entity) {
+        return contains(entity) ? &components[sparse[entityIndex(entity)]] : nullptr;
+    }
+
+    /**
+     * @brief Gets an entity's component.
+     * @param entity The entity.
+     * @return The component, or nullptr if the entity has none. Invalidated by insert() and remove().
+     */
+    const T* get(EntityId entity) const {
+        return contains(entity) ? &components[sparse[entityIndex(entity)]] : nullptr;
+    }
+
+    /**
+     * @brief Gives an entity a component, replacing any it had.
+     * @param entity The entity.
+     * @param component The component.
+     * @return The stored component.
+     */
+    T& insert(EntityId entity, const T& component) {
+        if (T* existing = get(entity)) {
+            *existing = component;
+            return *existing;
+        }
+
+        uint32_t index = entityIndex(entity);
+        if (index >= sparse.size()) {
+            sparse.resize(static_cast<size_t>(index) + 1, ABSENT);
+        }
+        sparse[index] = static_cast<uint32_t>(components.size());
+        owners.push_back(entity);
+        components.push_back(component);
+        return components.back();
+    }
+
+    /**
+     * @brief Removes an entity's component.
+     * @param entity The entity.
+     * @return True if the entity had one.
+     */
+    bool remove(EntityId entity) {
+        if (!contains(entity)) {
+            return false;
+        }
+
+        uint32_t slot = sparse[entityIndex(entity)];
+        uint32_t last = static_cast<uint32_t>(components.size() - 1);
+        if (slot != last) {
+            components[slot] = std::move(components[last]);
+            owners[slot] = owners[last];
+            sparse[entityIndex(owners[slot])] = slot;
+        }
+        components.pop_back();
+        owners.pop_back();
+        sparse[entityIndex(entity)] = ABSENT;
+        return true;
+    }
+
+    /**
+     * @brief Removes every component.
+     */
+    void clear() {
+        components.clear();
+        owners.clear();
+        sparse.clear();
+    }
+
+    /**
+     * @brief Gets the number of components.
+     * @return The component count.
+     */
+    size_t size() const {
+        return components.size();
+    }
+
+    /**
+     * @brief Gets the packed components, size() of them.
+     * @return The first component.
+     */
+    T* data() {
+        return components.data();
+    }
+
+    /**
+     * @brief Gets the packed components, size() of them.
+     * @return The first component.
+     */
+    const T* data() const {
+        return components.data();
+    }
+
+    /**
+     * @brief Gets the entity owning each packed component, in the same order.
+     * @return The first entity.
+     */
+    const EntityId* entities() const {
+        return owners.data();
+    }
+
+    /**
+     * @brief Gets the heap memory held by the store.
+     * @return Bytes, not counting the store object itself.
+     */
+    size_t getMemoryUsage() const {
+        return components.capacity() * sizeof(T) + owners.capacity() * sizeof(EntityId) + sparse.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr uint32_t ABSENT = UINT32_MAX; ///< Sparse entry of an entity without a component.
+
+    std::vector<T> components; ///< Packed components.
+    std::vector<EntityId> owners; ///< Entity owning each packed component.
+    std::vector<uint32_t> sparse; ///< Position in the packed arrays by entity slot, or ABSENT.
+};
+
+#endif // COMPONENT_STORE_H
@@ -0,0 +1,39 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file Compression.h
+ * @brief Small in-tree LZ77 block codec for map data.
+ *
+ * The block format follows LZ4's: a sequence of tokens, each holding a literal length
+ * (high nibble) and a match length minus 4 (low nibble), where a nibble of 15 is
+ * followed by extension bytes that add up to 255 each. Literals follow the token, then
+ * a 16-bit little-endian match offset. The last sequence has literals only. Tile planes
+ * are dominated by long runs, which become overlapping matches and compress well.
+ */
+
+/**
+ * @brief Compresses a block.
+ * @param data The bytes to compress.
+ * @param size The number of bytes.
+ * @return The compressed block. It may be larger than the input for data without repeats.
+ */
+std::vector<char> compressBlock(const char* data, size_t size);
+
+/**
+ * @brief Decompresses a block written by compressBlock().
+ *
+ * Malformed input is rejected rather than read or written out of bounds.
+ *
+ * @param data The compressed block.
+ * @param size The size of the compressed block.
+ * @param out The buffer to decompress into.
+ * @param rawSize The size of the original data; out must hold this many bytes.
+ * @return True if the block decoded to exactly rawSize bytes, false otherwise.
+ */
+bool decompressBlock(const char* data, size_t size, char* out, size_t rawSize);
+
+#endif // COMPRESSION_H
@@ -2,6 +2,8 @@
 #define CURSOR_MANAGER_H
 
 #include <SDL.h>
+#include "Camera.h"
+#include "SpatialHash.h"
 
 /**
  * @class CursorManager
@@ -19,13 +21,28 @@ public:
      * @brief Updates the cursor position and detects if it moves to a new tile.
      * 
      * @param event The SDL event containing mouse movement data.
+     * @param camera The camera the grid is viewed through.
      * @param maxCols The maximum number of columns in the grid.
      * @param maxRows The maximum number of rows in the grid.
      * @param outX Output parameter storing the new tile X coordinate if changed.
      * @param outY Output parameter storing the new tile Y coordinate if changed.
      * @return True if the cursor moved to a new tile, false otherwise.
      */
-    bool update(const SDL_Event& event, int maxCols, int maxRows, int& outX, int& outY);
+    bool update(const SDL_Event& event, const Camera& camera, int maxCols, int maxRows, int& outX, int& outY);
+
+    /**
+     * @brief Re-evaluates the hovered tile for a screen position, e.g. after the camera moved.
+     *
+     * @param screenX The cursor's x-coordinate on screen.
+     * @param screenY The cursor's y-coordinate on screen.
+     * @param camera The camera the grid is viewed through.
+     * @param maxCols The maximum number of columns in the grid.
+     * @param maxRows The maximum number of rows in the grid.
+     * @param outX Output parameter storing the new tile X coordinate if changed.
+     * @param outY Output parameter storing the new tile Y coordinate if changed.
+     * @return True if the cursor is over a different tile than before, false otherwise.
+     */
+    bool updatePosition(int screenX, int screenY, const Camera& camera, int maxCols, int maxRows, int& outX, int& outY);
 
     /**
      * @brief Gets the current hovered tile's X coordinate.
@@ -39,6 +56,13 @@ public:
      */
     int getHoverY() const;
 
+    /**
+     * @brief Finds the entity on the hovered tile, the one placed there last if there are several.
+     * @param entities The spatial hash of the entities under the cursor's grid.
+     * @return The entity, or NO_ENTITY if no tile is hovered or the tile is empty.
+     */
+    EntityId pickEntity(const SpatialHash& entities) const;
+
 private:
     const int TILE_SIZE; ///< The size of each tile in pixels.
     int hoverTileX = 0;  ///< Current hovered tile's X coordinate.
@@ -0,0 +1,107 @@
+#ifndef DELTA_PACK_H
+#define DELTA_PACK_H
+
+#include "TileMap.h"
+#include "WorldArchive.h"
+#include <cstdint>
+
+/**
+ * @file DeltaPack.h
+ * @brief The player's changes to inner maps, stored in the world archive.
+ *
+ * Inner maps are regenerated from their seed whenever they are entered, so only the
+ * tiles the player changed (those with TILE_FLAG_DIRTY) need to be kept. Each changed
+ * inner map has one archive entry at (parent column, parent row, DEPTH_INNER) whose
+ * payload is laid out as follows (all integers little-endian):
+ *
+ *   DeltaHeader                   16 bytes
+ *   terrain dictionary            dictionaryCount entries, as in map files (see MapFormat.h)
+ *   DeltaEntry                    entryCount x 12 bytes
+ */
+
+static constexpr uint32_t DELTA_MAGIC = 0x4C444757; ///< "WGDL" read as a little-endian uint32.
+
+/**
+ * @struct DeltaHeader
+ * @brief Header of one inner map's saved changes.
+ */
+struct DeltaHeader {
+    uint32_t magic;           ///< Always DELTA_MAGIC.
+    uint32_t tileCount;       ///< Number of tiles in the inner map the changes were taken from.
+    uint32_t entryCount;      ///< Number of DeltaEntry items after the dictionary.
+    uint32_t dictionaryCount; ///< Number of entries in the terrain dictionary.
+};
+
+/**
+ * @struct DeltaEntry
+ * @brief The saved state of one changed tile.
+ */
+struct DeltaEntry {
+    uint32_t index;      ///< Tile index within the inner map (row * numCols + col).
+    int32_t ownerId;     ///< Owner ID of the tile.
+    TerrainId terrainId; ///< Terrain ID of the tile, indexing the dictionary.
+    uint8_t flags;       ///< State bits of the tile.
+    uint16_t reserved;   ///< Always zero.
+};
+
+static_assert(sizeof(DeltaHeader) == 16, "DeltaHeader must stay 16 bytes");
+static_assert(sizeof(DeltaEntry) == 12, "DeltaEntry must stay 12 bytes");
+
+/**
+ * @class DeltaPack
+ * @brief Reads and writes inner map changes in a world archive.
+ *
+ * Checking whether an inner map has changes uses the archive's in-memory index, so
+ * maps the player never changed cost no I/O at all.
+ */
+class DeltaPack {
+public:
+    /**
+     * @brief Constructs a pack over an archive.
+     * @param archive The world archive; must outlive the pack.
+     */
+    explicit DeltaPack(WorldArchive& archive);
+
+    /**
+     * @brief Checks whether an inner map has saved changes. Never touches the disk.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return True if the archive holds changes for the inner map.
+     */
+    bool contains(int col, int row) const;
+
+    /**
+     * @brief Replays an inner map's saved changes onto a freshly generated copy of it.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @param map The generated inner map to update.
+     * @return True if changes were applied, false if there are none or they could not be read.
+     */
+    bool apply(int col, int row, TileMap& map);
+
+    /**
+     * @brief Saves the changed tiles of an inner map, replacing any earlier changes.
+     *
+     * A map with no changed tiles removes any earlier entry and is otherwise not stored.
+     *
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @param map The inner map to save.
+     * @param allTiles True to save every tile, for maps that were not generated from their seed.
+     * @return True if the changes are on disk, false otherwise.
+     */
+    bool store(int col, int row, const TileMap& map, bool allTiles = false);
+
+private:
+    WorldArchive& archive; ///< Where the changes are stored.
+
+    /**
+     * @brief Gets the archive key of an inner map.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return The key.
+     */
+    static WorldArchive::Key makeKey(int col, int row);
+};
+
+#endif // DELTA_PACK_H
@@ -0,0 +1,168 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include "ComponentStore.h"
+#include "SpatialHash.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum UnitKind
+ * @brief What a unit is.
+ */
+enum UnitKind : uint8_t {
+    UNIT_SOLDIER, ///< Patrols its faction's territory.
+    UNIT_SCOUT,   ///< Patrols further, into any passable land.
+    UNIT_FORT     ///< A building; never moves.
+};
+
+/**
+ * @struct Position
+ * @brief The tile an entity stands on. Changed through EntityRegistry::setPosition() only.
+ */
+struct Position {
+    int32_t col = 0; ///< Column of the tile.
+    int32_t row = 0; ///< Row of the tile.
+};
+
+/**
+ * @struct Unit
+ * @brief A unit or building of a faction.
+ */
+struct Unit {
+    int32_t ownerId = 0;        ///< Owner ID of the faction.
+    UnitKind kind = UNIT_SOLDIER; ///< What the unit is.
+    uint16_t strength = 1;      ///< Fighting strength.
+};
+
+/**
+ * @struct Movement
+ * @brief Where a mobile entity is heading.
+ */
+struct Movement {
+    int32_t targetCol = 0; ///< Column of the destination.
+    int32_t targetRow = 0; ///< Row of the destination.
+    uint16_t cooldown = 0; ///< Updates left before the next step.
+};
+
+/**
+ * @class EntityRegistry
+ * @brief Units and buildings, stored as entities with contiguous component arrays.
+ *
+ * An entity is only a handle (see EntityId); its data lives in one ComponentStore per
+ * component type, so each system walks the components it needs as packed arrays. Slots of
+ * destroyed entities are reused with a new generation.
+ *
+ * Positions are mirrored in a SpatialHash, which is why they are set through setPosition():
+ * finding the entities on or near a tile then costs a hash lookup instead of a scan.
+ */
+class EntityRegistry {
+public:
+    static constexpr size_t MAX_ENTITIES = ENTITY_INDEX_MASK; ///< Most entities alive at once.
+
+    /**
+     * @brief Creates an entity without components.
+     * @return The entity, or NO_ENTITY if MAX_ENTITIES are alive.
+     */
+    EntityId create();
+
+    /**
+     * @brief Destroys an entity and all its components.
+     * @param entity The entity.
+     * @return True if the entity was alive.
+     */
+    bool destroy(EntityId entity);
+
+    /**
+     * @brief Checks whether a handle names a live entity.
+     * @param entity The entity.
+     * @return True if the entity was created and not destroyed since.
+     */
+    bool isAlive(EntityId entity) const;
+
+    /**
+     * @brief Destroys every entity.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of live entities.
+     * @return The entity count.
+     */
+    size_t getEntityCount() const;
+
+    /**
+     * @brief Places an entity on a tile, giving it a Position if it had none.
+     * @param entity The entity.
+     * @param col The column.
+     * @param row The row.
+     * @return False if the entity is not alive.
+     */
+    bool setPosition(EntityId entity, int col, int row);
+
+    /**
+     * @brief Gets the positions, packed. Read-only, as the spatial hash must follow every change.
+     * @return The position store.
+     */
+    const ComponentStore<Position>& getPositions() const;
+
+    /**
+     * @brief Gets the units, packed.
+     * @return The unit store.
+     */
+    ComponentStore<Unit>& getUnits();
+
+    /**
+     * @brief Gets the units, packed.
+     * @return The unit store.
+     */
+    const ComponentStore<Unit>& getUnits() const;
+
+    /**
+     * @brief Gets the movements, packed.
+     * @return The movement store.
+     */
+    ComponentStore<Movement>& getMovements();
+
+    /**
+     * @brief Gets the movements, packed.
+     * @return The movement store.
+     */
+    const ComponentStore<Movement>& getMovements() const;
+
+    /**
+     * @brief Gets the index of entities by tile.
+     * @return The spatial hash.
+     */
+    const SpatialHash& getSpatialHash() const;
+
+    /**
+     * @brief Creates a unit on a tile; everything but forts gets a Movement that holds still.
+     * @param ownerId The owner ID of its faction.
+     * @param kind What the unit is.
+     * @param col The column.
+     * @param row The row.
+     * @return The entity, or NO_ENTITY if MAX_ENTITIES are alive.
+     */
+    EntityId spawnUnit(int32_t ownerId, UnitKind kind, int col, int row);
+
+    /**
+     * @brief Gets the heap memory held by the component stores.
+     * @return Bytes, not counting the spatial hash or the registry object itself.
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<uint8_t> generations; ///< Current generation of each slot.
+    std::vector<uint8_t> alive; ///< Whether each slot holds a live entity.
+    std::vector<uint32_t> freeSlots; ///< Slots of destroyed entities, reused last in first out.
+    size_t entityCount = 0; ///< Live entities.
+
+    ComponentStore<Position> positions; ///< Tile of every placed entity.
+    ComponentStore<Unit> units; ///< Every unit and building.
+    ComponentStore<Movement> movements; ///< Every mobile entity.
+    SpatialHash spatialHash; ///< Positions by tile.
+};
+
+#endif // ENTITY_REGISTRY_H
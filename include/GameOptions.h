@@ -0,0 +1,38 @@
+#ifndef GAME_OPTIONS_H
+#define GAME_OPTIONS_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @struct GameOptions
+ * @brief Run-time options chosen on the command line.
+ */
+struct GameOptions {
+    bool headless = false; ///< Run without a window, updating as fast as possible.
+    bool newMap = false;   ///< Generate and save a new world even if the map file exists.
+    bool showHelp = false; ///< Print usage and exit.
+    bool convert = false;  ///< Import the loose map files of the world into its archive and exit.
+    long long ticks = 10000; ///< Number of updates to run in headless mode.
+    std::string mapFile = "starter_map.dat"; ///< World map file under the map path prefix.
+    std::optional<uint64_t> seed; ///< Seed for a newly generated world; random if not set.
+    std::string tracePath; ///< File to write a profiler trace to on exit, or empty for none.
+
+    /**
+     * @brief Parses command-line arguments.
+     * @param argc The argument count.
+     * @param argv The argument values.
+     * @param options Output parameter receiving the parsed options.
+     * @return True if every argument was understood, false otherwise.
+     */
+    static bool parse(int argc, char* argv[], GameOptions& options);
+
+    /**
+     * @brief Prints the command-line usage.
+     * @param program The program name to show.
+     */
+    static void printUsage(const char* program);
+};
+
+#endif // GAME_OPTIONS_H
@@ -45,6 +45,84 @@ public:
      */
     int getTileSize() const;
 
+    /**
+     * @brief Gets the number of columns in a newly generated world map.
+     * @return The world width in tiles.
+     */
+    int getWorldCols() const;
+
+    /**
+     * @brief Gets the number of rows in a newly generated world map.
+     * @return The world height in tiles.
+     */
+    int getWorldRows() const;
+
+    /**
+     * @brief Gets the number of columns in an inner map.
+     * @return The inner map width in tiles.
+     */
+    int getInnerMapCols() const;
+
+    /**
+     * @brief Gets the number of rows in an inner map.
+     * @return The inner map height in tiles.
+     */
+    int getInnerMapRows() const;
+
+    /**
+     * @brief Gets the memory budget for streamed world chunks.
+     * @return The budget in bytes of tile data.
+     */
+    size_t getChunkCacheBudget() const;
+
+    /**
+     * @brief Gets the memory budget for inner maps kept packed after the player leaves them.
+     * @return The budget in bytes.
+     */
+    size_t getInnerMapCacheBudget() const;
+
+    /**
+     * @brief Gets how much journal may build up before changed maps are saved and the journal trimmed.
+     * @return The size in bytes.
+     */
+    size_t getJournalCheckpointSize() const;
+
+    /**
+     * @brief Gets how many fixed-step game updates run per second.
+     * @return The update rate in ticks per second.
+     */
+    int getTickRate() const;
+
+    /**
+     * @brief Gets how many world tiles the territory simulation visits per update.
+     * @return The tile count; worlds up to this size are simulated whole every update.
+     */
+    size_t getSimulationTilesPerTick() const;
+
+    /**
+     * @brief Gets how far a faction sees beyond the tiles it owns.
+     * @return The radius in tiles, measured in both directions (a square around each owned tile).
+     */
+    int getVisionRadius() const;
+
+    /**
+     * @brief Gets how many units each faction starts a game with.
+     * @return The unit count, including one fort.
+     */
+    int getStartingUnitsPerFaction() const;
+
+    /**
+     * @brief Gets the frame rate cap used when vsync is off.
+     * @return The target frames per second, or 0 for uncapped.
+     */
+    int getTargetFps() const;
+
+    /**
+     * @brief Checks whether presenting waits for the display's vertical sync.
+     * @return True if vsync is enabled, false otherwise.
+     */
+    bool isVsyncEnabled() const;
+
     /**
      * @brief Retrieves the map of tile textures.
      * @return A reference to the unordered map of tile texture file paths.
@@ -58,12 +136,32 @@ public:
      */
     const std::string& getTileTexture(const std::string& tileType) const;
 
+    /**
+     * @brief Gets the resources a tile of a terrain earns its owner per update.
+     * @param tileType The tile type identifier.
+     * @return The yield, or 1 for tile types without one.
+     */
+    int getTerrainYield(const std::string& tileType) const;
+
+    /**
+     * @brief Gets the cost of moving onto a tile of a terrain.
+     * @param tileType The tile type identifier.
+     * @return The cost from 1 to 255, 0 for impassable terrain, or 1 for tile types without one.
+     */
+    int getTerrainMoveCost(const std::string& tileType) const;
+
     /**
      * @brief Gets the map file path prefix.
      * @return The map path prefix as a string.
      */
     const std::string& getMapPathPrefix() const;
 
+    /**
+     * @brief Gets the file path of the button that shows and hides the minimap.
+     * @return The texture file path.
+     */
+    const std::string& getMapButtonTexture() const;
+
     /**
      * @brief Gets the player's unique ID.
      * @return The player ID.
@@ -87,11 +185,27 @@ private:
     const int WINDOW_WIDTH;  ///< Width of the game window.
     const int WINDOW_HEIGHT; ///< Height of the game window.
     const int TILE_SIZE;     ///< Size of each tile in pixels.
+    const int WORLD_COLS;    ///< Width of a newly generated world in tiles.
+    const int WORLD_ROWS;    ///< Height of a newly generated world in tiles.
+    const int INNER_MAP_COLS; ///< Width of an inner map in tiles.
+    const int INNER_MAP_ROWS; ///< Height of an inner map in tiles.
+    const size_t CHUNK_CACHE_BUDGET; ///< Bytes of streamed tile data kept resident.
+    const size_t INNER_MAP_CACHE_BUDGET; ///< Bytes of packed inner maps kept resident after they are left.
+    const size_t JOURNAL_CHECKPOINT_SIZE; ///< Journal size that triggers a checkpoint.
+    const int TICK_RATE;  ///< Fixed-step game updates per second.
+    const size_t SIMULATION_TILES_PER_TICK; ///< World tiles the territory simulation visits per update.
+    const int VISION_RADIUS; ///< Tiles a faction sees beyond its territory.
+    const int STARTING_UNITS_PER_FACTION; ///< Units each faction starts with.
+    const int TARGET_FPS; ///< Frame rate cap when vsync is off (0 for uncapped).
+    const bool VSYNC;     ///< Whether presenting waits for vertical sync.
 
     const std::string MAP_PATH_PREFIX; ///< Path prefix for storing map files.
+    const std::string MAP_BUTTON_TEXTURE; ///< File path of the minimap button.
 
     // Texture management
     std::unordered_map<std::string, std::string> TILE_TEXTURES; ///< Stores tile texture file paths.
+    std::unordered_map<std::string, int> TERRAIN_YIELDS; ///< Resources per tile and update, by tile type.
+    std::unordered_map<std::string, int> TERRAIN_MOVE_COSTS; ///< Cost of moving onto a tile, by tile type.
 
     // User settings
     const int32_t playerId; ///< The player's unique identifier.
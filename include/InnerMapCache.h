@@ -0,0 +1,139 @@
+#ifndef INNER_MAP_CACHE_H
+#define INNER_MAP_CACHE_H
+
+#include "TileMap.h"
+#include "PackedTileMap.h"
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class InnerMapCache
+ * @brief Least-recently-used cache of inner maps within a memory budget, keyed by the parent tile's grid position.
+ *
+ * Inner maps the player has left stay resident here, so entering them again swaps
+ * the map in without touching disk. Cached maps are kept packed (see PackedTileMap),
+ * which is a small fraction of their unpacked size, and are unpacked when taken.
+ * Once the packed maps exceed the budget the least recently left maps are evicted;
+ * those with unsaved changes are handed back to the caller to be saved.
+ */
+class InnerMapCache {
+public:
+    /**
+     * @struct Entry
+     * @brief A cached inner map and the world tile it belongs to.
+     */
+    struct Entry {
+        int col; ///< Column of the parent tile in the world.
+        int row; ///< Row of the parent tile in the world.
+        TileMap map; ///< The inner map.
+    };
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param memoryBudget The bytes of packed maps to keep before evicting; the most recent map is always kept.
+     */
+    explicit InnerMapCache(size_t memoryBudget);
+
+    /**
+     * @brief Checks whether the inner map of a tile is cached.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return True if cached, false otherwise.
+     */
+    bool contains(int col, int row) const;
+
+    /**
+     * @brief Removes the inner map of a tile from the cache.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return The map, or std::nullopt if it is not cached.
+     */
+    std::optional<TileMap> take(int col, int row);
+
+    /**
+     * @brief Packs an inner map and adds it as the most recently used.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @param map The inner map; left empty.
+     * @return The evicted entries with unsaved changes, unpacked, least recently used first.
+     */
+    std::vector<Entry> put(int col, int row, TileMap&& map);
+
+    /**
+     * @brief Empties the cache.
+     * @return Every cached entry with unsaved changes, unpacked, most recently used first.
+     */
+    std::vector<Entry> drain();
+
+    /**
+     * @brief Copies out every cached map with unsaved changes and marks the cached copies saved.
+     *
+     * The maps stay cached; the caller takes over saving the returned copies.
+     *
+     * @return The entries with unsaved changes, unpacked, most recently used first.
+     */
+    std::vector<Entry> collectUnsaved();
+
+    /**
+     * @brief Gets the number of cached maps.
+     * @return The map count.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the memory held by the cached maps.
+     * @return Bytes of packed maps.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Gets the memory held by one cached map.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return Bytes of the packed map, or 0 if it is not cached.
+     */
+    size_t getMemoryUsage(int col, int row) const;
+
+    /**
+     * @brief Gets the memory budget.
+     * @return The bytes of packed maps kept before evicting.
+     */
+    size_t getMemoryBudget() const;
+
+private:
+    /**
+     * @struct Slot
+     * @brief A cached inner map in packed form.
+     */
+    struct Slot {
+        int col; ///< Column of the parent tile in the world.
+        int row; ///< Row of the parent tile in the world.
+        PackedTileMap packed; ///< The packed inner map.
+        size_t memoryUsage; ///< Bytes held by the packed map.
+    };
+
+    const size_t memoryBudget; ///< Bytes of packed maps kept before evicting.
+    size_t memoryUsage = 0; ///< Bytes held by every packed map.
+    std::list<Slot> slots; ///< Cached maps, most recently used first.
+    std::unordered_map<uint64_t, std::list<Slot>::iterator> index; ///< Slots by parent tile key.
+
+    /**
+     * @brief Removes a slot and unpacks its map.
+     * @param it The slot to remove.
+     * @return The unpacked entry.
+     */
+    Entry remove(std::list<Slot>::iterator it);
+
+    /**
+     * @brief Packs parent tile coordinates into a key.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return The key.
+     */
+    static uint64_t makeKey(int col, int row);
+};
+
+#endif // INNER_MAP_CACHE_H
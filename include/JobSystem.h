@@ -0,0 +1,152 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobSystem
+ * @brief Singleton pool of per-core worker threads that run CPU-bound jobs, with work stealing.
+ *
+ * Each worker owns a deque: it pushes and pops jobs at the back, so nested work runs
+ * while its data is still in cache, and idle workers steal from the front of other
+ * deques. Threads outside the pool (the main thread, the I/O threads) submit to a
+ * shared deque. A job may depend on other jobs; it is queued once they have all finished.
+ *
+ * A thread that waits for a job runs other queued jobs until it finishes, so waiting
+ * never idles a core and nested parallelFor() calls cannot deadlock. Jobs must not block
+ * on disk or locks held for long; MapIOWorker and ChunkStreamer keep their own threads
+ * for that.
+ */
+class JobSystem {
+public:
+    class Job;
+    using JobHandle = std::shared_ptr<Job>; ///< Refers to a scheduled job.
+
+    /**
+     * @brief Deleted copy constructor to prevent copying.
+     */
+    JobSystem(const JobSystem&) = delete;
+
+    /**
+     * @brief Deleted assignment operator to enforce singleton pattern.
+     */
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Provides access to the singleton instance, starting the workers on first use.
+     * @return Reference to the singleton instance.
+     */
+    static JobSystem& getInstance();
+
+    /**
+     * @brief Schedules a job to run once its dependencies have finished.
+     * @param work The work to run.
+     * @param dependencies Jobs that must finish first; null handles are ignored.
+     * @return A handle to wait on or to pass as a dependency.
+     */
+    JobHandle schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+
+    /**
+     * @brief Runs queued jobs until a job has finished.
+     * @param job The job to wait for; a null handle returns at once.
+     */
+    void wait(const JobHandle& job);
+
+    /**
+     * @brief Checks whether a job has finished.
+     * @param job The job.
+     * @return True if the job has run, false otherwise.
+     */
+    bool isDone(const JobHandle& job) const;
+
+    /**
+     * @brief Splits a range into chunks, runs them on the pool and returns once all have run.
+     *
+     * The calling thread runs chunks too. A range of one chunk runs inline.
+     *
+     * @param begin The first index.
+     * @param end One past the last index.
+     * @param grainSize The number of indexes per chunk; at least 1.
+     * @param body Called with [chunkBegin, chunkEnd) for every chunk, possibly concurrently.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * @brief Gets the number of worker threads.
+     * @return The worker count, not counting threads that only submit and wait.
+     */
+    unsigned getWorkerCount() const;
+
+private:
+    /**
+     * @struct WorkDeque
+     * @brief The jobs queued by one worker, or by every thread outside the pool.
+     */
+    struct WorkDeque {
+        std::mutex mutex; ///< Guards jobs.
+        std::deque<JobHandle> jobs; ///< Owner end at the back, stealing end at the front.
+    };
+
+    std::vector<std::unique_ptr<WorkDeque>> deques; ///< One per worker, then the shared deque of outside threads.
+    std::vector<std::thread> workers; ///< Worker threads.
+    std::atomic<size_t> queued{0}; ///< Jobs sitting in any deque.
+    std::atomic<int> sleepers{0}; ///< Threads blocked on wakeup.
+    std::atomic<bool> stopping{false}; ///< Tells the workers to exit.
+    std::mutex sleepMutex; ///< Pairs with wakeup.
+    std::condition_variable wakeup; ///< Signalled when a job is queued or finishes.
+
+    /**
+     * @brief Starts one worker per core beyond the first, and at least one.
+     */
+    JobSystem();
+
+    /**
+     * @brief Stops and joins the workers; jobs still queued are dropped.
+     */
+    ~JobSystem();
+
+    /**
+     * @brief Runs jobs until the pool stops, sleeping while none are queued.
+     * @param index The worker's deque index.
+     */
+    void workerLoop(unsigned index);
+
+    /**
+     * @brief Pushes a ready job onto the calling thread's deque and wakes a sleeper.
+     * @param job The job.
+     */
+    void enqueue(JobHandle job);
+
+    /**
+     * @brief Takes a job from the calling thread's deque, or steals one from another.
+     * @return The job, or null if every deque is empty.
+     */
+    JobHandle takeJob();
+
+    /**
+     * @brief Runs a job, then queues the dependents it was the last blocker of.
+     * @param job The job.
+     */
+    void run(const JobHandle& job);
+
+    /**
+     * @brief Gets the deque index of the calling thread.
+     * @return The worker's index, or the shared deque's for threads outside the pool.
+     */
+    size_t getDequeIndex() const;
+
+    /**
+     * @brief Wakes every sleeping thread so it rechecks its condition.
+     */
+    void wakeSleepers();
+};
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,152 @@
+#ifndef MAP_FORMAT_H
+#define MAP_FORMAT_H
+
+#include "Tile.h"
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+/**
+ * @file MapFormat.h
+ * @brief On-disk layout of binary map files.
+ *
+ * A map file is laid out as follows (all integers little-endian):
+ *
+ *   MapFileHeader                 72 bytes (64 in version 1, which has no worldSeed)
+ *   terrain dictionary            dictionaryCount entries of { uint8_t length; char alias[length]; }
+ *   padding                       zero bytes up to terrainOffset
+ *   terrain plane                 numRows * numCols x uint8_t  (TerrainId per tile)
+ *   owner plane                   numRows * numCols x int32_t  (at ownerOffset, 8-byte aligned)
+ *   flag plane                    numRows * numCols x uint8_t  (TileFlags per tile)
+ *
+ * Each plane is stored row-major with exactly the layout TileMap uses in memory, so
+ * loading is a bulk read into the tile arrays. Terrain IDs in the file index the
+ * dictionary; they are remapped only if the dictionary differs from TerrainRegistry.
+ */
+
+static constexpr uint32_t MAP_FILE_MAGIC = 0x504D4757; ///< "WGMP" read as a little-endian uint32.
+static constexpr uint16_t MAP_FORMAT_VERSION = 2; ///< Current map format version.
+static constexpr uint16_t MAP_FORMAT_VERSION_1 = 1; ///< Oldest binary format still read; loaded into memory, never mapped.
+static constexpr size_t MAP_HEADER_SIZE_V1 = 64; ///< Size of a version 1 header: every field before worldSeed.
+static constexpr size_t MAP_PLANE_ALIGNMENT = 8; ///< Alignment of every tile plane within the file.
+
+/**
+ * @enum MapFileFlags
+ * @brief Bits stored in MapFileHeader::flags.
+ */
+enum MapFileFlags : uint32_t {
+    MAP_FILE_FLAG_NONE = 0,                 ///< No flags set.
+    MAP_FILE_FLAG_TILE_CRC_STALE = 1u << 0  ///< Tiles were changed in place through a mapping; tileCrc is out of date.
+};
+
+/**
+ * @struct MapFileHeader
+ * @brief Fixed-size header at the start of every map file.
+ */
+struct MapFileHeader {
+    uint32_t magic;           ///< Always MAP_FILE_MAGIC.
+    uint16_t version;         ///< Format version the file was written with.
+    uint16_t headerSize;      ///< Size of this header in bytes.
+    uint32_t numRows;         ///< Number of rows in the tile grid.
+    uint32_t numCols;         ///< Number of columns in the tile grid.
+    uint32_t flags;           ///< Header flags (see MapFileFlags).
+    uint32_t dictionaryCount; ///< Number of entries in the terrain dictionary.
+    uint64_t terrainOffset;   ///< Byte offset of the terrain plane.
+    uint64_t ownerOffset;     ///< Byte offset of the owner plane.
+    uint64_t flagsOffset;     ///< Byte offset of the flag plane.
+    uint64_t fileSize;        ///< Total size of the file in bytes.
+    uint32_t tileCrc;         ///< CRC-32 of the three tile planes, in file order.
+    uint32_t headerCrc;       ///< CRC-32 of everything before terrainOffset, with headerCrc zeroed.
+    uint64_t worldSeed;       ///< Seed the map was generated from (version 2; 0 for version 1 files).
+};
+
+static_assert(sizeof(MapFileHeader) == 72, "MapFileHeader must stay 72 bytes");
+static_assert(offsetof(MapFileHeader, worldSeed) == MAP_HEADER_SIZE_V1, "Version 1 fields must keep their offsets");
+
+static constexpr uint32_t MAP_MAX_DIMENSION = 1u << 20; ///< Largest row or column count accepted when loading.
+static constexpr uint64_t MAP_MAX_PREFIX_SIZE = 1u << 16; ///< Largest header plus dictionary accepted when loading.
+
+/**
+ * @brief Lookup table that maps terrain IDs stored in a file to TerrainRegistry IDs.
+ */
+typedef std::array<TerrainId, 256> TerrainRemap;
+
+/**
+ * @brief Computes or continues a CRC-32 (IEEE 802.3) checksum.
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @param crc The CRC of any preceding data, or 0 to start a new checksum.
+ * @return The updated CRC.
+ */
+uint32_t computeCrc32(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Computes the header CRC of an encoded map prefix.
+ * @param prefix The first terrainOffset bytes of the file, starting with a valid header.
+ * @return The CRC-32 of the prefix with the headerCrc field treated as zero.
+ */
+uint32_t computeMapHeaderCrc(const char* prefix);
+
+/**
+ * @brief Rounds an offset up to the plane alignment.
+ * @param offset The byte offset.
+ * @return The aligned offset.
+ */
+inline uint64_t alignMapOffset(uint64_t offset) {
+    return (offset + MAP_PLANE_ALIGNMENT - 1) & ~static_cast<uint64_t>(MAP_PLANE_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Appends the registry's terrain dictionary: every alias in ID order, each as
+ *        { uint8_t length; char alias[length]; }.
+ * @param out The buffer to append to.
+ * @return The number of dictionary entries written.
+ */
+uint32_t appendTerrainDictionary(std::vector<char>& out);
+
+/**
+ * @brief Decodes a terrain dictionary written by appendTerrainDictionary() into a remap table.
+ * @param data The encoded bytes.
+ * @param size The number of bytes in data; the dictionary must end at or before it.
+ * @param count The number of dictionary entries.
+ * @param offset Input/output parameter: where the dictionary starts, then where it ends.
+ * @param terrainRemap Output parameter mapping stored terrain IDs to TerrainRegistry IDs.
+ *        Unknown or out-of-range IDs map to TerrainRegistry::INVALID_TERRAIN.
+ * @param identityRemap Output parameter set to true if no remapping is needed.
+ * @return True if the dictionary is complete, false if it is truncated.
+ */
+bool decodeTerrainDictionary(const char* data, size_t size, uint32_t count, size_t& offset,
+                             TerrainRemap& terrainRemap, bool& identityRemap);
+
+/**
+ * @brief Builds the header, terrain dictionary and padding that precede the tile planes.
+ *
+ * The dictionary lists every TerrainRegistry alias in ID order, so maps written by this
+ * build load without remapping.
+ *
+ * @param numRows The number of rows in the tile grid.
+ * @param numCols The number of columns in the tile grid.
+ * @param tileCrc CRC-32 of the tile planes.
+ * @param worldSeed The seed the map was generated from.
+ * @return The encoded bytes. Their size equals the header's terrainOffset.
+ */
+std::vector<char> encodeMapPrefix(uint32_t numRows, uint32_t numCols, uint32_t tileCrc, uint64_t worldSeed);
+
+/**
+ * @brief Validates an encoded header and dictionary and builds the terrain remap table.
+ *
+ * Version 1 headers are accepted and decoded with a worldSeed of 0.
+ *
+ * @param prefix The first terrainOffset bytes of the file.
+ * @param prefixSize The number of bytes in prefix.
+ * @param header Output parameter receiving the decoded header.
+ * @param terrainRemap Output parameter mapping file terrain IDs to TerrainRegistry IDs.
+ *        Unknown or out-of-range IDs map to TerrainRegistry::INVALID_TERRAIN.
+ * @param identityRemap Output parameter set to true if no remapping is needed.
+ * @return True if the header and dictionary are valid, false otherwise.
+ */
+bool decodeMapPrefix(const char* prefix, size_t prefixSize, MapFileHeader& header,
+                     TerrainRemap& terrainRemap, bool& identityRemap);
+
+#endif // MAP_FORMAT_H
@@ -0,0 +1,220 @@
+#ifndef MAP_IO_WORKER_H
+#define MAP_IO_WORKER_H
+
+#include "TileMap.h"
+#include "DeltaPack.h"
+#include "WorldJournal.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class MapIOWorker
+ * @brief Generates inner maps and saves maps on a background thread.
+ *
+ * Requests are queued and served in order by a single worker thread, so a save of an
+ * inner map always completes before a later load of it. Inner maps are regenerated
+ * from their seed, and the player's changes to them are replayed from the world
+ * archive through a DeltaPack; an inner map that was never changed needs no disk
+ * I/O. Finished loads wait in a small ready cache until the game takes them, which
+ * lets map transitions swap in an already-resident map instead of blocking the
+ * render thread.
+ *
+ * Demand requests (saves, checkpoints and maps the player is entering) are served
+ * before speculative prefetches, and a new set of prefetches replaces any still queued.
+ * Journal commits are served before either, so the game never waits on a journal write.
+ */
+class MapIOWorker {
+public:
+    static constexpr size_t MAX_READY_MAPS = 16; ///< Finished maps kept before the oldest is dropped.
+
+    /**
+     * @struct InnerMapRequest
+     * @brief Everything needed to regenerate one inner map.
+     */
+    struct InnerMapRequest {
+        int col; ///< Column of the parent tile in the world.
+        int row; ///< Row of the parent tile in the world.
+        std::vector<TerrainId> terrains; ///< Terrain IDs to generate from.
+        uint64_t seed; ///< Seed to generate from.
+    };
+
+    /**
+     * @brief Starts the worker thread.
+     * @param archive The open world archive every map is loaded from and saved to; must outlive the worker.
+     * @param journal The world's journal, trimmed at checkpoints; must outlive the worker.
+     */
+    MapIOWorker(WorldArchive& archive, WorldJournal& journal);
+
+    /**
+     * @brief Finishes queued saves and demand loads, then stops the worker thread.
+     */
+    ~MapIOWorker();
+
+    MapIOWorker(const MapIOWorker&) = delete;
+    MapIOWorker& operator=(const MapIOWorker&) = delete;
+
+    /**
+     * @brief Queues an inner map to be generated, with any saved changes replayed onto it.
+     * @param request The inner map to load.
+     */
+    void requestInnerMap(const InnerMapRequest& request);
+
+    /**
+     * @brief Replaces the queued prefetches with a new set of inner maps.
+     *
+     * Prefetches run only when no demand request is waiting. Maps that are already
+     * ready or queued are skipped.
+     *
+     * @param requests The inner maps to prefetch, most likely first.
+     */
+    void prefetchInnerMaps(const std::vector<InnerMapRequest>& requests);
+
+    /**
+     * @brief Queues a snapshot of the world to be written to the archive as a mappable entry.
+     *
+     * Pass a moved-from map to hand it over without copying, or a copy to keep using
+     * the original. A snapshot mapped from the archive is flushed rather than rewritten.
+     * Afterwards the archive is compacted if replaced copies fill most of it, so the world
+     * must not be mapped from the archive while a save is queued.
+     *
+     * @param snapshot The world to save.
+     */
+    void saveWorld(TileMap snapshot);
+
+    /**
+     * @brief Queues the changed tiles of an inner map to be stored in the delta pack.
+     * @param snapshot The inner map to save; pass a moved-from map to avoid a copy.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     */
+    void saveInnerMap(TileMap snapshot, int col, int row);
+
+    /**
+     * @brief Queues a checkpoint: once every save queued before it succeeded, the archive index
+     *        is written and the journal records before a position are dropped.
+     *
+     * A save that fails is retried at every later checkpoint until it succeeds or a newer
+     * save of the same map replaces it; until then the journal is kept, so the changes
+     * are replayed on the next start instead.
+     *
+     * @param journalPosition The journal position the queued saves cover, from WorldJournal::mark().
+     */
+    void checkpoint(uint64_t journalPosition);
+
+    /**
+     * @brief Queues a write of the records appended to the journal since the last commit.
+     *
+     * A commit that is still queued covers the new records too, so at most one is ever waiting.
+     */
+    void commitJournal();
+
+    /**
+     * @brief Regenerates an inner map from its seed and replays its saved changes onto it.
+     * @param request The inner map to build.
+     * @param deltaPack The saved inner map changes.
+     * @return The inner map.
+     */
+    static TileMap buildInnerMap(const InnerMapRequest& request, DeltaPack& deltaPack);
+
+    /**
+     * @brief Takes a finished inner map out of the ready cache. Never blocks on I/O.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return The map, or std::nullopt if it is not ready yet.
+     */
+    std::optional<TileMap> takeInnerMap(int col, int row);
+
+private:
+    /**
+     * @enum RequestType
+     * @brief The kind of work a queued request asks for.
+     */
+    enum RequestType {
+        LOAD_INNER, ///< Generate an inner map and replay its saved changes.
+        SAVE_WORLD, ///< Write a snapshot of the world to the archive.
+        SAVE_INNER, ///< Store an inner map's changes in the delta pack.
+        CHECKPOINT  ///< Index the archive and trim the journal.
+    };
+
+    /**
+     * @struct Request
+     * @brief One queued unit of map I/O.
+     */
+    struct Request {
+        RequestType type; ///< What to do.
+        InnerMapRequest inner; ///< The inner map, for LOAD_INNER and SAVE_INNER requests.
+        std::optional<TileMap> snapshot; ///< Map to write, for SAVE_WORLD and SAVE_INNER requests.
+        uint64_t journalPosition = 0; ///< Journal position covered, for CHECKPOINT requests.
+    };
+
+    WorldArchive& archive; ///< The world archive; thread-safe on its own.
+    WorldJournal& journal; ///< The world's journal; thread-safe on its own.
+    DeltaPack deltaPack; ///< Saved inner map changes in the archive; used on the worker thread only.
+    std::vector<Request> failedSaves; ///< Saves to retry at the next checkpoint. Used on the worker thread only.
+
+    std::mutex mutex; ///< Guards all state below.
+    std::condition_variable wakeWorker; ///< Signals new requests or shutdown.
+    std::deque<Request> demand; ///< Saves and loads the game is waiting on, in order.
+    std::deque<Request> prefetch; ///< Speculative loads, most likely first.
+    std::unordered_map<uint64_t, TileMap> ready; ///< Finished loads by parent tile key.
+    std::deque<uint64_t> readyOrder; ///< Ready parent tile keys, oldest first.
+    std::optional<uint64_t> inFlight; ///< Parent tile key of the load being processed, if any.
+    bool journalCommitQueued = false; ///< Whether a journal commit is waiting.
+    bool stopping = false; ///< Set when the worker should exit.
+    std::thread worker; ///< Background I/O thread.
+
+    /**
+     * @brief Background loop that serves demand requests first, then prefetches.
+     */
+    void workerLoop();
+
+    /**
+     * @brief Performs one save request, keeping it in failedSaves if it fails.
+     * @param request The SAVE_WORLD or SAVE_INNER request to serve.
+     * @return True if the map was written, false otherwise.
+     */
+    bool save(Request& request);
+
+    /**
+     * @brief Performs one load request.
+     * @param request The request to serve.
+     * @return The loaded map.
+     */
+    TileMap load(const Request& request);
+
+    /**
+     * @brief Checks whether a load for an inner map is ready, running or queued. Must be called with the mutex held.
+     * @param key The parent tile key.
+     * @param includePrefetch True to also search the prefetch queue.
+     * @return True if the inner map needs no new request.
+     */
+    bool isKnown(uint64_t key, bool includePrefetch) const;
+
+    /**
+     * @brief Adds a finished map to the ready cache, dropping the oldest beyond the limit. Must be called with the mutex held.
+     * @param key The parent tile key.
+     * @param map The finished map.
+     */
+    void addReady(uint64_t key, TileMap&& map);
+
+    /**
+     * @brief Removes an inner map from the ready cache. Must be called with the mutex held.
+     * @param key The parent tile key.
+     */
+    void dropReady(uint64_t key);
+
+    /**
+     * @brief Packs parent tile coordinates into a key.
+     * @param col The column of the parent tile.
+     * @param row The row of the parent tile.
+     * @return The key.
+     */
+    static uint64_t makeKey(int col, int row);
+};
+
+#endif // MAP_IO_WORKER_H
@@ -0,0 +1,161 @@
+#ifndef MAP_PYRAMID_H
+#define MAP_PYRAMID_H
+
+#include "TileMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class MapPyramid
+ * @brief Downsampled copies of a map's terrain and owner planes, for drawing it zoomed out.
+ *
+ * Level 0 is the map itself. Each cell of level L + 1 holds the majority terrain and the
+ * majority owner of the 2x2 cells of level L it covers (ties go to the earliest cell in
+ * row order), so level L has one cell per 2^L x 2^L tiles. Levels are built down to a
+ * single cell.
+ *
+ * A view or minimap draws from the level whose cells are at least MIN_CELL_PIXELS on
+ * screen (see chooseLevel()), which bounds its cost by screen pixels, not by world size.
+ *
+ * Changed tiles are handed over with noteChangedTiles(), which only marks the level 1
+ * cells above them; update() re-derives the marked cells and marks a cell's parent only
+ * if the cell changed, so a tile costs at most one cell per level. Chunks whose revision
+ * changed without a note have every level 1 cell above them marked. A full build runs
+ * each level's rows as parallel jobs (see JobSystem).
+ */
+class MapPyramid {
+public:
+    static constexpr float MIN_CELL_PIXELS = 4.0f; ///< Smallest size on screen a tile or cell is drawn at.
+
+    /**
+     * @brief Picks the level to draw a view from.
+     * @param tilePixels The size of one tile on screen, in pixels.
+     * @return 0 to draw tiles, otherwise the coarsest level needed for cells of at least MIN_CELL_PIXELS.
+     */
+    static int chooseLevel(float tilePixels);
+
+    /**
+     * @brief Constructs an empty pyramid; update() builds it for a map.
+     */
+    MapPyramid() = default;
+
+    /**
+     * @brief Brings the pyramid up to date with a map.
+     *
+     * The first call, or a call with a different map, builds every level; later calls only
+     * re-derive the cells above noted tiles and above chunks changed since they were noted.
+     *
+     * @param world The map.
+     */
+    void update(const TileMap& world);
+
+    /**
+     * @brief Marks the cells above changed tiles for the next update().
+     *
+     * Cheap enough to call every tick while the pyramid is not drawn. Does nothing until
+     * the pyramid has been built for the map. The tiles account for their chunks' current
+     * revisions, so changes made with change tracking off must reach update() first.
+     *
+     * @param world The map.
+     * @param tiles Every tile of the map changed since the last call, as from TileMap::takeChangedTiles().
+     */
+    void noteChangedTiles(const TileMap& world, const std::vector<uint32_t>& tiles);
+
+    /**
+     * @brief Checks whether the pyramid was built for a map of this size and seed.
+     * @param world The map.
+     * @return True if the levels describe the map as of the last update().
+     */
+    bool describes(const TileMap& world) const;
+
+    /**
+     * @brief Gets the number of levels above the map.
+     * @return The level count; levels run from 1 to this count, the last one a single cell.
+     */
+    int getLevelCount() const;
+
+    /**
+     * @brief Gets the width of a level.
+     * @param level The level, from 1 to getLevelCount().
+     * @return The number of cell columns, or 0 for a level that does not exist.
+     */
+    int getLevelCols(int level) const;
+
+    /**
+     * @brief Gets the height of a level.
+     * @param level The level, from 1 to getLevelCount().
+     * @return The number of cell rows, or 0 for a level that does not exist.
+     */
+    int getLevelRows(int level) const;
+
+    /**
+     * @brief Gets the majority terrain of every cell of a level, row-major.
+     * @param level The level, from 1 to getLevelCount().
+     * @return The terrain IDs, or nullptr for a level that does not exist.
+     */
+    const TerrainId* getTerrainIds(int level) const;
+
+    /**
+     * @brief Gets the majority owner of every cell of a level, row-major.
+     * @param level The level, from 1 to getLevelCount().
+     * @return The owner IDs, or nullptr for a level that does not exist.
+     */
+    const int32_t* getOwnerIds(int level) const;
+
+    /**
+     * @brief Gets a number that changes whenever any cell may have changed.
+     * @return The current revision.
+     */
+    uint64_t getRevision() const;
+
+    /**
+     * @brief Gets the heap memory held by the pyramid.
+     * @return Bytes, not counting the pyramid object itself.
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    /**
+     * @struct Level
+     * @brief The planes of one level.
+     */
+    struct Level {
+        int cols = 0; ///< Cell columns.
+        int rows = 0; ///< Cell rows.
+        std::vector<TerrainId> terrainIds; ///< Majority terrain of each cell.
+        std::vector<int32_t> ownerIds; ///< Majority owner of each cell.
+        std::vector<bool> dirty; ///< Whether each cell is in dirtyCells.
+        std::vector<uint32_t> dirtyCells; ///< Cells to re-derive in the next update().
+    };
+
+    std::vector<Level> levels; ///< Levels 1 and up; levels[0] is level 1.
+    int numRows = 0; ///< Rows of the map the levels describe.
+    int numCols = 0; ///< Columns of the map the levels describe.
+    uint64_t worldSeed = 0; ///< Seed of the map, to notice a different map.
+    bool built = false; ///< Whether the levels describe a map.
+    uint64_t revision = 0; ///< Bumped with every update that changed cells; never reset.
+    int chunkCols = 0; ///< Map chunks per row.
+    std::vector<uint64_t> mapChunkRevisions; ///< Map chunk revisions the levels were derived from.
+
+    /**
+     * @brief Re-derives a rectangle of a level's cells from the level below it.
+     * @param world The map, the source of level 1.
+     * @param level The level, from 1 to getLevelCount().
+     * @param firstCol The first cell column.
+     * @param firstRow The first cell row.
+     * @param endCol One past the last cell column; clamped to the level.
+     * @param endRow One past the last cell row; clamped to the level.
+     */
+    void downsample(const TileMap& world, int level, int firstCol, int firstRow, int endCol, int endRow);
+
+    /**
+     * @brief Queues a cell to be re-derived by the next update().
+     * @param level The level, from 1 to getLevelCount().
+     * @param col The cell column.
+     * @param row The cell row.
+     */
+    void markCell(int level, int col, int row);
+};
+
+#endif // MAP_PYRAMID_H
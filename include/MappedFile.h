@@ -0,0 +1,128 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class MappedFile
+ * @brief RAII wrapper around a memory-mapped file.
+ *
+ * Pages are loaded by the operating system on first access, so opening a large file
+ * is constant-time and resident memory tracks only the pages that are touched.
+ * Supported on POSIX platforms; open() fails elsewhere so callers can fall back to
+ * regular file I/O.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Constructs an unmapped MappedFile.
+     */
+    MappedFile();
+
+    /**
+     * @brief Destructor that unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps an existing file, or a range of it, into memory, replacing any current mapping.
+     * @param path The path of the file to map.
+     * @param writable True to map the file shared and writable, false for read-only.
+     * @param offset The byte offset of the range; must be a multiple of getPageSize().
+     * @param length The length of the range in bytes, or 0 for the rest of the file.
+     * @return True if the file was mapped, false otherwise.
+     */
+    bool open(const std::string& path, bool writable, uint64_t offset = 0, size_t length = 0);
+
+    /**
+     * @brief Unmaps the file. Changes to a writable mapping are left for the OS to write back.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a file is currently mapped.
+     * @return True if mapped, false otherwise.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Checks whether the mapping can be written to.
+     * @return True if writable, false otherwise.
+     */
+    bool isWritable() const;
+
+    /**
+     * @brief Gets the start of the mapping.
+     * @return A pointer to the first mapped byte, or nullptr if nothing is mapped.
+     */
+    char* data() const;
+
+    /**
+     * @brief Gets the size of the mapping.
+     * @return The size in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the path of the mapped file.
+     * @return The path passed to open().
+     */
+    const std::string& getPath() const;
+
+    /**
+     * @brief Gets where in the file the mapping starts.
+     * @return The offset passed to open().
+     */
+    uint64_t getOffset() const;
+
+    /**
+     * @brief Writes a range of a writable mapping back to disk (msync).
+     * @param offset The byte offset of the range; rounded down to a page boundary.
+     * @param length The length of the range in bytes.
+     * @return True on success, false otherwise.
+     */
+    bool flush(size_t offset, size_t length);
+
+    /**
+     * @brief Pages in a range of the mapping on the calling thread.
+     *
+     * Hints the OS to read the range ahead, then touches each page so any disk read
+     * happens here rather than on a later access.
+     *
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     */
+    void prefetch(size_t offset, size_t length) const;
+
+    /**
+     * @brief Lets the OS drop the pages of a range from memory.
+     *
+     * Only pages lying entirely inside the range are released, and a writable mapping
+     * is written back first, so no data is lost. Released pages are read back from the
+     * file on their next access.
+     *
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     */
+    void release(size_t offset, size_t length);
+
+    /**
+     * @brief Gets the size of a virtual memory page.
+     * @return The page size in bytes.
+     */
+    static size_t getPageSize();
+
+private:
+    char* mapping = nullptr; ///< Start of the mapped region.
+    size_t mappedSize = 0; ///< Size of the mapped region in bytes.
+    uint64_t fileOffset = 0; ///< Offset of the mapped region within the file.
+    bool writable = false; ///< Whether the mapping is shared and writable.
+    std::string path; ///< Path of the mapped file.
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,103 @@
+#ifndef PACKED_TILE_MAP_H
+#define PACKED_TILE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file PackedTileMap.h
+ * @brief Compact in-memory form of a tile map that is not being shown.
+ *
+ * A packed map keeps its grid size, seed and save state as plain fields and
+ * everything else in one byte buffer (varints are little-endian base 128):
+ *
+ *   terrain plane, owner plane, flag plane    packed planes, as below
+ *   varint chunkCount                         followed by chunkCount x varint (revision - chunkRevision)
+ *
+ * Each plane is packed on its own, as whichever of two encodings is smaller:
+ *
+ *   uint8_t encoding                          PLANE_PALETTE or PLANE_RUNS
+ *   uint8_t bitsPerIndex                      width of a palette index, for PLANE_PALETTE
+ *   varint paletteCount                       followed by paletteCount x varint value,
+ *                                             the distinct values in order of first appearance
+ *   varint dataSize                           followed by dataSize bytes:
+ *     PLANE_PALETTE                           one bit-packed palette index per tile, LSB first
+ *                                             (no bytes at all when every tile has the same value)
+ *     PLANE_RUNS                              { varint runLength - 1; varint paletteIndex; } per run
+ *                                             of equal tiles in row-major order
+ *
+ * Inner maps have a single owner and a few terrains laid out in patches, so their
+ * planes shrink to a few bytes each. See TileMap::pack() and the TileMap constructor
+ * that takes a PackedTileMap.
+ */
+
+/**
+ * @enum PlaneEncoding
+ * @brief How the values of a packed plane are stored.
+ */
+enum PlaneEncoding : uint8_t {
+    PLANE_PALETTE, ///< Bit-packed palette indexes, one per tile.
+    PLANE_RUNS     ///< Varint-coded runs of equal palette indexes.
+};
+
+/**
+ * @struct PackedTileMap
+ * @brief A packed tile map, with the state needed to restore it exactly.
+ */
+struct PackedTileMap {
+    int numRows = 0;        ///< Number of rows in the tile grid.
+    int numCols = 0;        ///< Number of columns in the tile grid.
+    int tileSize = 0;       ///< Size of each tile in pixels.
+    uint64_t worldSeed = 0; ///< Seed the tiles were generated from.
+    uint64_t revision = 0;  ///< Revision of the map when it was packed.
+    size_t dirtyBegin = 0;  ///< First tile index not saved yet.
+    size_t dirtyEnd = 0;    ///< One past the last tile index not saved yet.
+    std::vector<uint8_t> bytes; ///< The packed planes and chunk revisions.
+
+    /**
+     * @brief Checks whether the packed map has changes that are not saved yet.
+     * @return True if there are unsaved changes.
+     */
+    bool hasUnsavedChanges() const { return dirtyBegin < dirtyEnd; }
+
+    /**
+     * @brief Gets the memory held by the packed map.
+     * @return Bytes, including the struct itself.
+     */
+    size_t getMemoryUsage() const { return sizeof(*this) + bytes.capacity(); }
+};
+
+/**
+ * @brief Appends a value as a varint.
+ * @param out The buffer to append to.
+ * @param value The value.
+ */
+void appendVarint(std::vector<uint8_t>& out, uint64_t value);
+
+/**
+ * @brief Reads a varint written by appendVarint().
+ * @param in The read position; advanced past the varint.
+ * @return The value.
+ */
+uint64_t readVarint(const uint8_t*& in);
+
+/**
+ * @brief Packs a plane of 1- or 4-byte values with whichever encoding is smaller.
+ * @param values The plane.
+ * @param count The number of values.
+ * @param valueSize The size of each value in bytes (1 or 4).
+ * @param out The buffer to append the packed plane to.
+ */
+void packPlane(const void* values, size_t count, size_t valueSize, std::vector<uint8_t>& out);
+
+/**
+ * @brief Restores a plane packed by packPlane().
+ * @param in The read position; advanced past the packed plane.
+ * @param values Output buffer for count values.
+ * @param count The number of values.
+ * @param valueSize The size of each value in bytes (1 or 4).
+ */
+void unpackPlane(const uint8_t*& in, void* values, size_t count, size_t valueSize);
+
+#endif // PACKED_TILE_MAP_H
@@ -0,0 +1,215 @@
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include "TileMap.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct PathRequest
+ * @brief A path query between two tiles of a map.
+ */
+struct PathRequest {
+    int startCol = 0; ///< Column of the start tile.
+    int startRow = 0; ///< Row of the start tile.
+    int goalCol = 0;  ///< Column of the goal tile.
+    int goalRow = 0;  ///< Row of the goal tile.
+    int32_t ownerId = -1; ///< Owner of the mover; tiles of other factions cost more. -1 ignores territory.
+};
+
+/**
+ * @struct PathResult
+ * @brief The answer to a PathRequest.
+ */
+struct PathResult {
+    bool found = false; ///< Whether the goal can be reached.
+    uint32_t cost = 0;  ///< Summed cost of every tile entered after the start.
+    std::vector<uint32_t> tiles; ///< Tile indexes from start to goal, both included.
+};
+
+/**
+ * @class Pathfinder
+ * @brief Hierarchical A* (HPA*) over a tile map, with terrain move costs and territory.
+ *
+ * Moves go to the four neighbouring tiles and cost the move cost of the tile entered
+ * (see GlobalSettings::getTerrainMoveCost(); 0 is impassable). A mover with an owner pays
+ * FOREIGN_COST_FACTOR times as much on tiles of other factions.
+ *
+ * The map is abstracted over TileMap::CHUNK_SIZE chunks. Each passable stretch of a chunk
+ * border gets one or two entrances, which become a pair of graph nodes, one on either
+ * side. Nodes in the same chunk are joined by edges holding their travel cost inside the
+ * chunk. A long query searches this graph, which is a few nodes per chunk, then runs one
+ * A* over the tiles of the chunks the abstract route crosses and their neighbours, so the
+ * path is not tied to the entrances. Nearby queries search the tiles directly.
+ *
+ * Edge costs are built on terrain alone. A chunk whose tiles all belong to one faction is
+ * recorded as owned by it, and a search scales the edges of chunks foreign to the mover by
+ * FOREIGN_COST_FACTOR; mixed chunks keep the terrain cost. refresh() compares each chunk's
+ * revision with the last build and re-abstracts only the chunks whose move costs changed,
+ * so ownership changes cost a scan of the chunk's owners.
+ *
+ * Paths are not guaranteed to be the cheapest. On generated worlds with simulated territory,
+ * paths up to 128 tiles apart cost on average less than 1% more than the cheapest path, with
+ * or without an owner, and single paths up to about 1.5 times as much (see
+ * test/PathfinderTest.cpp).
+ */
+class Pathfinder {
+public:
+    static constexpr int32_t ANY_OWNER = -1; ///< PathRequest owner that ignores territory.
+    static constexpr uint32_t FOREIGN_COST_FACTOR = 4; ///< Cost multiplier on tiles of other factions.
+
+    /**
+     * @brief Constructs an empty pathfinder; refresh() builds it for a map.
+     */
+    Pathfinder() = default;
+
+    /**
+     * @brief Brings the abstraction up to date with a map.
+     *
+     * The first call, or a call with a different map, builds everything; later calls
+     * rebuild only the chunks whose terrain changed. Chunks are abstracted in parallel.
+     *
+     * @param map The map to search.
+     */
+    void refresh(const TileMap& map);
+
+    /**
+     * @brief Finds the cheapest path between two tiles, or a near-cheapest one for long paths.
+     *
+     * Thread-safe between calls to refresh(), which must have been given the same map.
+     *
+     * @param map The map passed to refresh().
+     * @param request The query.
+     * @return The path, or a result with found false if a tile is outside the map,
+     *         impassable, or cut off.
+     */
+    PathResult findPath(const TileMap& map, const PathRequest& request) const;
+
+    /**
+     * @brief Refreshes the abstraction, then answers a batch of queries in parallel.
+     * @param map The map to search.
+     * @param requests The queries.
+     * @return One result per query, in order.
+     */
+    std::vector<PathResult> findPaths(const TileMap& map, const std::vector<PathRequest>& requests);
+
+    /**
+     * @brief Gets the number of nodes in the abstract graph.
+     * @return The node count.
+     */
+    size_t getNodeCount() const;
+
+private:
+    static constexpr int CHUNK = TileMap::CHUNK_SIZE; ///< Width and height of an abstracted chunk.
+    static constexpr int SPLIT_ENTRANCE = 6; ///< Border stretches longer than this get an entrance at each end.
+    static constexpr uint32_t NO_NODE = UINT32_MAX; ///< Marks a missing node.
+    static constexpr uint32_t UNREACHED = UINT32_MAX; ///< Cost of a tile or node not reached yet.
+    static constexpr int32_t MIXED_OWNERS = INT32_MIN; ///< Chunk owner of a chunk whose tiles have several owners.
+    static constexpr int CORRIDOR_MARGIN = 1; ///< Chunks around an abstract route that its refinement may use.
+
+    /**
+     * @struct Edge
+     * @brief A directed edge of the abstract graph.
+     */
+    struct Edge {
+        uint32_t target; ///< Node reached.
+        uint32_t cost;   ///< Cost of reaching it.
+    };
+
+    /**
+     * @struct Node
+     * @brief One side of a chunk entrance.
+     */
+    struct Node {
+        uint32_t tile = 0;       ///< Tile index.
+        uint32_t chunk = 0;      ///< Chunk index.
+        uint32_t peer = NO_NODE; ///< Node on the other side of the entrance, or NO_NODE if the node is free.
+        uint32_t peerCost = 0;   ///< Cost of stepping onto the peer.
+        std::vector<Edge> edges; ///< Edges to the other nodes of the chunk.
+    };
+
+    int numRows = 0; ///< Rows of the abstracted map.
+    int numCols = 0; ///< Columns of the abstracted map.
+    int chunkCols = 0; ///< Chunks per row.
+    int chunkRows = 0; ///< Chunks per column.
+    uint64_t worldSeed = 0; ///< Seed of the abstracted map, to notice a different map.
+    bool built = false; ///< Whether the abstraction describes a map.
+    uint32_t minCost = 1; ///< Smallest move cost of any passable terrain, for the heuristics.
+    std::array<uint8_t, 256> terrainCosts{}; ///< Move cost per terrain ID.
+    std::vector<uint8_t> costs; ///< Move cost per tile, 0 for impassable.
+    std::vector<uint64_t> chunkRevisions; ///< Chunk revisions the abstraction was built from.
+    std::vector<int32_t> chunkOwners; ///< Owner of every tile of each chunk, or MIXED_OWNERS.
+    std::vector<Node> nodes; ///< Abstract graph nodes; freed ones have no peer.
+    std::vector<uint32_t> freeNodes; ///< Indexes of freed nodes, for reuse.
+    std::vector<std::vector<uint32_t>> borderNodes; ///< Nodes on each border; border 2c is chunk c's east side, 2c+1 its south side.
+    std::vector<std::vector<uint32_t>> chunkNodes; ///< Nodes in each chunk.
+
+    /**
+     * @brief Recomputes the entrances of a border, freeing its old nodes.
+     * @param border The border index.
+     */
+    void buildBorder(size_t border);
+
+    /**
+     * @brief Recomputes the node list of a chunk and the edges between its nodes.
+     * @param chunk The chunk index.
+     */
+    void buildChunk(uint32_t chunk);
+
+    /**
+     * @brief Allocates a node.
+     * @param tile The tile index.
+     * @return The node index.
+     */
+    uint32_t addNode(uint32_t tile);
+
+    /**
+     * @brief Computes terrain-only costs from (or, reversed, to) a tile to every tile of its chunk.
+     * @param tile The tile index.
+     * @param reverse True for costs from each tile to the given tile.
+     * @param distances Output cost per tile of the chunk, row-major within the chunk.
+     */
+    void chunkDistances(uint32_t tile, bool reverse, std::vector<uint32_t>& distances) const;
+
+    /**
+     * @brief Runs A* between two tiles, staying inside a set of chunks.
+     * @param map The map, for tile owners.
+     * @param ownerId The mover's owner, or ANY_OWNER.
+     * @param corridor The chunks the search may enter, without duplicates.
+     * @param from The start tile index.
+     * @param to The goal tile index.
+     * @param tiles Output path; the tiles after from, up to and including to, are appended.
+     * @param cost Output parameter receiving the path cost.
+     * @return True if to was reached, false otherwise.
+     */
+    bool searchCorridor(const TileMap& map, int32_t ownerId, const std::vector<uint32_t>& corridor,
+                        uint32_t from, uint32_t to, std::vector<uint32_t>& tiles, uint32_t& cost) const;
+
+    /**
+     * @brief Gets the factor a mover pays on a chunk in the abstract search.
+     * @param chunk The chunk index.
+     * @param ownerId The mover's owner, or ANY_OWNER.
+     * @return FOREIGN_COST_FACTOR if another faction owns the whole chunk, 1 otherwise.
+     */
+    uint32_t chunkFactor(uint32_t chunk, int32_t ownerId) const;
+
+    /**
+     * @brief Adds a rectangle of chunks, clipped to the map, to a corridor.
+     * @param firstCx The first chunk column.
+     * @param firstCy The first chunk row.
+     * @param lastCx The last chunk column.
+     * @param lastCy The last chunk row.
+     * @param corridor The chunk list to append to; may hold duplicates afterwards.
+     */
+    void addChunks(int firstCx, int firstCy, int lastCx, int lastCy, std::vector<uint32_t>& corridor) const;
+
+    /**
+     * @brief Gets the chunk holding a tile.
+     * @param tile The tile index.
+     * @return The chunk index.
+     */
+    uint32_t chunkOf(uint32_t tile) const;
+};
+
+#endif // PATHFINDER_H
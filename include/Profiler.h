@@ -0,0 +1,203 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/**
+ * @file Profiler.h
+ * @brief Scoped-timer instrumentation, compiled in only when WARGAME_PROFILING is defined.
+ *
+ * Wrap a block in PROFILE_SCOPE("name") to record how long it took. Names must be
+ * string literals, since only the pointer is stored. Without WARGAME_PROFILING the
+ * macros expand to nothing and the Profiler class does not exist.
+ */
+
+#ifdef WARGAME_PROFILING
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+/// Times the rest of the enclosing scope under a string-literal name.
+#define PROFILE_SCOPE(name) Profiler::ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+/// Names the calling thread in exported traces.
+#define PROFILE_THREAD_NAME(name) Profiler::getInstance().setThreadName(name)
+
+/**
+ * @class Profiler
+ * @brief Collects timed scopes from every thread and rolling frame-time statistics.
+ *
+ * Each thread records into its own fixed-size ring buffer, so recording never
+ * allocates and only contends with an export in progress. The oldest events are
+ * overwritten once a buffer is full.
+ *
+ * A thread's buffer is retired when the thread exits. Its events stay until the next
+ * export, after which the buffer is handed to the next new thread; at most
+ * MAX_RETIRED_BUFFERS unexported ones are kept, so short-lived threads cannot grow
+ * the profiler without bound.
+ */
+class Profiler {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16; ///< Ring buffer size per thread.
+    static constexpr size_t FRAME_HISTORY = 240; ///< Frames kept for the rolling statistics.
+    static constexpr size_t MAX_RETIRED_BUFFERS = 4; ///< Buffers of exited threads kept for export before the oldest is reused.
+
+    /**
+     * @class ScopedTimer
+     * @brief Records the time between its construction and destruction.
+     */
+    class ScopedTimer {
+    public:
+        /**
+         * @brief Starts timing.
+         * @param name The scope name; must outlive the profiler, e.g. a string literal.
+         */
+        explicit ScopedTimer(const char* name) : name(name), start(Profiler::now()) {}
+
+        /**
+         * @brief Stops timing and records the scope.
+         */
+        ~ScopedTimer() { Profiler::getInstance().record(name, start, Profiler::now()); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        const char* name; ///< Scope name.
+        uint64_t start; ///< Start time in nanoseconds.
+    };
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * @brief Provides access to the singleton instance of Profiler.
+     * @return Reference to the singleton instance.
+     */
+    static Profiler& getInstance();
+
+    /**
+     * @brief Gets a monotonic timestamp.
+     * @return Nanoseconds since an arbitrary epoch.
+     */
+    static uint64_t now();
+
+    /**
+     * @brief Records a finished scope on the calling thread.
+     * @param name The scope name.
+     * @param start The start time in nanoseconds.
+     * @param end The end time in nanoseconds.
+     */
+    void record(const char* name, uint64_t start, uint64_t end);
+
+    /**
+     * @brief Names the calling thread in exported traces.
+     * @param name The thread name.
+     */
+    void setThreadName(const std::string& name);
+
+    /**
+     * @brief Adds a frame to the rolling statistics. Call from the render thread only.
+     * @param seconds The time the frame took.
+     */
+    void recordFrame(double seconds);
+
+    /**
+     * @brief Gets the recent frame times, oldest first. Call from the render thread only.
+     * @return Frame times in seconds.
+     */
+    std::vector<double> getFrameTimes() const;
+
+    /**
+     * @brief Gets a percentile of the recent frame times. Call from the render thread only.
+     * @param percentile The percentile, from 0 to 100.
+     * @return The frame time in seconds, or 0 if no frames were recorded.
+     */
+    double getFramePercentile(double percentile) const;
+
+    /**
+     * @brief Writes every buffered event as Chrome trace JSON (chrome://tracing, Perfetto).
+     *
+     * Buffers of threads that have exited are written once more and then freed for reuse.
+     *
+     * @param path The file to write.
+     * @return True if the file was written, false otherwise.
+     */
+    bool exportChromeTrace(const std::string& path);
+
+private:
+    /**
+     * @struct Event
+     * @brief One finished scope.
+     */
+    struct Event {
+        const char* name; ///< Scope name.
+        uint64_t start; ///< Start time in nanoseconds.
+        uint64_t duration; ///< Duration in nanoseconds.
+    };
+
+    /**
+     * @struct ThreadBuffer
+     * @brief Ring buffer of one thread's events.
+     */
+    struct ThreadBuffer {
+        std::mutex mutex; ///< Taken by the owning thread to record and by exports to read.
+        std::array<Event, EVENTS_PER_THREAD> events; ///< Ring storage.
+        uint64_t written = 0; ///< Events recorded so far; the next slot is written % size.
+        uint32_t threadId = 0; ///< Small ID used in traces.
+        std::string threadName; ///< Name shown in traces, if set.
+        bool retired = false; ///< Whether the owning thread has exited; guarded by registryMutex.
+    };
+
+    /**
+     * @struct BufferOwner
+     * @brief Thread-local handle that retires its thread's buffer when the thread exits.
+     */
+    struct BufferOwner {
+        ThreadBuffer* buffer = nullptr; ///< The thread's buffer, once registered.
+
+        ~BufferOwner();
+    };
+
+    Profiler();
+
+    /**
+     * @brief Gets the calling thread's buffer, registering it on first use.
+     * @return The thread's buffer.
+     */
+    ThreadBuffer& threadBuffer();
+
+    /**
+     * @brief Takes a buffer for a new thread: a free one, else the oldest retired one past the limit, else a new one.
+     * @return The cleared buffer. Call with registryMutex held.
+     */
+    ThreadBuffer* acquireBuffer();
+
+    /**
+     * @brief Marks an exited thread's buffer as retired, keeping its events for the next export.
+     * @param buffer The buffer.
+     */
+    void retireBuffer(ThreadBuffer* buffer);
+
+    mutable std::mutex registryMutex; ///< Guards the buffer lists.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; ///< Every buffer, live, retired or free.
+    std::vector<ThreadBuffer*> retiredBuffers; ///< Buffers of exited threads not yet exported, oldest first.
+    std::vector<ThreadBuffer*> freeBuffers; ///< Exported buffers of exited threads, ready for reuse.
+    uint32_t nextThreadId = 0; ///< Last thread ID handed out; reused buffers get a new one.
+    std::array<double, FRAME_HISTORY> frameTimes{}; ///< Ring of recent frame times.
+    size_t framesRecorded = 0; ///< Frames recorded so far.
+};
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif // WARGAME_PROFILING
+
+#endif // PROFILER_H
@@ -0,0 +1,132 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "ComponentStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class SpatialHash
+ * @brief Finds the entities on or near a tile.
+ *
+ * The tile grid is cut into CELL_SIZE squares and each occupied square keeps a short
+ * packed list of the entities in it and their tiles. Every entity remembers its cell's
+ * list and its place in it, so inserting, moving and removing an entity are O(1), and a
+ * move within a cell needs no hash lookup at all. Finding what stands on a tile reads a
+ * single list, whose length is bounded by the local density rather than by the number of
+ * entities.
+ */
+class SpatialHash {
+public:
+    static constexpr int CELL_SIZE = 8; ///< Width and height of a cell in tiles; a quarter of a TileMap chunk.
+
+    /**
+     * @brief Adds an entity at a tile, or moves it there if it is already in the hash.
+     * @param entity The entity.
+     * @param col The column of its tile.
+     * @param row The row of its tile.
+     */
+    void insert(EntityId entity, int col, int row);
+
+    /**
+     * @brief Removes an entity.
+     * @param entity The entity.
+     * @return True if the entity was in the hash.
+     */
+    bool remove(EntityId entity);
+
+    /**
+     * @brief Removes every entity.
+     */
+    void clear();
+
+    /**
+     * @brief Appends the entities standing on a tile.
+     * @param col The column.
+     * @param row The row.
+     * @param out Receives the entities, the last one added to the tile first.
+     * @return The number of entities appended.
+     */
+    size_t queryTile(int col, int row, std::vector<EntityId>& out) const;
+
+    /**
+     * @brief Appends the entities inside a rectangle of tiles.
+     * @param firstCol The first column.
+     * @param firstRow The first row.
+     * @param endCol One past the last column.
+     * @param endRow One past the last row.
+     * @param out Receives the entities.
+     * @return The number of entities appended.
+     */
+    size_t queryRect(int firstCol, int firstRow, int endCol, int endRow, std::vector<EntityId>& out) const;
+
+    /**
+     * @brief Appends the entities within a number of tiles of a tile, in a square.
+     * @param col The column.
+     * @param row The row.
+     * @param radius The distance in tiles along each axis.
+     * @param out Receives the entities.
+     * @return The number of entities appended.
+     */
+    size_t queryNear(int col, int row, int radius, std::vector<EntityId>& out) const;
+
+    /**
+     * @brief Finds the entity standing on a tile that was put there last, as hover picking wants.
+     * @param col The column.
+     * @param row The row.
+     * @return The entity, or NO_ENTITY if the tile is empty.
+     */
+    EntityId findOnTile(int col, int row) const;
+
+    /**
+     * @brief Gets the number of entities in the hash.
+     * @return The entity count.
+     */
+    size_t size() const;
+
+private:
+    static constexpr uint32_t ABSENT = UINT32_MAX; ///< Entry index of an entity not in the hash.
+
+    /**
+     * @struct Entry
+     * @brief One entity in a cell.
+     */
+    struct Entry {
+        EntityId entity; ///< The entity.
+        int32_t col;     ///< Column of its tile.
+        int32_t row;     ///< Row of its tile.
+    };
+
+    /**
+     * @struct Location
+     * @brief Where an entity's entry is.
+     */
+    struct Location {
+        uint64_t cell = 0;      ///< Key of the cell.
+        uint32_t entry = ABSENT; ///< Index in the cell's entries, or ABSENT.
+        std::vector<Entry>* entries = nullptr; ///< The cell's entries; map nodes never move, and an empty cell has no locations.
+    };
+
+    std::unordered_map<uint64_t, std::vector<Entry>> cells; ///< Entries of each occupied cell, keyed by cellKey().
+    std::vector<Location> locations; ///< Location of each entity, by entity slot.
+    size_t count = 0; ///< Entities in the hash.
+
+    /**
+     * @brief Combines the cell coordinates of a tile into one map key.
+     * @param col The column.
+     * @param row The row.
+     * @return The key.
+     */
+    static uint64_t cellKey(int col, int row);
+
+    /**
+     * @brief Finds an entity's location, if it is in the hash.
+     * @param entity The entity.
+     * @return The location, or nullptr.
+     */
+    Location* find(EntityId entity);
+};
+
+#endif // SPATIAL_HASH_H
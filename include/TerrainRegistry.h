@@ -0,0 +1,95 @@
+#ifndef TERRAIN_REGISTRY_H
+#define TERRAIN_REGISTRY_H
+
+#include "Tile.h"
+#include "GlobalSettings.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @class TerrainRegistry
+ * @brief Singleton that interns every terrain alias from GlobalSettings into a small integer ID.
+ *
+ * IDs are assigned once at startup in alias order, so they are stable for a given
+ * texture set. Tiles, renderers and generators work with TerrainId only; aliases are
+ * needed only when loading assets, reading legacy map files, or debugging.
+ */
+class TerrainRegistry {
+public:
+    static constexpr TerrainId INVALID_TERRAIN = 0xFF; ///< ID returned for unknown aliases.
+
+    /**
+     * @brief Deleted copy constructor to prevent copying.
+     */
+    TerrainRegistry(const TerrainRegistry&) = delete;
+
+    /**
+     * @brief Deleted assignment operator to enforce singleton pattern.
+     */
+    TerrainRegistry& operator=(const TerrainRegistry&) = delete;
+
+    /**
+     * @brief Provides access to the singleton instance of TerrainRegistry.
+     * @return Reference to the singleton instance.
+     */
+    static TerrainRegistry& getInstance();
+
+    /**
+     * @brief Gets the number of registered terrain types.
+     * @return The terrain count.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Looks up the ID of a terrain alias.
+     * @param alias The terrain alias.
+     * @return The terrain ID, or INVALID_TERRAIN if the alias is unknown.
+     */
+    TerrainId getId(const std::string& alias) const;
+
+    /**
+     * @brief Gets the alias of a terrain ID.
+     * @param terrainId The terrain ID.
+     * @return The alias, or an empty string if the ID is unknown.
+     */
+    const std::string& getAlias(TerrainId terrainId) const;
+
+    /**
+     * @brief Gets the texture file path of a terrain ID.
+     * @param terrainId The terrain ID.
+     * @return The file path, or an empty string if the ID is unknown.
+     */
+    const std::string& getTexturePath(TerrainId terrainId) const;
+
+    /**
+     * @brief Gets every registered terrain ID.
+     * @return A constant reference to the list of IDs.
+     */
+    const std::vector<TerrainId>& getAllTerrains() const;
+
+    /**
+     * @brief Gets the terrain types in the same family as the given terrain.
+     *
+     * A family groups variants of one terrain, e.g. medgrass1 and medgrass2.
+     *
+     * @param terrainId The terrain ID.
+     * @return The IDs in the terrain's family, or an empty list if the ID is unknown.
+     */
+    const std::vector<TerrainId>& getMatchingTerrain(TerrainId terrainId) const;
+
+private:
+    /**
+     * @brief Private constructor that builds the registry from GlobalSettings.
+     */
+    TerrainRegistry();
+
+    std::vector<std::string> aliases; ///< Terrain aliases, indexed by ID.
+    std::vector<std::string> texturePaths; ///< Texture file paths, indexed by ID.
+    std::vector<size_t> familyIndex; ///< Family of each terrain, indexed by ID.
+    std::vector<std::vector<TerrainId>> families; ///< Members of each terrain family.
+    std::vector<TerrainId> allTerrains; ///< Every registered terrain ID.
+    std::unordered_map<std::string, TerrainId> idsByAlias; ///< Reverse lookup used at load time.
+};
+
+#endif // TERRAIN_REGISTRY_H
@@ -0,0 +1,184 @@
+#ifndef TERRITORY_INDEX_H
+#define TERRITORY_INDEX_H
+
+#include "TerrainRegistry.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class TerritoryIndex
+ * @brief Tile counts per owner and terrain, for the whole map and for each chunk.
+ *
+ * Each CHUNK_SIZE square keeps a short list of how many of its tiles each (owner, terrain)
+ * pair holds, and the map keeps the totals. A tile change moves one tile between two
+ * pairs in both, so totals cost O(1) to read and keep current, and a rectangle is counted
+ * from the summaries of the chunks it covers, scanning tiles only in the chunks cut by its
+ * edges. TileMap owns one index and keeps it in step with its tiles.
+ */
+class TerritoryIndex {
+public:
+    static constexpr int CHUNK_SIZE = 32; ///< Width and height of a summarized chunk; matches TileMap::CHUNK_SIZE.
+
+    /**
+     * @struct TileCount
+     * @brief How many tiles one owner holds of one terrain.
+     */
+    struct TileCount {
+        int32_t ownerId = 0;     ///< Owner ID.
+        TerrainId terrainId = 0; ///< Terrain ID.
+        uint64_t tiles = 0;      ///< Number of tiles.
+    };
+
+    /**
+     * @struct OwnerCount
+     * @brief How many tiles one owner holds.
+     */
+    struct OwnerCount {
+        int32_t ownerId = 0; ///< Owner ID.
+        uint64_t tiles = 0;  ///< Number of tiles.
+    };
+
+    /**
+     * @brief Counts every tile of a map, one job per band of chunk rows.
+     * @param terrainIds The terrain ID of every tile, row-major.
+     * @param ownerIds The owner ID of every tile, row-major.
+     * @param numRows The number of rows.
+     * @param numCols The number of columns.
+     */
+    void build(const TerrainId* terrainIds, const int32_t* ownerIds, int numRows, int numCols);
+
+    /**
+     * @brief Forgets every count; the index must be built again before use.
+     */
+    void clear();
+
+    /**
+     * @brief Checks whether the index has been built since it was last cleared.
+     * @return True if the counts are usable.
+     */
+    bool isBuilt() const;
+
+    /**
+     * @brief Moves one tile from its old owner and terrain to its new ones. Ignored until built.
+     * @param index The tile index (row * numCols + col).
+     * @param oldTerrain The terrain ID before the change.
+     * @param oldOwner The owner ID before the change.
+     * @param newTerrain The terrain ID after the change.
+     * @param newOwner The owner ID after the change.
+     */
+    void moveTile(size_t index, TerrainId oldTerrain, int32_t oldOwner, TerrainId newTerrain, int32_t newOwner);
+
+    /**
+     * @brief Gets the number of tiles an owner holds.
+     * @param ownerId The owner ID.
+     * @return The tile count.
+     */
+    uint64_t countOwnerTiles(int32_t ownerId) const;
+
+    /**
+     * @brief Gets the number of tiles of one terrain an owner holds.
+     * @param ownerId The owner ID.
+     * @param terrainId The terrain ID.
+     * @return The tile count.
+     */
+    uint64_t countOwnerTiles(int32_t ownerId, TerrainId terrainId) const;
+
+    /**
+     * @brief Gets the number of tiles of a terrain, whoever owns them.
+     * @param terrainId The terrain ID.
+     * @return The tile count.
+     */
+    uint64_t countTerrainTiles(TerrainId terrainId) const;
+
+    /**
+     * @brief Gets the tile count of every owner holding any tiles.
+     * @return The counts, ordered by owner ID.
+     */
+    std::vector<OwnerCount> getOwnerCounts() const;
+
+    /**
+     * @brief Gets the tile count of every (owner, terrain) pair holding any tiles.
+     * @return The counts, ordered by owner ID, then terrain ID.
+     */
+    std::vector<TileCount> getTileCounts() const;
+
+    /**
+     * @brief Counts the tiles of each (owner, terrain) pair inside a rectangle.
+     *
+     * Chunks inside the rectangle are read from their summaries; only the tiles of chunks
+     * cut by its edges are read, from the planes given.
+     *
+     * @param terrainIds The terrain ID of every tile, as passed to build().
+     * @param ownerIds The owner ID of every tile, as passed to build().
+     * @param firstCol The first column; clamped to the map.
+     * @param firstRow The first row; clamped to the map.
+     * @param endCol One past the last column; clamped to the map.
+     * @param endRow One past the last row; clamped to the map.
+     * @return The counts, ordered by owner ID, then terrain ID.
+     */
+    std::vector<TileCount> countRegion(const TerrainId* terrainIds, const int32_t* ownerIds,
+                                       int firstCol, int firstRow, int endCol, int endRow) const;
+
+    /**
+     * @brief Sums (owner, terrain) counts into an owner histogram.
+     * @param counts Counts ordered by owner ID, as returned by countRegion().
+     * @return The tile count of each owner, ordered by owner ID.
+     */
+    static std::vector<OwnerCount> sumByOwner(const std::vector<TileCount>& counts);
+
+    /**
+     * @brief Gets the heap memory held by the index.
+     * @return Bytes, not counting the index object itself.
+     */
+    size_t getMemoryUsage() const;
+
+private:
+    /**
+     * @struct ChunkEntry
+     * @brief Tiles of one (owner, terrain) pair inside one chunk.
+     */
+    struct ChunkEntry {
+        int32_t ownerId;     ///< Owner ID.
+        TerrainId terrainId; ///< Terrain ID.
+        uint16_t tiles;      ///< Number of tiles; a chunk holds at most CHUNK_SIZE squared.
+    };
+
+    bool built = false; ///< Whether the counts describe the map's tiles.
+    int numRows = 0; ///< Rows of the counted map.
+    int numCols = 0; ///< Columns of the counted map.
+    int chunkCols = 0; ///< Chunks per row.
+    std::vector<std::vector<ChunkEntry>> chunks; ///< Summary of each chunk, row-major; a few entries each.
+    std::unordered_map<int32_t, uint64_t> ownerTiles; ///< Tiles per owner; owners with none are removed.
+    std::unordered_map<uint64_t, uint64_t> pairTiles; ///< Tiles per (owner, terrain) pair, keyed by pairKey().
+    std::array<uint64_t, 256> terrainTiles{}; ///< Tiles per terrain ID.
+
+    /**
+     * @brief Combines an owner and a terrain into one map key.
+     * @param ownerId The owner ID.
+     * @param terrainId The terrain ID.
+     * @return The key.
+     */
+    static uint64_t pairKey(int32_t ownerId, TerrainId terrainId);
+
+    /**
+     * @brief Adds tiles of a pair to a chunk summary, dropping the entry once it reaches zero.
+     * @param entries The chunk summary.
+     * @param ownerId The owner ID.
+     * @param terrainId The terrain ID.
+     * @param delta The number of tiles to add; negative to remove.
+     */
+    static void addToChunk(std::vector<ChunkEntry>& entries, int32_t ownerId, TerrainId terrainId, int delta);
+
+    /**
+     * @brief Adds tiles of a pair to the map totals, dropping entries that reach zero.
+     * @param ownerId The owner ID.
+     * @param terrainId The terrain ID.
+     * @param delta The number of tiles to add; negative to remove.
+     */
+    void addToTotals(int32_t ownerId, TerrainId terrainId, int64_t delta);
+};
+
+#endif // TERRITORY_INDEX_H
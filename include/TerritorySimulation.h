@@ -0,0 +1,177 @@
+#ifndef TERRITORY_SIMULATION_H
+#define TERRITORY_SIMULATION_H
+
+#include "TileMap.h"
+#include "WorldGenerator.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class TerritorySimulation
+ * @brief Fixed-step simulation of factions earning resources and contesting border tiles of the world.
+ *
+ * Every owner on the world map is a faction. Each update, a faction earns the yield of
+ * every tile it owns (see GlobalSettings::getTerrainYield()). A tile bordering another
+ * faction may be captured by it: the chance grows with the number of the attacker's
+ * neighbouring tiles and its strength, and each capture costs the attacker some updates'
+ * worth of the tile's yield. Factions other than the player decide every so often whether
+ * to hold, expand against weaker neighbours, or attack anyone; the player's faction only
+ * defends until given a posture.
+ *
+ * An update reads the owner and terrain planes as they were at its start and collects
+ * captures into per-band lists, so bands of rows are contested as parallel jobs (see
+ * JobSystem). The captures are then applied in band order through TileMap::setOwnerId(),
+ * which keeps dirty tracking, revisions and the journal in step. Rolls are hashed from the
+ * world seed, tile and update count, so a world plays out the same way on any number of threads.
+ *
+ * The two halves can also be run apart: contest() only reads the map, so the game runs it as
+ * a job while it draws the map, and applyContest() writes the captures once the job is done.
+ *
+ * Large worlds are visited in a rolling window of GlobalSettings::getSimulationTilesPerTick()
+ * tiles per update, which bounds the cost of an update regardless of the world size.
+ */
+class TerritorySimulation {
+public:
+    static constexpr int32_t NEUTRAL_OWNER = WorldGenerator::INNER_OWNER; ///< Owner of unclaimed tiles; never attacks or earns.
+
+    /**
+     * @enum Posture
+     * @brief Which border tiles a faction tries to capture.
+     */
+    enum Posture : uint8_t {
+        HOLD,   ///< Capture nothing and save resources.
+        EXPAND, ///< Capture unclaimed tiles and tiles of weaker factions.
+        ATTACK  ///< Capture tiles of any neighbouring faction.
+    };
+
+    /**
+     * @struct Faction
+     * @brief The state of one owner.
+     */
+    struct Faction {
+        int32_t ownerId = 0;     ///< Owner ID of the faction's tiles.
+        bool ai = false;         ///< Whether the faction picks its own posture.
+        Posture posture = HOLD;  ///< Current posture.
+        uint8_t aggression = 0;  ///< AI trait: higher values attack with smaller reserves.
+        uint32_t strength = 1;   ///< Attack and defence multiplier, from the reserve.
+        uint64_t tiles = 0;      ///< Number of tiles owned.
+        int64_t income = 0;      ///< Resources earned per update.
+        int64_t resources = 0;   ///< Resources saved.
+    };
+
+    /**
+     * @brief Constructs an empty simulation; reset() must be called before tick().
+     */
+    TerritorySimulation() = default;
+
+    /**
+     * @brief Counts each owner's tiles and income and starts every faction with no resources.
+     * @param world The world map.
+     */
+    void reset(const TileMap& world);
+
+    /**
+     * @brief Runs one update on the world map; the same as contest() followed by applyContest().
+     * @param world The world map passed to reset().
+     */
+    void tick(TileMap& world);
+
+    /**
+     * @brief Starts an update: earns income, makes AI decisions and rolls captures without changing the map.
+     *
+     * The map may be read elsewhere meanwhile, but not written.
+     *
+     * @param world The world map passed to reset().
+     */
+    void contest(const TileMap& world);
+
+    /**
+     * @brief Finishes the update started by contest() by applying its captures. Does nothing if none was started.
+     * @param world The world map passed to contest().
+     */
+    void applyContest(TileMap& world);
+
+    /**
+     * @brief Gets every faction, ordered by owner ID.
+     * @return The factions.
+     */
+    const std::vector<Faction>& getFactions() const;
+
+    /**
+     * @brief Finds the faction of an owner.
+     * @param ownerId The owner ID.
+     * @return The faction, or nullptr if the owner has no tiles in the world.
+     */
+    const Faction* getFaction(int32_t ownerId) const;
+
+    /**
+     * @brief Sets the posture of a faction, such as the player's.
+     * @param ownerId The owner ID.
+     * @param posture The posture; AI factions replace it at their next decision.
+     */
+    void setPosture(int32_t ownerId, Posture posture);
+
+    /**
+     * @brief Gets the number of updates run since reset().
+     * @return The update count.
+     */
+    uint64_t getTickCount() const;
+
+private:
+    static constexpr int BAND_ROWS = 32; ///< Rows contested per job.
+    static constexpr size_t PARALLEL_SIMULATION_TILES = 1 << 16; ///< Smallest window worth splitting into jobs.
+    static constexpr uint32_t CAPTURE_CHANCE = 1024; ///< Capture chance out of 65536 for an overwhelming attack.
+    static constexpr int64_t CAPTURE_COST_TICKS = 60; ///< Updates of a tile's yield that capturing it costs.
+    static constexpr uint64_t DECISION_TICKS = 30; ///< Updates between AI posture decisions.
+    static constexpr uint32_t NO_FACTION = UINT32_MAX; ///< Marks an owner missing from the faction index.
+
+    /**
+     * @struct Capture
+     * @brief A successful roll, applied once every band has been contested.
+     */
+    struct Capture {
+        uint32_t index;    ///< Tile index.
+        uint32_t attacker; ///< Faction index of the attacker.
+        uint32_t defender; ///< Faction index of the tile's owner.
+    };
+
+    uint64_t seed = 0; ///< Seed of the world, for capture rolls and AI traits.
+    uint64_t ticks = 0; ///< Updates run since reset().
+    int nextRow = 0; ///< First row of the next update's window.
+    std::vector<Faction> factions; ///< Factions, ordered by owner ID.
+    std::unordered_map<int32_t, uint32_t> factionIndex; ///< Faction index by owner ID.
+    std::array<int32_t, 256> terrainYields{}; ///< Yield per terrain ID.
+    std::vector<std::vector<Capture>> bandCaptures; ///< Captures rolled by each band of the current window.
+    bool contested = false; ///< Whether contest() rolled captures that applyContest() has not applied yet.
+
+    /**
+     * @brief Picks a posture for every AI faction from its reserve and aggression.
+     */
+    void decide();
+
+    /**
+     * @brief Rolls captures for every border tile in a band of rows.
+     * @param world The world map.
+     * @param firstRow The first row of the band.
+     * @param endRow One past the last row of the band.
+     * @param captures Output list receiving the band's captures in tile order.
+     */
+    void contestRows(const TileMap& world, int firstRow, int endRow, std::vector<Capture>& captures) const;
+
+    /**
+     * @brief Applies the rolled captures that attackers can still pay for.
+     * @param world The world map.
+     */
+    void applyCaptures(TileMap& world);
+
+    /**
+     * @brief Looks up the faction index of an owner.
+     * @param ownerId The owner ID.
+     * @return The index, or NO_FACTION.
+     */
+    uint32_t findFaction(int32_t ownerId) const;
+};
+
+#endif // TERRITORY_SIMULATION_H
@@ -3,48 +3,236 @@
 
 #include "Tile.h"
 #include "GlobalSettings.h"
+#include "TerrainRegistry.h"
+#include "MapFormat.h"
+#include "MappedFile.h"
+#include "WorldArchive.h"
+#include "PackedTileMap.h"
+#include "TerritoryIndex.h"
+#include "Camera.h"
 #include <vector>
 #include <string>
 #include <random>
 #include <fstream>
+#include <iosfwd>
+#include <optional>
 #include <memory>
 
 /**
  * @class TileMap
  * @brief Manages a grid of tiles, including generation, retrieval, saving, and loading.
+ *
+ * Tile data is stored as a dense row-major structure of arrays: one terrain ID, one
+ * owner ID and one flag byte per tile. A tile's grid position is derived from its
+ * index (index = row * numCols + col).
+ *
+ * The arrays either live on the heap or, after openMapped(), point directly into a
+ * memory-mapped map file so that large worlds are served without copying.
  */
 class TileMap {
 public:
+    static constexpr int CHUNK_SIZE = 32; ///< Width and height of a world chunk in tiles.
+
     /**
      * @brief Constructs a TileMap and initializes settings from global configurations.
      */
     TileMap();
 
     /**
-     * @brief Generates a grid of tiles with random textures.
+     * @brief Copies a map. A copy of a memory-mapped map is a heap-backed snapshot.
+     * @param other The map to copy.
+     */
+    TileMap(const TileMap& other);
+
+    /**
+     * @brief Copies a map into this one. See the copy constructor.
+     * @param other The map to copy.
+     * @return Reference to this map.
+     */
+    TileMap& operator=(const TileMap& other);
+
+    /**
+     * @brief Moves a map, including any file mapping.
+     * @param other The map to move from; left empty.
+     */
+    TileMap(TileMap&& other) noexcept;
+
+    /**
+     * @brief Moves a map into this one, including any file mapping.
+     * @param other The map to move from; left empty.
+     * @return Reference to this map.
+     */
+    TileMap& operator=(TileMap&& other) noexcept;
+
+    /**
+     * @brief Restores a map packed by pack(), with the same revisions and unsaved changes.
+     * @param packed The packed map.
+     */
+    explicit TileMap(const PackedTileMap& packed);
+
+    /**
+     * @brief Packs the tiles compactly, for keeping a map resident while it is not shown.
+     * @return The packed map; this map is left unchanged.
+     */
+    PackedTileMap pack() const;
+
+    /**
+     * @brief Generates a grid of tiles from a seed with WorldGenerator.
+     *
+     * The same seed, size and terrains always give the same tiles. Large maps are
+     * generated on several threads.
+     *
      * @param numRows The number of rows in the tile grid.
      * @param numCols The number of columns in the tile grid.
      * @param tileSize The size of each tile in pixels.
-     * @param textures A list of texture aliases used for tile generation.
+     * @param terrains A list of terrain IDs used for tile generation.
+     * @param seed The seed to generate from; stored with the map.
+     * @param isInner True for an inner map, whose tiles all belong to WorldGenerator::INNER_OWNER.
+     */
+    void generateTiles(int numRows, int numCols, int tileSize, const std::vector<TerrainId>& terrains, uint64_t seed, bool isInner = false);
+
+    /**
+     * @brief Gets the seed the map was generated from.
+     * @return The seed, or 0 for maps saved before seeds were stored.
+     */
+    uint64_t getWorldSeed() const;
+
+    /**
+     * @brief Gets the number of rows in the grid.
+     * @return The row count.
+     */
+    int getNumRows() const;
+
+    /**
+     * @brief Gets the number of columns in the grid.
+     * @return The column count.
      */
-    void generateTiles(int numRows, int numCols, int tileSize, const std::vector<std::string>& textures, bool isInner = false);
+    int getNumCols() const;
 
     /**
-     * @brief Gets the list of all tiles in the map.
-     * @return A constant reference to the vector of shared tile pointers.
+     * @brief Gets the size of each tile in pixels.
+     * @return The tile size.
      */
-    const std::vector<std::shared_ptr<Tile>>& getTileMap() const;
+    int getTileSize() const;
+
+    /**
+     * @brief Gets the number of tiles in the grid.
+     * @return The tile count (numRows * numCols).
+     */
+    size_t getTileCount() const;
+
+    /**
+     * @brief Gets the terrain ID (see TerrainRegistry) of every tile, in row-major order.
+     * @return A pointer to getTileCount() terrain IDs.
+     */
+    const TerrainId* getTerrainIds() const;
+
+    /**
+     * @brief Gets the owner ID of every tile, in row-major order.
+     * @return A pointer to getTileCount() owner IDs.
+     */
+    const int32_t* getOwnerIds() const;
+
+    /**
+     * @brief Gets the state bits of every tile, in row-major order.
+     * @return A pointer to getTileCount() flag bytes.
+     */
+    const uint8_t* getTileFlags() const;
 
     /**
      * @brief Retrieves a tile at specific pixel coordinates.
      * @param x The x-coordinate in pixels.
      * @param y The y-coordinate in pixels.
-     * @return A shared pointer to the tile at the given coordinates, or nullptr if out of bounds.
+     * @return A view of the tile at the given coordinates, or std::nullopt if out of bounds.
+     */
+    std::optional<Tile> getTileAt(int x, int y) const;
+
+    /**
+     * @brief Retrieves the tile under a screen position, translating through a camera.
+     * @param screenX The x-coordinate on screen.
+     * @param screenY The y-coordinate on screen.
+     * @param camera The camera the map is viewed through.
+     * @return A view of the tile under the position, or std::nullopt if out of bounds.
+     */
+    std::optional<Tile> getTileAt(int screenX, int screenY, const Camera& camera) const;
+
+    /**
+     * @brief Retrieves a tile at specific grid coordinates.
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @return A view of the tile, or std::nullopt if out of bounds.
      */
-    const std::shared_ptr<Tile> getTileAt(int x, int y) const;
+    std::optional<Tile> getTile(int col, int row) const;
 
     /**
-     * @brief Saves the tile map to a binary file.
+     * @brief Changes the owner of a tile and marks it dirty.
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @param ownerId The new owner's ID.
+     */
+    void setOwnerId(int col, int row, int32_t ownerId);
+
+    /**
+     * @brief Changes the terrain of a tile and marks it dirty.
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @param terrainId The new terrain ID.
+     */
+    void setTerrainId(int col, int row, TerrainId terrainId);
+
+    /**
+     * @brief Overwrites one tile with previously saved values without counting it as an unsaved change.
+     *
+     * Used to replay saved changes onto a freshly generated map. Ignored for mapped maps,
+     * whose file already holds their tiles.
+     *
+     * @param index The index of the tile (row * numCols + col).
+     * @param terrainId The saved terrain ID.
+     * @param ownerId The saved owner ID.
+     * @param flags The saved state bits.
+     */
+    void restoreTile(size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags);
+
+    /**
+     * @brief Sets a tile's whole state as a change, like the setters do, for replaying a journal.
+     *
+     * Unlike restoreTile(), this works on mapped maps and leaves the tile unsaved.
+     *
+     * @param index The tile index (row * numCols + col).
+     * @param terrainId The terrain ID.
+     * @param ownerId The owner ID.
+     * @param flags The state bits; TILE_FLAG_DIRTY is always set.
+     */
+    void replayTile(size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags);
+
+    /**
+     * @brief Starts or stops recording which tiles change, so they can be journaled.
+     *
+     * Moving a map keeps its recording; copies and packed maps do not record.
+     *
+     * @param enabled True to record changed tiles.
+     */
+    void setChangeTracking(bool enabled);
+
+    /**
+     * @brief Takes the tiles changed since the last call while change tracking was on.
+     * @return Indexes of the changed tiles, ascending and without duplicates.
+     */
+    std::vector<uint32_t> takeChangedTiles();
+
+    /**
+     * @brief Treats every tile as saved, after a copy of a heap-backed map was queued for saving.
+     *
+     * Mapped maps are unaffected; flush() writes them back instead.
+     */
+    void markSaved();
+
+    /**
+     * @brief Saves the tile map to a binary file in the format described in MapFormat.h.
+     *
+     * The map is written to a temporary file that then replaces the old one, so a
+     * failed or interrupted save never leaves a partly written map behind.
+     *
      * @param filename The name of the file to save to.
      * @param mapPathPrefix The path prefix where the file should be saved.
      */
@@ -52,16 +240,245 @@ public:
 
     /**
      * @brief Loads a tile map from a binary file. If the file is missing, generates a new map.
+     *
+     * Files in the original per-tile format are still accepted. A corrupt file is renamed
+     * with a ".corrupt" suffix before a new map is generated and saved in its place.
+     *
      * @param filename The name of the file to load from.
      * @param mapPathPrefix The path prefix where the file is located.
      */
     void loadFromFile(const std::string& filename, const std::string& mapPathPrefix);
 
+    /**
+     * @brief Reads a map file in either format, without generating a replacement when it fails.
+     * @param fullPath The path of the file to read.
+     * @return True if the map was loaded, false if the file is missing or invalid.
+     */
+    bool importFile(const std::string& fullPath);
+
+    /**
+     * @brief Saves the tile map as an entry of a world archive, in the format described in MapFormat.h.
+     *
+     * A map that is mapped from that same entry is flushed instead.
+     *
+     * @param archive The archive to write to.
+     * @param key The entry to write.
+     * @param mappable True to store the entry uncompressed so openMapped() can map it later;
+     *        false to compress it.
+     * @return True if the map was saved, false otherwise.
+     */
+    bool saveToArchive(WorldArchive& archive, const WorldArchive::Key& key, bool mappable) const;
+
+    /**
+     * @brief Loads a tile map from an entry of a world archive.
+     * @param archive The archive to read from.
+     * @param key The entry to read.
+     * @return True if the map was loaded, false if the entry is missing or invalid.
+     */
+    bool loadFromArchive(WorldArchive& archive, const WorldArchive::Key& key);
+
+    /**
+     * @brief Maps a map file into memory and serves tiles directly from the mapped pages.
+     *
+     * Nothing is copied; pages are read on first access. Tile checksums are not verified,
+     * since that would touch every page. Fails for legacy files, older format versions and
+     * files written with a different terrain set, in which case loadFromFile() should be used instead.
+     *
+     * @param filename The name of the file to map.
+     * @param mapPathPrefix The path prefix where the file is located.
+     * @param writable True to allow tile changes to be written back to the file.
+     * @return True if the file was mapped, false otherwise.
+     */
+    bool openMapped(const std::string& filename, const std::string& mapPathPrefix, bool writable = true);
+
+    /**
+     * @brief Maps an archive entry stored as mappable into memory, like openMapped() does for a file.
+     * @param archive The archive holding the entry.
+     * @param key The entry to map.
+     * @param writable True to allow tile changes to be written back to the archive in place.
+     * @return True if the entry was mapped, false otherwise.
+     */
+    bool openMapped(WorldArchive& archive, const WorldArchive::Key& key, bool writable = true);
+
+    /**
+     * @brief Gets the heap memory held by the map.
+     *
+     * Pages of a mapped file are not counted; the OS can drop them at any time.
+     *
+     * @return Bytes, including the map object itself.
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Checks whether tiles are served from a memory-mapped file.
+     * @return True if mapped, false if the tiles live on the heap.
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief Checks whether tiles changed since the map was loaded, saved or flushed.
+     * @return True if there are changes that are not on disk yet.
+     */
+    bool hasUnsavedChanges() const;
+
+    /**
+     * @brief Gets a number that changes whenever tiles are changed, loaded or generated.
+     *
+     * Revisions are unique across all maps, so a cache keyed by revision never
+     * mistakes one map for another. A moved or copied map keeps its revision.
+     *
+     * @return The current revision.
+     */
+    uint64_t getRevision() const;
+
+    /**
+     * @brief Gets the revision of the last change inside one chunk.
+     *
+     * Like getRevision(), but only changes when a tile in the given CHUNK_SIZE square
+     * changes (or the whole map is replaced), so caches can redraw just the chunks
+     * that changed.
+     *
+     * @param chunkCol The chunk column.
+     * @param chunkRow The chunk row.
+     * @return The chunk's revision, or 0 if the chunk is outside the map.
+     */
+    uint64_t getChunkRevision(int chunkCol, int chunkRow) const;
+
+    /**
+     * @brief Gets the tile counts per owner and terrain, building them on first use.
+     *
+     * The first call after the tiles are generated, loaded or mapped counts every tile
+     * (paging in a mapped map); afterwards every tile change keeps the counts current, so
+     * reading them never rescans the map. Not safe to call while another thread uses the map.
+     *
+     * @return The index.
+     */
+    const TerritoryIndex& getTerritoryIndex() const;
+
+    /**
+     * @brief Counts the tiles of each (owner, terrain) pair inside a rectangle of tiles.
+     *
+     * Costs one summary per chunk covered plus the tiles of the chunks cut by the
+     * rectangle's edges. See TerritoryIndex::sumByOwner() for an owner histogram.
+     *
+     * @param firstCol The first column; clamped to the map.
+     * @param firstRow The first row; clamped to the map.
+     * @param endCol One past the last column; clamped to the map.
+     * @param endRow One past the last row; clamped to the map.
+     * @return The counts, ordered by owner ID, then terrain ID.
+     */
+    std::vector<TerritoryIndex::TileCount> countRegion(int firstCol, int firstRow, int endCol, int endRow) const;
+
+    /**
+     * @brief Writes tiles changed since the last flush back to the mapped file (msync).
+     * @return True on success or if the map is not mapped, false otherwise.
+     */
+    bool flush() const;
+
+    /**
+     * @brief Pages in the mapped data for a run of consecutive tiles on the calling thread.
+     *
+     * Does nothing for heap-backed maps, whose tiles are always resident.
+     *
+     * @param firstIndex The index of the first tile.
+     * @param count The number of tiles.
+     */
+    void prefetchTiles(size_t firstIndex, size_t count) const;
+
+    /**
+     * @brief Lets the OS drop the mapped pages that hold only tiles from a run.
+     *
+     * Changed tiles are written back first. Does nothing for heap-backed maps.
+     *
+     * @param firstIndex The index of the first tile.
+     * @param count The number of tiles.
+     */
+    void releaseTiles(size_t firstIndex, size_t count) const;
+
 private:
-    std::vector<std::shared_ptr<Tile>> tileMap; ///< Stores the tile objects in the map.
+    std::vector<TerrainId> terrainStore; ///< Heap storage for terrain IDs when not mapped.
+    std::vector<int32_t> ownerStore; ///< Heap storage for owner IDs when not mapped.
+    std::vector<uint8_t> flagStore; ///< Heap storage for tile flags when not mapped.
+    TerrainId* terrainIds = nullptr; ///< Terrain ID of each tile (heap or mapped).
+    int32_t* ownerIds = nullptr; ///< Owner ID of each tile (heap or mapped).
+    uint8_t* tileFlags = nullptr; ///< State bits of each tile (heap or mapped).
+    size_t tileCount = 0; ///< Number of tiles in the grid.
+
+    std::unique_ptr<MappedFile> mappedFile; ///< Backing file mapping, if any.
+    MapFileHeader mappedHeader{}; ///< Header of the mapped file.
+    mutable size_t dirtyBegin = 0; ///< First tile index changed since the last save or flush.
+    mutable size_t dirtyEnd = 0; ///< One past the last tile index changed since the last save or flush.
+
+    uint64_t revision = 0; ///< Changes with every tile change; see getRevision().
+    std::vector<uint64_t> chunkRevisions; ///< Revision of the last change in each chunk, row-major.
+    int chunkCols = 0; ///< Number of chunk columns in chunkRevisions.
     int numRows = 0; ///< Number of rows in the tile grid.
     int numCols = 0; ///< Number of columns in the tile grid.
     int TILE_SIZE = 0; ///< Size of each tile in pixels.
+    uint64_t worldSeed = 0; ///< Seed the tiles were generated from.
+    bool trackChanges = false; ///< Whether changed tiles are recorded in changedTiles.
+    std::vector<uint32_t> changedTiles; ///< Tiles changed since the last takeChangedTiles(), unsorted.
+    mutable TerritoryIndex territoryIndex; ///< Tile counts; built on first use, cleared when the tiles are replaced.
+
+    /**
+     * @brief Resizes the tile arrays for the given dimensions and clears their contents.
+     * @param rows The number of rows.
+     * @param cols The number of columns.
+     */
+    void resize(int rows, int cols);
+
+    /**
+     * @brief Points the tile arrays at the heap stores and drops any file mapping.
+     */
+    void bindHeapPlanes();
+
+    /**
+     * @brief Sizes the chunk revision grid for the current dimensions and sets every entry to the map revision.
+     *
+     * Called whenever the tiles are replaced as a whole, so it also clears the territory index.
+     */
+    void resetChunkRevisions();
+
+    /**
+     * @brief Records a tile change: sets its dirty flag and tracks it for flush().
+     * @param index The index of the changed tile.
+     * @return False if the map is mapped read-only and cannot be changed.
+     */
+    bool markDirty(size_t index);
+
+    /**
+     * @brief Gives the map and the chunk holding a tile a new revision after the tile changed.
+     * @param index The index of the changed tile.
+     */
+    void bumpRevision(size_t index);
+
+    /**
+     * @brief Writes the map in the current format.
+     * @param out The stream to write to.
+     * @return True if every byte was written, false otherwise.
+     */
+    bool writeMapFile(std::ostream& out) const;
+
+    /**
+     * @brief Reads a map file in the current format.
+     * @param file The open stream, positioned at the start of the map.
+     * @return True if the map was read and its checksums match, false otherwise.
+     */
+    bool readMapFile(std::istream& file);
+
+    /**
+     * @brief Reads a map file in the original per-tile format.
+     * @param file The open stream, positioned at the start of the map.
+     * @return True if the map was read successfully, false otherwise.
+     */
+    bool readLegacyMapFile(std::istream& file);
+
+    /**
+     * @brief Serves the tiles from a mapped map file image, after validating it.
+     * @param file The mapping; its data starts with a map header.
+     * @return True if the mapping holds a current-format map that can be used in place.
+     */
+    bool bindMapping(std::unique_ptr<MappedFile> file);
 };
 
 #endif // TILEMAP_H
@@ -0,0 +1,78 @@
+#ifndef UNIT_SYSTEM_H
+#define UNIT_SYSTEM_H
+
+#include "EntityRegistry.h"
+#include "TileMap.h"
+#include <array>
+#include <cstdint>
+
+/**
+ * @class UnitSystem
+ * @brief Fixed-step behaviour of the units in an EntityRegistry: placing them and moving them about the world.
+ *
+ * Every update walks the packed Movement components once. A unit steps one tile at a time
+ * towards its destination, along the longer axis first, and waits STEP_TICKS updates per
+ * point of the entered tile's move cost (see GlobalSettings::getTerrainMoveCost()); 0 is
+ * impassable. A unit that arrives or is blocked picks a new destination near it: soldiers
+ * only within their faction's territory, scouts anywhere passable. Picks are hashed from
+ * the world seed, entity and update count, so a world plays out the same way every time.
+ */
+class UnitSystem {
+public:
+    static constexpr int STEP_TICKS = 10; ///< Updates per point of move cost between steps.
+    static constexpr int PATROL_RADIUS = 12; ///< Furthest a soldier's destination is from where it picks it, per axis.
+    static constexpr int SCOUT_RADIUS = 32; ///< Furthest a scout's destination is from where it picks it, per axis.
+
+    /**
+     * @brief Constructs a system with no map; reset() must be called before tick().
+     */
+    UnitSystem() = default;
+
+    /**
+     * @brief Reads the move costs and seed of a world and restarts the update count.
+     * @param world The world map.
+     */
+    void reset(const TileMap& world);
+
+    /**
+     * @brief Places units for every faction on passable tiles it owns: a fort, then soldiers with every fourth a scout.
+     * @param entities The registry receiving the units.
+     * @param world The world map passed to reset().
+     * @param perFaction Units per faction.
+     * @return The number of units placed; fewer if factions own too few passable tiles.
+     */
+    size_t spawnStartingUnits(EntityRegistry& entities, const TileMap& world, int perFaction);
+
+    /**
+     * @brief Runs one update, moving every mobile entity.
+     * @param entities The registry whose entities move.
+     * @param world The world map passed to reset().
+     */
+    void tick(EntityRegistry& entities, const TileMap& world);
+
+private:
+    uint64_t seed = 0; ///< Seed of the world, for destination picks.
+    uint64_t ticks = 0; ///< Updates run since reset().
+    std::array<uint8_t, 256> moveCosts{}; ///< Move cost per terrain ID; 0 is impassable.
+
+    /**
+     * @brief Picks a destination near an entity's tile, or its own tile if the pick is not allowed.
+     * @param entity The entity.
+     * @param unit The entity's unit, or nullptr.
+     * @param from The entity's tile.
+     * @param world The world map.
+     * @param movement Receives the destination.
+     */
+    void pickDestination(EntityId entity, const Unit* unit, const Position& from, const TileMap& world, Movement& movement) const;
+
+    /**
+     * @brief Checks whether a tile can be entered.
+     * @param world The world map.
+     * @param col The column.
+     * @param row The row.
+     * @return True if the tile is on the map and passable.
+     */
+    bool isPassable(const TileMap& world, int col, int row) const;
+};
+
+#endif // UNIT_SYSTEM_H
@@ -0,0 +1,164 @@
+#ifndef VISIBILITY_LAYER_H
+#define VISIBILITY_LAYER_H
+
+#include "TileMap.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class VisibilityLayer
+ * @brief Fog of war: which world tiles each viewing faction sees now and has ever seen.
+ *
+ * Every viewer has three bitsets aligned to the map's rows, 64 tiles per word: the tiles
+ * it owns, the tiles it sees (its territory grown by GlobalSettings::getVisionRadius() in
+ * every direction) and the tiles it has explored (seen at any time since setViewers()).
+ *
+ * update() compares the map's chunk revisions with the last update, so only changed chunks
+ * are rescanned for ownership. Vision is then recomputed for the rows those chunks can reach:
+ * ORing the owned rows within the radius, then spreading each row sideways with word shifts.
+ * Bands of chunk rows run as parallel jobs (see JobSystem).
+ *
+ * Like TileMap, the layer keeps a revision per chunk that changes whenever what any viewer
+ * sees in that chunk changes, so renderers can redraw only those chunks.
+ */
+class VisibilityLayer {
+public:
+    /**
+     * @brief Constructs a layer with no viewers.
+     */
+    VisibilityLayer() = default;
+
+    /**
+     * @brief Sets the factions that see through the layer and forgets what they explored.
+     * @param ownerIds The owner ID of each viewer.
+     */
+    void setViewers(const std::vector<int32_t>& ownerIds);
+
+    /**
+     * @brief Brings vision up to date with the world's ownership.
+     *
+     * The first call, or a call with a different map, recomputes everything; later calls
+     * only the rows near chunks whose revision changed.
+     *
+     * @param world The world map.
+     */
+    void update(const TileMap& world);
+
+    /**
+     * @brief Checks whether a viewer sees a tile.
+     * @param ownerId The viewer's owner ID.
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @return True if the tile is seen; false if it is not, is outside the map, or the owner is not a viewer.
+     */
+    bool isVisible(int32_t ownerId, int col, int row) const;
+
+    /**
+     * @brief Checks whether a viewer has ever seen a tile.
+     * @param ownerId The viewer's owner ID.
+     * @param col The column of the tile.
+     * @param row The row of the tile.
+     * @return True if the tile was seen since setViewers(), false otherwise.
+     */
+    bool isExplored(int32_t ownerId, int col, int row) const;
+
+    /**
+     * @brief Gets a viewer's visible bitset: bit (col % 64) of word row * getWordsPerRow() + col / 64.
+     * @param ownerId The viewer's owner ID.
+     * @return The bits, or nullptr if the owner is not a viewer or nothing was updated yet.
+     */
+    const uint64_t* getVisibleBits(int32_t ownerId) const;
+
+    /**
+     * @brief Gets a viewer's explored bitset, laid out like getVisibleBits().
+     * @param ownerId The viewer's owner ID.
+     * @return The bits, or nullptr if the owner is not a viewer or nothing was updated yet.
+     */
+    const uint64_t* getExploredBits(int32_t ownerId) const;
+
+    /**
+     * @brief Gets the number of 64-bit words per map row in each bitset.
+     * @return The word count.
+     */
+    size_t getWordsPerRow() const;
+
+    /**
+     * @brief Gets the number of rows the bitsets cover.
+     * @return The row count of the last updated map.
+     */
+    int getNumRows() const;
+
+    /**
+     * @brief Gets the number of columns the bitsets cover.
+     * @return The column count of the last updated map.
+     */
+    int getNumCols() const;
+
+    /**
+     * @brief Gets a number that changes whenever any viewer's vision changes.
+     * @return The current revision.
+     */
+    uint64_t getRevision() const;
+
+    /**
+     * @brief Gets the revision of the last vision change inside one TileMap::CHUNK_SIZE square.
+     * @param chunkCol The chunk column.
+     * @param chunkRow The chunk row.
+     * @return The chunk's revision, or 0 if the chunk is outside the map.
+     */
+    uint64_t getChunkRevision(int chunkCol, int chunkRow) const;
+
+private:
+    static constexpr int CHUNK = TileMap::CHUNK_SIZE; ///< Chunk width and height in tiles; half a word.
+    static constexpr int MAX_RADIUS = 63; ///< Largest vision radius; sideways spreading shifts within one word.
+
+    /**
+     * @struct Viewer
+     * @brief The bitsets of one viewing faction.
+     */
+    struct Viewer {
+        int32_t ownerId = 0;           ///< Owner ID of the faction.
+        std::vector<uint64_t> owned;   ///< Tiles the faction owns.
+        std::vector<uint64_t> visible; ///< Tiles the faction sees.
+        std::vector<uint64_t> explored; ///< Tiles the faction has seen.
+    };
+
+    std::vector<Viewer> viewers; ///< Viewing factions.
+    int numRows = 0; ///< Rows of the map the bitsets describe.
+    int numCols = 0; ///< Columns of the map the bitsets describe.
+    size_t wordsPerRow = 0; ///< Words per row in each bitset.
+    int chunkCols = 0; ///< Chunks per row.
+    int chunkRows = 0; ///< Chunks per column.
+    int radius = 0; ///< Vision radius in tiles.
+    uint64_t worldSeed = 0; ///< Seed of the map, to notice a different map.
+    bool built = false; ///< Whether the bitsets describe a map.
+    uint64_t revision = 0; ///< Bumped with every vision change; never reset, so old revisions are not reused.
+    std::vector<uint64_t> chunkRevisions; ///< Revision of the last vision change in each chunk.
+    std::vector<uint64_t> mapChunkRevisions; ///< Map chunk revisions the owned bits were read from.
+    std::vector<uint8_t> bandOwnedChanged; ///< Per chunk row: whether its owned bits were rescanned this update.
+    std::vector<uint8_t> chunkVisionChanged; ///< Per chunk: whether its vision changed this update.
+
+    /**
+     * @brief Rescans ownership in the changed chunks of one band of chunk rows.
+     * @param world The world map.
+     * @param band The chunk row.
+     * @param changedChunks Per chunk of the band: whether it changed.
+     */
+    void scanOwned(const TileMap& world, int band, const uint8_t* changedChunks);
+
+    /**
+     * @brief Recomputes vision for the rows of one chunk row, recording the chunks whose vision changed.
+     * @param band The chunk row.
+     */
+    void updateVision(int band);
+
+    /**
+     * @brief Finds a viewer.
+     * @param ownerId The owner ID.
+     * @return The viewer, or nullptr.
+     */
+    const Viewer* findViewer(int32_t ownerId) const;
+};
+
+#endif // VISIBILITY_LAYER_H
@@ -0,0 +1,389 @@
+#ifndef WORLD_ARCHIVE_H
+#define WORLD_ARCHIVE_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file WorldArchive.h
+ * @brief Single-file archive holding a world map and everything saved for its inner maps.
+ *
+ * An archive is laid out as follows (all integers little-endian):
+ *
+ *   ArchiveHeader                 64 bytes
+ *   records, back to back:
+ *     ArchiveRecordHeader         48 bytes
+ *     payload                     storedSize bytes
+ *   ...
+ *
+ * Every write appends a record; nothing already written is overwritten, except the
+ * header and the payload of a mapped entry changed in place. The last record for a
+ * key wins, and a REMOVE record deletes the key. On close the full index is appended
+ * as an INDEX record and the header is pointed at it, so the next open reads one
+ * index and scans only the records written after it. Records after a crash are
+ * recovered by that scan, and a torn record at the end is cut off.
+ *
+ * Mappable entries are stored uncompressed, with their payload aligned to
+ * ARCHIVE_MAP_ALIGNMENT, so a map can be memory-mapped straight out of the archive.
+ * Padding before them is a PAD record.
+ */
+
+static constexpr uint32_t ARCHIVE_MAGIC = 0x52414757; ///< "WGAR" read as a little-endian uint32.
+static constexpr uint32_t ARCHIVE_RECORD_MAGIC = 0x43524757; ///< "WGRC"; starts every record.
+static constexpr uint16_t ARCHIVE_VERSION = 1; ///< Current archive format version.
+static constexpr uint64_t ARCHIVE_MAP_ALIGNMENT = 1u << 16; ///< Payload alignment of mappable entries; a multiple of every page size.
+
+/**
+ * @enum ArchiveCodec
+ * @brief How a payload is stored.
+ */
+enum ArchiveCodec : uint32_t {
+    ARCHIVE_CODEC_NONE = 0, ///< Stored as is.
+    ARCHIVE_CODEC_LZ = 1    ///< Compressed with compressBlock() (see Compression.h).
+};
+
+/**
+ * @enum ArchiveRecordType
+ * @brief What a record holds.
+ */
+enum ArchiveRecordType : uint32_t {
+    ARCHIVE_RECORD_ENTRY = 0,    ///< The payload of a key.
+    ARCHIVE_RECORD_MAPPABLE = 1, ///< An uncompressed, aligned payload that may be mapped and changed in place.
+    ARCHIVE_RECORD_REMOVE = 2,   ///< Deletes a key; no payload.
+    ARCHIVE_RECORD_PAD = 3,      ///< Padding before an aligned payload.
+    ARCHIVE_RECORD_INDEX = 4     ///< A checkpoint of the index, as ArchiveIndexEntry items.
+};
+
+/**
+ * @struct ArchiveHeader
+ * @brief Fixed-size header at the start of every archive.
+ */
+struct ArchiveHeader {
+    uint32_t magic;        ///< Always ARCHIVE_MAGIC.
+    uint16_t version;      ///< Format version the archive was written with.
+    uint16_t headerSize;   ///< Size of this header in bytes.
+    uint64_t indexOffset;  ///< Offset of the last INDEX record, or 0 if there is none.
+    uint64_t scanOffset;   ///< Offset just past that INDEX record; later records are scanned on open.
+    uint64_t reserved[4];  ///< Always zero.
+    uint32_t flags;        ///< Always zero.
+    uint32_t headerCrc;    ///< CRC-32 of this header with headerCrc zeroed.
+};
+
+/**
+ * @struct ArchiveRecordHeader
+ * @brief Header in front of every record.
+ */
+struct ArchiveRecordHeader {
+    uint32_t magic;      ///< Always ARCHIVE_RECORD_MAGIC.
+    uint32_t type;       ///< What the record holds (see ArchiveRecordType).
+    int32_t x;           ///< First part of the key; the column of an inner map's parent tile.
+    int32_t y;           ///< Second part of the key; the row of an inner map's parent tile.
+    int32_t depth;       ///< Third part of the key; 0 for the world, 1 for inner maps.
+    uint32_t codec;      ///< How the payload is stored (see ArchiveCodec).
+    uint64_t storedSize; ///< Size of the payload in the archive.
+    uint64_t rawSize;    ///< Size of the payload once decoded.
+    uint32_t payloadCrc; ///< CRC-32 of the stored payload; not checked for mappable payloads.
+    uint32_t headerCrc;  ///< CRC-32 of this header with headerCrc zeroed.
+};
+
+/**
+ * @struct ArchiveIndexEntry
+ * @brief One live key in an INDEX record.
+ */
+struct ArchiveIndexEntry {
+    int32_t x;           ///< First part of the key.
+    int32_t y;           ///< Second part of the key.
+    int32_t depth;       ///< Third part of the key.
+    uint32_t type;       ///< ARCHIVE_RECORD_ENTRY or ARCHIVE_RECORD_MAPPABLE.
+    uint64_t offset;     ///< Offset of the record header.
+    uint64_t storedSize; ///< Size of the payload in the archive.
+    uint64_t rawSize;    ///< Size of the payload once decoded.
+    uint32_t codec;      ///< How the payload is stored.
+    uint32_t payloadCrc; ///< CRC-32 of the stored payload.
+};
+
+static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader must stay 64 bytes");
+static_assert(sizeof(ArchiveRecordHeader) == 48, "ArchiveRecordHeader must stay 48 bytes");
+static_assert(sizeof(ArchiveIndexEntry) == 48, "ArchiveIndexEntry must stay 48 bytes");
+
+/**
+ * @class WorldArchive
+ * @brief Reads, appends and compacts the entries of one world archive file.
+ *
+ * Entries are keyed by (x, y, depth): the world map is (0, 0, DEPTH_WORLD) and an inner
+ * map is (parent column, parent row, DEPTH_INNER). Every method is thread-safe.
+ */
+class WorldArchive {
+public:
+    static constexpr int32_t DEPTH_WORLD = 0; ///< Depth of the world map entry.
+    static constexpr int32_t DEPTH_INNER = 1; ///< Depth of inner map entries.
+
+    /**
+     * @struct Key
+     * @brief Identifies an entry.
+     */
+    struct Key {
+        int32_t x;     ///< Column of the parent tile, or 0 for the world.
+        int32_t y;     ///< Row of the parent tile, or 0 for the world.
+        int32_t depth; ///< DEPTH_WORLD or DEPTH_INNER.
+
+        bool operator==(const Key& other) const {
+            return x == other.x && y == other.y && depth == other.depth;
+        }
+    };
+
+    static constexpr Key WORLD_KEY{0, 0, DEPTH_WORLD}; ///< Key of the world map entry.
+
+    /**
+     * @enum StoreMode
+     * @brief How write() stores a payload.
+     */
+    enum StoreMode {
+        STORE_RAW,        ///< Uncompressed.
+        STORE_COMPRESSED, ///< Compressed when that makes it smaller.
+        STORE_MAPPABLE    ///< Uncompressed and aligned, so it can be memory-mapped.
+    };
+
+    /**
+     * @struct EntryInfo
+     * @brief Where and how an entry is stored.
+     */
+    struct EntryInfo {
+        uint32_t type;          ///< ARCHIVE_RECORD_ENTRY or ARCHIVE_RECORD_MAPPABLE.
+        uint64_t offset;        ///< Offset of the record header.
+        uint64_t storedSize;    ///< Size of the payload in the archive.
+        uint64_t rawSize;       ///< Size of the payload once decoded.
+        uint32_t codec;         ///< How the payload is stored.
+        uint32_t payloadCrc;    ///< CRC-32 of the stored payload.
+
+        /**
+         * @brief Gets the offset of the payload.
+         * @return The byte offset just past the record header.
+         */
+        uint64_t payloadOffset() const { return offset + sizeof(ArchiveRecordHeader); }
+    };
+
+    /**
+     * @brief Constructs a closed archive.
+     */
+    WorldArchive() = default;
+
+    /**
+     * @brief Closes the archive, writing an index checkpoint.
+     */
+    ~WorldArchive();
+
+    WorldArchive(const WorldArchive&) = delete;
+    WorldArchive& operator=(const WorldArchive&) = delete;
+
+    /**
+     * @brief Opens an archive, creating it if it does not exist.
+     *
+     * An archive mostly made of replaced entries is compacted first, so this must not be
+     * called while an entry of the file is memory-mapped.
+     *
+     * @param path The path of the archive file.
+     * @param truncate True to start a new, empty archive even if the file exists.
+     * @return True if the archive is usable, false otherwise.
+     */
+    bool open(const std::string& path, bool truncate = false);
+
+    /**
+     * @brief Writes an index checkpoint and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Writes an index checkpoint if entries changed since the last one, keeping the archive open.
+     * @return True if every entry written so far is on disk and indexed, false otherwise.
+     */
+    bool sync();
+
+    /**
+     * @brief Checks whether an archive is open.
+     * @return True if open, false otherwise.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Gets the path of the archive file.
+     * @return The path passed to open().
+     */
+    const std::string& getPath() const;
+
+    /**
+     * @brief Checks whether an entry exists. Never touches the disk.
+     * @param key The entry.
+     * @return True if the entry exists.
+     */
+    bool contains(const Key& key) const;
+
+    /**
+     * @brief Looks up where an entry is stored. Never touches the disk.
+     * @param key The entry.
+     * @param info Output parameter receiving the entry's location.
+     * @return True if the entry exists.
+     */
+    bool getEntryInfo(const Key& key, EntryInfo& info) const;
+
+    /**
+     * @brief Reads and decodes an entry's payload.
+     * @param key The entry.
+     * @param data Output parameter receiving the payload.
+     * @return True if the entry exists and was read intact, false otherwise.
+     */
+    bool read(const Key& key, std::vector<char>& data);
+
+    /**
+     * @brief Appends a new payload for an entry, replacing any earlier one.
+     * @param key The entry.
+     * @param data The payload.
+     * @param size The size of the payload.
+     * @param mode How to store the payload.
+     * @return True if the payload is on disk, false otherwise.
+     */
+    bool write(const Key& key, const char* data, size_t size, StoreMode mode);
+
+    /**
+     * @brief Deletes an entry.
+     * @param key The entry.
+     * @return True if the entry is gone, false if the removal could not be written.
+     */
+    bool remove(const Key& key);
+
+    /**
+     * @brief Rewrites the archive with only its live entries.
+     *
+     * The new archive is written next to the old one and renamed over it, so a crash
+     * leaves one of the two intact. Must not be called while an entry is memory-mapped.
+     *
+     * @return True on success, false otherwise.
+     */
+    bool compact();
+
+    /**
+     * @brief Compacts the archive if replaced entries take more than half of it.
+     *
+     * Archives smaller than MIN_COMPACT_SIZE are left alone. Must not be called while an
+     * entry is memory-mapped.
+     *
+     * @return True if the archive was compacted, false if it did not need it or compaction failed.
+     */
+    bool compactIfSparse();
+
+    /**
+     * @brief Gets the number of live entries.
+     * @return The entry count.
+     */
+    size_t getEntryCount() const;
+
+    /**
+     * @brief Gets the bytes taken by live entries, including their record headers.
+     * @return The live size in bytes.
+     */
+    uint64_t getLiveBytes() const;
+
+    /**
+     * @brief Gets the size of the archive file.
+     * @return The size in bytes.
+     */
+    uint64_t getFileSize() const;
+
+    /**
+     * @brief Names the archive of a world after its map file, replacing a ".dat" extension with ".wgar".
+     * @param mapFile The world map file name, as given with --map.
+     * @return The archive file name.
+     */
+    static std::string getArchiveFilename(const std::string& mapFile);
+
+private:
+    static constexpr uint64_t MIN_COMPACT_SIZE = 1u << 20; ///< Archives smaller than this are never compacted on open.
+    static constexpr uint64_t MAX_INDEX_ENTRIES = 1u << 28; ///< Largest index accepted when opening.
+
+    /**
+     * @struct KeyHash
+     * @brief Hashes a Key for the index.
+     */
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    mutable std::mutex mutex; ///< Guards all state below.
+    std::string path; ///< Path of the archive file.
+    std::fstream file; ///< The open archive file.
+    std::unordered_map<Key, EntryInfo, KeyHash> index; ///< Live entries.
+    uint64_t endOffset = 0; ///< Offset just past the last valid record; where the next one goes.
+    uint64_t liveBytes = 0; ///< Bytes taken by live entries.
+    bool indexDirty = false; ///< Whether records were written since the last index checkpoint.
+
+    /**
+     * @brief Reads the header, the last index checkpoint and every record after it.
+     * @return True if the file is a valid archive, false otherwise.
+     */
+    bool readIndex();
+
+    /**
+     * @brief Writes a header pointing at an index checkpoint.
+     * @param out The stream to write to.
+     * @param indexOffset Offset of the INDEX record, or 0 for none.
+     * @param scanOffset Offset just past the INDEX record.
+     * @return True if the header was written.
+     */
+    static bool writeHeader(std::ostream& out, uint64_t indexOffset, uint64_t scanOffset);
+
+    /**
+     * @brief Reads and checks a record header.
+     * @param in The stream to read from.
+     * @param offset The offset of the record.
+     * @param limit The size of the file; the record must end before it.
+     * @param header Output parameter receiving the header.
+     * @return True if a valid record header was read.
+     */
+    static bool readRecordHeader(std::istream& in, uint64_t offset, uint64_t limit, ArchiveRecordHeader& header);
+
+    /**
+     * @brief Appends a record. Must be called with the mutex held.
+     * @param header The record header; its checksum is filled in here.
+     * @param payload The payload, or nullptr if there is none.
+     * @return True if the record was written.
+     */
+    bool appendRecord(ArchiveRecordHeader header, const char* payload);
+
+    /**
+     * @brief Appends an INDEX record and points the header at it. Must be called with the mutex held.
+     * @return True on success.
+     */
+    bool writeCheckpoint();
+
+    /**
+     * @brief Updates the index for a record. Must be called with the mutex held.
+     * @param header The record header.
+     * @param offset The offset of the record.
+     */
+    void indexRecord(const ArchiveRecordHeader& header, uint64_t offset);
+
+    /**
+     * @brief Compacts the archive. Must be called with the mutex held.
+     * @return True on success.
+     */
+    bool compactLocked();
+
+    /**
+     * @brief Checks whether replaced entries take more than half of an archive worth compacting.
+     * @return True if the archive should be compacted. Must be called with the mutex held.
+     */
+    bool isSparse() const;
+
+    /**
+     * @brief Gets the size a live entry takes in the archive.
+     * @param info The entry.
+     * @return The size of its record header and payload.
+     */
+    static uint64_t entrySize(const EntryInfo& info);
+};
+
+#endif // WORLD_ARCHIVE_H
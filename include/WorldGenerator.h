@@ -0,0 +1,130 @@
+#ifndef WORLD_GENERATOR_H
+#define WORLD_GENERATOR_H
+
+#include "Tile.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class WorldGenerator
+ * @brief Deterministic procedural terrain and territory generation from a 64-bit seed.
+ *
+ * Every tile is a pure function of the seed and its coordinates. Terrain comes from
+ * fractal value noise, so neighbouring tiles share a terrain family (contiguous biomes);
+ * a second noise field picks the variant within the family. Owners come from cellular
+ * (Worley) noise, so territories form clusters instead of single tiles.
+ *
+ * All arithmetic is integer, so a seed produces the same map on every platform and
+ * compiler, and any range of rows can be generated independently and in parallel.
+ */
+class WorldGenerator {
+public:
+    static constexpr int32_t INNER_OWNER = 1776; ///< Owner of every tile of an inner map.
+
+    /**
+     * @brief Prepares a generator.
+     * @param seed The seed of the map being generated.
+     * @param terrains The terrain IDs to generate from; grouped into families by TerrainRegistry.
+     * @param isInner True for an inner map, whose tiles all get INNER_OWNER and smaller biomes.
+     */
+    WorldGenerator(uint64_t seed, const std::vector<TerrainId>& terrains, bool isInner);
+
+    /**
+     * @brief Generates a band of rows of a map.
+     * @param numCols The width of the map in tiles.
+     * @param firstRow The first row to generate.
+     * @param endRow One past the last row to generate.
+     * @param terrainIds The map's terrain plane (row-major, numCols wide).
+     * @param ownerIds The map's owner plane (row-major, numCols wide).
+     */
+    void generateRows(int numCols, int firstRow, int endRow, TerrainId* terrainIds, int32_t* ownerIds) const;
+
+    /**
+     * @brief Mixes a 64-bit value into a well-distributed hash (SplitMix64 finalizer).
+     * @param value The value to hash.
+     * @return The hash.
+     */
+    static uint64_t hash(uint64_t value);
+
+    /**
+     * @brief Hashes a seed with a pair of coordinates and a stream number.
+     * @param seed The seed.
+     * @param x The x-coordinate.
+     * @param y The y-coordinate.
+     * @param stream Separates independent uses of the same seed and coordinates.
+     * @return The hash.
+     */
+    static uint64_t hashCoords(uint64_t seed, int64_t x, int64_t y, uint64_t stream);
+
+    /**
+     * @brief Derives the seed of the inner map under a world tile.
+     * @param worldSeed The seed of the world.
+     * @param col The column of the world tile.
+     * @param row The row of the world tile.
+     * @return The inner map's seed.
+     */
+    static uint64_t deriveInnerSeed(uint64_t worldSeed, int col, int row);
+
+    /**
+     * @brief Draws a fresh seed from the system's random device, for new worlds.
+     * @return A random seed.
+     */
+    static uint64_t randomSeed();
+
+private:
+    static constexpr int OCTAVES = 4; ///< Noise octaves summed per field.
+
+    uint64_t seed; ///< Seed of the map being generated.
+    bool isInner; ///< Whether an inner map is being generated.
+    int biomeShift; ///< log2 of the largest biome noise cell, in tiles.
+    int variantShift; ///< log2 of the largest variant noise cell, in tiles.
+    int territoryShift; ///< log2 of a territory cell, in tiles.
+    int32_t ownerCount; ///< Number of distinct owners handed out.
+    std::vector<std::vector<TerrainId>> families; ///< Requested terrains grouped by family.
+
+    /**
+     * @struct TerritoryCentre
+     * @brief The jittered centre of one territory cell and its owner.
+     */
+    struct TerritoryCentre {
+        int64_t x; ///< Column of the centre.
+        int64_t y; ///< Row of the centre.
+        int32_t owner; ///< Owner of the territory.
+    };
+
+    /**
+     * @brief Samples fractal value noise at the centre of every tile in a row.
+     * @param row The row.
+     * @param numCols The width of the row in tiles.
+     * @param cellShift log2 of the largest octave's cell size, in tiles.
+     * @param stream The hash stream of the noise field.
+     * @param noise Output parameter receiving noise in [0, 65535] per column.
+     */
+    void fractalNoiseRow(int row, int numCols, int cellShift, uint64_t stream, std::vector<uint32_t>& noise) const;
+
+    /**
+     * @brief Adds one weighted octave of value noise to a row.
+     *
+     * Corner values are hashed once per cell, so only the interpolation runs per tile.
+     *
+     * @param row The row.
+     * @param cellShift log2 of the cell size, in tiles.
+     * @param stream The hash stream of the octave.
+     * @param weight The octave's weight.
+     * @param noise The row to add to.
+     */
+    void addOctaveRow(int row, int cellShift, uint64_t stream, uint32_t weight, std::vector<uint32_t>& noise) const;
+
+    /**
+     * @brief Computes the territory centres of the cell rows around a tile row.
+     * @param row The tile row.
+     * @param numCols The width of the map in tiles.
+     * @param centres Output parameter receiving three rows of centres, one per cell row, each
+     *        starting one cell left of the map.
+     * @return The number of centres per cell row.
+     */
+    size_t territoryCentresRow(int row, int numCols, std::vector<TerritoryCentre>& centres) const;
+
+};
+
+#endif // WORLD_GENERATOR_H
@@ -0,0 +1,221 @@
+#ifndef WORLD_JOURNAL_H
+#define WORLD_JOURNAL_H
+
+#include "Tile.h"
+#include "WorldArchive.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file WorldJournal.h
+ * @brief Write-ahead journal of tile changes made since the world archive was last saved.
+ *
+ * Every tile change is appended to the journal as it happens, which costs a few bytes
+ * instead of a map rewrite. Once every changed map has been saved to the archive
+ * (a checkpoint), the records that the saves cover are dropped. After a crash, the
+ * records still in the journal are replayed onto the saved maps. Records hold a tile's
+ * whole state, so replaying one that was already saved changes nothing.
+ *
+ * A journal file is laid out as follows (all integers little-endian):
+ *
+ *   JournalHeader                 24 bytes
+ *   terrain dictionary            dictionaryCount entries, as in map files (see MapFormat.h)
+ *   JournalRecord                 28 bytes each, until the end of the file
+ *
+ * A record that is cut short or fails its checksum ends the journal; it and everything
+ * after it are discarded when the journal is opened.
+ *
+ * Commits are flushed to the operating system but not synced to the disk, so committed
+ * records survive the game crashing but not the machine losing power. A trim syncs the
+ * new journal and its directory before and after swapping it in, so the swap itself is
+ * durable.
+ */
+
+static constexpr uint32_t JOURNAL_MAGIC = 0x4E4A4757; ///< "WGJN" read as a little-endian uint32.
+static constexpr uint16_t JOURNAL_VERSION = 1; ///< Current journal format version.
+
+/**
+ * @struct JournalHeader
+ * @brief Fixed-size header at the start of a journal file.
+ */
+struct JournalHeader {
+    uint32_t magic;           ///< Always JOURNAL_MAGIC.
+    uint16_t version;         ///< Format version the journal was written with.
+    uint16_t headerSize;      ///< Size of this header in bytes.
+    uint64_t worldSeed;       ///< Seed of the world the records belong to.
+    uint32_t dictionaryCount; ///< Number of entries in the terrain dictionary.
+    uint32_t headerCrc;       ///< CRC-32 of the header and dictionary, with headerCrc zeroed.
+};
+
+/**
+ * @struct JournalRecord
+ * @brief The state of one tile after a change.
+ */
+struct JournalRecord {
+    int32_t x;           ///< Archive key of the map: column of the parent tile, or 0 for the world.
+    int32_t y;           ///< Archive key of the map: row of the parent tile, or 0 for the world.
+    int32_t depth;       ///< Archive key of the map: WorldArchive::DEPTH_WORLD or DEPTH_INNER.
+    uint32_t index;      ///< Tile index within the map (row * numCols + col).
+    int32_t ownerId;     ///< Owner ID of the tile.
+    TerrainId terrainId; ///< Terrain ID of the tile, indexing the dictionary on disk.
+    uint8_t flags;       ///< State bits of the tile.
+    uint16_t reserved;   ///< Always zero.
+    uint32_t crc;        ///< CRC-32 of the fields above.
+};
+
+static_assert(sizeof(JournalHeader) == 24, "JournalHeader must stay 24 bytes");
+static_assert(sizeof(JournalRecord) == 28, "JournalRecord must stay 28 bytes");
+
+/**
+ * @class WorldJournal
+ * @brief Appends, recovers and trims the journal of one world.
+ *
+ * Records are counted from the first one ever written to the journal, so a position
+ * taken by mark() stays valid while older records are dropped. While no file is open,
+ * records are dropped as they are appended. Every method is thread-safe.
+ */
+class WorldJournal {
+public:
+    /**
+     * @brief Constructs a closed journal.
+     */
+    WorldJournal() = default;
+
+    /**
+     * @brief Commits pending records and closes the file.
+     */
+    ~WorldJournal();
+
+    WorldJournal(const WorldJournal&) = delete;
+    WorldJournal& operator=(const WorldJournal&) = delete;
+
+    /**
+     * @brief Opens or creates a journal, reading the records a crash left behind.
+     *
+     * Records written for a different world, or a journal that cannot be read, are
+     * discarded with a warning.
+     *
+     * @param path The path of the journal file.
+     * @param worldSeed The seed of the world the journal belongs to.
+     * @param truncate True to start an empty journal even if the file exists.
+     * @return True if the journal is usable, false otherwise.
+     */
+    bool open(const std::string& path, uint64_t worldSeed, bool truncate = false);
+
+    /**
+     * @brief Commits pending records and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a journal file is open.
+     * @return True if appended records are written, false if they are dropped.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Gets the records found when the journal was opened, with terrain IDs remapped.
+     *
+     * Records whose terrain no longer exists are left out.
+     *
+     * @return The records, oldest first.
+     */
+    const std::vector<JournalRecord>& getRecovered() const;
+
+    /**
+     * @brief Frees the records found when the journal was opened.
+     */
+    void clearRecovered();
+
+    /**
+     * @brief Queues a record of a tile's state; commit() writes it. Dropped if no file is open.
+     * @param key The archive key of the map the tile belongs to.
+     * @param index The tile index.
+     * @param terrainId The terrain ID.
+     * @param ownerId The owner ID.
+     * @param flags The state bits.
+     */
+    void append(const WorldArchive::Key& key, size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags);
+
+    /**
+     * @brief Writes every queued record to the file.
+     * @return True if the records are in the file, false otherwise.
+     */
+    bool commit();
+
+    /**
+     * @brief Gets the position after the last record, for a later trim().
+     * @return The number of records written or queued since the journal was created,
+     *         or NO_JOURNAL if no file is open.
+     */
+    uint64_t mark() const;
+
+    /**
+     * @brief Drops the records before a position, after the maps they changed were saved.
+     *
+     * The remaining records are written to a new file that replaces the journal, so an
+     * interrupted trim leaves the old journal intact. If the new file cannot be reopened,
+     * the journal is closed.
+     *
+     * @param position A position returned by mark(). NO_JOURNAL trims nothing.
+     * @return True if the journal was trimmed or there is nothing to trim, false otherwise.
+     */
+    bool trim(uint64_t position);
+
+    /**
+     * @brief Gets the size of the journal file, including queued records.
+     * @return Bytes.
+     */
+    uint64_t getSize() const;
+
+    /**
+     * @brief Names the journal of a world after its map file, replacing a ".dat" extension with ".wgj".
+     * @param mapFile The world map file name, as given with --map.
+     * @return The journal file name.
+     */
+    static std::string getJournalFilename(const std::string& mapFile);
+
+    static constexpr uint64_t NO_JOURNAL = UINT64_MAX; ///< Position reported by mark() while no file is open.
+
+private:
+    mutable std::mutex mutex; ///< Guards all state below.
+    std::fstream file; ///< The open journal file.
+    std::string path; ///< Path of the journal file.
+    uint64_t worldSeed = 0; ///< Seed of the world the journal belongs to.
+    uint64_t headerEnd = 0; ///< Offset of the first record.
+    uint64_t firstRecord = 0; ///< Position of the first record in the file.
+    uint64_t fileRecords = 0; ///< Number of records in the file.
+    std::vector<JournalRecord> pending; ///< Records queued by append().
+    std::vector<JournalRecord> recovered; ///< Records found by open().
+
+    /**
+     * @brief Writes a header and the current terrain dictionary to an empty stream.
+     * @param out The stream to write to.
+     * @return The number of bytes written, or 0 on failure.
+     */
+    uint64_t writeHeader(std::ostream& out) const;
+
+    /**
+     * @brief Reads the header and every intact record. Must be called with the mutex held.
+     * @param fileSize The size of the file.
+     * @return True if the header belongs to this world, false if the journal must be discarded.
+     */
+    bool readRecords(uint64_t fileSize);
+
+    /**
+     * @brief Starts an empty journal file. Must be called with the mutex held.
+     * @return True if the file was created, false otherwise.
+     */
+    bool createFile();
+
+    /**
+     * @brief Writes queued records. Must be called with the mutex held.
+     * @return True if the records are in the file, false otherwise.
+     */
+    bool commitLocked();
+};
+
+#endif // WORLD_JOURNAL_H
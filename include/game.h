@@ -12,6 +12,20 @@
 #include "TileMap.h"
 #include "GlobalSettings.h"
 #include "CursorManager.h"
+#include "ChunkStreamer.h"
+#include "MapIOWorker.h"
+#include "ArchiveConverter.h"
+#include "InnerMapCache.h"
+#include "JobSystem.h"
+#include "TerritorySimulation.h"
+#include "VisibilityLayer.h"
+#include "EntityRegistry.h"
+#include "UnitSystem.h"
+#include "MapPyramid.h"
+#include "Camera.h"
+#include "WorldGenerator.h"
+#include "GameOptions.h"
+#include "Profiler.h"
 
 /**
  * @enum MapState
@@ -40,12 +54,18 @@ public:
 
     /**
      * @brief Initializes SDL, creates the window, and loads or generates the map.
+     *
+     * In headless mode no SDL subsystem, window or renderer is created.
+     *
+     * @param options The run-time options chosen on the command line.
      * @return True if initialization succeeds, false otherwise.
      */
-    bool init();
+    bool init(const GameOptions& options);
 
     /**
      * @brief Starts the main game loop, handling updates, rendering, and events.
+     *
+     * In headless mode, runs the requested number of updates as fast as possible instead.
      */
     void run();
 
@@ -54,15 +74,31 @@ public:
      */
     void cleanup();
 
-    void handleTileHover(int mouseX, int mouseY, int hoverX, int hoverY);
+    /**
+     * @brief Highlights the hovered tile and prefetches the inner maps around it.
+     * @param hoverX The column of the hovered tile.
+     * @param hoverY The row of the hovered tile.
+     */
+    void handleTileHover(int hoverX, int hoverY);
 
     void getMousePosition(int &mouseX, int &mouseY);
 
+    /**
+     * @brief Determines matching terrain types based on the given terrain.
+     * @param terrainId The ID of the terrain type.
+     * @return A vector of matching terrain IDs.
+     */
+    static std::vector<TerrainId> getMatchingTerrain(TerrainId terrainId);
+
 
 
 private:
     // Game State
     bool running = false;   ///< Flag indicating if the game is running.
+    bool headless = false;  ///< Whether the game runs without a window or renderer.
+    long long headlessTicks = 0; ///< Updates to run in headless mode.
+    uint64_t tickCount = 0; ///< Fixed-step updates run so far.
+    std::string tracePath;  ///< File to write a profiler trace to on exit, or empty for none.
     MapState state = OUTER; ///< Current state of the game (inner or outer map).
 
     // SDL Window & Rendering
@@ -71,7 +107,42 @@ private:
 
     // Game Data
     TileMap tileMap;  ///< Manages and stores all tiles in the game.
+    TileMap worldMap; ///< The world, kept resident while an inner map is shown.
+    InnerMapCache innerMaps{GlobalSettings::getInstance().getInnerMapCacheBudget()}; ///< Recently left inner maps.
+    TerritorySimulation simulation; ///< Territory control on the world map.
+    bool simulationPaused = false; ///< Whether the territory simulation is paused.
+    JobSystem::JobHandle simulationJob; ///< Job rolling the current tick's captures, until finishSimulation() applies them.
+    VisibilityLayer visibility; ///< What the player sees of the world map.
+    EntityRegistry entities; ///< Units and buildings on the world map.
+    UnitSystem units; ///< Moves the units about the world map.
+    MapPyramid pyramid; ///< Downsampled world map for zoomed-out views and the minimap.
+    int innerCol = -1; ///< Column of the world tile whose inner map is shown.
+    int innerRow = -1; ///< Row of the world tile whose inner map is shown.
     CursorManager cursorManager; ///< Manages cursor movement and tile selection.
+    std::unique_ptr<ChunkStreamer> chunkStreamer; ///< Streams a mapped world around the view.
+    std::optional<Camera> outerCamera; ///< World camera saved while an inner map is shown.
+    WorldArchive archive; ///< The world and the player's inner map changes, in one file.
+    WorldJournal journal; ///< Tile changes not yet covered by a save of their map.
+    uint64_t changesSinceCheckpoint = 0; ///< Tile changes journaled, or dropped without a journal, since the last checkpoint.
+    std::unique_ptr<MapIOWorker> ioWorker; ///< Loads and saves maps off the render thread.
+    bool transitionPending = false; ///< Whether a transition is waiting on an inner map.
+    int pendingCol = -1; ///< Column of the world tile being entered.
+    int pendingRow = -1; ///< Row of the world tile being entered.
+
+    // Frame Pacing
+    static constexpr int IDLE_WAIT_MS = 250; ///< Longest wait for input while nothing moves.
+    static constexpr double MAX_FRAME_SECONDS = 0.25; ///< Frame time cap, so a stall does not trigger a burst of updates.
+    static constexpr float SCROLL_SPEED = 800.0f; ///< Camera scroll speed in world pixels per second.
+    bool scrollLeft = false;  ///< Whether a scroll-left key is held.
+    bool scrollRight = false; ///< Whether a scroll-right key is held.
+    bool scrollUp = false;    ///< Whether a scroll-up key is held.
+    bool scrollDown = false;  ///< Whether a scroll-down key is held.
+    float tickPanX = 0.0f; ///< Horizontal camera movement of the last update, for interpolation.
+    float tickPanY = 0.0f; ///< Vertical camera movement of the last update, for interpolation.
+#ifdef WARGAME_PROFILING
+    static constexpr const char* TRACE_FILE = "wargame_trace.json"; ///< Trace written by the export key.
+    double statsSeconds = 0.0; ///< Time since the frame statistics were last shown in the title.
+#endif
 
     // Global Settings
     int TILE_SIZE = 0;  ///< Size of each tile in pixels.
@@ -84,44 +155,147 @@ private:
 
     // Core Game Loop Functions
     /**
-     * @brief Processes SDL events, including input handling.
+     * @brief Waits for SDL events and processes every queued one.
+     * @param timeoutMs The longest time to wait for the first event, or 0 to only poll.
+     * @return True if any event was processed.
+     */
+    bool processEvents(int timeoutMs);
+
+    /**
+     * @brief Handles one SDL event, including input handling.
+     * @param event The event to handle.
+     */
+    void handleEvent(const SDL_Event& event);
+
+    /**
+     * @brief Runs updates back to back without a window and reports the tick rate.
+     */
+    void runHeadless();
+
+    /**
+     * @brief Advances the game state by one fixed step. Never touches rendering.
+     * @param tickSeconds The length of a step in seconds.
      */
-    void processEvents();
+    void update(double tickSeconds);
 
     /**
-     * @brief Updates the game state (to be implemented).
+     * @brief Waits for the captures rolled on the job pool and applies them to the world.
+     *
+     * Must be called before anything writes the world or swaps the shown map.
      */
-    void update();
+    void finishSimulation();
+
+    /**
+     * @brief Scrolls the camera by one fixed step while scroll keys are held.
+     * @param tickSeconds The length of a step in seconds.
+     */
+    void scrollCamera(double tickSeconds);
+
+    /**
+     * @brief Finishes map transitions and streams chunks; runs once per frame.
+     */
+    void pollBackgroundWork();
+
+#ifdef WARGAME_PROFILING
+    /**
+     * @brief Records a rendered frame's time and refreshes the statistics in the window title.
+     * @param frameSeconds The time spent on the frame, excluding waits for input.
+     * @param elapsed The wall-clock time since the previous loop iteration.
+     */
+    void recordFrameStats(double frameSeconds, double elapsed);
+#endif
+
+    /**
+     * @brief Checks whether nothing is simulating, moving or loading, so the loop may block on input.
+     * @return True if the game is idle.
+     */
+    bool isIdle() const;
 
     /**
      * @brief Renders the game scene.
+     * @param alpha How far the frame lies between the last update and the next, from 0 to 1.
      */
-    void render();
+    void render(float alpha);
+
+    /**
+     * @brief Scrolls or zooms the camera in response to keyboard and mouse wheel input.
+     * @param event The SDL key or mouse wheel event.
+     */
+    void handleCameraInput(const SDL_Event& event);
+
+    /**
+     * @brief Moves the camera so a world position is in the middle of the screen, e.g. after a minimap click.
+     * @param worldX The world x-coordinate.
+     * @param worldY The world y-coordinate.
+     */
+    void centerCamera(float worldX, float worldY);
+
+    /**
+     * @brief Re-evaluates the hovered tile for the current cursor position.
+     */
+    void refreshHover();
 
     // Inner Map Management
     /**
-     * @brief Enters the inner map of a specific tile, saving the current map if needed.
+     * @brief Starts entering the inner map of a specific tile without blocking on I/O.
      * @param tile The tile whose inner map is to be entered.
      */
-    void enterInnerMap(std::shared_ptr<Tile> tile);
+    void enterInnerMap(const Tile& tile);
 
     /**
-     * @brief Loads or generates an inner map for a tile.
-     * @param tile The tile for which an inner map is needed.
+     * @brief Builds the I/O request for a world tile's inner map.
+     * @param tile The world tile the inner map belongs to.
+     * @return The position, terrain family and derived seed of the inner map.
      */
-    void generateInnerMap(std::shared_ptr<Tile> tile);
+    MapIOWorker::InnerMapRequest getInnerMapRequest(const Tile& tile) const;
 
     /**
-     * @brief Determines matching terrain types based on the given terrain alias.
-     * @param terrainType The alias of the terrain type.
-     * @return A vector of matching terrain types.
+     * @brief Enters a pending inner map if it is cached or ready, keeping the world resident.
      */
-    std::vector<std::string> getMatchingTerrain(const std::string& terrainType);
+    void finishTransition();
 
     /**
-     * @brief Exits the inner map and returns to the outer world.
+     * @brief Prefetches the inner maps of the hovered tile and its neighbours.
+     * @param hoverX The column of the hovered tile.
+     * @param hoverY The row of the hovered tile.
+     */
+    void prefetchInnerMaps(int hoverX, int hoverY);
+
+    /**
+     * @brief Returns to the resident outer world, caching the inner map.
      */
     void exitInnerMap();
+
+    /**
+     * @brief Queues saves for the world and every cached inner map with unsaved changes.
+     */
+    void saveChangedMaps();
+
+    /**
+     * @brief Appends the tiles changed in the resident maps to the journal and commits them.
+     */
+    void journalChanges();
+
+    /**
+     * @brief Queues saves of every map with unsaved changes, keeping them resident, then trims the journal behind them.
+     */
+    void checkpoint();
+
+    /**
+     * @brief Replays the journal a crash left behind onto the saved maps and saves them.
+     */
+    void recoverJournal();
+
+    /**
+     * @brief Opens the world entry of the archive, memory-mapping it when it is stored mappable.
+     * @return True if the world was loaded, false if the entry is invalid.
+     */
+    bool loadWorldMap();
+
+    /**
+     * @brief Starts streaming the current map's chunks if it is memory-mapped.
+     */
+    void startChunkStreaming();
 };
 
 #endif // GAME_H
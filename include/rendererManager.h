@@ -6,10 +6,18 @@
 #include <tuple>
 #include "TileRenderer.h"
 #include "TileMap.h"
+#include "VisibilityLayer.h"
+#include "EntityRegistry.h"
+#include "MapPyramid.h"
+#include "Camera.h"
+#include "Profiler.h"
 
 /**
  * @class RendererManager
  * @brief Handles rendering operations, including drawing the tile map and hover effects.
+ *
+ * Given a MapPyramid, it also draws the map button and, while it is shown, a minimap
+ * with the camera's view outlined, both in the bottom-right corner.
  */
 class RendererManager {
 public:
@@ -32,10 +40,14 @@ public:
     void clear();
 
     /**
-     * @brief Renders the tile map and the highlighted hover tile.
+     * @brief Renders the visible part of the tile map, the units on it and the highlighted hover tile.
      * @param tileMap The tile map to be rendered.
+     * @param visibility Fog of war seen by the player, or nullptr to show every tile.
+     * @param entities Units standing on the map, or nullptr to draw none.
+     * @param pyramid Downsampled copies of the map for zoomed-out views and the minimap, or nullptr for neither.
      */
-    void render(const TileMap& tileMap);
+    void render(const TileMap& tileMap, const VisibilityLayer* visibility = nullptr, const EntityRegistry* entities = nullptr,
+                const MapPyramid* pyramid = nullptr);
 
     /**
      * @brief Presents the rendered content to the screen.
@@ -44,12 +56,54 @@ public:
 
     /**
      * @brief Updates the hover position and changes the highlight color.
-     * @param x The x-coordinate of the hovered tile.
-     * @param y The y-coordinate of the hovered tile.
+     * @param x The column of the hovered tile, or -1 for none.
+     * @param y The row of the hovered tile, or -1 for none.
      * @param newHoverColor The new color for the hover highlight.
      */
     void updateHover(int x, int y, SDL_Color newHoverColor);
 
+    /**
+     * @brief Forces the cached terrain layer to be redrawn, e.g. after render targets were reset.
+     */
+    void invalidateCache();
+
+    /**
+     * @brief Shows or hides the minimap.
+     * @param visible True to draw the minimap while a pyramid is rendered.
+     */
+    void setMinimapVisible(bool visible);
+
+    /**
+     * @brief Checks whether the minimap is shown.
+     * @return True if the minimap is drawn.
+     */
+    bool isMinimapVisible() const;
+
+    /**
+     * @brief Checks whether a screen position is on the map button.
+     * @param x The x-coordinate on screen.
+     * @param y The y-coordinate on screen.
+     * @return True if the position is on the button.
+     */
+    bool isOverMapButton(int x, int y) const;
+
+    /**
+     * @brief Converts a screen position on the shown minimap to world pixels.
+     * @param x The x-coordinate on screen.
+     * @param y The y-coordinate on screen.
+     * @param tileMap The map the minimap shows.
+     * @param worldX Output parameter receiving the world x-coordinate.
+     * @param worldY Output parameter receiving the world y-coordinate.
+     * @return True if the minimap is shown and the position is on it.
+     */
+    bool minimapToWorld(int x, int y, const TileMap& tileMap, float& worldX, float& worldY) const;
+
+    /**
+     * @brief Gets the camera the map is viewed through.
+     * @return A reference to the camera.
+     */
+    Camera& getCamera();
+
     /**
      * @brief Gets the SDL renderer.
      * @return A pointer to the SDL_Renderer instance.
@@ -62,13 +116,76 @@ public:
      */
     TileRenderer* getTileRenderer();
 
+#ifdef WARGAME_PROFILING
+    /**
+     * @brief Shows or hides the frame-time overlay.
+     * @param visible True to draw the overlay on every frame.
+     */
+    void setProfilerOverlayVisible(bool visible);
+
+    /**
+     * @brief Checks whether the frame-time overlay is shown.
+     * @return True if the overlay is drawn.
+     */
+    bool isProfilerOverlayVisible() const;
+#endif
+
 private:
     SDL_Renderer* renderer;  ///< SDL renderer for rendering content.
     TileRenderer* tileRenderer; ///< Tile renderer for managing tile textures.
     const int TILE_SIZE; ///< Size of each tile in pixels.
+    Camera camera; ///< Scroll and zoom applied to the map.
 
     std::tuple<int, int> currHover; ///< Stores the current hover tile coordinates.
     SDL_Color hoverColor; ///< Color used to highlight hovered tiles.
+    std::vector<SDL_Rect> friendlyUnits; ///< Screen areas of the player's units being drawn.
+    std::vector<SDL_Rect> enemyUnits; ///< Screen areas of other factions' units being drawn.
+
+    static constexpr int MINIMAP_SIZE = 200;   ///< Longest side of the minimap in pixels.
+    static constexpr int MAP_BUTTON_SIZE = 25; ///< Width and height of the map button in pixels.
+    static constexpr int PANEL_MARGIN = 10;    ///< Gap between the button, the minimap and the screen edges.
+    SDL_Texture* mapButton = nullptr; ///< Map button image, or nullptr if it failed to load.
+    bool minimapVisible = false; ///< Whether the minimap is drawn.
+
+    /**
+     * @brief Computes where the minimap goes: the map's shape, fitted into MINIMAP_SIZE above the map button.
+     * @param numCols The number of columns in the map.
+     * @param numRows The number of rows in the map.
+     * @return The screen rectangle of the minimap.
+     */
+    SDL_Rect getMinimapArea(int numCols, int numRows) const;
+
+    /**
+     * @brief Computes where the map button goes, in the bottom-right corner.
+     * @return The screen rectangle of the button.
+     */
+    SDL_Rect getMapButtonArea() const;
+
+    /**
+     * @brief Draws the minimap with a border and an outline of the camera's view.
+     * @param tileMap The map the pyramid describes.
+     * @param pyramid The pyramid to draw from.
+     */
+    void renderMinimap(const TileMap& tileMap, const MapPyramid& pyramid);
+
+    /**
+     * @brief Draws every unit on a tile in view that the player can see.
+     * @param tileMap The tile map the units stand on.
+     * @param visibility Fog of war seen by the player, or nullptr.
+     * @param entities The units.
+     */
+    void renderUnits(const TileMap& tileMap, const VisibilityLayer* visibility, const EntityRegistry& entities);
+
+#ifdef WARGAME_PROFILING
+    static constexpr int OVERLAY_PIXELS_PER_MS = 4; ///< Height of one millisecond in the frame-time graph.
+    static constexpr int OVERLAY_HEIGHT = 100;      ///< Height of the frame-time graph in pixels.
+    bool profilerOverlay = false; ///< Whether the frame-time overlay is drawn.
+
+    /**
+     * @brief Draws recent frame times as a bar graph, with lines at the p50 and p99 frame times.
+     */
+    void renderProfilerOverlay();
+#endif
 };
 
 #endif // RENDERER_MANAGER_H
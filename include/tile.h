@@ -1,52 +1,92 @@
 #ifndef TILE_H
 #define TILE_H
 
+#include <cstdint>
 #include <string>
 
+/**
+ * @brief Compact identifier of a tile's terrain type.
+ */
+typedef uint8_t TerrainId;
+
+/**
+ * @enum TileFlags
+ * @brief Per-tile state bits stored alongside terrain and owner data.
+ */
+enum TileFlags : uint8_t {
+    TILE_FLAG_NONE  = 0,      ///< No flags set.
+    TILE_FLAG_DIRTY = 1 << 0  ///< The tile changed since the map was last saved.
+};
+
 /**
  * @class Tile
- * @brief Represents a tile in the game world with position, asset type, and ownership data.
+ * @brief Lightweight value view of a single tile in a TileMap.
+ *
+ * Tiles are not stored individually; TileMap keeps terrain, owner and flag data
+ * in parallel arrays and hands out Tile values on demand.
  */
 class Tile {
 public:
     /**
-     * @brief Constructs a Tile with given coordinates, asset alias, and owner ID.
-     * @param x The x-coordinate of the tile.
-     * @param y The y-coordinate of the tile.
-     * @param assetAlias The alias representing the tile's visual asset.
+     * @brief Constructs a Tile view for the given grid cell.
+     * @param col The column of the tile in the grid.
+     * @param row The row of the tile in the grid.
+     * @param tileSize The size of each tile in pixels.
+     * @param terrainId The identifier of the tile's terrain type.
      * @param ownerId The ID of the player who owns this tile.
+     * @param flags The tile's state bits (see TileFlags).
      */
-    Tile(int x, int y, const std::string& assetAlias, const int32_t ownerId);
+    Tile(int col, int row, int tileSize, TerrainId terrainId, int32_t ownerId, uint8_t flags);
 
     /**
-     * @brief Gets the alias of the tile's asset.
-     * @return A reference to the asset alias string.
+     * @brief Gets the identifier of the tile's terrain type.
+     * @return The terrain ID.
      */
-    const std::string& getAssetAlias() const;
+    TerrainId getTerrainId() const;
 
     /**
      * @brief Gets the x-coordinate of the tile.
-     * @return The x-coordinate.
+     * @return The x-coordinate in pixels.
      */
     int getX() const;
 
     /**
      * @brief Gets the y-coordinate of the tile.
-     * @return The y-coordinate.
+     * @return The y-coordinate in pixels.
      */
     int getY() const;
 
+    /**
+     * @brief Gets the column of the tile in the grid.
+     * @return The column index.
+     */
+    int getCol() const;
+
+    /**
+     * @brief Gets the row of the tile in the grid.
+     * @return The row index.
+     */
+    int getRow() const;
+
     /**
      * @brief Gets the ID of the tile's owner.
      * @return A reference to the owner's ID.
      */
     const int32_t& getOwnerId() const;
 
+    /**
+     * @brief Gets the tile's state bits.
+     * @return The flags (see TileFlags).
+     */
+    uint8_t getFlags() const;
+
 private:
-    std::string assetAlias; ///< The alias representing the tile's visual asset.
-    int x; ///< The x-coordinate of the tile.
-    int y; ///< The y-coordinate of the tile.
+    int col; ///< The column of the tile.
+    int row; ///< The row of the tile.
+    int tileSize; ///< The size of the tile in pixels.
     int32_t ownerId; ///< The ID of the player who owns the tile.
+    TerrainId terrainId; ///< The tile's terrain type.
+    uint8_t flags; ///< The tile's state bits.
 };
 
 #endif // TILE_H
@@ -5,12 +5,45 @@
 #include <SDL_image.h>
 #include <vector>
 #include <unordered_map>
+#include <array>
 #include "Tile.h"
 #include "TileMap.h"
+#include "VisibilityLayer.h"
+#include "MapPyramid.h"
+#include "TerrainRegistry.h"
+#include "Camera.h"
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+/**
+ * @brief Vertex layout matching SDL 2.0.18's, so batches can be built the same way on older SDL.
+ */
+struct SDL_Vertex {
+    SDL_FPoint position; ///< Position in screen pixels.
+    SDL_Color color; ///< Vertex color.
+    SDL_FPoint tex_coord; ///< Normalized texture coordinates.
+};
+#endif
 
 /**
  * @class TileRenderer
  * @brief Handles rendering of tiles using textures loaded from an asset map.
+ *
+ * Every terrain texture is packed into a single atlas at load time, and tiles are
+ * drawn as one batch of textured quads with SDL_RenderGeometry (SDL 2.0.18 and later),
+ * so the number of draw calls does not grow with the number of tiles.
+ *
+ * The terrain of the current view is cached in a render-target layer. A frame is one
+ * copy of that layer; it is fully redrawn only when the camera or map size changes,
+ * and otherwise only the chunks whose revision changed are redrawn.
+ *
+ * With a VisibilityLayer, tiles the viewer never explored are left black and explored
+ * tiles it cannot see now are darkened; the layer's chunk revisions mark chunks to redraw
+ * alongside the map's.
+ *
+ * Zoomed out below MapPyramid::MIN_CELL_PIXELS per tile, the view is drawn from a
+ * MapPyramid level instead: one pixel per cell in each terrain's average colour, uploaded
+ * to a texture and scaled to the screen in one copy. The same image, tinted by owner,
+ * makes the minimap.
  */
 class TileRenderer {
 public:
@@ -27,31 +60,213 @@ public:
     ~TileRenderer();
 
     /**
-     * @brief Renders the tiles from the tile map onto the screen.
+     * @brief Renders the tiles visible through the camera onto the screen.
      * @param tileMap The tile map containing the tiles to be rendered.
-     * @param tileSize The size of each tile in pixels.
+     * @param tileSize The size of each tile in world pixels.
+     * @param camera The camera the map is viewed through.
+     * @param visibility Fog of war to draw the map through, or nullptr to show every tile.
+     * @param viewerId The owner ID whose vision is drawn; ignored without a visibility layer.
+     * @param pyramid Downsampled levels of the map to draw zoomed-out views from, or nullptr to always draw tiles.
+     */
+    void renderTiles(const TileMap& tileMap, int tileSize, const Camera& camera,
+                     const VisibilityLayer* visibility = nullptr, int32_t viewerId = 0, const MapPyramid* pyramid = nullptr);
+
+    /**
+     * @brief Draws the whole map into a screen area, from the finest pyramid level that fits it.
+     *
+     * Cells are tinted by owner, and the fog of the last renderTiles() call applies.
+     *
+     * @param tileMap The tile map the pyramid describes.
+     * @param pyramid Downsampled levels of the map.
+     * @param area The screen area; the map is stretched to fill it.
      */
-    void renderTiles(const TileMap& tileMap, int tileSize);
+    void renderMinimap(const TileMap& tileMap, const MapPyramid& pyramid, const SDL_Rect& area);
+
+    /**
+     * @brief Forces the cached terrain layer to be redrawn on the next frame.
+     *
+     * Needed when the renderer loses the contents of its render targets.
+     */
+    void invalidateCache();
 
 private:
+    /**
+     * @struct ViewKey
+     * @brief Everything the visible tile range and its screen positions depend on.
+     */
+    struct ViewKey {
+        float cameraX = 0.0f; ///< Camera x-coordinate.
+        float cameraY = 0.0f; ///< Camera y-coordinate.
+        float zoom = 0.0f; ///< Camera zoom.
+        int tileSize = 0; ///< Tile size in world pixels.
+        int numCols = -1; ///< Map width in tiles.
+        int numRows = -1; ///< Map height in tiles.
+
+        bool operator==(const ViewKey& other) const {
+            return cameraX == other.cameraX && cameraY == other.cameraY && zoom == other.zoom &&
+                   tileSize == other.tileSize && numCols == other.numCols && numRows == other.numRows;
+        }
+    };
+
+    static constexpr SDL_Color FOG_COLOR = {96, 96, 96, 255}; ///< Tint of explored tiles the viewer cannot see now.
+
     SDL_Renderer* renderer; ///< The SDL renderer used for rendering.
     std::unordered_map<std::string, std::string> assetMap; ///< Maps tile aliases to texture file paths.
-    std::unordered_map<std::string, SDL_Texture*> textureCache; ///< Caches loaded textures for rendering.
+    SDL_Texture* atlas = nullptr; ///< Every terrain texture packed into one texture.
+    int atlasWidth = 0; ///< Width of the atlas in pixels.
+    int atlasHeight = 0; ///< Height of the atlas in pixels.
+    std::array<SDL_Rect, 256> atlasRects{}; ///< Area of each terrain in the atlas, indexed by terrain ID (empty if missing).
+
+    ViewKey viewKey; ///< View the visible range and edges were computed for.
+    int visibleFirstCol = 0; ///< First visible column.
+    int visibleFirstRow = 0; ///< First visible row.
+    int visibleEndCol = 0; ///< One past the last visible column.
+    int visibleEndRow = 0; ///< One past the last visible row.
+    std::vector<int> columnEdges; ///< Screen x of each visible column edge.
+    std::vector<int> rowEdges; ///< Screen y of each visible row edge.
+    std::vector<SDL_Vertex> vertices; ///< Four vertices per tile being drawn.
+    std::vector<int> indices; ///< Two triangles per quad; only grows.
+    uint64_t batchRevision = 0; ///< Map revision the vertex batch holds when drawing without a layer.
+    uint64_t batchFogRevision = 0; ///< Visibility revision the vertex batch holds when drawing without a layer.
+
+    const VisibilityLayer* fog = nullptr; ///< Visibility layer of the current frame, or nullptr when every tile is shown.
+    int32_t fogViewerId = 0; ///< Owner ID whose vision is drawn.
+    const uint64_t* visibleBits = nullptr; ///< The viewer's visible bits for this frame, or nullptr without fog.
+    const uint64_t* exploredBits = nullptr; ///< The viewer's explored bits for this frame, or nullptr without fog.
+
+    SDL_Texture* layer = nullptr; ///< Render target holding the terrain of the current view.
+    int layerWidth = 0; ///< Width of the layer in pixels.
+    int layerHeight = 0; ///< Height of the layer in pixels.
+    bool layerValid = false; ///< Whether the layer holds the current view.
+    uint64_t layerRevision = 0; ///< Map revision the layer was last brought up to date with.
+    int layerFirstCx = 0; ///< First chunk column drawn in the layer.
+    int layerFirstCy = 0; ///< First chunk row drawn in the layer.
+    int layerEndCx = 0; ///< One past the last chunk column drawn in the layer.
+    int layerEndCy = 0; ///< One past the last chunk row drawn in the layer.
+    uint64_t layerFogRevision = 0; ///< Visibility revision the layer was last brought up to date with.
+    std::vector<uint64_t> layerChunkRevisions; ///< Revision of each chunk as drawn in the layer.
+    std::vector<uint64_t> layerFogChunkRevisions; ///< Visibility revision of each chunk as drawn in the layer.
+    std::vector<SDL_Rect> dirtyRects; ///< Screen areas of the chunks being redrawn.
 
     /**
-     * @brief Loads textures from the asset map into the texture cache.
+     * @struct PyramidImage
+     * @brief A rectangle of pyramid cells as one pixel each, and what it was drawn from.
+     */
+    struct PyramidImage {
+        SDL_Texture* texture = nullptr; ///< Streaming texture holding the pixels; only grows.
+        int textureWidth = 0;  ///< Width of the texture.
+        int textureHeight = 0; ///< Height of the texture.
+        std::vector<SDL_Color> pixels; ///< One pixel per cell, row-major; SDL_Color matches SDL_PIXELFORMAT_RGBA32.
+        int level = 0;    ///< Pyramid level drawn.
+        int firstCol = 0; ///< First cell column drawn.
+        int firstRow = 0; ///< First cell row drawn.
+        int endCol = 0;   ///< One past the last cell column drawn.
+        int endRow = 0;   ///< One past the last cell row drawn.
+        uint64_t pyramidRevision = 0; ///< Pyramid revision drawn.
+        const VisibilityLayer* fog = nullptr; ///< Visibility layer drawn through, or nullptr.
+        uint64_t fogRevision = 0; ///< Visibility revision drawn.
+    };
+
+    std::array<SDL_Color, 256> terrainColors{}; ///< Average colour of each terrain's texture, indexed by terrain ID.
+    PyramidImage overview; ///< The zoomed-out view.
+    PyramidImage minimap; ///< The minimap.
+
+    /**
+     * @brief Loads textures from the asset map and packs them into the atlas.
      */
     void loadTextures();
 
     /**
-     * @brief Retrieves a texture from the cache based on an alias.
-     * @param alias The alias of the tile texture.
-     * @return A pointer to the SDL_Texture, or nullptr if not found.
+     * @brief Recomputes the visible range and edge positions if the view changed.
+     * @param tileMap The tile map being drawn.
+     * @param tileSize The size of each tile in world pixels.
+     * @param camera The camera the map is viewed through.
+     * @return True if the view changed.
+     */
+    bool updateView(const TileMap& tileMap, int tileSize, const Camera& camera);
+
+    /**
+     * @brief Creates or resizes the layer render target.
+     * @param width The layer width in pixels.
+     * @param height The layer height in pixels.
+     * @return True if a layer is available, false if render targets are unsupported.
+     */
+    bool ensureLayer(int width, int height);
+
+    /**
+     * @brief Picks up the visibility layer for this frame, dropping the cache if the fog source changed.
+     * @param tileMap The tile map being drawn.
+     * @param visibility The visibility layer, or nullptr.
+     * @param viewerId The owner ID whose vision is drawn.
+     */
+    void updateFog(const TileMap& tileMap, const VisibilityLayer* visibility, int32_t viewerId);
+
+    /**
+     * @brief Gets the revision of the fog being drawn.
+     * @return The visibility layer's revision, or 0 without fog.
+     */
+    uint64_t getFogRevision() const;
+
+    /**
+     * @brief Sets the draw colour the layer is cleared to: black under fog, white otherwise.
+     */
+    void setBackgroundColor();
+
+    /**
+     * @brief Redraws the whole layer for the current view.
+     * @param tileMap The tile map to draw.
+     */
+    void redrawLayer(const TileMap& tileMap);
+
+    /**
+     * @brief Redraws only the chunks of the layer whose revision changed.
+     * @param tileMap The tile map to draw.
+     */
+    void redrawChangedChunks(const TileMap& tileMap);
+
+    /**
+     * @brief Appends one textured quad per tile in a range to the vertex batch, skipping unexplored tiles under fog.
+     * @param tileMap The tile map to draw.
+     * @param firstCol The first column, within the visible range.
+     * @param firstRow The first row, within the visible range.
+     * @param endCol One past the last column, within the visible range.
+     * @param endRow One past the last row, within the visible range.
+     */
+    void buildBatch(const TileMap& tileMap, int firstCol, int firstRow, int endCol, int endRow);
+
+    /**
+     * @brief Draws the vertex batch to the current render target in one call.
+     */
+    void drawBatch();
+
+    /**
+     * @brief Draws the view from a pyramid level, clipped to the map.
+     * @param tileMap The tile map the pyramid describes.
+     * @param pyramid Downsampled levels of the map.
+     * @param level The level, from 1 to pyramid.getLevelCount().
+     * @param tileSize The size of each tile in world pixels.
+     * @param camera The camera the map is viewed through.
+     */
+    void renderOverview(const TileMap& tileMap, const MapPyramid& pyramid, int level, int tileSize, const Camera& camera);
+
+    /**
+     * @brief Brings an image up to date with a rectangle of pyramid cells, redrawing only if anything it shows changed.
+     * @param image The image.
+     * @param tileMap The tile map the pyramid describes.
+     * @param pyramid Downsampled levels of the map.
+     * @param level The level, from 1 to pyramid.getLevelCount().
+     * @param firstCol The first cell column.
+     * @param firstRow The first cell row.
+     * @param endCol One past the last cell column.
+     * @param endRow One past the last cell row.
+     * @param tintOwners Whether to blend each cell's colour with its owner's.
+     * @return True if the texture holds the image, false if it could not be created.
      */
-    SDL_Texture* getTexture(const std::string& alias) const;
+    bool updateImage(PyramidImage& image, const TileMap& tileMap, const MapPyramid& pyramid, int level,
+                     int firstCol, int firstRow, int endCol, int endRow, bool tintOwners);
 
     /**
-     * @brief Cleans up and frees all loaded textures.
+     * @brief Cleans up and frees the atlas, the layer and the pyramid images.
      */
     void cleanupTextures();
 };
@@ -0,0 +1,71 @@
+#include "ArchiveConverter.h"
+#include "DeltaPack.h"
+#include "GlobalSettings.h"
+#include "TileMap.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+bool ArchiveConverter::hasLegacyWorld(const std::string& mapFile, const std::string& mapPathPrefix) {
+    std::error_code error;
+    return std::filesystem::is_regular_file(mapPathPrefix + mapFile, error);
+}
+
+// Imports the world first, then every inner map file found next to it.
+bool ArchiveConverter::convert(const std::string& mapFile, const std::string& mapPathPrefix, WorldArchive& archive) {
+    TileMap world;
+    if (!world.importFile(mapPathPrefix + mapFile)) {
+        std::cerr << "Error: Could not read world map file: " << mapPathPrefix << mapFile << "\n";
+        return false;
+    }
+    if (!world.saveToArchive(archive, WorldArchive::WORLD_KEY, true)) {
+        return false;
+    }
+
+    // Inner map files live in a folder named after the world file, without ".dat".
+    std::string mapName = mapFile;
+    size_t pos = mapName.rfind(".dat");
+    if (pos != std::string::npos) {
+        mapName = mapName.substr(0, pos);
+    }
+
+    const int tileSize = GlobalSettings::getInstance().getTileSize();
+    DeltaPack deltaPack(archive);
+    size_t converted = 0;
+    size_t skipped = 0;
+
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(mapPathPrefix + mapName, error)) {
+        int x = 0;
+        int y = 0;
+        if (!item.is_regular_file() || !parseInnerMapName(item.path().filename().string(), x, y)) {
+            continue;
+        }
+
+        // Legacy names hold the parent tile's pixel position; archive keys hold its column and row.
+        int col = x / tileSize;
+        int row = y / tileSize;
+        TileMap innerMap;
+        if (col < 0 || col >= world.getNumCols() || row < 0 || row >= world.getNumRows() ||
+            !innerMap.importFile(item.path().string()) || !deltaPack.store(col, row, innerMap, true)) {
+            std::cerr << "Warning: Skipped inner map file: " << item.path().string() << "\n";
+            skipped++;
+            continue;
+        }
+        converted++;
+    }
+
+    std::cout << "Converted " << mapFile << " and " << converted << " inner maps into " << archive.getPath();
+    if (skipped > 0) {
+        std::cout << " (" << skipped << " skipped)";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+// Accepts exactly "tile_<x>_<y>.dat".
+bool ArchiveConverter::parseInnerMapName(const std::string& name, int& x, int& y) {
+    int consumed = 0;
+    return std::sscanf(name.c_str(), "tile_%d_%d.dat%n", &x, &y, &consumed) == 2 &&
+           consumed == static_cast<int>(name.size());
+}
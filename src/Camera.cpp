@@ -0,0 +1,108 @@
+#include "Camera.h"
+#include <algorithm>
+#include <cmath>
+
+// Constructor: Starts at the world origin with zoom 1.
+Camera::Camera(int viewportWidth, int viewportHeight)
+    : viewportWidth(viewportWidth), viewportHeight(viewportHeight) {}
+
+// Converts screen pixels to world pixels.
+void Camera::screenToWorld(int screenX, int screenY, float& worldX, float& worldY) const {
+    worldX = x + screenX / zoom;
+    worldY = y + screenY / zoom;
+}
+
+// Converts world pixels to screen pixels.
+void Camera::worldToScreen(float worldX, float worldY, float& screenX, float& screenY) const {
+    screenX = (worldX - x) * zoom;
+    screenY = (worldY - y) * zoom;
+}
+
+// Converts a screen position to grid coordinates, rounding toward negative infinity.
+void Camera::screenToTile(int screenX, int screenY, int tileSize, int& col, int& row) const {
+    float worldX, worldY;
+    screenToWorld(screenX, screenY, worldX, worldY);
+    col = static_cast<int>(std::floor(worldX / tileSize));
+    row = static_cast<int>(std::floor(worldY / tileSize));
+}
+
+// Computes a tile's screen rectangle from its rounded edges.
+void Camera::tileToScreen(int col, int row, int tileSize, int& outX, int& outY, int& outW, int& outH) const {
+    float left, top, right, bottom;
+    worldToScreen(static_cast<float>(col) * tileSize, static_cast<float>(row) * tileSize, left, top);
+    worldToScreen(static_cast<float>(col + 1) * tileSize, static_cast<float>(row + 1) * tileSize, right, bottom);
+
+    outX = static_cast<int>(std::lround(left));
+    outY = static_cast<int>(std::lround(top));
+    outW = static_cast<int>(std::lround(right)) - outX;
+    outH = static_cast<int>(std::lround(bottom)) - outY;
+}
+
+// Computes the visible tile range, clamped to the map.
+void Camera::getVisibleTiles(int tileSize, int numCols, int numRows,
+                             int& firstCol, int& firstRow, int& endCol, int& endRow) const {
+    float worldRight = x + viewportWidth / zoom;
+    float worldBottom = y + viewportHeight / zoom;
+
+    firstCol = std::max(0, static_cast<int>(std::floor(x / tileSize)));
+    firstRow = std::max(0, static_cast<int>(std::floor(y / tileSize)));
+    endCol = std::min(numCols, static_cast<int>(std::ceil(worldRight / tileSize)));
+    endRow = std::min(numRows, static_cast<int>(std::ceil(worldBottom / tileSize)));
+}
+
+// Scrolls by a screen-space distance.
+void Camera::pan(float screenDx, float screenDy) {
+    x += screenDx / zoom;
+    y += screenDy / zoom;
+}
+
+// Zooms around a screen position so the world point under it stays put.
+void Camera::zoomAt(float factor, int screenX, int screenY) {
+    float worldX, worldY;
+    screenToWorld(screenX, screenY, worldX, worldY);
+
+    zoom = std::clamp(zoom * factor, MIN_ZOOM, MAX_ZOOM);
+    x = worldX - screenX / zoom;
+    y = worldY - screenY / zoom;
+}
+
+// Keeps the view inside the world; a world smaller than the view is pinned to the top-left.
+void Camera::clampTo(float worldWidth, float worldHeight) {
+    float maxX = std::max(0.0f, worldWidth - viewportWidth / zoom);
+    float maxY = std::max(0.0f, worldHeight - viewportHeight / zoom);
+    x = std::clamp(x, 0.0f, maxX);
+    y = std::clamp(y, 0.0f, maxY);
+}
+
+// Moves the camera and resets the zoom.
+void Camera::reset(float worldX, float worldY) {
+    x = worldX;
+    y = worldY;
+    zoom = 1.0f;
+}
+
+// Moves the camera, keeping the zoom.
+void Camera::moveTo(float worldX, float worldY) {
+    x = worldX;
+    y = worldY;
+}
+
+float Camera::getZoom() const {
+    return zoom;
+}
+
+float Camera::getX() const {
+    return x;
+}
+
+float Camera::getY() const {
+    return y;
+}
+
+int Camera::getViewportWidth() const {
+    return viewportWidth;
+}
+
+int Camera::getViewportHeight() const {
+    return viewportHeight;
+}
@@ -0,0 +1,181 @@
+#include "ChunkStreamer.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace {
+    // Bytes of tile data in one full chunk across all planes.
+    constexpr size_t CHUNK_BYTES = static_cast<size_t>(TileMap::CHUNK_SIZE) * TileMap::CHUNK_SIZE *
+                                   (sizeof(TerrainId) + sizeof(int32_t) + sizeof(uint8_t));
+}
+
+// Constructor: Sizes the chunk grid and budget, then starts the paging thread.
+ChunkStreamer::ChunkStreamer(const TileMap& tileMap, size_t memoryBudget)
+    : tileMap(tileMap),
+      chunkCols((tileMap.getNumCols() + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE),
+      chunkRows((tileMap.getNumRows() + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE),
+      maxChunks(std::max<size_t>(1, memoryBudget / CHUNK_BYTES)) {
+    worker = std::thread(&ChunkStreamer::workerLoop, this);
+}
+
+// Destructor: Stops and joins the paging thread.
+ChunkStreamer::~ChunkStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorker.notify_all();
+    worker.join();
+}
+
+// Marks the chunks around the view as wanted and queues any that are not tracked yet.
+void ChunkStreamer::update(int firstCol, int firstRow, int endCol, int endRow) {
+    const int size = TileMap::CHUNK_SIZE;
+    int firstCx = std::max(0, firstCol / size - PREFETCH_MARGIN);
+    int firstCy = std::max(0, firstRow / size - PREFETCH_MARGIN);
+    int endCx = std::min(chunkCols, (endCol + size - 1) / size + PREFETCH_MARGIN);
+    int endCy = std::min(chunkRows, (endRow + size - 1) / size + PREFETCH_MARGIN);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (firstCx == wantedFirstCx && firstCy == wantedFirstCy && endCx == wantedEndCx && endCy == wantedEndCy) {
+        return; // The view is still inside the same chunks.
+    }
+    wantedFirstCx = firstCx;
+    wantedFirstCy = firstCy;
+    wantedEndCx = endCx;
+    wantedEndCy = endCy;
+
+    std::vector<uint64_t> added;
+    for (int cy = firstCy; cy < endCy; cy++) {
+        for (int cx = firstCx; cx < endCx; cx++) {
+            uint64_t key = makeKey(cx, cy);
+            auto it = chunks.find(key);
+            if (it != chunks.end()) {
+                lru.splice(lru.begin(), lru, it->second.lruPosition);
+                continue;
+            }
+
+            lru.push_front(key);
+            chunks[key].lruPosition = lru.begin();
+            added.push_back(key);
+        }
+    }
+
+    if (added.empty()) {
+        return;
+    }
+
+    // Page in chunks closest to the centre of the view first.
+    int centreCx = firstCx + endCx;
+    int centreCy = firstCy + endCy;
+    std::sort(added.begin(), added.end(), [centreCx, centreCy](uint64_t a, uint64_t b) {
+        int ax = static_cast<int>(a & 0xFFFFFFFF) * 2 - centreCx, ay = static_cast<int>(a >> 32) * 2 - centreCy;
+        int bx = static_cast<int>(b & 0xFFFFFFFF) * 2 - centreCx, by = static_cast<int>(b >> 32) * 2 - centreCy;
+        return ax * ax + ay * ay < bx * bx + by * by;
+    });
+    pending.insert(pending.end(), added.begin(), added.end());
+    wakeWorker.notify_one();
+}
+
+size_t ChunkStreamer::getResidentChunkCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return residentCount;
+}
+
+// Pages in queued chunks and evicts the least recently wanted ones beyond the budget.
+void ChunkStreamer::workerLoop() {
+    PROFILE_THREAD_NAME("Chunk streamer");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeWorker.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        uint64_t key = pending.front();
+        pending.pop_front();
+        if (chunks.find(key) == chunks.end()) {
+            continue; // Evicted before it was paged in.
+        }
+
+        // Page faults happen here, off the render thread.
+        lock.unlock();
+        pageInChunk(static_cast<int>(key & 0xFFFFFFFF), static_cast<int>(key >> 32));
+        lock.lock();
+
+        auto it = chunks.find(key);
+        if (it != chunks.end() && !it->second.resident) {
+            it->second.resident = true;
+            residentCount++;
+        }
+
+        // Evict from the cold end of the LRU list, never touching the wanted area.
+        std::vector<std::pair<size_t, size_t>> runs;
+        while (chunks.size() > maxChunks) {
+            uint64_t victim = lru.back();
+            int cx = static_cast<int>(victim & 0xFFFFFFFF);
+            int cy = static_cast<int>(victim >> 32);
+            if (cx >= wantedFirstCx && cx < wantedEndCx && cy >= wantedFirstCy && cy < wantedEndCy) {
+                break;
+            }
+
+            if (chunks[victim].resident) {
+                residentCount--;
+            }
+            chunks.erase(victim);
+            lru.pop_back();
+            collectReleaseRuns(cx, cy, runs);
+        }
+
+        if (!runs.empty()) {
+            lock.unlock();
+            for (const auto& run : runs) {
+                tileMap.releaseTiles(run.first, run.second);
+            }
+            lock.lock();
+        }
+    }
+}
+
+// Pages in each row segment of a chunk.
+void ChunkStreamer::pageInChunk(int cx, int cy) const {
+    PROFILE_SCOPE("ChunkStreamer::pageInChunk");
+    const int numCols = tileMap.getNumCols();
+    int firstCol = cx * TileMap::CHUNK_SIZE;
+    int endCol = std::min(numCols, firstCol + TileMap::CHUNK_SIZE);
+    int firstRow = cy * TileMap::CHUNK_SIZE;
+    int endRow = std::min(tileMap.getNumRows(), firstRow + TileMap::CHUNK_SIZE);
+
+    for (int row = firstRow; row < endRow; row++) {
+        tileMap.prefetchTiles(static_cast<size_t>(row) * numCols + firstCol, endCol - firstCol);
+    }
+}
+
+// Extends an evicted chunk sideways over untracked neighbours and emits one run per row.
+void ChunkStreamer::collectReleaseRuns(int cx, int cy, std::vector<std::pair<size_t, size_t>>& runs) const {
+    int firstCx = cx;
+    int endCx = cx + 1;
+    while (firstCx > 0 && chunks.find(makeKey(firstCx - 1, cy)) == chunks.end()) firstCx--;
+    while (endCx < chunkCols && chunks.find(makeKey(endCx, cy)) == chunks.end()) endCx++;
+
+    const int numCols = tileMap.getNumCols();
+    int firstCol = firstCx * TileMap::CHUNK_SIZE;
+    int endCol = std::min(numCols, endCx * TileMap::CHUNK_SIZE);
+    int firstRow = cy * TileMap::CHUNK_SIZE;
+    int endRow = std::min(tileMap.getNumRows(), firstRow + TileMap::CHUNK_SIZE);
+
+    if (firstCol == 0 && endCol == numCols) {
+        // The whole chunk row is untracked: release it as one contiguous run.
+        runs.emplace_back(static_cast<size_t>(firstRow) * numCols, static_cast<size_t>(endRow - firstRow) * numCols);
+        return;
+    }
+
+    for (int row = firstRow; row < endRow; row++) {
+        runs.emplace_back(static_cast<size_t>(row) * numCols + firstCol, endCol - firstCol);
+    }
+}
+
+// Packs chunk coordinates into a 64-bit key (row in the high half).
+uint64_t ChunkStreamer::makeKey(int cx, int cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cy)) << 32) | static_cast<uint32_t>(cx);
+}
@@ -0,0 +1,156 @@
+#include "Compression.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    constexpr size_t MIN_MATCH = 4; ///< Shortest match worth encoding.
+    constexpr size_t MAX_OFFSET = 65535; ///< Farthest a match may reach back.
+    constexpr size_t LAST_LITERALS = 5; ///< Bytes at the end of a block that are always literals.
+    constexpr size_t MATCH_LIMIT = 12; ///< Matches must start at least this far before the end.
+    constexpr int HASH_BITS = 14; ///< Size of the match finder's table, as a power of two.
+
+    // Reads four bytes as an integer, for comparing and hashing.
+    inline uint32_t read32(const char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // Hashes four bytes into a match-table slot.
+    inline uint32_t hashSequence(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Writes the 255-byte extension of a length whose nibble was 15.
+    void writeLength(std::vector<char>& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+
+    // Reads a length extension; fails if the block ends first.
+    bool readLength(const uint8_t* in, size_t size, size_t& ip, size_t& length) {
+        uint8_t byte;
+        do {
+            if (ip >= size) {
+                return false;
+            }
+            byte = in[ip++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    // Emits one sequence: a token, the literals, and the match if there is one.
+    void writeSequence(std::vector<char>& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+        uint8_t token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+        token |= static_cast<uint8_t>(matchCode >= 15 ? 15 : matchCode);
+        out.push_back(static_cast<char>(token));
+
+        if (literalLength >= 15) {
+            writeLength(out, literalLength - 15);
+        }
+        out.insert(out.end(), literals, literals + literalLength);
+
+        if (matchLength) {
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15) {
+                writeLength(out, matchCode - 15);
+            }
+        }
+    }
+}
+
+// Greedy single-probe match finder over a hash table of 4-byte sequences.
+std::vector<char> compressBlock(const char* data, size_t size) {
+    std::vector<char> out;
+    out.reserve(size / 2 + 16);
+
+    size_t anchor = 0;
+    if (size > MATCH_LIMIT) {
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, UINT32_MAX);
+        const size_t matchEnd = size - LAST_LITERALS;
+        size_t pos = 0;
+
+        while (pos + MATCH_LIMIT <= size) {
+            uint32_t sequence = read32(data + pos);
+            uint32_t& slot = table[hashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos);
+
+            if (candidate == UINT32_MAX || pos - candidate > MAX_OFFSET || read32(data + candidate) != sequence) {
+                pos++;
+                continue;
+            }
+
+            size_t length = MIN_MATCH;
+            while (pos + length < matchEnd && data[candidate + length] == data[pos + length]) {
+                length++;
+            }
+
+            writeSequence(out, data + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    writeSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+// Decodes sequences with a bounds check before every copy.
+bool decompressBlock(const char* data, size_t size, char* out, size_t rawSize) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < size) {
+        uint8_t token = in[ip++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(in, size, ip, literalLength)) {
+            return false;
+        }
+        if (literalLength > size - ip || literalLength > rawSize - op) {
+            return false;
+        }
+        std::memcpy(out + op, in + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == size) {
+            break; // The last sequence has no match.
+        }
+
+        if (size - ip < 2) {
+            return false;
+        }
+        size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(in, size, ip, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > rawSize - op) {
+            return false;
+        }
+
+        // Matches may overlap their own output (runs), so copy forwards byte by byte.
+        const char* match = out + op - offset;
+        for (size_t i = 0; i < matchLength; i++) {
+            out[op + i] = match[i];
+        }
+        op += matchLength;
+    }
+
+    return op == rawSize;
+}
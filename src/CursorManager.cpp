@@ -5,14 +5,20 @@ CursorManager::CursorManager(int tileSize)
     : TILE_SIZE(tileSize), hoverTileX(-1), hoverTileY(-1) {}
 
 // Updates cursor position and detects if it moves to a new tile.
-bool CursorManager::update(const SDL_Event& event, int maxCols, int maxRows, int& outX, int& outY) {
+bool CursorManager::update(const SDL_Event& event, const Camera& camera, int maxCols, int maxRows, int& outX, int& outY) {
+    if (event.type != SDL_MOUSEMOTION) {
+        return false;
+    }
+
+    return updatePosition(event.motion.x, event.motion.y, camera, maxCols, maxRows, outX, outY);
+}
+
+// Translates a screen position through the camera and detects if it is over a new tile.
+bool CursorManager::updatePosition(int screenX, int screenY, const Camera& camera, int maxCols, int maxRows, int& outX, int& outY) {
     int oldHoverX = hoverTileX;
     int oldHoverY = hoverTileY;
 
-    if (event.type == SDL_MOUSEMOTION) {
-        hoverTileX = event.motion.x / TILE_SIZE;
-        hoverTileY = event.motion.y / TILE_SIZE;
-    }
+    camera.screenToTile(screenX, screenY, TILE_SIZE, hoverTileX, hoverTileY);
 
     // Reset hover coordinates if cursor moves outside valid tile bounds.
     if (hoverTileX < 0 || hoverTileX >= maxCols || hoverTileY < 0 || hoverTileY >= maxRows) {
@@ -39,3 +45,11 @@ int CursorManager::getHoverX() const {
 int CursorManager::getHoverY() const { 
     return hoverTileY; 
 }
+
+// Picks from the hovered tile's spatial hash cell instead of searching every entity.
+EntityId CursorManager::pickEntity(const SpatialHash& entities) const {
+    if (hoverTileX < 0 || hoverTileY < 0) {
+        return NO_ENTITY;
+    }
+    return entities.findOnTile(hoverTileX, hoverTileY);
+}
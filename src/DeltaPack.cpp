@@ -0,0 +1,91 @@
+#include "DeltaPack.h"
+#include "MapFormat.h"
+#include "Profiler.h"
+#include <cstring>
+#include <iostream>
+
+// Constructor: Works on the given archive.
+DeltaPack::DeltaPack(WorldArchive& archive)
+    : archive(archive) {}
+
+bool DeltaPack::contains(int col, int row) const {
+    return archive.contains(makeKey(col, row));
+}
+
+// Reads an inner map's entry and restores its tiles over the generated ones.
+bool DeltaPack::apply(int col, int row, TileMap& map) {
+    if (!contains(col, row)) {
+        return false;
+    }
+
+    PROFILE_SCOPE("DeltaPack::apply");
+    std::vector<char> data;
+    if (!archive.read(makeKey(col, row), data)) {
+        return false;
+    }
+
+    DeltaHeader header{};
+    TerrainRemap terrainRemap;
+    bool identityRemap = true;
+    size_t offset = sizeof(header);
+    if (data.size() >= sizeof(header)) {
+        std::memcpy(&header, data.data(), sizeof(header));
+    }
+    if (header.magic != DELTA_MAGIC || header.dictionaryCount > 256 ||
+        !decodeTerrainDictionary(data.data(), data.size(), header.dictionaryCount, offset, terrainRemap, identityRemap) ||
+        (data.size() - offset) / sizeof(DeltaEntry) < header.entryCount) {
+        std::cerr << "Error: Saved changes of inner map " << col << "," << row << " are corrupt.\n";
+        return false;
+    }
+    if (header.tileCount != map.getTileCount()) {
+        std::cerr << "Warning: Inner map " << col << "," << row << " changed size; saved changes ignored.\n";
+        return false;
+    }
+
+    const TerrainId* generated = map.getTerrainIds();
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        DeltaEntry entry;
+        std::memcpy(&entry, data.data() + offset + i * sizeof(DeltaEntry), sizeof(entry));
+        if (entry.index >= header.tileCount) {
+            continue;
+        }
+
+        TerrainId terrainId = terrainRemap[entry.terrainId];
+        if (terrainId == TerrainRegistry::INVALID_TERRAIN) {
+            terrainId = generated[entry.index]; // Terrain no longer exists; keep what the generator chose.
+        }
+        map.restoreTile(entry.index, terrainId, entry.ownerId, entry.flags);
+    }
+    return true;
+}
+
+// Encodes every changed tile (or every tile) and writes it as the inner map's entry.
+bool DeltaPack::store(int col, int row, const TileMap& map, bool allTiles) {
+    const TerrainId* terrainIds = map.getTerrainIds();
+    const int32_t* ownerIds = map.getOwnerIds();
+    const uint8_t* tileFlags = map.getTileFlags();
+
+    std::vector<char> data(sizeof(DeltaHeader));
+    DeltaHeader header{DELTA_MAGIC, static_cast<uint32_t>(map.getTileCount()), 0, appendTerrainDictionary(data)};
+
+    for (size_t i = 0; i < map.getTileCount(); i++) {
+        if (allTiles || (tileFlags[i] & TILE_FLAG_DIRTY)) {
+            DeltaEntry entry{static_cast<uint32_t>(i), ownerIds[i], terrainIds[i], tileFlags[i], 0};
+            const char* bytes = reinterpret_cast<const char*>(&entry);
+            data.insert(data.end(), bytes, bytes + sizeof(entry));
+            header.entryCount++;
+        }
+    }
+
+    if (header.entryCount == 0) {
+        return archive.remove(makeKey(col, row)); // Untouched maps are regenerated, never stored.
+    }
+
+    PROFILE_SCOPE("DeltaPack::store");
+    std::memcpy(data.data(), &header, sizeof(header));
+    return archive.write(makeKey(col, row), data.data(), data.size(), WorldArchive::STORE_COMPRESSED);
+}
+
+WorldArchive::Key DeltaPack::makeKey(int col, int row) {
+    return WorldArchive::Key{col, row, WorldArchive::DEPTH_INNER};
+}
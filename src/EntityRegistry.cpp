@@ -0,0 +1,119 @@
+#include "EntityRegistry.h"
+
+// Reuses the most recently freed slot, whose generation was bumped when it was freed.
+EntityId EntityRegistry::create() {
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else if (generations.size() < MAX_ENTITIES) {
+        index = static_cast<uint32_t>(generations.size());
+        generations.push_back(0);
+        alive.push_back(0);
+    } else {
+        return NO_ENTITY;
+    }
+
+    alive[index] = 1;
+    entityCount++;
+    return (static_cast<EntityId>(generations[index]) << ENTITY_INDEX_BITS) | index;
+}
+
+// Drops every component, then retires the handle by moving the slot to its next generation.
+bool EntityRegistry::destroy(EntityId entity) {
+    if (!isAlive(entity)) {
+        return false;
+    }
+
+    positions.remove(entity);
+    units.remove(entity);
+    movements.remove(entity);
+    spatialHash.remove(entity);
+
+    uint32_t index = entityIndex(entity);
+    alive[index] = 0;
+    generations[index]++;
+    freeSlots.push_back(index);
+    entityCount--;
+    return true;
+}
+
+bool EntityRegistry::isAlive(EntityId entity) const {
+    uint32_t index = entityIndex(entity);
+    return entity != NO_ENTITY && index < generations.size() && alive[index] &&
+           generations[index] == static_cast<uint8_t>(entity >> ENTITY_INDEX_BITS);
+}
+
+void EntityRegistry::clear() {
+    generations.clear();
+    alive.clear();
+    freeSlots.clear();
+    entityCount = 0;
+    positions.clear();
+    units.clear();
+    movements.clear();
+    spatialHash.clear();
+}
+
+size_t EntityRegistry::getEntityCount() const {
+    return entityCount;
+}
+
+// The position store and the spatial hash change together, so queries always match the positions.
+bool EntityRegistry::setPosition(EntityId entity, int col, int row) {
+    if (!isAlive(entity)) {
+        return false;
+    }
+
+    if (Position* position = positions.get(entity)) {
+        position->col = col;
+        position->row = row;
+    } else {
+        positions.insert(entity, Position{col, row});
+    }
+    spatialHash.insert(entity, col, row);
+    return true;
+}
+
+const ComponentStore<Position>& EntityRegistry::getPositions() const {
+    return positions;
+}
+
+ComponentStore<Unit>& EntityRegistry::getUnits() {
+    return units;
+}
+
+const ComponentStore<Unit>& EntityRegistry::getUnits() const {
+    return units;
+}
+
+ComponentStore<Movement>& EntityRegistry::getMovements() {
+    return movements;
+}
+
+const ComponentStore<Movement>& EntityRegistry::getMovements() const {
+    return movements;
+}
+
+const SpatialHash& EntityRegistry::getSpatialHash() const {
+    return spatialHash;
+}
+
+EntityId EntityRegistry::spawnUnit(int32_t ownerId, UnitKind kind, int col, int row) {
+    EntityId entity = create();
+    if (entity == NO_ENTITY) {
+        return NO_ENTITY;
+    }
+
+    setPosition(entity, col, row);
+    units.insert(entity, Unit{ownerId, kind, static_cast<uint16_t>(kind == UNIT_FORT ? 4 : 1)});
+    if (kind != UNIT_FORT) {
+        movements.insert(entity, Movement{col, row, 0});
+    }
+    return entity;
+}
+
+size_t EntityRegistry::getMemoryUsage() const {
+    return generations.capacity() + alive.capacity() + freeSlots.capacity() * sizeof(uint32_t) +
+           positions.getMemoryUsage() + units.getMemoryUsage() + movements.getMemoryUsage();
+}
@@ -1,4 +1,8 @@
 #include "Game.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
 
 // CONSTRUCTORS + DESTRUCTORS
 
@@ -23,213 +27,723 @@ Game::~Game() {
     cleanup();
 }
 
-// Initializes SDL, creates the window, and loads or generates the map.
-bool Game::init() {
-    std::string mapFile;
+// Initializes SDL, creates the window, and loads or generates the map. Headless runs skip SDL entirely.
+bool Game::init(const GameOptions& options) {
+    const std::string& mapFile = options.mapFile;
+    headless = options.headless;
+    headlessTicks = options.ticks;
+    tracePath = options.tracePath;
+    PROFILE_THREAD_NAME("Main");
+#ifndef WARGAME_PROFILING
+    if (!tracePath.empty()) {
+        std::cerr << "Warning: Profiling is compiled out of this build; no trace will be written.\n";
+    }
+#endif
 
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        SDL_Log("SDL could not initialize! SDL Error: %s", SDL_GetError());
-        return false;
+    if (!headless) {
+        // Initialize SDL
+        if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+            SDL_Log("SDL could not initialize! SDL Error: %s", SDL_GetError());
+            return false;
+        }
+
+        // Create game window
+        window = SDL_CreateWindow(
+            "Tile Game", 
+            SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 
+            WINDOW_WIDTH, 
+            WINDOW_HEIGHT, 
+            SDL_WINDOW_SHOWN
+        );
+
+        if (!window) {
+            SDL_Log("Window could not be created! SDL Error: %s", SDL_GetError());
+            return false;
+        }
+
+        // Initialize RenderManager
+        rendererManager = std::make_unique<RendererManager>(window, TILE_TEXTURES, TILE_SIZE);
     }
 
-    // Create game window
-    window = SDL_CreateWindow(
-        "Tile Game", 
-        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 
-        WINDOW_WIDTH, 
-        WINDOW_HEIGHT, 
-        SDL_WINDOW_SHOWN
-    );
+    int numRows = GlobalSettings::getInstance().getWorldRows();
+    int numCols = GlobalSettings::getInstance().getWorldCols();
 
-    if (!window) {
-        SDL_Log("Window could not be created! SDL Error: %s", SDL_GetError());
+    // Open the world archive; a new world starts from an empty one.
+    map_filename = mapFile;
+    std::error_code error;
+    std::filesystem::create_directories(MAP_PATH_PREFIX, error); // Fresh checkouts and batch boxes have no map folder yet.
+    if (!archive.open(MAP_PATH_PREFIX + WorldArchive::getArchiveFilename(mapFile), options.newMap)) {
         return false;
     }
 
-    // Initialize RenderManager
-    rendererManager = std::make_unique<RendererManager>(window, TILE_TEXTURES, TILE_SIZE);
-    int numRows = WINDOW_HEIGHT / TILE_SIZE;
-    int numCols = WINDOW_WIDTH / TILE_SIZE;
-
+    // Worlds saved before archives existed are imported on first load.
+    if (!options.newMap && !archive.contains(WorldArchive::WORLD_KEY) &&
+        ArchiveConverter::hasLegacyWorld(mapFile, MAP_PATH_PREFIX)) {
+        ArchiveConverter::convert(mapFile, MAP_PATH_PREFIX, archive);
+    }
 
-    // Load or generate the map
-    #if defined(LOAD_EXISTING_MAP)
-        mapFile = MAP_FILE_PATH;
-        tileMap.loadFromFile(mapFile, MAP_PATH_PREFIX);
-        SDL_Log("Loaded existing map: %s", mapFile.c_str());
+    // Load the world, or generate one if asked to or if the archive does not hold one yet
+    if (archive.contains(WorldArchive::WORLD_KEY) && loadWorldMap()) {
+        std::cout << "Loaded existing map: " << archive.getPath() << (tileMap.isMapped() ? " (mapped)" : "") << "\n";
+    } else {
+        uint64_t seed = options.seed ? *options.seed : WorldGenerator::randomSeed();
+        tileMap.generateTiles(numRows, numCols, TILE_SIZE, TerrainRegistry::getInstance().getAllTerrains(), seed);
+        std::cout << "Generated new map: " << archive.getPath() << " (seed " << seed << ")\n";
+    }
 
-    #elif defined(NEW_GAME_MAP)
-        mapFile = MAP_FILE_PATH;
-        tileMap.generateTiles(numRows, numCols, TILE_SIZE, 
-            {"medgrass2", "medgrass1", "darkgrass", "deadgrass1", "deadgrass2", "deadgrass3"});
-        tileMap.saveToFile(mapFile, MAP_PATH_PREFIX);
-        SDL_Log("Generated new map: %s", mapFile.c_str());
+    // Changes made after the last save survive a crash in the journal.
+    if (!journal.open(MAP_PATH_PREFIX + WorldJournal::getJournalFilename(mapFile), tileMap.getWorldSeed(), options.newMap)) {
+        std::cerr << "Warning: Running without a journal; changes since the last save are lost on a crash.\n";
+    }
+    if (!journal.getRecovered().empty()) {
+        recoverJournal();
+    }
 
-    #else
-        mapFile = "default_map.dat";
-        tileMap.generateTiles(numRows, numCols, TILE_SIZE, 
-            {"medgrass2", "medgrass1", "darkgrass", "deadgrass1", "deadgrass2", "deadgrass3"});
-        tileMap.saveToFile(mapFile, MAP_PATH_PREFIX);
-        SDL_Log("No map mode selected. Defaulting to: %s", mapFile.c_str());
-    #endif
+    // Checkpoints flush a mapped world in place but append a whole copy of a world held in memory,
+    // so store a generated, converted, or remapped world as a mappable entry and serve it from there.
+    if (!tileMap.isMapped() && tileMap.saveToArchive(archive, WorldArchive::WORLD_KEY, true) && archive.sync() &&
+        tileMap.openMapped(archive, WorldArchive::WORLD_KEY)) {
+        startChunkStreaming();
+    }
+    tileMap.setChangeTracking(true);
+    simulation.reset(tileMap);
+    if (!headless) {
+        visibility.setViewers({GlobalSettings::getInstance().getPlayerId()});
+        visibility.update(tileMap);
+    }
+    units.reset(tileMap);
+    units.spawnStartingUnits(entities, tileMap, GlobalSettings::getInstance().getStartingUnitsPerFaction());
 
-    SDL_Log("Using map: %s", mapFile.c_str());
-    map_filename = mapFile;
+    ioWorker = std::make_unique<MapIOWorker>(archive, journal);
     running = true;
     return true;
 }
 
-// Main game loop: Updates, renders, and processes events.
+// Main game loop: fixed-step updates, interpolated rendering, and blocking waits instead of spinning.
 void Game::run() {
+    if (headless) {
+        runHeadless();
+        return;
+    }
+
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+    const double tickSeconds = 1.0 / settings.getTickRate();
+    const int targetFps = settings.isVsyncEnabled() ? 0 : settings.getTargetFps(); // Vsync paces presents itself.
+    const double frameSeconds = targetFps > 0 ? 1.0 / targetFps : 0.0;
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+    Uint64 previous = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
+    double sinceFrame = 0.0;
+    bool redraw = true;
+
     while (running) {
-        update();
-        render();
-        processEvents();
+        // Sleep until input arrives or the next update or frame is due; when idle, until input arrives.
+        bool idle = isIdle();
+        int timeoutMs = IDLE_WAIT_MS;
+        if (!idle) {
+            double untilDue = std::min(tickSeconds - accumulator, frameSeconds - sinceFrame);
+            timeoutMs = static_cast<int>(std::max(0.0, untilDue) * 1000.0);
+        }
+        redraw = processEvents(timeoutMs) || redraw;
+
+        Uint64 now = SDL_GetPerformanceCounter();
+#ifdef WARGAME_PROFILING
+        Uint64 frameStart = now; // Frame time excludes waiting for input.
+#endif
+        double elapsed = std::min(static_cast<double>(now - previous) / frequency, MAX_FRAME_SECONDS);
+        previous = now;
+
+        if (idle) {
+            // Time spent waiting for input is not simulated.
+            accumulator = 0.0;
+            tickPanX = tickPanY = 0.0f;
+        } else {
+            accumulator += elapsed;
+            while (accumulator >= tickSeconds) {
+                scrollCamera(tickSeconds);
+                update(tickSeconds);
+                accumulator -= tickSeconds;
+            }
+            sinceFrame += elapsed;
+        }
+
+        pollBackgroundWork();
+
+        if (idle ? redraw : sinceFrame >= frameSeconds) {
+            render(idle ? 1.0f : static_cast<float>(accumulator / tickSeconds));
+            sinceFrame = 0.0;
+            redraw = false;
+#ifdef WARGAME_PROFILING
+            recordFrameStats(static_cast<double>(SDL_GetPerformanceCounter() - frameStart) / frequency, elapsed);
+#endif
+        }
+    }
+}
+
+// Headless loop: runs updates back to back without presenting frames, then reports the rate.
+void Game::runHeadless() {
+    const double tickSeconds = 1.0 / GlobalSettings::getInstance().getTickRate();
+    const uint64_t startTick = tickCount;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < headlessTicks && running; ++i) {
+        update(tickSeconds);
     }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t ticks = tickCount - startTick;
+    std::cout << "Ran " << ticks << " ticks in " << elapsed.count() << " s";
+    if (elapsed.count() > 0.0) {
+        std::cout << " (" << static_cast<uint64_t>(ticks / elapsed.count()) << " ticks/s)";
+    }
+    std::cout << "\n";
+    running = false;
+}
+
+#ifdef WARGAME_PROFILING
+// Adds a frame to the profiler and, while the overlay is shown, puts p50/p99 and map memory in the window title once a second.
+void Game::recordFrameStats(double frameSeconds, double elapsed) {
+    Profiler& profiler = Profiler::getInstance();
+    profiler.recordFrame(frameSeconds);
+
+    statsSeconds += elapsed;
+    if (statsSeconds < 1.0 || !rendererManager->isProfilerOverlayVisible()) {
+        return;
+    }
+    statsSeconds = 0.0;
+
+    char title[192];
+    std::snprintf(title, sizeof(title), "Tile Game - frame p50 %.2f ms, p99 %.2f ms - map %zu KiB, %zu cached inner maps %zu KiB",
+                  profiler.getFramePercentile(50.0) * 1000.0, profiler.getFramePercentile(99.0) * 1000.0,
+                  tileMap.getMemoryUsage() / 1024, innerMaps.size(), innerMaps.getMemoryUsage() / 1024);
+    SDL_SetWindowTitle(window, title);
+}
+#endif
+
+// Checks whether nothing is simulating, moving or loading, so the loop can block on input.
+bool Game::isIdle() const {
+    return simulationPaused && !scrollLeft && !scrollRight && !scrollUp && !scrollDown && !transitionPending;
 }
 
-// Cleans up SDL resources.
+// Saves every changed map, then cleans up SDL resources.
 void Game::cleanup() {
+    finishSimulation();
+    chunkStreamer.reset();
+    saveChangedMaps();
+    ioWorker.reset(); // Finishes any queued saves.
+#ifdef WARGAME_PROFILING
+    if (!tracePath.empty()) {
+        Profiler::getInstance().exportChromeTrace(tracePath);
+        tracePath.clear(); // cleanup() also runs from the destructor.
+    }
+#endif
+    tileMap.flush(); // Write back in-place changes to a mapped world.
+    archive.close(); // Records the index, so the next open need not scan the archive.
+    rendererManager.reset();
     if (window) SDL_DestroyWindow(window);
-    SDL_Quit();
+    window = nullptr;
+    if (!headless) SDL_Quit();
 }
 
-// Processes SDL events such as quitting, mouse movement, and key presses.
-void Game::processEvents() {
+// Waits up to a timeout for events, then processes every queued event.
+bool Game::processEvents(int timeoutMs) {
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) {
-            running = false;
-        }
+    bool received = timeoutMs > 0 ? SDL_WaitEventTimeout(&event, timeoutMs) : SDL_PollEvent(&event);
+    if (!received) {
+        return false;
+    }
 
-        // Handle mouse movement
-        if (event.type == SDL_MOUSEMOTION) {
-            int hoverX, hoverY;
-            if (cursorManager.update(event, WINDOW_WIDTH / TILE_SIZE, WINDOW_HEIGHT / TILE_SIZE, hoverX, hoverY)) {
-                handleTileHover(event.motion.x, event.motion.y, hoverX, hoverY);
-            }
+    PROFILE_SCOPE("Game::processEvents");
+    finishSimulation(); // Input may change or swap the maps the simulation reads.
+    do {
+        handleEvent(event);
+    } while (SDL_PollEvent(&event));
+    return true;
+}
+
+// Handles one SDL event such as quitting, mouse movement, and key presses.
+void Game::handleEvent(const SDL_Event& event) {
+    if (event.type == SDL_QUIT) {
+        running = false;
+    }
+
+    // The renderer lost its render-target contents; rebuild the cached terrain layer.
+    if (event.type == SDL_RENDER_TARGETS_RESET) {
+        rendererManager->invalidateCache();
+    }
+
+    // Handle mouse movement
+    if (event.type == SDL_MOUSEMOTION) {
+        int hoverX, hoverY;
+        if (cursorManager.update(event, rendererManager->getCamera(), tileMap.getNumCols(), tileMap.getNumRows(), hoverX, hoverY)) {
+            handleTileHover(hoverX, hoverY);
         }
+    }
 
-        // Handle mouse click
-        if (event.type == SDL_MOUSEBUTTONDOWN) {
-            std::shared_ptr<Tile> tile = tileMap.getTileAt(event.motion.x, event.motion.y);
-            if (GlobalSettings::getInstance().isPlayerId(tile->getOwnerId())) {
-                enterInnerMap(tile);
-            }
+    // Handle camera scrolling and zooming
+    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP || event.type == SDL_MOUSEWHEEL) {
+        handleCameraInput(event);
+    }
+
+    // Handle mouse click; the map button and the minimap take clicks before the world under them
+    if (event.type == SDL_MOUSEBUTTONDOWN && curr_state == OUTER) {
+        float worldX, worldY;
+        if (rendererManager->isOverMapButton(event.button.x, event.button.y)) {
+            rendererManager->setMinimapVisible(!rendererManager->isMinimapVisible());
+            return;
         }
+        if (rendererManager->minimapToWorld(event.button.x, event.button.y, tileMap, worldX, worldY)) {
+            centerCamera(worldX, worldY);
+            return;
+        }
+    }
+    if (event.type == SDL_MOUSEBUTTONDOWN) {
+        std::optional<Tile> tile = tileMap.getTileAt(event.button.x, event.button.y, rendererManager->getCamera());
+        if (tile && GlobalSettings::getInstance().isPlayerId(tile->getOwnerId())) {
+            enterInnerMap(*tile);
+        }
+    }
 
-        // Handle tab key press to exit inner map
-        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_TAB) {
-            exitInnerMap();
+    // Handle tab key press to exit inner map
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_TAB) {
+        exitInnerMap();
+    }
+
+    // P pauses and resumes the territory simulation
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_p) {
+        simulationPaused = !simulationPaused;
+    }
+
+    // M shows and hides the minimap
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_m) {
+        rendererManager->setMinimapVisible(!rendererManager->isMinimapVisible());
+    }
+
+#ifdef WARGAME_PROFILING
+    // F3 toggles the frame-time overlay; F4 exports a trace of recent frames
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+        bool visible = !rendererManager->isProfilerOverlayVisible();
+        rendererManager->setProfilerOverlayVisible(visible);
+        if (!visible) {
+            SDL_SetWindowTitle(window, "Tile Game");
         }
     }
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F4) {
+        Profiler::getInstance().exportChromeTrace(TRACE_FILE);
+    }
+#endif
 }
 
-// Game state update (currently not implemented).
-void Game::update() {
-    // DO LATER
-}
+// Fixed-step game update. Runs in headless mode too, so it must not touch the renderer or the camera.
+void Game::update(double /*tickSeconds*/) {
+    PROFILE_SCOPE("Game::update");
+    ++tickCount;
+
+    // Territory is contested on the world even while an inner map is shown. The captures rolled
+    // last tick land first; this tick's are rolled on the job pool while everything up to the next
+    // update, the frame included, only reads the world.
+    TileMap& world = curr_state == INNER ? worldMap : tileMap;
+    finishSimulation();
+    if (!simulationPaused) {
+        simulationJob = JobSystem::getInstance().schedule([this, &world] { simulation.contest(world); });
+        units.tick(entities, world);
+    }
+    // Fog of war is only ever drawn, so headless runs skip it. The pyramid is brought up to date in render().
+    if (!headless) {
+        visibility.update(world);
+    }
 
-// Renders the game scene.
-void Game::render() {
-    rendererManager->clear();
-    rendererManager->render(tileMap); 
-    rendererManager->present();
+    journalChanges();
+    // Counted by the game rather than read from the journal, which the worker trims some time after a
+    // checkpoint is queued and which may not be open at all.
+    if (changesSinceCheckpoint * sizeof(JournalRecord) > GlobalSettings::getInstance().getJournalCheckpointSize()) {
+        checkpoint();
+    }
 }
 
-// Handles entering an inner map from a tile.
-void Game::enterInnerMap(std::shared_ptr<Tile> tile) {
-    if (curr_state == INNER || !tile) {
+// Waits for the captures being rolled on the job pool, if any, and applies them to the world.
+void Game::finishSimulation() {
+    if (!simulationJob) {
         return;
     }
 
-    // Save current map state before switching
-    #ifdef MAP_FILE_PATH
-        tileMap.saveToFile(MAP_FILE_PATH, MAP_PATH_PREFIX);
-    #else
-        std::cerr << "Warning: MAP_FILE_PATH is not defined, using default map file.\n";
-        tileMap.saveToFile("default_map.dat", MAP_PATH_PREFIX);
-    #endif
+    PROFILE_SCOPE("Game::finishSimulation");
+    JobSystem::getInstance().wait(simulationJob);
+    simulationJob.reset();
+    simulation.applyContest(curr_state == INNER ? worldMap : tileMap);
+}
 
-    generateInnerMap(tile);
-    curr_state = INNER;
+// Scrolls the camera by one fixed step while keys are held.
+void Game::scrollCamera(double tickSeconds) {
+    Camera& camera = rendererManager->getCamera();
+    float startX = camera.getX();
+    float startY = camera.getY();
+
+    float distance = static_cast<float>(SCROLL_SPEED * tickSeconds);
+    camera.pan((scrollRight - scrollLeft) * distance, (scrollDown - scrollUp) * distance);
+    camera.clampTo(static_cast<float>(tileMap.getNumCols()) * TILE_SIZE, static_cast<float>(tileMap.getNumRows()) * TILE_SIZE);
+
+    // Remember this tick's movement so frames between ticks can be interpolated.
+    tickPanX = camera.getX() - startX;
+    tickPanY = camera.getY() - startY;
+    if (tickPanX != 0.0f || tickPanY != 0.0f) {
+        refreshHover();
+    }
 }
 
-// Generates an inner map for a tile, either loading from file or creating a new one.
-void Game::generateInnerMap(std::shared_ptr<Tile> tile) {
-    if (!tile) {
-        std::cerr << "Error: Null tile passed to generateInnerMap.\n";
+// Per-frame work outside the fixed step: finishes map transitions and streams world chunks around the view.
+void Game::pollBackgroundWork() {
+    PROFILE_SCOPE("Game::pollBackgroundWork");
+    finishTransition();
+
+    // A view drawn from the pyramid does not read the tiles, so there is nothing to stream.
+    if (chunkStreamer && MapPyramid::chooseLevel(TILE_SIZE * rendererManager->getCamera().getZoom()) == 0) {
+        int firstCol, firstRow, endCol, endRow;
+        rendererManager->getCamera().getVisibleTiles(TILE_SIZE, tileMap.getNumCols(), tileMap.getNumRows(),
+                                                     firstCol, firstRow, endCol, endRow);
+        chunkStreamer->update(firstCol, firstRow, endCol, endRow);
+    }
+}
+
+// Tracks held arrow/WASD keys for scrolling in update(), and zooms the camera with the mouse wheel.
+void Game::handleCameraInput(const SDL_Event& event) {
+    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+        bool held = event.type == SDL_KEYDOWN;
+        switch (event.key.keysym.sym) {
+            case SDLK_LEFT:  case SDLK_a: scrollLeft = held; break;
+            case SDLK_RIGHT: case SDLK_d: scrollRight = held; break;
+            case SDLK_UP:    case SDLK_w: scrollUp = held; break;
+            case SDLK_DOWN:  case SDLK_s: scrollDown = held; break;
+            default: break;
+        }
         return;
     }
 
-    // Determine base map filename
-    #ifdef MAP_FILE_PATH
-        std::string mapName = MAP_FILE_PATH;
-    #else
-        std::string mapName = "default_map.dat";
-    #endif
+    if (event.wheel.y == 0) return; // Horizontal scrolling only.
 
-    // Strip ".dat" extension
-    size_t pos = mapName.rfind(".dat");
-    if (pos != std::string::npos) {
-        mapName = mapName.substr(0, pos);
+    Camera& camera = rendererManager->getCamera();
+    int mouseX, mouseY;
+    getMousePosition(mouseX, mouseY);
+    camera.zoomAt(event.wheel.y > 0 ? 1.1f : 1.0f / 1.1f, mouseX, mouseY);
+    camera.clampTo(static_cast<float>(tileMap.getNumCols()) * TILE_SIZE, static_cast<float>(tileMap.getNumRows()) * TILE_SIZE);
+    tickPanX = tickPanY = 0.0f; // The camera jumped; do not interpolate across it.
+    refreshHover();
+}
+
+// Moves the camera so a world position is in the middle of the screen.
+void Game::centerCamera(float worldX, float worldY) {
+    Camera& camera = rendererManager->getCamera();
+    camera.moveTo(worldX - camera.getViewportWidth() / camera.getZoom() / 2.0f,
+                  worldY - camera.getViewportHeight() / camera.getZoom() / 2.0f);
+    camera.clampTo(static_cast<float>(tileMap.getNumCols()) * TILE_SIZE, static_cast<float>(tileMap.getNumRows()) * TILE_SIZE);
+    tickPanX = tickPanY = 0.0f; // The camera jumped; do not interpolate across it.
+    refreshHover();
+}
+
+// Recomputes the hovered tile after the camera or map changed under a still cursor.
+void Game::refreshHover() {
+    int mouseX, mouseY, hoverX, hoverY;
+    getMousePosition(mouseX, mouseY);
+    if (cursorManager.updatePosition(mouseX, mouseY, rendererManager->getCamera(), tileMap.getNumCols(), tileMap.getNumRows(), hoverX, hoverY)) {
+        handleTileHover(hoverX, hoverY);
     }
+}
 
-    // Construct full path for inner map
-    std::string innerMapFile = MAP_PATH_PREFIX + mapName + "/tile_" + 
-                               std::to_string(tile->getX()) + "_" + 
-                               std::to_string(tile->getY()) + ".dat";
+// Renders the game scene, placing the camera between the last two updates.
+void Game::render(float alpha) {
+    PROFILE_SCOPE("Game::render");
+    Camera& camera = rendererManager->getCamera();
+    float cameraX = camera.getX();
+    float cameraY = camera.getY();
+    camera.moveTo(cameraX - tickPanX * (1.0f - alpha), cameraY - tickPanY * (1.0f - alpha));
+
+    // Only a zoomed-out view or the minimap reads the pyramid; until one is drawn, changes just mark cells.
+    if (curr_state == OUTER && (rendererManager->isMinimapVisible() || MapPyramid::chooseLevel(TILE_SIZE * camera.getZoom()) > 0)) {
+        pyramid.update(tileMap);
+    }
 
-    // Load existing inner map if available
-    if (std::filesystem::exists(innerMapFile)) {
-        std::cout << "Loading inner map from " << innerMapFile << "\n";
-        tileMap.loadFromFile(innerMapFile, MAP_PATH_PREFIX);
+    rendererManager->clear();
+    // Fog of war, units and the pyramid belong to the world; an inner map is shown in full and empty.
+    rendererManager->render(tileMap, curr_state == OUTER ? &visibility : nullptr, curr_state == OUTER ? &entities : nullptr,
+                            curr_state == OUTER ? &pyramid : nullptr);
+    rendererManager->present();
+
+    camera.moveTo(cameraX, cameraY);
+}
+
+// Requests the inner map of a tile; the switch happens once the I/O worker has it ready.
+void Game::enterInnerMap(const Tile& tile) {
+    PROFILE_SCOPE("Game::enterInnerMap");
+    if (curr_state == INNER || transitionPending) {
         return;
-    } 
+    }
 
-    std::cout << "Generating new inner map for tile (" << tile->getX() << ", " << tile->getY() << ")\n";
+    transitionPending = true;
+    pendingCol = tile.getCol();
+    pendingRow = tile.getRow();
+    if (!innerMaps.contains(pendingCol, pendingRow)) {
+        ioWorker->requestInnerMap(getInnerMapRequest(tile));
+    }
+    finishTransition(); // Swaps immediately if the map was cached or prefetched.
+}
+
+// Describes a tile's inner map: where it is, and the terrain family and seed it is generated from.
+MapIOWorker::InnerMapRequest Game::getInnerMapRequest(const Tile& tile) const {
+    // While an inner map is shown the world is parked in worldMap.
+    const TileMap& world = curr_state == INNER ? worldMap : tileMap;
+    return MapIOWorker::InnerMapRequest{tile.getCol(), tile.getRow(), getMatchingTerrain(tile.getTerrainId()),
+                                        WorldGenerator::deriveInnerSeed(world.getWorldSeed(), tile.getCol(), tile.getRow())};
+}
+
+// Swaps in a pending inner map once it is cached or the I/O worker has finished it.
+void Game::finishTransition() {
+    if (!transitionPending) {
+        return;
+    }
+
+    std::optional<TileMap> map = innerMaps.take(pendingCol, pendingRow);
+    if (!map) {
+        map = ioWorker->takeInnerMap(pendingCol, pendingRow);
+    }
+    if (!map) {
+        return; // Still loading; keep showing the current map.
+    }
 
-    // Generate new inner map
-    tileMap.generateTiles(WINDOW_HEIGHT / TILE_SIZE, WINDOW_WIDTH / TILE_SIZE, TILE_SIZE, 
-        getMatchingTerrain(tile->getAssetAlias()), true);
+    PROFILE_SCOPE("Game::finishTransition");
+    finishSimulation();
 
-    // Ensure the directory exists before saving
-    std::filesystem::create_directories(MAP_PATH_PREFIX + mapName);
+    // Park the world in memory and remember where the camera was.
+    chunkStreamer.reset();
+    outerCamera = rendererManager->getCamera();
+    rendererManager->getCamera().reset();
+    worldMap = std::move(tileMap);
+    tileMap = std::move(*map);
+    tickPanX = tickPanY = 0.0f;
 
-    // Save the generated inner map
-    tileMap.saveToFile(innerMapFile, MAP_PATH_PREFIX);
+    tileMap.setChangeTracking(true);
+
+    innerCol = pendingCol;
+    innerRow = pendingRow;
+    curr_state = INNER;
+    transitionPending = false;
+    refreshHover();
 }
 
-// Returns terrain types matching the given terrain alias.
-std::vector<std::string> Game::getMatchingTerrain(const std::string& terrainType) {
-    if (terrainType == "darkgrass") return {"darkgrass"};
-    if (terrainType == "medgrass1" || terrainType == "medgrass2") return {"medgrass1", "medgrass2"};
-    if (terrainType == "deadgrass1" || terrainType == "deadgrass2" || terrainType == "deadgrass3") 
-        return {"deadgrass1", "deadgrass2", "deadgrass3"};
-    return {"darkgrass"}; // Default case
+// Returns terrain types in the same family as the given terrain.
+std::vector<TerrainId> Game::getMatchingTerrain(TerrainId terrainId) {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    const std::vector<TerrainId>& matching = registry.getMatchingTerrain(terrainId);
+    if (!matching.empty()) return matching;
+    return {registry.getId("darkgrass")}; // Default case
 }
 
-// Exits the inner map and reloads the outer map.
+// Returns to the resident world, keeping the inner map cached for the next visit.
 void Game::exitInnerMap() {
     if (curr_state == OUTER) return;
-    tileMap.loadFromFile(map_filename, MAP_PATH_PREFIX);
+
+    finishSimulation();
+    journalChanges(); // The cache keeps maps packed, without their change lists.
+    for (InnerMapCache::Entry& evicted : innerMaps.put(innerCol, innerRow, std::move(tileMap))) {
+        ioWorker->saveInnerMap(std::move(evicted.map), evicted.col, evicted.row);
+    }
+
+    tileMap = std::move(worldMap);
+    if (outerCamera) {
+        rendererManager->getCamera() = *outerCamera;
+    }
+    tickPanX = tickPanY = 0.0f;
+    startChunkStreaming();
+
     curr_state = OUTER;
+    refreshHover();
+}
+
+// Queues a save of every resident map with unsaved changes; a mapped world is flushed by cleanup().
+void Game::saveChangedMaps() {
+    if (!ioWorker) {
+        return; // Never initialized.
+    }
+
+    finishSimulation();
+    journalChanges();
+    uint64_t journalPosition = journal.mark();
+
+    if (curr_state == INNER) {
+        if (tileMap.hasUnsavedChanges()) {
+            ioWorker->saveInnerMap(std::move(tileMap), innerCol, innerRow);
+        }
+        tileMap = std::move(worldMap);
+        curr_state = OUTER;
+    }
+
+    for (InnerMapCache::Entry& entry : innerMaps.drain()) {
+        ioWorker->saveInnerMap(std::move(entry.map), entry.col, entry.row);
+    }
+
+    if (tileMap.isMapped()) {
+        tileMap.flush(); // Before the checkpoint, so the journal is only trimmed once the world is on disk.
+    } else if (tileMap.hasUnsavedChanges()) {
+        ioWorker->saveWorld(std::move(tileMap));
+    }
+    ioWorker->checkpoint(journalPosition);
 }
 
-void Game::handleTileHover(int mouseX, int mouseY, int hoverX, int hoverY) {
-    std::shared_ptr<Tile> tile = tileMap.getTileAt(mouseX, mouseY);
-    if (!tile) return; // Prevent accessing a null pointer
+// Journals the shown map and, while an inner map is shown, the parked world.
+void Game::journalChanges() {
+    auto appendChanges = [this](TileMap& map, const WorldArchive::Key& key) {
+        const TerrainId* terrainIds = map.getTerrainIds();
+        const int32_t* ownerIds = map.getOwnerIds();
+        const uint8_t* flags = map.getTileFlags();
+        std::vector<uint32_t> changed = map.takeChangedTiles();
+        for (uint32_t index : changed) {
+            journal.append(key, index, terrainIds[index], ownerIds[index], flags[index]);
+            ++changesSinceCheckpoint;
+        }
+        if (key == WorldArchive::WORLD_KEY) {
+            pyramid.noteChangedTiles(map, changed);
+        }
+    };
+
+    if (curr_state == INNER) {
+        appendChanges(tileMap, WorldArchive::Key{innerCol, innerRow, WorldArchive::DEPTH_INNER});
+        appendChanges(worldMap, WorldArchive::WORLD_KEY);
+    } else {
+        appendChanges(tileMap, WorldArchive::WORLD_KEY);
+    }
+    // The write and flush happen on the I/O worker, off the tick.
+    if (ioWorker) {
+        ioWorker->commitJournal();
+    } else {
+        journal.commit();
+    }
+}
+
+// Saves copies of the changed maps in the background; the worker trims the journal once they are written.
+void Game::checkpoint() {
+    PROFILE_SCOPE("Game::checkpoint");
+    journalChanges();
+    uint64_t journalPosition = journal.mark();
+    changesSinceCheckpoint = 0;
+
+    TileMap& world = curr_state == INNER ? worldMap : tileMap;
+    if (world.isMapped()) {
+        world.flush();
+    } else if (world.hasUnsavedChanges()) {
+        ioWorker->saveWorld(TileMap(world));
+        world.markSaved();
+    }
+
+    if (curr_state == INNER && tileMap.hasUnsavedChanges()) {
+        ioWorker->saveInnerMap(TileMap(tileMap), innerCol, innerRow);
+        tileMap.markSaved();
+    }
+    for (InnerMapCache::Entry& entry : innerMaps.collectUnsaved()) {
+        ioWorker->saveInnerMap(std::move(entry.map), entry.col, entry.row);
+    }
+
+    ioWorker->checkpoint(journalPosition);
+}
+
+// Replays world records onto the loaded world and inner records onto their rebuilt inner maps, then saves them all.
+void Game::recoverJournal() {
+    const std::vector<JournalRecord>& records = journal.getRecovered();
+    std::map<std::pair<int, int>, std::vector<const JournalRecord*>> innerRecords;
+    size_t replayed = 0;
+    for (const JournalRecord& record : records) {
+        if (record.depth == WorldArchive::DEPTH_INNER) {
+            innerRecords[{record.x, record.y}].push_back(&record);
+        } else if (record.depth == WorldArchive::DEPTH_WORLD && record.index < tileMap.getTileCount()) {
+            tileMap.replayTile(record.index, record.terrainId, record.ownerId, record.flags);
+            replayed++;
+        }
+    }
+
+    DeltaPack deltaPack(archive);
+    for (const auto& [position, group] : innerRecords) {
+        std::optional<Tile> parent = tileMap.getTile(position.first, position.second);
+        if (!parent) {
+            continue; // The world no longer has this tile.
+        }
+
+        TileMap inner = MapIOWorker::buildInnerMap(getInnerMapRequest(*parent), deltaPack);
+        for (const JournalRecord* record : group) {
+            if (record->index < inner.getTileCount()) {
+                inner.replayTile(record->index, record->terrainId, record->ownerId, record->flags);
+                replayed++;
+            }
+        }
+        deltaPack.store(position.first, position.second, inner);
+    }
+
+    bool saved = tileMap.isMapped() ? tileMap.flush() : tileMap.saveToArchive(archive, WorldArchive::WORLD_KEY, true);
+    if (saved && archive.sync()) {
+        journal.trim(journal.mark());
+    } else {
+        std::cerr << "Warning: Could not save the recovered changes; the journal is kept for the next start.\n";
+    }
+    journal.clearRecovered();
+    std::cout << "Recovered " << replayed << " tile changes from the journal.\n";
+}
+
+// Maps the world entry in place when possible, falling back to reading it into memory.
+bool Game::loadWorldMap() {
+    chunkStreamer.reset();
+
+    bool loaded = tileMap.openMapped(archive, WorldArchive::WORLD_KEY) ||
+                  tileMap.loadFromArchive(archive, WorldArchive::WORLD_KEY);
+    if (loaded) {
+        startChunkStreaming();
+    }
+    return loaded;
+}
+
+// Mapped worlds can be far larger than memory; stream the chunks around the view.
+void Game::startChunkStreaming() {
+    if (tileMap.isMapped() && !headless) {
+        chunkStreamer = std::make_unique<ChunkStreamer>(tileMap, GlobalSettings::getInstance().getChunkCacheBudget());
+    }
+}
+
+// Queues the inner maps around the hovered tile that the player could enter next.
+void Game::prefetchInnerMaps(int hoverX, int hoverY) {
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+    std::vector<MapIOWorker::InnerMapRequest> requests;
+
+    // The hovered tile first, then its neighbours.
+    static const int OFFSETS[9][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+    for (const auto& offset : OFFSETS) {
+        std::optional<Tile> tile = tileMap.getTile(hoverX + offset[0], hoverY + offset[1]);
+        if (tile && settings.isPlayerId(tile->getOwnerId()) && !innerMaps.contains(tile->getCol(), tile->getRow())) {
+            requests.push_back(getInnerMapRequest(*tile));
+        }
+    }
+
+    ioWorker->prefetchInnerMaps(requests);
+}
+
+void Game::handleTileHover(int hoverX, int hoverY) {
+    std::optional<Tile> tile = tileMap.getTile(hoverX, hoverY);
+    if (!tile) return; // Cursor is outside the map
 
     const GlobalSettings& settings = GlobalSettings::getInstance();
     const int32_t& ownerId = tile->getOwnerId();
 
     SDL_Color color = settings.isPlayerId(ownerId) ? SDL_Color{0, 255, 0, 125} : SDL_Color{255, 255, 0, 125};
-    if (ownerId == 1776) {
+    // Owners and units on world tiles the player cannot see now are not given away.
+    if (curr_state == OUTER && !visibility.isVisible(settings.getPlayerId(), hoverX, hoverY)) {
+        color = SDL_Color{0, 0, 0, 125};
+    } else if (curr_state == OUTER && cursorManager.pickEntity(entities.getSpatialHash()) != NO_ENTITY) {
+        color = SDL_Color{0, 160, 255, 125}; // A unit stands here.
+    } else if (ownerId == 1776) {
         color = SDL_Color{0, 0, 0, 125};
     }
 
     rendererManager->updateHover(hoverX, hoverY, color);
+
+    if (curr_state == OUTER && !transitionPending) {
+        prefetchInnerMaps(hoverX, hoverY);
+    }
 }
 
 void Game::getMousePosition(int &mouseX, int &mouseY) {
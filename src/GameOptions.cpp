@@ -0,0 +1,73 @@
+#include "GameOptions.h"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Parses a whole argument as an unsigned number; empty, signed, partly numeric and out-of-range values fail.
+    bool parseUnsigned(const char* text, int base, unsigned long long& value) {
+        if (text[0] == '\0' || text[0] == '-' || text[0] == '+' || std::isspace(static_cast<unsigned char>(text[0]))) {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtoull(text, &end, base);
+        return errno == 0 && *end == '\0';
+    }
+}
+
+// Parses the command line; unknown arguments and missing values are errors.
+bool GameOptions::parse(int argc, char* argv[], GameOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(arg, "--new") == 0) {
+            options.newMap = true;
+        } else if (std::strcmp(arg, "--convert") == 0) {
+            options.convert = true;
+        } else if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            options.showHelp = true;
+        } else if (std::strcmp(arg, "--map") == 0 && hasValue) {
+            options.mapFile = argv[++i];
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            unsigned long long seed = 0;
+            if (!parseUnsigned(argv[++i], 0, seed)) {
+                std::cerr << "Error: Invalid seed \"" << argv[i] << "\"\n";
+                return false;
+            }
+            options.seed = seed;
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(arg, "--ticks") == 0 && hasValue) {
+            unsigned long long ticks = 0;
+            if (!parseUnsigned(argv[++i], 10, ticks) || ticks > static_cast<unsigned long long>(LLONG_MAX)) {
+                std::cerr << "Error: Invalid tick count \"" << argv[i] << "\"\n";
+                return false;
+            }
+            options.ticks = static_cast<long long>(ticks);
+        } else {
+            std::cerr << "Error: Unknown or incomplete argument " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prints the supported arguments.
+void GameOptions::printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --map <file>     World map file under the map directory (default starter_map.dat)\n"
+              << "  --new            Generate a new world instead of loading the map file\n"
+              << "  --seed <number>  Seed for a newly generated world (default random)\n"
+              << "  --convert        Import the map file and its inner map files into the world archive, then exit\n"
+              << "  --headless       Run without a window, updating as fast as possible\n"
+              << "  --ticks <count>  Updates to run in headless mode (default 10000)\n"
+              << "  --trace <file>   Write a Chrome trace on exit (profiling builds only)\n"
+              << "  --help           Show this message\n";
+}
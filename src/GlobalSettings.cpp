@@ -8,7 +8,12 @@ GlobalSettings& GlobalSettings::getInstance() {
 
 // Constructor: Initializes default game settings.
 GlobalSettings::GlobalSettings()
-    : TILE_SIZE(100), WINDOW_WIDTH(1000), WINDOW_HEIGHT(600), MAP_PATH_PREFIX("../maps/"), playerId(1) {
+    : TILE_SIZE(100), WINDOW_WIDTH(1000), WINDOW_HEIGHT(600),
+      WORLD_COLS(128), WORLD_ROWS(128), INNER_MAP_COLS(10), INNER_MAP_ROWS(6),
+      CHUNK_CACHE_BUDGET(64 * 1024 * 1024), INNER_MAP_CACHE_BUDGET(4 * 1024 * 1024),
+      JOURNAL_CHECKPOINT_SIZE(1024 * 1024),
+      TICK_RATE(30), SIMULATION_TILES_PER_TICK(1 << 20), VISION_RADIUS(3), STARTING_UNITS_PER_FACTION(16), TARGET_FPS(60), VSYNC(true), MAP_PATH_PREFIX("../maps/"),
+      MAP_BUTTON_TEXTURE("../assets/mapbtn.png"), playerId(1) {
     
     // Define tile textures with file paths.
     TILE_TEXTURES = {
@@ -19,6 +24,26 @@ GlobalSettings::GlobalSettings()
         {"deadgrass2", "../assets/deadgrass1_subtexture2.png"},
         {"deadgrass3", "../assets/deadgrass1_subtexture3.png"},
     };
+
+    // Richer grass feeds a territory better.
+    TERRAIN_YIELDS = {
+        {"darkgrass", 3},
+        {"medgrass1", 2},
+        {"medgrass2", 2},
+        {"deadgrass1", 1},
+        {"deadgrass2", 1},
+        {"deadgrass3", 1},
+    };
+
+    // Tall grass slows movement; dead grass is the easiest going.
+    TERRAIN_MOVE_COSTS = {
+        {"darkgrass", 3},
+        {"medgrass1", 2},
+        {"medgrass2", 2},
+        {"deadgrass1", 1},
+        {"deadgrass2", 1},
+        {"deadgrass3", 1},
+    };
 }
 
 // Getters for game settings.
@@ -34,10 +59,66 @@ int GlobalSettings::getTileSize() const {
     return TILE_SIZE; 
 }
 
+int GlobalSettings::getWorldCols() const {
+    return WORLD_COLS;
+}
+
+int GlobalSettings::getWorldRows() const {
+    return WORLD_ROWS;
+}
+
+int GlobalSettings::getInnerMapCols() const {
+    return INNER_MAP_COLS;
+}
+
+int GlobalSettings::getInnerMapRows() const {
+    return INNER_MAP_ROWS;
+}
+
+size_t GlobalSettings::getChunkCacheBudget() const {
+    return CHUNK_CACHE_BUDGET;
+}
+
+size_t GlobalSettings::getInnerMapCacheBudget() const {
+    return INNER_MAP_CACHE_BUDGET;
+}
+
+size_t GlobalSettings::getJournalCheckpointSize() const {
+    return JOURNAL_CHECKPOINT_SIZE;
+}
+
+int GlobalSettings::getTickRate() const {
+    return TICK_RATE;
+}
+
+size_t GlobalSettings::getSimulationTilesPerTick() const {
+    return SIMULATION_TILES_PER_TICK;
+}
+
+int GlobalSettings::getVisionRadius() const {
+    return VISION_RADIUS;
+}
+
+int GlobalSettings::getStartingUnitsPerFaction() const {
+    return STARTING_UNITS_PER_FACTION;
+}
+
+int GlobalSettings::getTargetFps() const {
+    return TARGET_FPS;
+}
+
+bool GlobalSettings::isVsyncEnabled() const {
+    return VSYNC;
+}
+
 const std::string& GlobalSettings::getMapPathPrefix() const { 
     return MAP_PATH_PREFIX; 
 }
 
+const std::string& GlobalSettings::getMapButtonTexture() const {
+    return MAP_BUTTON_TEXTURE;
+}
+
 // Returns the map of tile textures.
 const std::unordered_map<std::string, std::string>& GlobalSettings::getTileTextures() const {
     return TILE_TEXTURES;
@@ -48,6 +129,18 @@ const std::string& GlobalSettings::getTileTexture(const std::string& tileType) c
     return TILE_TEXTURES.at(tileType);
 }
 
+// Returns the yield of a tile type, defaulting to 1.
+int GlobalSettings::getTerrainYield(const std::string& tileType) const {
+    auto it = TERRAIN_YIELDS.find(tileType);
+    return it != TERRAIN_YIELDS.end() ? it->second : 1;
+}
+
+// Returns the move cost of a tile type, defaulting to 1.
+int GlobalSettings::getTerrainMoveCost(const std::string& tileType) const {
+    auto it = TERRAIN_MOVE_COSTS.find(tileType);
+    return it != TERRAIN_MOVE_COSTS.end() ? it->second : 1;
+}
+
 // Player ID management.
 const int32_t& GlobalSettings::getPlayerId() const { 
     return playerId; 
@@ -0,0 +1,112 @@
+#include "InnerMapCache.h"
+#include "Profiler.h"
+#include <iterator>
+
+// Constructor: Starts empty.
+InnerMapCache::InnerMapCache(size_t memoryBudget)
+    : memoryBudget(memoryBudget) {}
+
+bool InnerMapCache::contains(int col, int row) const {
+    return index.count(makeKey(col, row)) != 0;
+}
+
+// Unpacks a cached map and forgets it.
+std::optional<TileMap> InnerMapCache::take(int col, int row) {
+    auto it = index.find(makeKey(col, row));
+    if (it == index.end()) {
+        return std::nullopt;
+    }
+
+    PROFILE_SCOPE("InnerMapCache::take");
+    return std::move(remove(it->second).map);
+}
+
+// Packs the map at the front, then evicts from the back until the packed maps fit the budget.
+// Evicted maps without unsaved changes are regenerated on the next visit, so they are dropped packed.
+std::vector<InnerMapCache::Entry> InnerMapCache::put(int col, int row, TileMap&& map) {
+    PROFILE_SCOPE("InnerMapCache::put");
+    uint64_t key = makeKey(col, row);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        memoryUsage -= it->second->memoryUsage;
+        slots.erase(it->second);
+    }
+
+    PackedTileMap packed = map.pack();
+    size_t packedUsage = packed.getMemoryUsage();
+    slots.push_front(Slot{col, row, std::move(packed), packedUsage});
+    index[key] = slots.begin();
+    memoryUsage += packedUsage;
+    map = TileMap(); // The caller gave the map up; free its planes now.
+
+    std::vector<Entry> evicted;
+    while (memoryUsage > memoryBudget && slots.size() > 1) {
+        auto last = std::prev(slots.end());
+        if (last->packed.hasUnsavedChanges()) {
+            evicted.push_back(remove(last));
+        } else {
+            memoryUsage -= last->memoryUsage;
+            index.erase(makeKey(last->col, last->row));
+            slots.erase(last);
+        }
+    }
+    return evicted;
+}
+
+// Unpacks every entry that needs saving, dropping the rest, and leaves the cache empty.
+std::vector<InnerMapCache::Entry> InnerMapCache::drain() {
+    std::vector<Entry> drained;
+    for (const Slot& slot : slots) {
+        if (slot.packed.hasUnsavedChanges()) {
+            drained.push_back(Entry{slot.col, slot.row, TileMap(slot.packed)});
+        }
+    }
+
+    slots.clear();
+    index.clear();
+    memoryUsage = 0;
+    return drained;
+}
+
+// Unpacks a copy of each map that needs saving; the packed copy keeps its tiles but is no longer dirty.
+std::vector<InnerMapCache::Entry> InnerMapCache::collectUnsaved() {
+    std::vector<Entry> unsaved;
+    for (Slot& slot : slots) {
+        if (slot.packed.hasUnsavedChanges()) {
+            unsaved.push_back(Entry{slot.col, slot.row, TileMap(slot.packed)});
+            slot.packed.dirtyBegin = slot.packed.dirtyEnd = 0;
+        }
+    }
+    return unsaved;
+}
+
+size_t InnerMapCache::size() const {
+    return slots.size();
+}
+
+size_t InnerMapCache::getMemoryUsage() const {
+    return memoryUsage;
+}
+
+size_t InnerMapCache::getMemoryUsage(int col, int row) const {
+    auto it = index.find(makeKey(col, row));
+    return it == index.end() ? 0 : it->second->memoryUsage;
+}
+
+size_t InnerMapCache::getMemoryBudget() const {
+    return memoryBudget;
+}
+
+// Unlinks a slot and expands its map.
+InnerMapCache::Entry InnerMapCache::remove(std::list<Slot>::iterator it) {
+    Entry entry{it->col, it->row, TileMap(it->packed)};
+    memoryUsage -= it->memoryUsage;
+    index.erase(makeKey(it->col, it->row));
+    slots.erase(it);
+    return entry;
+}
+
+// Packs the coordinates into a 64-bit key (row in the high half).
+uint64_t InnerMapCache::makeKey(int col, int row) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(col);
+}
@@ -0,0 +1,211 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+    thread_local const JobSystem* currentPool = nullptr; ///< Pool the calling thread works for, if any.
+    thread_local size_t currentIndex = 0; ///< Deque index of the calling worker.
+}
+
+/**
+ * @class JobSystem::Job
+ * @brief A unit of work and the jobs waiting on it.
+ */
+class JobSystem::Job {
+public:
+    std::function<void()> work; ///< The work; released once run.
+    std::atomic<int> blockers{1}; ///< Unfinished dependencies, plus one until schedule() returns.
+    std::atomic<bool> done{false}; ///< Whether the work has run.
+    std::mutex mutex; ///< Guards dependents against the job finishing.
+    std::vector<JobHandle> dependents; ///< Jobs to unblock when this one finishes.
+};
+
+// Singleton instance: Ensures only one pool of workers exists.
+JobSystem& JobSystem::getInstance() {
+    static JobSystem instance;
+    return instance;
+}
+
+// Constructor: Creates a deque per worker plus the shared one, then starts the workers.
+JobSystem::JobSystem() {
+    unsigned workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    workerCount = std::max(1u, workerCount); // Jobs scheduled without a wait still need a thread to run them.
+    for (unsigned i = 0; i <= workerCount; i++) {
+        deques.push_back(std::make_unique<WorkDeque>());
+    }
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+// Destructor: Stops and joins the workers.
+JobSystem::~JobSystem() {
+    stopping = true;
+    wakeSleepers();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Registers the job with each unfinished dependency; the last one to finish queues it.
+JobSystem::JobHandle JobSystem::schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    JobHandle job = std::make_shared<Job>();
+    job->work = std::move(work);
+
+    for (const JobHandle& dependency : dependencies) {
+        if (!dependency) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->done) {
+            job->blockers++;
+            dependency->dependents.push_back(job);
+        }
+    }
+
+    if (--job->blockers == 0) {
+        enqueue(job);
+    }
+    return job;
+}
+
+// Helps with queued jobs instead of blocking; sleeps only when there is nothing to run.
+void JobSystem::wait(const JobHandle& job) {
+    if (!job) {
+        return;
+    }
+
+    while (!job->done) {
+        if (JobHandle next = takeJob()) {
+            run(next);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers++;
+        wakeup.wait(lock, [&]() { return job->done || queued > 0; });
+        sleepers--;
+    }
+}
+
+bool JobSystem::isDone(const JobHandle& job) const {
+    return !job || job->done;
+}
+
+// Schedules every chunk, then waits on them in order, running chunks while it waits.
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (begin >= end) {
+        return;
+    }
+    grainSize = std::max<size_t>(1, grainSize);
+    if (end - begin <= grainSize) {
+        body(begin, end);
+        return;
+    }
+
+    std::vector<JobHandle> chunks;
+    chunks.reserve((end - begin + grainSize - 1) / grainSize);
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+        size_t chunkEnd = std::min(end, chunkBegin + grainSize);
+        chunks.push_back(schedule([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }));
+    }
+    for (const JobHandle& chunk : chunks) {
+        wait(chunk);
+    }
+}
+
+unsigned JobSystem::getWorkerCount() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+// Runs jobs until stopped; sleeps on the condition variable while every deque is empty.
+void JobSystem::workerLoop(unsigned index) {
+    currentPool = this;
+    currentIndex = index;
+    PROFILE_THREAD_NAME("Job worker " + std::to_string(index));
+
+    while (!stopping) {
+        if (JobHandle job = takeJob()) {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers++;
+        wakeup.wait(lock, [this]() { return stopping || queued > 0; });
+        sleepers--;
+    }
+}
+
+void JobSystem::enqueue(JobHandle job) {
+    WorkDeque& deque = *deques[getDequeIndex()];
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.jobs.push_back(std::move(job));
+    }
+    queued++;
+    if (sleepers > 0) {
+        wakeSleepers();
+    }
+}
+
+// Pops the newest job of the caller's own deque, else steals the oldest job of the next non-empty deque.
+JobSystem::JobHandle JobSystem::takeJob() {
+    if (queued == 0) {
+        return nullptr;
+    }
+
+    size_t own = getDequeIndex();
+    for (size_t offset = 0; offset < deques.size(); offset++) {
+        WorkDeque& deque = *deques[(own + offset) % deques.size()];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.jobs.empty()) {
+            continue;
+        }
+
+        JobHandle job;
+        if (offset == 0) {
+            job = std::move(deque.jobs.back());
+            deque.jobs.pop_back();
+        } else {
+            job = std::move(deque.jobs.front());
+            deque.jobs.pop_front();
+        }
+        queued--;
+        return job;
+    }
+    return nullptr;
+}
+
+// Marks the job done under its lock, so a concurrent schedule() either registers before or sees it done.
+void JobSystem::run(const JobHandle& job) {
+    job->work();
+    job->work = nullptr;
+
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        dependents.swap(job->dependents);
+    }
+    for (JobHandle& dependent : dependents) {
+        if (--dependent->blockers == 0) {
+            enqueue(std::move(dependent));
+        }
+    }
+
+    if (sleepers > 0) {
+        wakeSleepers(); // A thread may be waiting for this job.
+    }
+}
+
+size_t JobSystem::getDequeIndex() const {
+    return currentPool == this ? currentIndex : deques.size() - 1;
+}
+
+// Taking the mutex orders the notify after any sleeper's check of its condition.
+void JobSystem::wakeSleepers() {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wakeup.notify_all();
+}
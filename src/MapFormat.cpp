@@ -0,0 +1,176 @@
+#include "MapFormat.h"
+#include "TerrainRegistry.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Builds the CRC-32 lookup table for the reflected polynomial 0xEDB88320.
+static std::array<uint32_t, 256> buildCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+        }
+        table[i] = value;
+    }
+    return table;
+}
+
+// Computes or continues a CRC-32 checksum over a block of bytes.
+uint32_t computeCrc32(const void* data, size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = buildCrcTable();
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Computes the header CRC over the header (with its CRC field zeroed), dictionary and padding.
+// headerCrc sits at the same offset in every version, so this works for version 1 prefixes too.
+uint32_t computeMapHeaderCrc(const char* prefix) {
+    MapFileHeader header;
+    std::memcpy(&header, prefix, MAP_HEADER_SIZE_V1);
+
+    const uint32_t zero = 0;
+    const size_t crcOffset = offsetof(MapFileHeader, headerCrc);
+    const size_t crcEnd = crcOffset + sizeof(zero);
+    uint32_t crc = computeCrc32(prefix, crcOffset);
+    crc = computeCrc32(&zero, sizeof(zero), crc);
+    return computeCrc32(prefix + crcEnd, header.terrainOffset - crcEnd, crc);
+}
+
+// Fills in the plane offsets and file size for a map whose tile data starts at terrainOffset.
+static void layoutMapPlanes(MapFileHeader& header, uint64_t terrainOffset) {
+    uint64_t tileCount = static_cast<uint64_t>(header.numRows) * header.numCols;
+    header.terrainOffset = terrainOffset;
+    header.ownerOffset = alignMapOffset(terrainOffset + tileCount);
+    header.flagsOffset = header.ownerOffset + tileCount * sizeof(int32_t);
+    header.fileSize = header.flagsOffset + tileCount;
+}
+
+// Appends every registry alias in ID order.
+uint32_t appendTerrainDictionary(std::vector<char>& out) {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    for (size_t id = 0; id < registry.size(); id++) {
+        const std::string& alias = registry.getAlias(static_cast<TerrainId>(id));
+        uint8_t length = static_cast<uint8_t>(std::min<size_t>(alias.size(), 255));
+        out.push_back(static_cast<char>(length));
+        out.insert(out.end(), alias.begin(), alias.begin() + length);
+    }
+    return static_cast<uint32_t>(registry.size());
+}
+
+// Looks up each stored alias in the registry.
+bool decodeTerrainDictionary(const char* data, size_t size, uint32_t count, size_t& offset,
+                             TerrainRemap& terrainRemap, bool& identityRemap) {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    terrainRemap.fill(TerrainRegistry::INVALID_TERRAIN);
+    identityRemap = true;
+
+    for (uint32_t id = 0; id < count; id++) {
+        if (offset >= size) {
+            std::cerr << "Error: Terrain dictionary is truncated.\n";
+            return false;
+        }
+        uint8_t length = static_cast<uint8_t>(data[offset++]);
+        if (offset + length > size) {
+            std::cerr << "Error: Terrain dictionary is truncated.\n";
+            return false;
+        }
+
+        std::string alias(data + offset, length);
+        offset += length;
+
+        terrainRemap[id] = registry.getId(alias);
+        if (terrainRemap[id] != id) {
+            identityRemap = false;
+        }
+        if (terrainRemap[id] == TerrainRegistry::INVALID_TERRAIN) {
+            std::cerr << "Warning: Map uses unknown terrain '" << alias << "'.\n";
+        }
+    }
+
+    return true;
+}
+
+// Encodes the header, the registry's terrain dictionary and padding up to the terrain plane.
+std::vector<char> encodeMapPrefix(uint32_t numRows, uint32_t numCols, uint32_t tileCrc, uint64_t worldSeed) {
+    std::vector<char> prefix(sizeof(MapFileHeader), 0);
+    uint32_t dictionaryCount = appendTerrainDictionary(prefix);
+
+    MapFileHeader header{};
+    header.magic = MAP_FILE_MAGIC;
+    header.version = MAP_FORMAT_VERSION;
+    header.headerSize = sizeof(MapFileHeader);
+    header.numRows = numRows;
+    header.numCols = numCols;
+    header.dictionaryCount = dictionaryCount;
+    header.tileCrc = tileCrc;
+    header.worldSeed = worldSeed;
+    layoutMapPlanes(header, alignMapOffset(prefix.size()));
+
+    prefix.resize(header.terrainOffset, 0);
+    std::memcpy(prefix.data(), &header, sizeof(header));
+    header.headerCrc = computeMapHeaderCrc(prefix.data());
+    std::memcpy(prefix.data(), &header, sizeof(header));
+    return prefix;
+}
+
+// Validates the header and dictionary, and maps the file's terrain IDs onto the registry.
+bool decodeMapPrefix(const char* prefix, size_t prefixSize, MapFileHeader& header,
+                     TerrainRemap& terrainRemap, bool& identityRemap) {
+    if (prefixSize < MAP_HEADER_SIZE_V1) {
+        std::cerr << "Error: Map header is truncated.\n";
+        return false;
+    }
+    std::memcpy(&header, prefix, MAP_HEADER_SIZE_V1);
+    header.worldSeed = 0;
+
+    if (header.magic != MAP_FILE_MAGIC) {
+        std::cerr << "Error: Not a map file.\n";
+        return false;
+    }
+    if (header.version != MAP_FORMAT_VERSION && header.version != MAP_FORMAT_VERSION_1) {
+        std::cerr << "Error: Unsupported map format version " << header.version << ".\n";
+        return false;
+    }
+
+    size_t headerSize = header.version == MAP_FORMAT_VERSION ? sizeof(MapFileHeader) : MAP_HEADER_SIZE_V1;
+    if (header.headerSize != headerSize || prefixSize < headerSize || header.terrainOffset < headerSize) {
+        std::cerr << "Error: Map header is truncated or has the wrong size.\n";
+        return false;
+    }
+    if (header.version == MAP_FORMAT_VERSION) {
+        std::memcpy(&header, prefix, sizeof(header));
+    }
+    if (header.numRows == 0 || header.numCols == 0 ||
+        header.numRows > MAP_MAX_DIMENSION || header.numCols > MAP_MAX_DIMENSION ||
+        header.terrainOffset > prefixSize || header.dictionaryCount > 256) {
+        std::cerr << "Error: Map header has invalid dimensions or offsets.\n";
+        return false;
+    }
+
+    // The plane offsets are fully determined by the dimensions; reject anything else.
+    MapFileHeader expected = header;
+    layoutMapPlanes(expected, header.terrainOffset);
+    if (expected.ownerOffset != header.ownerOffset || expected.flagsOffset != header.flagsOffset ||
+        expected.fileSize != header.fileSize) {
+        std::cerr << "Error: Map header plane layout is inconsistent.\n";
+        return false;
+    }
+
+    if (computeMapHeaderCrc(prefix) != header.headerCrc) {
+        std::cerr << "Error: Map header checksum mismatch.\n";
+        return false;
+    }
+
+    // Decode the dictionary into the remap table.
+    size_t offset = headerSize;
+    return decodeTerrainDictionary(prefix, header.terrainOffset, header.dictionaryCount, offset,
+                                   terrainRemap, identityRemap);
+}
@@ -0,0 +1,263 @@
+#include "MapIOWorker.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+
+// Constructor: Starts the I/O thread.
+MapIOWorker::MapIOWorker(WorldArchive& archive, WorldJournal& journal)
+    : archive(archive), journal(journal), deltaPack(archive) {
+    worker = std::thread(&MapIOWorker::workerLoop, this);
+}
+
+// Destructor: Drops prefetches, lets queued saves and loads finish, then joins the thread.
+MapIOWorker::~MapIOWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        prefetch.clear();
+        stopping = true;
+    }
+    wakeWorker.notify_all();
+    worker.join();
+}
+
+// Queues an inner map load, promoting it if it was only being prefetched.
+void MapIOWorker::requestInnerMap(const InnerMapRequest& innerMap) {
+    uint64_t key = makeKey(innerMap.col, innerMap.row);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isKnown(key, false)) {
+        return;
+    }
+
+    auto it = std::find_if(prefetch.begin(), prefetch.end(),
+                           [key](const Request& request) { return makeKey(request.inner.col, request.inner.row) == key; });
+    if (it != prefetch.end()) {
+        prefetch.erase(it);
+    }
+
+    demand.push_back(Request{LOAD_INNER, innerMap, std::nullopt});
+    wakeWorker.notify_one();
+}
+
+// Replaces the prefetch queue; stale guesses from an earlier hover are discarded.
+void MapIOWorker::prefetchInnerMaps(const std::vector<InnerMapRequest>& requests) {
+    std::lock_guard<std::mutex> lock(mutex);
+    prefetch.clear();
+
+    for (const InnerMapRequest& request : requests) {
+        if (!isKnown(makeKey(request.col, request.row), true)) {
+            prefetch.push_back(Request{LOAD_INNER, request, std::nullopt});
+        }
+    }
+
+    if (!prefetch.empty()) {
+        wakeWorker.notify_one();
+    }
+}
+
+// Queues a world snapshot write.
+void MapIOWorker::saveWorld(TileMap snapshot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    demand.push_back(Request{SAVE_WORLD, {}, std::move(snapshot)});
+    wakeWorker.notify_one();
+}
+
+// Queues an inner map's changes for the delta pack; any cached copy of it is now stale.
+void MapIOWorker::saveInnerMap(TileMap snapshot, int col, int row) {
+    std::lock_guard<std::mutex> lock(mutex);
+    dropReady(makeKey(col, row));
+    demand.push_back(Request{SAVE_INNER, InnerMapRequest{col, row, {}, 0}, std::move(snapshot)});
+    wakeWorker.notify_one();
+}
+
+// Queues a checkpoint behind the saves it covers.
+void MapIOWorker::checkpoint(uint64_t journalPosition) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Request request{CHECKPOINT, {}, std::nullopt};
+    request.journalPosition = journalPosition;
+    demand.push_back(std::move(request));
+    wakeWorker.notify_one();
+}
+
+// Queues a journal commit unless one is already waiting.
+void MapIOWorker::commitJournal() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!journalCommitQueued) {
+        journalCommitQueued = true;
+        wakeWorker.notify_one();
+    }
+}
+
+// Hands over a finished inner map, if there is one.
+std::optional<TileMap> MapIOWorker::takeInnerMap(int col, int row) {
+    uint64_t key = makeKey(col, row);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ready.find(key);
+    if (it == ready.end()) {
+        return std::nullopt;
+    }
+
+    std::optional<TileMap> map(std::move(it->second));
+    dropReady(key);
+    return map;
+}
+
+// Serves journal commits, then demand requests in order, and prefetches only while nothing is waiting on the worker.
+void MapIOWorker::workerLoop() {
+    PROFILE_THREAD_NAME("Map I/O");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeWorker.wait(lock, [this] { return stopping || journalCommitQueued || !demand.empty() || !prefetch.empty(); });
+        if (journalCommitQueued) {
+            journalCommitQueued = false;
+            lock.unlock();
+            {
+                PROFILE_SCOPE("MapIOWorker::commitJournal");
+                journal.commit(); // Reports its own errors; the records stay queued for the next commit.
+            }
+            lock.lock();
+            continue;
+        }
+        if (demand.empty() && prefetch.empty()) {
+            return; // Stopping with nothing left to write.
+        }
+
+        std::deque<Request>& queue = demand.empty() ? prefetch : demand;
+        Request request = std::move(queue.front());
+        queue.pop_front();
+
+        if (request.type == SAVE_WORLD || request.type == SAVE_INNER) {
+            lock.unlock();
+            save(request);
+            lock.lock();
+            continue;
+        }
+
+        if (request.type == CHECKPOINT) {
+            lock.unlock();
+            {
+                PROFILE_SCOPE("MapIOWorker::checkpoint");
+                // Earlier failures are retried, so one bad write does not keep the journal growing for good.
+                std::vector<Request> retries;
+                retries.swap(failedSaves);
+                for (Request& retry : retries) {
+                    save(retry);
+                }
+
+                if (!failedSaves.empty() || !archive.sync() || !journal.trim(request.journalPosition)) {
+                    std::cerr << "Warning: Checkpoint skipped; the journal keeps the unsaved changes.\n";
+                }
+            }
+            lock.lock();
+            continue;
+        }
+
+        uint64_t key = makeKey(request.inner.col, request.inner.row);
+        inFlight = key;
+        lock.unlock();
+        TileMap map = load(request);
+        lock.lock();
+        inFlight.reset();
+
+        // A save queued while this load ran makes the result stale; the next request reloads it.
+        bool superseded = std::any_of(demand.begin(), demand.end(), [key](const Request& queued) {
+            return queued.type == SAVE_INNER && makeKey(queued.inner.col, queued.inner.row) == key;
+        });
+        if (!superseded) {
+            addReady(key, std::move(map));
+        }
+    }
+}
+
+// Writes a snapshot on the worker thread; a newer snapshot of a map replaces one that failed to save.
+bool MapIOWorker::save(Request& request) {
+    bool saved = false;
+    if (request.type == SAVE_WORLD) {
+        PROFILE_SCOPE("MapIOWorker::saveWorld");
+        saved = request.snapshot->saveToArchive(archive, WorldArchive::WORLD_KEY, true);
+    } else {
+        PROFILE_SCOPE("MapIOWorker::saveInnerMap");
+        saved = deltaPack.store(request.inner.col, request.inner.row, *request.snapshot);
+    }
+
+    uint64_t key = makeKey(request.inner.col, request.inner.row);
+    failedSaves.erase(std::remove_if(failedSaves.begin(), failedSaves.end(),
+                                     [&request, key](const Request& failed) {
+                                         return failed.type == request.type && makeKey(failed.inner.col, failed.inner.row) == key;
+                                     }),
+                      failedSaves.end());
+    if (!saved) {
+        failedSaves.push_back(std::move(request));
+        return false;
+    }
+    request.snapshot.reset(); // Unmap or free the snapshot off the render thread too.
+
+    // Only a world that is not mapped is saved whole, so nothing maps the archive here;
+    // drop the copies it replaced before they take over the file.
+    if (request.type == SAVE_WORLD) {
+        archive.compactIfSparse();
+    }
+    return true;
+}
+
+// Serves a load request on the worker thread; an inner map whose save failed is served from its snapshot.
+TileMap MapIOWorker::load(const Request& request) {
+    PROFILE_SCOPE("MapIOWorker::load");
+    uint64_t key = makeKey(request.inner.col, request.inner.row);
+    for (const Request& failed : failedSaves) {
+        if (failed.type == SAVE_INNER && makeKey(failed.inner.col, failed.inner.row) == key) {
+            return TileMap(*failed.snapshot);
+        }
+    }
+    return buildInnerMap(request.inner, deltaPack);
+}
+
+// Regenerates an inner map from its seed and replays the player's saved changes, if any.
+TileMap MapIOWorker::buildInnerMap(const InnerMapRequest& inner, DeltaPack& deltaPack) {
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+
+    TileMap map;
+    map.generateTiles(settings.getInnerMapRows(), settings.getInnerMapCols(), settings.getTileSize(),
+                      inner.terrains, inner.seed, true);
+    deltaPack.apply(inner.col, inner.row, map);
+    return map;
+}
+
+// Checks the ready cache, the running load and the queues for an inner map.
+bool MapIOWorker::isKnown(uint64_t key, bool includePrefetch) const {
+    if (ready.count(key) || inFlight == key) {
+        return true;
+    }
+
+    auto matches = [key](const Request& request) {
+        return request.type == LOAD_INNER && makeKey(request.inner.col, request.inner.row) == key;
+    };
+    if (std::any_of(demand.begin(), demand.end(), matches)) {
+        return true;
+    }
+    return includePrefetch && std::any_of(prefetch.begin(), prefetch.end(), matches);
+}
+
+// Caches a finished map, evicting the oldest once the cache is full.
+void MapIOWorker::addReady(uint64_t key, TileMap&& map) {
+    dropReady(key);
+    ready.emplace(key, std::move(map));
+    readyOrder.push_back(key);
+
+    while (readyOrder.size() > MAX_READY_MAPS) {
+        ready.erase(readyOrder.front());
+        readyOrder.pop_front();
+    }
+}
+
+// Forgets a cached map.
+void MapIOWorker::dropReady(uint64_t key) {
+    if (ready.erase(key)) {
+        readyOrder.erase(std::find(readyOrder.begin(), readyOrder.end(), key));
+    }
+}
+
+// Packs the coordinates into a 64-bit key (row in the high half).
+uint64_t MapIOWorker::makeKey(int col, int row) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(col);
+}
@@ -0,0 +1,222 @@
+#include "MapPyramid.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr size_t ROWS_PER_JOB = 64; ///< Cell rows downsampled per job in a full build.
+
+    // The value occurring most often; ties go to the one seen first.
+    template <typename T>
+    T majority(const T* values, int count) {
+        T best = values[0];
+        int bestCount = 0;
+        for (int i = 0; i < count; i++) {
+            int matches = 0;
+            for (int j = 0; j < count; j++) {
+                matches += values[j] == values[i];
+            }
+            if (matches > bestCount) {
+                best = values[i];
+                bestCount = matches;
+            }
+        }
+        return best;
+    }
+}
+
+// Each level halves the cell size on screen, so the level is the number of halvings below MIN_CELL_PIXELS.
+int MapPyramid::chooseLevel(float tilePixels) {
+    if (tilePixels >= MIN_CELL_PIXELS || tilePixels <= 0.0f) {
+        return 0;
+    }
+    return static_cast<int>(std::ceil(std::log2(MIN_CELL_PIXELS / tilePixels)));
+}
+
+// Builds every level for a new map; otherwise re-derives marked cells, climbing only while cells change.
+void MapPyramid::update(const TileMap& world) {
+    PROFILE_SCOPE("MapPyramid::update");
+    if (!describes(world)) {
+        numRows = world.getNumRows();
+        numCols = world.getNumCols();
+        worldSeed = world.getWorldSeed();
+        chunkCols = (numCols + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE;
+        const int chunkRows = (numRows + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE;
+        mapChunkRevisions.assign(static_cast<size_t>(chunkCols) * chunkRows, 0);
+
+        levels.clear();
+        for (int cols = numCols, rows = numRows; cols > 1 || rows > 1;) {
+            cols = (cols + 1) / 2;
+            rows = (rows + 1) / 2;
+            Level level;
+            level.cols = cols;
+            level.rows = rows;
+            level.terrainIds.assign(static_cast<size_t>(cols) * rows, 0);
+            level.ownerIds.assign(static_cast<size_t>(cols) * rows, 0);
+            level.dirty.assign(static_cast<size_t>(cols) * rows, false);
+            levels.push_back(std::move(level));
+        }
+
+        for (int level = 1; level <= getLevelCount(); level++) {
+            const Level& cells = levels[level - 1];
+            JobSystem::getInstance().parallelFor(0, static_cast<size_t>(cells.rows), ROWS_PER_JOB, [&](size_t firstRow, size_t endRow) {
+                downsample(world, level, 0, static_cast<int>(firstRow), cells.cols, static_cast<int>(endRow));
+            });
+        }
+        for (int cy = 0; cy < chunkRows; cy++) {
+            for (int cx = 0; cx < chunkCols; cx++) {
+                mapChunkRevisions[static_cast<size_t>(cy) * chunkCols + cx] = world.getChunkRevision(cx, cy);
+            }
+        }
+        built = true;
+        revision++;
+        return;
+    }
+
+    // Chunks changed behind noteChangedTiles()'s back are re-derived whole.
+    for (size_t chunk = 0; chunk < mapChunkRevisions.size(); chunk++) {
+        const int cx = static_cast<int>(chunk % chunkCols);
+        const int cy = static_cast<int>(chunk / chunkCols);
+        uint64_t mapRevision = world.getChunkRevision(cx, cy);
+        if (mapRevision == mapChunkRevisions[chunk]) {
+            continue;
+        }
+        mapChunkRevisions[chunk] = mapRevision;
+
+        const int firstCol = cx * TileMap::CHUNK_SIZE, firstRow = cy * TileMap::CHUNK_SIZE;
+        const int lastCol = std::min(numCols, firstCol + TileMap::CHUNK_SIZE) - 1;
+        const int lastRow = std::min(numRows, firstRow + TileMap::CHUNK_SIZE) - 1;
+        for (int row = firstRow >> 1; row <= lastRow >> 1; row++) {
+            for (int col = firstCol >> 1; col <= lastCol >> 1; col++) {
+                markCell(1, col, row);
+            }
+        }
+    }
+
+    bool changed = false;
+    for (int level = 1; level <= getLevelCount(); level++) {
+        Level& cells = levels[level - 1];
+        for (uint32_t cell : cells.dirtyCells) {
+            cells.dirty[cell] = false;
+            const TerrainId oldTerrain = cells.terrainIds[cell];
+            const int32_t oldOwner = cells.ownerIds[cell];
+            const int col = static_cast<int>(cell % cells.cols);
+            const int row = static_cast<int>(cell / cells.cols);
+            downsample(world, level, col, row, col + 1, row + 1);
+
+            // An unchanged majority leaves everything above it as it was.
+            if (cells.terrainIds[cell] != oldTerrain || cells.ownerIds[cell] != oldOwner) {
+                changed = true;
+                if (level < getLevelCount()) {
+                    markCell(level + 1, col / 2, row / 2);
+                }
+            }
+        }
+        cells.dirtyCells.clear();
+    }
+    if (changed) {
+        revision++;
+    }
+}
+
+// Marks the level 1 cell above each tile; the tiles account for their chunks' new revisions.
+void MapPyramid::noteChangedTiles(const TileMap& world, const std::vector<uint32_t>& tiles) {
+    if (!describes(world) || levels.empty()) {
+        return;
+    }
+
+    const size_t tileCount = static_cast<size_t>(numRows) * numCols;
+    for (uint32_t index : tiles) {
+        if (index >= tileCount) {
+            continue;
+        }
+        const int col = static_cast<int>(index % numCols);
+        const int row = static_cast<int>(index / numCols);
+        markCell(1, col / 2, row / 2);
+
+        const int cx = col / TileMap::CHUNK_SIZE;
+        const int cy = row / TileMap::CHUNK_SIZE;
+        mapChunkRevisions[static_cast<size_t>(cy) * chunkCols + cx] = world.getChunkRevision(cx, cy);
+    }
+}
+
+bool MapPyramid::describes(const TileMap& world) const {
+    return built && world.getNumRows() == numRows && world.getNumCols() == numCols && world.getWorldSeed() == worldSeed;
+}
+
+int MapPyramid::getLevelCount() const {
+    return static_cast<int>(levels.size());
+}
+
+int MapPyramid::getLevelCols(int level) const {
+    return level >= 1 && level <= getLevelCount() ? levels[level - 1].cols : 0;
+}
+
+int MapPyramid::getLevelRows(int level) const {
+    return level >= 1 && level <= getLevelCount() ? levels[level - 1].rows : 0;
+}
+
+const TerrainId* MapPyramid::getTerrainIds(int level) const {
+    return level >= 1 && level <= getLevelCount() ? levels[level - 1].terrainIds.data() : nullptr;
+}
+
+const int32_t* MapPyramid::getOwnerIds(int level) const {
+    return level >= 1 && level <= getLevelCount() ? levels[level - 1].ownerIds.data() : nullptr;
+}
+
+uint64_t MapPyramid::getRevision() const {
+    return revision;
+}
+
+size_t MapPyramid::getMemoryUsage() const {
+    size_t bytes = levels.capacity() * sizeof(Level) + mapChunkRevisions.capacity() * sizeof(uint64_t);
+    for (const Level& level : levels) {
+        bytes += level.terrainIds.capacity() * sizeof(TerrainId) + level.ownerIds.capacity() * sizeof(int32_t) +
+                 level.dirty.capacity() / 8 + level.dirtyCells.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+// Gathers the up to four cells below each cell in row order, so ties favour the top-left one.
+void MapPyramid::downsample(const TileMap& world, int level, int firstCol, int firstRow, int endCol, int endRow) {
+    Level& cells = levels[level - 1];
+    const bool fromMap = level == 1;
+    const int sourceCols = fromMap ? numCols : levels[level - 2].cols;
+    const int sourceRows = fromMap ? numRows : levels[level - 2].rows;
+    const TerrainId* sourceTerrain = fromMap ? world.getTerrainIds() : levels[level - 2].terrainIds.data();
+    const int32_t* sourceOwners = fromMap ? world.getOwnerIds() : levels[level - 2].ownerIds.data();
+    endCol = std::min(endCol, cells.cols);
+    endRow = std::min(endRow, cells.rows);
+
+    for (int row = firstRow; row < endRow; row++) {
+        const int sourceRowEnd = std::min(sourceRows, row * 2 + 2);
+        for (int col = firstCol; col < endCol; col++) {
+            const int sourceColEnd = std::min(sourceCols, col * 2 + 2);
+            TerrainId terrain[4]{};
+            int32_t owners[4]{};
+            int count = 0;
+            for (int y = row * 2; y < sourceRowEnd; y++) {
+                for (int x = col * 2; x < sourceColEnd; x++, count++) {
+                    size_t index = static_cast<size_t>(y) * sourceCols + x;
+                    terrain[count] = sourceTerrain[index];
+                    owners[count] = sourceOwners[index];
+                }
+            }
+
+            size_t cell = static_cast<size_t>(row) * cells.cols + col;
+            cells.terrainIds[cell] = majority(terrain, count);
+            cells.ownerIds[cell] = majority(owners, count);
+        }
+    }
+}
+
+// Queues a cell once, however many of the tiles or cells below it changed.
+void MapPyramid::markCell(int level, int col, int row) {
+    Level& cells = levels[level - 1];
+    size_t cell = static_cast<size_t>(row) * cells.cols + col;
+    if (!cells.dirty[cell]) {
+        cells.dirty[cell] = true;
+        cells.dirtyCells.push_back(static_cast<uint32_t>(cell));
+    }
+}
@@ -0,0 +1,173 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Constructor: Starts without a mapping.
+MappedFile::MappedFile() {}
+
+// Destructor: Releases the mapping.
+MappedFile::~MappedFile() {
+    close();
+}
+
+// Maps a file or a range of it. The descriptor is closed immediately; the mapping keeps the file alive.
+bool MappedFile::open(const std::string& filePath, bool writeAccess, uint64_t offset, size_t length) {
+    close();
+
+#if defined(_WIN32)
+    std::cerr << "Warning: Memory-mapped maps are not supported on this platform: " << filePath << std::endl;
+    return false;
+#else
+    int fd = ::open(filePath.c_str(), writeAccess ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    uint64_t fileSize = 0;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        fileSize = static_cast<uint64_t>(info.st_size);
+    }
+    if (length == 0 && offset < fileSize) {
+        length = static_cast<size_t>(fileSize - offset);
+    }
+    if (offset % getPageSize() != 0 || length == 0 || offset + length > fileSize) {
+        ::close(fd);
+        return false;
+    }
+
+    int protection = writeAccess ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* address = mmap(nullptr, length, protection, MAP_SHARED, fd, static_cast<off_t>(offset));
+    ::close(fd);
+
+    if (address == MAP_FAILED) {
+        std::cerr << "Error: Failed to map file: " << filePath << std::endl;
+        return false;
+    }
+
+    mapping = static_cast<char*>(address);
+    mappedSize = length;
+    fileOffset = offset;
+    writable = writeAccess;
+    path = filePath;
+    return true;
+#endif
+}
+
+// Unmaps the file.
+void MappedFile::close() {
+#if !defined(_WIN32)
+    if (mapping) {
+        munmap(mapping, mappedSize);
+    }
+#endif
+    mapping = nullptr;
+    mappedSize = 0;
+    fileOffset = 0;
+    writable = false;
+    path.clear();
+}
+
+bool MappedFile::isOpen() const {
+    return mapping != nullptr;
+}
+
+bool MappedFile::isWritable() const {
+    return writable;
+}
+
+char* MappedFile::data() const {
+    return mapping;
+}
+
+size_t MappedFile::size() const {
+    return mappedSize;
+}
+
+const std::string& MappedFile::getPath() const {
+    return path;
+}
+
+uint64_t MappedFile::getOffset() const {
+    return fileOffset;
+}
+
+// Writes a range of the mapping back to disk. msync requires a page-aligned start address.
+bool MappedFile::flush(size_t offset, size_t length) {
+#if defined(_WIN32)
+    return false;
+#else
+    if (!mapping || !writable || offset >= mappedSize || length == 0) {
+        return mapping != nullptr;
+    }
+
+    size_t pageSize = getPageSize();
+    size_t start = offset - (offset % pageSize);
+    size_t end = std::min(offset + length, mappedSize);
+
+    if (msync(mapping + start, end - start, MS_SYNC) != 0) {
+        std::cerr << "Error: Failed to flush mapped file: " << path << std::endl;
+        return false;
+    }
+    return true;
+#endif
+}
+
+// Hints the OS to read a range ahead and touches each page so the read happens now.
+void MappedFile::prefetch(size_t offset, size_t length) const {
+    if (!mapping || offset >= mappedSize || length == 0) {
+        return;
+    }
+
+    size_t pageSize = getPageSize();
+    size_t start = offset - (offset % pageSize);
+    size_t end = std::min(offset + length, mappedSize);
+
+#if !defined(_WIN32)
+    madvise(mapping + start, end - start, MADV_WILLNEED);
+#endif
+
+    volatile char sink = 0;
+    for (size_t page = start; page < end; page += pageSize) {
+        sink = sink + mapping[page];
+    }
+}
+
+// Writes back and releases the pages lying entirely inside a range.
+void MappedFile::release(size_t offset, size_t length) {
+#if !defined(_WIN32)
+    if (!mapping || offset >= mappedSize || length == 0) {
+        return;
+    }
+
+    size_t pageSize = getPageSize();
+    size_t start = ((offset + pageSize - 1) / pageSize) * pageSize;
+    size_t end = std::min(offset + length, mappedSize);
+    end -= end % pageSize;
+    if (start >= end) {
+        return;
+    }
+
+    if (writable) {
+        msync(mapping + start, end - start, MS_SYNC);
+    }
+    madvise(mapping + start, end - start, MADV_DONTNEED);
+#endif
+}
+
+// Returns the virtual memory page size.
+size_t MappedFile::getPageSize() {
+#if defined(_WIN32)
+    return 4096;
+#else
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+#endif
+}
@@ -0,0 +1,174 @@
+#include "PackedTileMap.h"
+#include <array>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t NO_INDEX = UINT32_MAX; ///< Marks a byte value that has no palette index yet.
+
+    uint32_t readValue(const uint8_t* values, size_t index, size_t valueSize) {
+        if (valueSize == 1) {
+            return values[index];
+        }
+        uint32_t value;
+        std::memcpy(&value, values + index * sizeof(value), sizeof(value));
+        return value;
+    }
+
+    void writeValue(uint8_t* values, size_t index, size_t valueSize, uint32_t value) {
+        if (valueSize == 1) {
+            values[index] = static_cast<uint8_t>(value);
+        } else {
+            std::memcpy(values + index * sizeof(value), &value, sizeof(value));
+        }
+    }
+
+    size_t varintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+}
+
+// Writes seven bits per byte, setting the top bit on every byte but the last.
+void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t readVarint(const uint8_t*& in) {
+    uint64_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+// Maps each value to a palette index, then sizes both encodings and writes the smaller one.
+void packPlane(const void* values, size_t count, size_t valueSize, std::vector<uint8_t>& out) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(values);
+    std::vector<uint32_t> palette;
+    std::vector<uint32_t> indexes(count);
+    std::array<uint32_t, 256> byteIndex; // Byte planes skip the hash map.
+    byteIndex.fill(NO_INDEX);
+    std::unordered_map<uint32_t, uint32_t> wordIndex;
+
+    size_t runBytes = 0;
+    size_t runStart = 0;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t value = readValue(bytes, i, valueSize);
+        if (i > 0 && value == previous) {
+            indexes[i] = indexes[i - 1]; // Inside a run; most tiles take this path.
+            continue;
+        }
+        previous = value;
+
+        uint32_t& slot = valueSize == 1 ? byteIndex[value] : wordIndex.emplace(value, NO_INDEX).first->second;
+        if (slot == NO_INDEX) {
+            slot = static_cast<uint32_t>(palette.size());
+            palette.push_back(value);
+        }
+        indexes[i] = slot;
+
+        if (i > 0) {
+            runBytes += varintSize(i - runStart - 1) + varintSize(indexes[i - 1]);
+        }
+        runStart = i;
+    }
+    if (count > 0) {
+        runBytes += varintSize(count - runStart - 1) + varintSize(indexes[count - 1]);
+    }
+
+    uint8_t bitsPerIndex = 0;
+    while (palette.size() > (size_t{1} << bitsPerIndex)) {
+        bitsPerIndex++;
+    }
+    size_t paletteBytes = (count * bitsPerIndex + 7) / 8;
+    PlaneEncoding encoding = runBytes < paletteBytes ? PLANE_RUNS : PLANE_PALETTE;
+
+    out.push_back(encoding);
+    out.push_back(bitsPerIndex);
+    appendVarint(out, palette.size());
+    for (uint32_t value : palette) {
+        appendVarint(out, value);
+    }
+
+    if (encoding == PLANE_RUNS) {
+        appendVarint(out, runBytes);
+        for (size_t start = 0; start < count;) {
+            size_t end = start + 1;
+            while (end < count && indexes[end] == indexes[start]) {
+                end++;
+            }
+            appendVarint(out, end - start - 1);
+            appendVarint(out, indexes[start]);
+            start = end;
+        }
+        return;
+    }
+
+    appendVarint(out, paletteBytes);
+    size_t base = out.size();
+    out.resize(base + paletteBytes, 0);
+    size_t bit = 0;
+    for (size_t i = 0; i < count && bitsPerIndex > 0; i++, bit += bitsPerIndex) {
+        uint64_t field = static_cast<uint64_t>(indexes[i]) << (bit % 8);
+        for (size_t byte = base + bit / 8; field != 0; byte++, field >>= 8) {
+            out[byte] |= static_cast<uint8_t>(field);
+        }
+    }
+}
+
+// Expands runs or bit-packed indexes back into values.
+void unpackPlane(const uint8_t*& in, void* values, size_t count, size_t valueSize) {
+    uint8_t* bytes = static_cast<uint8_t*>(values);
+    PlaneEncoding encoding = static_cast<PlaneEncoding>(*in++);
+    uint8_t bitsPerIndex = *in++;
+
+    std::vector<uint32_t> palette(static_cast<size_t>(readVarint(in)));
+    for (uint32_t& value : palette) {
+        value = static_cast<uint32_t>(readVarint(in));
+    }
+    size_t dataSize = static_cast<size_t>(readVarint(in));
+    const uint8_t* data = in;
+    in += dataSize;
+
+    if (encoding == PLANE_RUNS) {
+        for (size_t i = 0; i < count;) {
+            size_t length = static_cast<size_t>(readVarint(data)) + 1;
+            uint32_t value = palette[static_cast<size_t>(readVarint(data))];
+            for (size_t end = i + length; i < end; i++) {
+                writeValue(bytes, i, valueSize, value);
+            }
+        }
+        return;
+    }
+
+    if (bitsPerIndex == 0) {
+        uint32_t value = palette.empty() ? 0 : palette[0];
+        for (size_t i = 0; i < count; i++) {
+            writeValue(bytes, i, valueSize, value);
+        }
+        return;
+    }
+
+    const uint64_t mask = (uint64_t{1} << bitsPerIndex) - 1;
+    size_t bit = 0;
+    for (size_t i = 0; i < count; i++, bit += bitsPerIndex) {
+        uint64_t field = 0;
+        for (size_t byte = bit / 8, shift = 0; shift < (bit % 8) + bitsPerIndex; byte++, shift += 8) {
+            field |= static_cast<uint64_t>(data[byte]) << shift;
+        }
+        writeValue(bytes, i, valueSize, palette[(field >> (bit % 8)) & mask]);
+    }
+}
@@ -0,0 +1,631 @@
+#include "Pathfinder.h"
+#include "GlobalSettings.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "TerrainRegistry.h"
+#include "TerritorySimulation.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+    /**
+     * @struct OpenEntry
+     * @brief An entry of a search's open list, ordered cheapest first.
+     */
+    struct OpenEntry {
+        uint32_t priority; ///< Cost so far plus heuristic.
+        uint32_t item;     ///< Tile or node.
+        bool operator>(const OpenEntry& other) const { return priority > other.priority; }
+    };
+
+    /**
+     * @struct SearchScratch
+     * @brief Per-thread search arrays, reused across queries; stamps stand in for clearing them.
+     */
+    struct SearchScratch {
+        std::vector<uint32_t> cost;   ///< Best cost found per item.
+        std::vector<uint32_t> parent; ///< Item each one was reached from.
+        std::vector<uint32_t> stamp;  ///< Search that last touched each item.
+        std::vector<OpenEntry> open;  ///< Binary heap of the open list.
+        uint32_t search = 0;          ///< Current search number.
+
+        // Starts a search over a number of items.
+        void begin(size_t items) {
+            if (stamp.size() < items) {
+                cost.resize(items);
+                parent.resize(items);
+                stamp.resize(items, 0);
+            }
+            if (++search == 0) {
+                std::fill(stamp.begin(), stamp.end(), 0); // The counter wrapped.
+                search = 1;
+            }
+            open.clear();
+        }
+
+        uint32_t getCost(uint32_t item) const {
+            return stamp[item] == search ? cost[item] : UINT32_MAX;
+        }
+
+        void setCost(uint32_t item, uint32_t value, uint32_t from) {
+            stamp[item] = search;
+            cost[item] = value;
+            parent[item] = from;
+        }
+
+        void push(uint32_t priority, uint32_t item) {
+            open.push_back(OpenEntry{priority, item});
+            std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        }
+
+        OpenEntry pop() {
+            std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+            OpenEntry entry = open.back();
+            open.pop_back();
+            return entry;
+        }
+    };
+
+    /**
+     * @struct BucketQueue
+     * @brief Open list of a tile search, bucketed by priority (Dial's algorithm).
+     *
+     * Tile searches pop priorities in rising order, and a step raises one by at most a tile's
+     * foreign cost plus the heuristic's change, so the pending priorities always fit in a
+     * ring of BUCKETS and each push and pop is constant time.
+     */
+    struct BucketQueue {
+        static constexpr uint32_t BUCKETS = 2048; ///< Ring size; a power of two above the largest step.
+        std::vector<std::vector<uint32_t>> buckets{BUCKETS}; ///< Items by priority modulo BUCKETS.
+        uint32_t current = 0; ///< Priority of the bucket being popped.
+        size_t count = 0;     ///< Items queued.
+
+        // Empties the queue, which an early finish leaves partly full.
+        void begin() {
+            if (count > 0) {
+                for (std::vector<uint32_t>& bucket : buckets) {
+                    bucket.clear();
+                }
+            }
+            current = 0;
+            count = 0;
+        }
+
+        void push(uint32_t priority, uint32_t item) {
+            buckets[priority & (BUCKETS - 1)].push_back(item);
+            count++;
+        }
+
+        bool pop(uint32_t& priority, uint32_t& item) {
+            if (count == 0) {
+                return false;
+            }
+            while (buckets[current & (BUCKETS - 1)].empty()) {
+                current++;
+            }
+            std::vector<uint32_t>& bucket = buckets[current & (BUCKETS - 1)];
+            priority = current;
+            item = bucket.back();
+            bucket.pop_back();
+            count--;
+            return true;
+        }
+    };
+
+    thread_local SearchScratch tileScratch;  ///< Tile searches in a region.
+    thread_local BucketQueue tileQueue;      ///< Open list of tile searches.
+    thread_local SearchScratch nodeScratch;  ///< Abstract graph searches.
+    thread_local std::vector<uint32_t> startDistances; ///< Costs from a query's start within its chunk.
+    thread_local std::vector<uint32_t> goalDistances;  ///< Costs to a query's goal within its chunk.
+    thread_local std::vector<uint32_t> edgeDistances;  ///< Costs from a node within its chunk, while building.
+    thread_local std::vector<uint32_t> corridorChunks; ///< Chunks a query's refinement may enter.
+    thread_local std::vector<uint32_t> corridorSlots;  ///< Position of each chunk in the corridor, or UINT32_MAX.
+}
+
+// Rebuilds everything for a new map; otherwise re-abstracts the chunks whose move costs changed and their neighbours.
+void Pathfinder::refresh(const TileMap& map) {
+    PROFILE_SCOPE("Pathfinder::refresh");
+    bool sameMap = built && map.getNumRows() == numRows && map.getNumCols() == numCols && map.getWorldSeed() == worldSeed;
+    if (!sameMap) {
+        const GlobalSettings& settings = GlobalSettings::getInstance();
+        const TerrainRegistry& registry = TerrainRegistry::getInstance();
+        minCost = 255;
+        for (size_t terrainId = 0; terrainId < terrainCosts.size(); terrainId++) {
+            const std::string& alias = registry.getAlias(static_cast<TerrainId>(terrainId));
+            int cost = alias.empty() ? 0 : std::clamp(settings.getTerrainMoveCost(alias), 0, 255);
+            terrainCosts[terrainId] = static_cast<uint8_t>(cost);
+            if (cost > 0) {
+                minCost = std::min<uint32_t>(minCost, static_cast<uint32_t>(cost));
+            }
+        }
+
+        numRows = map.getNumRows();
+        numCols = map.getNumCols();
+        worldSeed = map.getWorldSeed();
+        chunkCols = (numCols + CHUNK - 1) / CHUNK;
+        chunkRows = (numRows + CHUNK - 1) / CHUNK;
+        size_t chunkCount = static_cast<size_t>(chunkCols) * chunkRows;
+        costs.assign(map.getTileCount(), 0);
+        chunkRevisions.assign(chunkCount, 0);
+        chunkOwners.assign(chunkCount, MIXED_OWNERS);
+        nodes.clear();
+        freeNodes.clear();
+        borderNodes.assign(chunkCount * 2, {});
+        chunkNodes.assign(chunkCount, {});
+    }
+
+    // Revisions also change with ownership, which only changes the chunk's owner; compare the costs too.
+    const TerrainId* terrainIds = map.getTerrainIds();
+    const int32_t* ownerIds = map.getOwnerIds();
+    std::vector<uint32_t> dirty;
+    for (int cy = 0; cy < chunkRows; cy++) {
+        for (int cx = 0; cx < chunkCols; cx++) {
+            uint32_t chunk = static_cast<uint32_t>(cy * chunkCols + cx);
+            uint64_t revision = map.getChunkRevision(cx, cy);
+            if (sameMap && revision == chunkRevisions[chunk]) {
+                continue;
+            }
+            chunkRevisions[chunk] = revision;
+
+            bool changed = !sameMap;
+            int32_t owner = ownerIds[static_cast<size_t>(cy) * CHUNK * numCols + static_cast<size_t>(cx) * CHUNK];
+            for (int row = cy * CHUNK; row < std::min(numRows, (cy + 1) * CHUNK); row++) {
+                for (int col = cx * CHUNK; col < std::min(numCols, (cx + 1) * CHUNK); col++) {
+                    size_t index = static_cast<size_t>(row) * numCols + col;
+                    uint8_t cost = terrainCosts[terrainIds[index]];
+                    changed |= costs[index] != cost;
+                    costs[index] = cost;
+                    if (ownerIds[index] != owner) {
+                        owner = MIXED_OWNERS;
+                    }
+                }
+            }
+            chunkOwners[chunk] = owner;
+            if (changed) {
+                dirty.push_back(chunk);
+            }
+        }
+    }
+    built = true;
+    if (dirty.empty()) {
+        return;
+    }
+
+    // A chunk's borders are shared with its neighbours, whose node lists change with them.
+    std::vector<size_t> borders;
+    std::vector<uint32_t> affected;
+    for (uint32_t chunk : dirty) {
+        int cx = static_cast<int>(chunk) % chunkCols;
+        int cy = static_cast<int>(chunk) / chunkCols;
+        borders.push_back(chunk * 2);
+        borders.push_back(chunk * 2 + 1);
+        affected.push_back(chunk);
+        if (cx > 0) {
+            borders.push_back((chunk - 1) * 2);
+            affected.push_back(chunk - 1);
+        }
+        if (cy > 0) {
+            borders.push_back((chunk - chunkCols) * 2 + 1);
+            affected.push_back(chunk - chunkCols);
+        }
+        if (cx + 1 < chunkCols) affected.push_back(chunk + 1);
+        if (cy + 1 < chunkRows) affected.push_back(chunk + chunkCols);
+    }
+    std::sort(borders.begin(), borders.end());
+    borders.erase(std::unique(borders.begin(), borders.end()), borders.end());
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for (size_t border : borders) {
+        buildBorder(border);
+    }
+    JobSystem::getInstance().parallelFor(0, affected.size(), 16, [&](size_t first, size_t end) {
+        for (size_t i = first; i < end; i++) {
+            buildChunk(affected[i]);
+        }
+    });
+}
+
+// Searches tiles directly between neighbouring chunks; otherwise searches the graph and refines the route's corridor.
+PathResult Pathfinder::findPath(const TileMap& map, const PathRequest& request) const {
+    PathResult result;
+    if (!built || request.startCol < 0 || request.startCol >= numCols || request.startRow < 0 || request.startRow >= numRows ||
+        request.goalCol < 0 || request.goalCol >= numCols || request.goalRow < 0 || request.goalRow >= numRows) {
+        return result;
+    }
+
+    uint32_t start = static_cast<uint32_t>(request.startRow * numCols + request.startCol);
+    uint32_t goal = static_cast<uint32_t>(request.goalRow * numCols + request.goalCol);
+    if (costs[start] == 0 || costs[goal] == 0) {
+        return result;
+    }
+    result.tiles.push_back(start);
+    if (start == goal) {
+        result.found = true;
+        return result;
+    }
+
+    uint32_t startChunk = chunkOf(start);
+    uint32_t goalChunk = chunkOf(goal);
+    int startCx = static_cast<int>(startChunk) % chunkCols, startCy = static_cast<int>(startChunk) / chunkCols;
+    int goalCx = static_cast<int>(goalChunk) % chunkCols, goalCy = static_cast<int>(goalChunk) / chunkCols;
+    std::vector<uint32_t>& corridor = corridorChunks;
+    if (std::abs(startCx - goalCx) <= 1 && std::abs(startCy - goalCy) <= 1) {
+        corridor.clear();
+        addChunks(std::min(startCx, goalCx), std::min(startCy, goalCy), std::max(startCx, goalCx), std::max(startCy, goalCy), corridor);
+        if (searchCorridor(map, request.ownerId, corridor, start, goal, result.tiles, result.cost)) {
+            result.found = true;
+            return result;
+        }
+        // The way round leaves the neighbourhood; fall back to the graph.
+    }
+
+    chunkDistances(start, false, startDistances);
+    chunkDistances(goal, true, goalDistances);
+    auto localIndex = [this](uint32_t tile) {
+        int col = static_cast<int>(tile % numCols), row = static_cast<int>(tile / numCols);
+        int width = std::min(CHUNK, numCols - col / CHUNK * CHUNK);
+        return static_cast<size_t>((row % CHUNK) * width + col % CHUNK);
+    };
+    auto heuristic = [this, goal](uint32_t tile) {
+        int dx = std::abs(static_cast<int>(tile % numCols) - static_cast<int>(goal % numCols));
+        int dy = std::abs(static_cast<int>(tile / numCols) - static_cast<int>(goal / numCols));
+        return static_cast<uint32_t>(dx + dy) * minCost;
+    };
+
+    // A* over the graph; entering the goal chunk offers the finish at the node's cost to the goal.
+    // Chunks wholly owned by another faction cost the mover FOREIGN_COST_FACTOR times as much.
+    const int32_t* ownerIds = map.getOwnerIds();
+    const uint32_t startFactor = chunkFactor(startChunk, request.ownerId);
+    const uint32_t goalFactor = chunkFactor(goalChunk, request.ownerId);
+    SearchScratch& search = nodeScratch;
+    search.begin(nodes.size());
+    for (uint32_t node : chunkNodes[startChunk]) {
+        uint32_t cost = startDistances[localIndex(nodes[node].tile)];
+        if (cost != UNREACHED) {
+            cost *= startFactor;
+        }
+        if (cost != UNREACHED && cost < search.getCost(node)) {
+            search.setCost(node, cost, NO_NODE);
+            search.push(cost + heuristic(nodes[node].tile), node);
+        }
+    }
+
+    uint32_t bestCost = UNREACHED;
+    uint32_t lastNode = NO_NODE;
+    while (!search.open.empty()) {
+        OpenEntry entry = search.pop();
+        if (entry.priority >= bestCost) {
+            break;
+        }
+        uint32_t node = entry.item;
+        uint32_t cost = search.getCost(node);
+        if (entry.priority != cost + heuristic(nodes[node].tile)) {
+            continue; // Superseded by a cheaper entry.
+        }
+
+        if (nodes[node].chunk == goalChunk) {
+            uint32_t toGoal = goalDistances[localIndex(nodes[node].tile)];
+            if (toGoal != UNREACHED && cost + toGoal * goalFactor < bestCost) {
+                bestCost = cost + toGoal * goalFactor;
+                lastNode = node;
+            }
+        }
+
+        auto relax = [&](uint32_t target, uint32_t stepCost) {
+            uint32_t newCost = cost + stepCost;
+            if (newCost < search.getCost(target)) {
+                search.setCost(target, newCost, node);
+                search.push(newCost + heuristic(nodes[target].tile), target);
+            }
+        };
+        uint32_t peer = nodes[node].peer;
+        bool foreignPeer = request.ownerId != ANY_OWNER && ownerIds[nodes[peer].tile] != request.ownerId &&
+                           ownerIds[nodes[peer].tile] != TerritorySimulation::NEUTRAL_OWNER;
+        relax(peer, nodes[node].peerCost * (foreignPeer ? FOREIGN_COST_FACTOR : 1));
+        uint32_t factor = chunkFactor(nodes[node].chunk, request.ownerId);
+        for (const Edge& edge : nodes[node].edges) {
+            relax(edge.target, edge.cost * factor);
+        }
+    }
+    if (lastNode == NO_NODE) {
+        return result;
+    }
+
+    // Refine: the cheapest path through the chunks the route crosses and their neighbours, which
+    // straightens the detours to and between entrances and lets the path go round foreign tiles.
+    corridor.clear();
+    addChunks(startCx - CORRIDOR_MARGIN, startCy - CORRIDOR_MARGIN, startCx + CORRIDOR_MARGIN, startCy + CORRIDOR_MARGIN, corridor);
+    for (uint32_t node = lastNode; node != NO_NODE; node = search.parent[node]) {
+        int cx = static_cast<int>(nodes[node].chunk) % chunkCols, cy = static_cast<int>(nodes[node].chunk) / chunkCols;
+        addChunks(cx - CORRIDOR_MARGIN, cy - CORRIDOR_MARGIN, cx + CORRIDOR_MARGIN, cy + CORRIDOR_MARGIN, corridor);
+    }
+    std::sort(corridor.begin(), corridor.end());
+    corridor.erase(std::unique(corridor.begin(), corridor.end()), corridor.end());
+
+    result.found = searchCorridor(map, request.ownerId, corridor, start, goal, result.tiles, result.cost);
+    if (!result.found) {
+        result.tiles.clear();
+        result.cost = 0;
+    }
+    return result;
+}
+
+// Refreshes serially, then answers the queries as jobs of a few queries each.
+std::vector<PathResult> Pathfinder::findPaths(const TileMap& map, const std::vector<PathRequest>& requests) {
+    refresh(map);
+
+    PROFILE_SCOPE("Pathfinder::findPaths");
+    std::vector<PathResult> results(requests.size());
+    JobSystem::getInstance().parallelFor(0, requests.size(), 8, [&](size_t first, size_t end) {
+        for (size_t i = first; i < end; i++) {
+            results[i] = findPath(map, requests[i]);
+        }
+    });
+    return results;
+}
+
+size_t Pathfinder::getNodeCount() const {
+    return nodes.size() - freeNodes.size();
+}
+
+// Places an entrance in the middle of each short passable stretch of the border, and one at each end of a long one.
+void Pathfinder::buildBorder(size_t border) {
+    for (uint32_t node : borderNodes[border]) {
+        nodes[node].peer = NO_NODE;
+        nodes[node].edges.clear();
+        freeNodes.push_back(node);
+    }
+    borderNodes[border].clear();
+
+    int chunk = static_cast<int>(border / 2);
+    bool south = (border & 1) != 0;
+    int cx = chunk % chunkCols, cy = chunk / chunkCols;
+    if ((south && cy + 1 >= chunkRows) || (!south && cx + 1 >= chunkCols)) {
+        return; // The map edge.
+    }
+
+    // Walk along the border; a is the tile inside the chunk, b its neighbour across.
+    size_t lineStart = static_cast<size_t>(south ? cx * CHUNK : cy * CHUNK);
+    size_t lineEnd = static_cast<size_t>(south ? std::min(numCols, (cx + 1) * CHUNK) : std::min(numRows, (cy + 1) * CHUNK));
+    auto tileA = [&](size_t i) {
+        return south ? static_cast<uint32_t>((static_cast<size_t>(cy) * CHUNK + CHUNK - 1) * numCols + i)
+                     : static_cast<uint32_t>(i * numCols + static_cast<size_t>(cx) * CHUNK + CHUNK - 1);
+    };
+    auto tileB = [&](size_t i) { return south ? tileA(i) + static_cast<uint32_t>(numCols) : tileA(i) + 1; };
+    auto open = [&](size_t i) { return costs[tileA(i)] != 0 && costs[tileB(i)] != 0; };
+    auto addEntrance = [&](size_t i) {
+        uint32_t a = addNode(tileA(i));
+        uint32_t b = addNode(tileB(i));
+        nodes[a].peer = b;
+        nodes[a].peerCost = costs[nodes[b].tile];
+        nodes[b].peer = a;
+        nodes[b].peerCost = costs[nodes[a].tile];
+        borderNodes[border].push_back(a);
+        borderNodes[border].push_back(b);
+    };
+
+    for (size_t i = lineStart; i < lineEnd;) {
+        if (!open(i)) {
+            i++;
+            continue;
+        }
+        size_t end = i;
+        while (end < lineEnd && open(end)) {
+            end++;
+        }
+        if (end - i > SPLIT_ENTRANCE) {
+            addEntrance(i);
+            addEntrance(end - 1);
+        } else {
+            addEntrance((i + end - 1) / 2);
+        }
+        i = end;
+    }
+}
+
+// Gathers the chunk's nodes from its four borders, then joins each pair reachable inside the chunk.
+void Pathfinder::buildChunk(uint32_t chunk) {
+    int cx = static_cast<int>(chunk) % chunkCols, cy = static_cast<int>(chunk) / chunkCols;
+    std::vector<uint32_t>& members = chunkNodes[chunk];
+    members.clear();
+
+    size_t borders[4];
+    int borderCount = 0;
+    borders[borderCount++] = chunk * 2;
+    borders[borderCount++] = chunk * 2 + 1;
+    if (cx > 0) borders[borderCount++] = (chunk - 1) * 2;
+    if (cy > 0) borders[borderCount++] = (chunk - chunkCols) * 2 + 1;
+    for (int i = 0; i < borderCount; i++) {
+        for (uint32_t node : borderNodes[borders[i]]) {
+            if (nodes[node].chunk == chunk) {
+                members.push_back(node);
+            }
+        }
+    }
+
+    int width = std::min(CHUNK, numCols - cx * CHUNK);
+    for (uint32_t node : members) {
+        chunkDistances(nodes[node].tile, false, edgeDistances);
+        std::vector<Edge>& edges = nodes[node].edges;
+        edges.clear();
+        for (uint32_t other : members) {
+            uint32_t tile = nodes[other].tile;
+            size_t local = static_cast<size_t>((static_cast<int>(tile / numCols) - cy * CHUNK) * width +
+                                               static_cast<int>(tile % numCols) - cx * CHUNK);
+            if (other != node && edgeDistances[local] != UNREACHED) {
+                edges.push_back(Edge{other, edgeDistances[local]});
+            }
+        }
+    }
+}
+
+uint32_t Pathfinder::addNode(uint32_t tile) {
+    uint32_t node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[node].tile = tile;
+    nodes[node].chunk = chunkOf(tile);
+    nodes[node].edges.clear();
+    return node;
+}
+
+// Dijkstra inside the chunk. Forward, a step costs the tile entered; reversed, the tile left towards the target.
+void Pathfinder::chunkDistances(uint32_t tile, bool reverse, std::vector<uint32_t>& distances) const {
+    uint32_t chunk = chunkOf(tile);
+    int firstCol = static_cast<int>(chunk) % chunkCols * CHUNK, firstRow = static_cast<int>(chunk) / chunkCols * CHUNK;
+    int width = std::min(CHUNK, numCols - firstCol), height = std::min(CHUNK, numRows - firstRow);
+    distances.assign(static_cast<size_t>(width) * height, UNREACHED);
+
+    BucketQueue& open = tileQueue;
+    open.begin();
+    auto local = [&](int col, int row) { return static_cast<uint32_t>((row - firstRow) * width + col - firstCol); };
+    uint32_t source = local(static_cast<int>(tile % numCols), static_cast<int>(tile / numCols));
+    distances[source] = 0;
+    open.push(0, source);
+
+    static const int STEPS[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+    uint32_t priority, item;
+    while (open.pop(priority, item)) {
+        if (priority != distances[item]) {
+            continue;
+        }
+        int col = firstCol + static_cast<int>(item) % width;
+        int row = firstRow + static_cast<int>(item) / width;
+        uint32_t here = costs[static_cast<size_t>(row) * numCols + col];
+
+        for (const auto& step : STEPS) {
+            int nextCol = col + step[0], nextRow = row + step[1];
+            if (nextCol < firstCol || nextCol >= firstCol + width || nextRow < firstRow || nextRow >= firstRow + height) {
+                continue;
+            }
+            uint32_t next = costs[static_cast<size_t>(nextRow) * numCols + nextCol];
+            if (next == 0) {
+                continue;
+            }
+            uint32_t cost = priority + (reverse ? here : next);
+            uint32_t nextLocal = local(nextCol, nextRow);
+            if (cost < distances[nextLocal]) {
+                distances[nextLocal] = cost;
+                open.push(cost, nextLocal);
+            }
+        }
+    }
+}
+
+// A* with a Manhattan heuristic scaled by the cheapest terrain, which stays admissible with the foreign factor.
+// Tiles are numbered by the corridor position of their chunk, so the scratch arrays cover only the corridor.
+bool Pathfinder::searchCorridor(const TileMap& map, int32_t ownerId, const std::vector<uint32_t>& corridor,
+                                uint32_t from, uint32_t to, std::vector<uint32_t>& tiles, uint32_t& cost) const {
+    const int32_t* ownerIds = map.getOwnerIds();
+    const int goalCol = static_cast<int>(to % numCols), goalRow = static_cast<int>(to / numCols);
+    std::vector<uint32_t>& slots = corridorSlots;
+    if (slots.size() < chunkRevisions.size()) {
+        slots.assign(chunkRevisions.size(), UINT32_MAX);
+    }
+    for (size_t slot = 0; slot < corridor.size(); slot++) {
+        slots[corridor[slot]] = static_cast<uint32_t>(slot);
+    }
+    auto local = [&](int col, int row) {
+        uint32_t slot = slots[static_cast<size_t>(row / CHUNK) * chunkCols + col / CHUNK];
+        return slot == UINT32_MAX ? UINT32_MAX : slot * CHUNK * CHUNK + static_cast<uint32_t>((row % CHUNK) * CHUNK + col % CHUNK);
+    };
+    auto tileOf = [&](uint32_t item) {
+        uint32_t chunk = corridor[item / (CHUNK * CHUNK)];
+        int offset = static_cast<int>(item % (CHUNK * CHUNK));
+        int col = static_cast<int>(chunk) % chunkCols * CHUNK + offset % CHUNK;
+        int row = static_cast<int>(chunk) / chunkCols * CHUNK + offset / CHUNK;
+        return static_cast<uint32_t>(row * numCols + col);
+    };
+    auto heuristic = [&](int col, int row) {
+        return static_cast<uint32_t>(std::abs(col - goalCol) + std::abs(row - goalRow)) * minCost;
+    };
+
+    SearchScratch& search = tileScratch;
+    BucketQueue& open = tileQueue;
+    search.begin(corridor.size() * CHUNK * CHUNK);
+    open.begin();
+    int startCol = static_cast<int>(from % numCols), startRow = static_cast<int>(from / numCols);
+    uint32_t source = local(startCol, startRow);
+    uint32_t target = local(goalCol, goalRow);
+    bool reached = false;
+    if (source != UINT32_MAX && target != UINT32_MAX) {
+        search.setCost(source, 0, UINT32_MAX);
+        open.push(heuristic(startCol, startRow), source);
+    }
+
+    static const int STEPS[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+    uint32_t priority, item;
+    while (open.pop(priority, item)) {
+        uint32_t tile = tileOf(item);
+        int col = static_cast<int>(tile % numCols);
+        int row = static_cast<int>(tile / numCols);
+        uint32_t here = search.getCost(item);
+        if (priority != here + heuristic(col, row)) {
+            continue;
+        }
+
+        if (item == target) {
+            size_t first = tiles.size();
+            for (uint32_t item = target; item != source; item = search.parent[item]) {
+                tiles.push_back(tileOf(item));
+            }
+            std::reverse(tiles.begin() + static_cast<std::ptrdiff_t>(first), tiles.end());
+            cost = here;
+            reached = true;
+            break;
+        }
+
+        for (const auto& step : STEPS) {
+            int nextCol = col + step[0], nextRow = row + step[1];
+            if (nextCol < 0 || nextCol >= numCols || nextRow < 0 || nextRow >= numRows) {
+                continue;
+            }
+            uint32_t nextLocal = local(nextCol, nextRow);
+            size_t index = static_cast<size_t>(nextRow) * numCols + nextCol;
+            uint32_t stepCost = costs[index];
+            if (nextLocal == UINT32_MAX || stepCost == 0) {
+                continue;
+            }
+            if (ownerId != ANY_OWNER && ownerIds[index] != ownerId && ownerIds[index] != TerritorySimulation::NEUTRAL_OWNER) {
+                stepCost *= FOREIGN_COST_FACTOR;
+            }
+
+            uint32_t nextCost = here + stepCost;
+            if (nextCost < search.getCost(nextLocal)) {
+                search.setCost(nextLocal, nextCost, item);
+                open.push(nextCost + heuristic(nextCol, nextRow), nextLocal);
+            }
+        }
+    }
+
+    for (uint32_t chunk : corridor) {
+        slots[chunk] = UINT32_MAX;
+    }
+    return reached;
+}
+
+uint32_t Pathfinder::chunkFactor(uint32_t chunk, int32_t ownerId) const {
+    int32_t owner = chunkOwners[chunk];
+    bool foreign = ownerId != ANY_OWNER && owner != MIXED_OWNERS && owner != ownerId && owner != TerritorySimulation::NEUTRAL_OWNER;
+    return foreign ? FOREIGN_COST_FACTOR : 1;
+}
+
+// Appends the chunks of a rectangle that lie on the map.
+void Pathfinder::addChunks(int firstCx, int firstCy, int lastCx, int lastCy, std::vector<uint32_t>& corridor) const {
+    for (int cy = std::max(0, firstCy); cy <= std::min(chunkRows - 1, lastCy); cy++) {
+        for (int cx = std::max(0, firstCx); cx <= std::min(chunkCols - 1, lastCx); cx++) {
+            corridor.push_back(static_cast<uint32_t>(cy * chunkCols + cx));
+        }
+    }
+}
+
+uint32_t Pathfinder::chunkOf(uint32_t tile) const {
+    return static_cast<uint32_t>((static_cast<int>(tile / numCols) / CHUNK) * chunkCols + static_cast<int>(tile % numCols) / CHUNK);
+}
@@ -0,0 +1,188 @@
+#include "Profiler.h"
+
+#ifdef WARGAME_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // Writes a string as a JSON string literal.
+    void writeJsonString(std::ostream& out, const std::string& text) {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) >= 0x20) {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+}
+
+// Singleton instance: Ensures only one instance of Profiler exists. It is never destroyed, so
+// worker threads joined during static destruction can still record and retire their buffers.
+Profiler& Profiler::getInstance() {
+    static Profiler* instance = new Profiler();
+    return *instance;
+}
+
+Profiler::Profiler() = default;
+
+// Monotonic clock shared by every thread, so traces line up.
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Appends an event to the calling thread's ring, overwriting the oldest when full.
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex); // Uncontended unless an export is running.
+    buffer.events[buffer.written % EVENTS_PER_THREAD] = Event{name, start, end - start};
+    buffer.written++;
+}
+
+// Sets the name exported for the calling thread.
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.threadName = name;
+}
+
+// Finds the calling thread's buffer; the first call on a thread registers one, retired again when the thread exits.
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    thread_local BufferOwner owner;
+    if (!owner.buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        owner.buffer = acquireBuffer();
+    }
+    return *owner.buffer;
+}
+
+// Exported buffers are reused first; past the retirement limit the oldest unexported events are given up.
+Profiler::ThreadBuffer* Profiler::acquireBuffer() {
+    ThreadBuffer* buffer = nullptr;
+    if (!freeBuffers.empty()) {
+        buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+    } else if (retiredBuffers.size() >= MAX_RETIRED_BUFFERS) {
+        buffer = retiredBuffers.front();
+        retiredBuffers.erase(retiredBuffers.begin());
+    } else {
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+    }
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->written = 0;
+    buffer->threadId = ++nextThreadId;
+    buffer->threadName.clear();
+    buffer->retired = false;
+    return buffer;
+}
+
+void Profiler::retireBuffer(ThreadBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->retired = true;
+    retiredBuffers.push_back(buffer);
+}
+
+// Runs as the thread exits; the profiler singleton is never destroyed, so it is still there.
+Profiler::BufferOwner::~BufferOwner() {
+    if (buffer) {
+        Profiler::getInstance().retireBuffer(buffer);
+    }
+}
+
+// Stores a frame time in the rolling history.
+void Profiler::recordFrame(double seconds) {
+    frameTimes[framesRecorded % FRAME_HISTORY] = seconds;
+    framesRecorded++;
+}
+
+// Copies the rolling history out in the order the frames happened.
+std::vector<double> Profiler::getFrameTimes() const {
+    size_t count = std::min(framesRecorded, FRAME_HISTORY);
+    std::vector<double> times;
+    times.reserve(count);
+    for (size_t i = framesRecorded - count; i < framesRecorded; i++) {
+        times.push_back(frameTimes[i % FRAME_HISTORY]);
+    }
+    return times;
+}
+
+// Nearest-rank percentile of the rolling history.
+double Profiler::getFramePercentile(double percentile) const {
+    std::vector<double> times = getFrameTimes();
+    if (times.empty()) {
+        return 0.0;
+    }
+
+    size_t rank = static_cast<size_t>(percentile / 100.0 * (times.size() - 1) + 0.5);
+    rank = std::min(rank, times.size() - 1);
+    std::nth_element(times.begin(), times.begin() + rank, times.end());
+    return times[rank];
+}
+
+// Writes complete ("X") events plus thread-name metadata, with times in microseconds.
+bool Profiler::exportChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Error: Failed to open trace file for writing: " << path << "\n";
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (buffer->retired && buffer->written == 0) {
+            continue; // Free, or an exited thread that never recorded.
+        }
+
+        if (!buffer->threadName.empty()) {
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->threadName);
+            out << "}}";
+        }
+
+        uint64_t count = std::min<uint64_t>(buffer->written, EVENTS_PER_THREAD);
+        for (uint64_t i = buffer->written - count; i < buffer->written; i++) {
+            const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+            separator();
+            out << "{\"ph\":\"X\",\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << event.start / 1000 << '.' << (event.start / 100) % 10
+                << ",\"dur\":" << event.duration / 1000 << '.' << (event.duration / 100) % 10 << "}";
+        }
+    }
+    out << "]}\n";
+
+    // Exited threads' events are now in a trace; their buffers can serve new threads.
+    for (ThreadBuffer* buffer : retiredBuffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->written = 0;
+        freeBuffers.push_back(buffer);
+    }
+    retiredBuffers.clear();
+
+    if (!out) {
+        std::cerr << "Error: Failed to write trace file: " << path << "\n";
+        return false;
+    }
+    std::cout << "Wrote profiler trace to " << path << "\n";
+    return true;
+}
+
+#endif // WARGAME_PROFILING
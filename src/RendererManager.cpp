@@ -1,11 +1,19 @@
 #include "RendererManager.h"
+#include <algorithm>
 
 // Constructor: Initializes the renderer and tile renderer.
 RendererManager::RendererManager(SDL_Window* window, const std::unordered_map<std::string, std::string>& tileAssetMap, int tileSize)
-    : TILE_SIZE(tileSize), currHover(-1, -1), hoverColor({255, 255, 0, 150}) {
+    : TILE_SIZE(tileSize),
+      camera(GlobalSettings::getInstance().getWindowWidth(), GlobalSettings::getInstance().getWindowHeight()),
+      currHover(-1, -1), hoverColor({255, 255, 0, 150}) {
     
     // Create the SDL renderer
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // Render-target support lets the tile renderer cache the terrain layer between frames.
+    Uint32 flags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+    if (GlobalSettings::getInstance().isVsyncEnabled()) {
+        flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    renderer = SDL_CreateRenderer(window, -1, flags);
     if (!renderer) {
         SDL_Log("Renderer could not be created! SDL Error: %s", SDL_GetError());
         return;
@@ -13,10 +21,17 @@ RendererManager::RendererManager(SDL_Window* window, const std::unordered_map<st
 
     // Initialize the tile renderer
     tileRenderer = new TileRenderer(renderer, tileAssetMap);
+
+    // The map button toggles the minimap; without its image the M key still does.
+    mapButton = IMG_LoadTexture(renderer, GlobalSettings::getInstance().getMapButtonTexture().c_str());
+    if (!mapButton) {
+        SDL_Log("Failed to load texture: %s", IMG_GetError());
+    }
 }
 
 // Destructor: Cleans up resources.
 RendererManager::~RendererManager() {
+    if (mapButton) SDL_DestroyTexture(mapButton);
     delete tileRenderer;
     SDL_DestroyRenderer(renderer);
 }
@@ -27,24 +42,130 @@ void RendererManager::clear() {
     SDL_RenderClear(renderer);
 }
 
-// Renders the tile map and highlights the hovered tile.
-void RendererManager::render(const TileMap& tileMap) {
-    // Render all tiles
-    tileRenderer->renderTiles(tileMap, TILE_SIZE);
+// Renders the cached terrain layer, or the pyramid when zoomed out, and highlights the hovered tile.
+void RendererManager::render(const TileMap& tileMap, const VisibilityLayer* visibility, const EntityRegistry* entities,
+                             const MapPyramid* pyramid) {
+    PROFILE_SCOPE("RendererManager::render");
+
+    // Keep the view inside the current map, which may have changed size.
+    camera.clampTo(static_cast<float>(tileMap.getNumCols()) * TILE_SIZE, static_cast<float>(tileMap.getNumRows()) * TILE_SIZE);
+
+    // Render visible tiles, through the player's fog of war if there is one
+    tileRenderer->renderTiles(tileMap, TILE_SIZE, camera, visibility, GlobalSettings::getInstance().getPlayerId(), pyramid);
+
+    // Units would be under a pixel each once the map is drawn from the pyramid.
+    if (entities && (!pyramid || MapPyramid::chooseLevel(TILE_SIZE * camera.getZoom()) == 0)) {
+        renderUnits(tileMap, visibility, *entities);
+    }
 
     // Draw hover highlight
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(renderer, hoverColor.r, hoverColor.g, hoverColor.b, hoverColor.a);
-    SDL_Rect newRect = { 
-        std::get<0>(currHover) * TILE_SIZE, 
-        std::get<1>(currHover) * TILE_SIZE, 
-        TILE_SIZE, TILE_SIZE 
-    };
-    SDL_RenderFillRect(renderer, &newRect);
+    if (std::get<0>(currHover) >= 0 && std::get<1>(currHover) >= 0) {
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, hoverColor.r, hoverColor.g, hoverColor.b, hoverColor.a);
+        SDL_Rect newRect;
+        camera.tileToScreen(std::get<0>(currHover), std::get<1>(currHover), TILE_SIZE,
+                            newRect.x, newRect.y, newRect.w, newRect.h);
+        SDL_RenderFillRect(renderer, &newRect);
+    }
+
+    if (pyramid) {
+        if (minimapVisible) {
+            renderMinimap(tileMap, *pyramid);
+        }
+        if (mapButton) {
+            SDL_Rect button = getMapButtonArea();
+            SDL_RenderCopy(renderer, mapButton, nullptr, &button);
+        }
+    }
+
+#ifdef WARGAME_PROFILING
+    if (profilerOverlay) {
+        renderProfilerOverlay();
+    }
+#endif
+}
+
+// Draws the minimap, its border, and the camera's view scaled down onto it.
+void RendererManager::renderMinimap(const TileMap& tileMap, const MapPyramid& pyramid) {
+    PROFILE_SCOPE("RendererManager::renderMinimap");
+    if (tileMap.getNumCols() <= 0 || tileMap.getNumRows() <= 0) return;
+
+    SDL_Rect area = getMinimapArea(tileMap.getNumCols(), tileMap.getNumRows());
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_Rect border = {area.x - 2, area.y - 2, area.w + 4, area.h + 4};
+    SDL_RenderFillRect(renderer, &border);
+    tileRenderer->renderMinimap(tileMap, pyramid, area);
+
+    const float scaleX = static_cast<float>(area.w) / (static_cast<float>(tileMap.getNumCols()) * TILE_SIZE);
+    const float scaleY = static_cast<float>(area.h) / (static_cast<float>(tileMap.getNumRows()) * TILE_SIZE);
+    SDL_Rect view = {area.x + static_cast<int>(camera.getX() * scaleX), area.y + static_cast<int>(camera.getY() * scaleY),
+                     std::max(1, static_cast<int>(camera.getViewportWidth() / camera.getZoom() * scaleX)),
+                     std::max(1, static_cast<int>(camera.getViewportHeight() / camera.getZoom() * scaleY))};
+    SDL_RenderSetClipRect(renderer, &area);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDrawRect(renderer, &view);
+    SDL_RenderSetClipRect(renderer, nullptr);
+}
+
+// Keeps the map's aspect ratio, so every tile covers the same share of both axes.
+SDL_Rect RendererManager::getMinimapArea(int numCols, int numRows) const {
+    int width = MINIMAP_SIZE, height = MINIMAP_SIZE;
+    if (numCols > numRows) {
+        height = std::max(1, static_cast<int>(static_cast<int64_t>(MINIMAP_SIZE) * numRows / numCols));
+    } else if (numRows > numCols) {
+        width = std::max(1, static_cast<int>(static_cast<int64_t>(MINIMAP_SIZE) * numCols / numRows));
+    }
+    SDL_Rect button = getMapButtonArea();
+    return SDL_Rect{camera.getViewportWidth() - PANEL_MARGIN - width, button.y - PANEL_MARGIN - height, width, height};
+}
+
+SDL_Rect RendererManager::getMapButtonArea() const {
+    return SDL_Rect{camera.getViewportWidth() - PANEL_MARGIN - MAP_BUTTON_SIZE,
+                    camera.getViewportHeight() - PANEL_MARGIN - MAP_BUTTON_SIZE, MAP_BUTTON_SIZE, MAP_BUTTON_SIZE};
+}
+
+// Walks the packed positions once and draws the units in view as squares, one fill call per colour.
+void RendererManager::renderUnits(const TileMap& tileMap, const VisibilityLayer* visibility, const EntityRegistry& entities) {
+    PROFILE_SCOPE("RendererManager::renderUnits");
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+    int firstCol, firstRow, endCol, endRow;
+    camera.getVisibleTiles(TILE_SIZE, tileMap.getNumCols(), tileMap.getNumRows(), firstCol, firstRow, endCol, endRow);
+
+    const ComponentStore<Position>& positions = entities.getPositions();
+    const ComponentStore<Unit>& units = entities.getUnits();
+    friendlyUnits.clear();
+    enemyUnits.clear();
+    for (size_t i = 0; i < positions.size(); i++) {
+        const Position& position = positions.data()[i];
+        if (position.col < firstCol || position.col >= endCol || position.row < firstRow || position.row >= endRow) {
+            continue;
+        }
+        if (visibility && !visibility->isVisible(settings.getPlayerId(), position.col, position.row)) {
+            continue;
+        }
+        const Unit* unit = units.get(positions.entities()[i]);
+        if (!unit) {
+            continue;
+        }
+
+        // Forts fill most of their tile; other units are a small square in its centre.
+        SDL_Rect rect;
+        camera.tileToScreen(position.col, position.row, TILE_SIZE, rect.x, rect.y, rect.w, rect.h);
+        int inset = unit->kind == UNIT_FORT ? rect.w / 8 : rect.w / 3;
+        rect = SDL_Rect{rect.x + inset, rect.y + inset, rect.w - 2 * inset, rect.h - 2 * inset};
+        (settings.isPlayerId(unit->ownerId) ? friendlyUnits : enemyUnits).push_back(rect);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 30, 90, 220, 255);
+    SDL_RenderFillRects(renderer, friendlyUnits.data(), static_cast<int>(friendlyUnits.size()));
+    SDL_SetRenderDrawColor(renderer, 200, 40, 40, 255);
+    SDL_RenderFillRects(renderer, enemyUnits.data(), static_cast<int>(enemyUnits.size()));
 }
 
 // Presents the rendered content to the screen.
 void RendererManager::present() {
+    PROFILE_SCOPE("RendererManager::present");
     SDL_RenderPresent(renderer);
 }
 
@@ -54,6 +175,44 @@ void RendererManager::updateHover(int x, int y, SDL_Color newHoverColor) {
     hoverColor = newHoverColor;
 }
 
+// Forces the cached terrain layer to be redrawn.
+void RendererManager::invalidateCache() {
+    tileRenderer->invalidateCache();
+}
+
+// Shows or hides the minimap.
+void RendererManager::setMinimapVisible(bool visible) {
+    minimapVisible = visible;
+}
+
+// Checks whether the minimap is shown.
+bool RendererManager::isMinimapVisible() const {
+    return minimapVisible;
+}
+
+// Checks whether a screen position is on the map button.
+bool RendererManager::isOverMapButton(int x, int y) const {
+    SDL_Rect button = getMapButtonArea();
+    return x >= button.x && x < button.x + button.w && y >= button.y && y < button.y + button.h;
+}
+
+// The minimap shows the whole map, so a position on it scales straight to world pixels.
+bool RendererManager::minimapToWorld(int x, int y, const TileMap& tileMap, float& worldX, float& worldY) const {
+    if (!minimapVisible || tileMap.getNumCols() <= 0 || tileMap.getNumRows() <= 0) return false;
+
+    SDL_Rect area = getMinimapArea(tileMap.getNumCols(), tileMap.getNumRows());
+    if (x < area.x || x >= area.x + area.w || y < area.y || y >= area.y + area.h) return false;
+
+    worldX = (x - area.x + 0.5f) / area.w * static_cast<float>(tileMap.getNumCols()) * TILE_SIZE;
+    worldY = (y - area.y + 0.5f) / area.h * static_cast<float>(tileMap.getNumRows()) * TILE_SIZE;
+    return true;
+}
+
+// Accessor for the camera.
+Camera& RendererManager::getCamera() {
+    return camera;
+}
+
 // Accessor for the SDL renderer.
 SDL_Renderer* RendererManager::getSDLRenderer() { 
     return renderer; 
@@ -63,3 +222,52 @@ SDL_Renderer* RendererManager::getSDLRenderer() {
 TileRenderer* RendererManager::getTileRenderer() { 
     return tileRenderer; 
 }
+
+#ifdef WARGAME_PROFILING
+// Shows or hides the frame-time overlay.
+void RendererManager::setProfilerOverlayVisible(bool visible) {
+    profilerOverlay = visible;
+}
+
+// Checks whether the frame-time overlay is shown.
+bool RendererManager::isProfilerOverlayVisible() const {
+    return profilerOverlay;
+}
+
+// Draws one bar per recent frame in the bottom-left corner, with p50 (green) and p99 (red) lines.
+void RendererManager::renderProfilerOverlay() {
+    const Profiler& profiler = Profiler::getInstance();
+    std::vector<double> frameTimes = profiler.getFrameTimes();
+    if (frameTimes.empty()) {
+        return;
+    }
+
+    const int barWidth = 2;
+    const int width = static_cast<int>(Profiler::FRAME_HISTORY) * barWidth;
+    const int bottom = camera.getViewportHeight() - 10;
+    auto heightOf = [](double seconds) {
+        return std::min(OVERLAY_HEIGHT, static_cast<int>(seconds * 1000.0 * OVERLAY_PIXELS_PER_MS));
+    };
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_Rect background = {10, bottom - OVERLAY_HEIGHT, width, OVERLAY_HEIGHT};
+    SDL_RenderFillRect(renderer, &background);
+
+    std::vector<SDL_Rect> bars;
+    bars.reserve(frameTimes.size());
+    for (size_t i = 0; i < frameTimes.size(); i++) {
+        int height = heightOf(frameTimes[i]);
+        bars.push_back(SDL_Rect{10 + static_cast<int>(i) * barWidth, bottom - height, barWidth - 1, height});
+    }
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 200);
+    SDL_RenderFillRects(renderer, bars.data(), static_cast<int>(bars.size()));
+
+    int p50 = bottom - heightOf(profiler.getFramePercentile(50.0));
+    int p99 = bottom - heightOf(profiler.getFramePercentile(99.0));
+    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+    SDL_RenderDrawLine(renderer, 10, p50, 10 + width, p50);
+    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+    SDL_RenderDrawLine(renderer, 10, p99, 10 + width, p99);
+}
+#endif
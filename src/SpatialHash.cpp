@@ -0,0 +1,144 @@
+#include "SpatialHash.h"
+#include <algorithm>
+
+namespace {
+    // Cell coordinate of a tile coordinate, rounding down for negative ones.
+    int cellOf(int coordinate) {
+        return coordinate >= 0 ? coordinate / SpatialHash::CELL_SIZE : -((-coordinate - 1) / SpatialHash::CELL_SIZE) - 1;
+    }
+}
+
+// Moving within a cell only rewrites the entry; otherwise the entry moves to the new cell's list.
+void SpatialHash::insert(EntityId entity, int col, int row) {
+    uint64_t key = cellKey(col, row);
+    if (Location* location = find(entity)) {
+        if (location->cell == key) {
+            Entry& entry = (*location->entries)[location->entry];
+            entry.col = col;
+            entry.row = row;
+            return;
+        }
+        remove(entity);
+    }
+
+    uint32_t index = entityIndex(entity);
+    if (index >= locations.size()) {
+        locations.resize(static_cast<size_t>(index) + 1);
+    }
+    std::vector<Entry>& entries = cells[key];
+    locations[index] = Location{key, static_cast<uint32_t>(entries.size()), &entries};
+    entries.push_back(Entry{entity, col, row});
+    count++;
+}
+
+// Fills the hole with the cell's last entry and drops cells that become empty.
+bool SpatialHash::remove(EntityId entity) {
+    Location* location = find(entity);
+    if (!location) {
+        return false;
+    }
+
+    std::vector<Entry>& entries = *location->entries;
+    uint32_t slot = location->entry;
+    uint64_t key = location->cell;
+    *location = Location{};
+    if (slot + 1 != entries.size()) {
+        entries[slot] = entries.back();
+        locations[entityIndex(entries[slot].entity)].entry = slot;
+    }
+    entries.pop_back();
+    if (entries.empty()) {
+        cells.erase(key);
+    }
+    count--;
+    return true;
+}
+
+void SpatialHash::clear() {
+    cells.clear();
+    locations.clear();
+    count = 0;
+}
+
+// Newer entries sit at the end of a cell's list, so the list is walked backwards.
+size_t SpatialHash::queryTile(int col, int row, std::vector<EntityId>& out) const {
+    auto cell = cells.find(cellKey(col, row));
+    if (cell == cells.end()) {
+        return 0;
+    }
+
+    size_t found = 0;
+    for (auto entry = cell->second.rbegin(); entry != cell->second.rend(); ++entry) {
+        if (entry->col == col && entry->row == row) {
+            out.push_back(entry->entity);
+            found++;
+        }
+    }
+    return found;
+}
+
+// Cells wholly inside the rectangle are appended without looking at each entry's tile.
+size_t SpatialHash::queryRect(int firstCol, int firstRow, int endCol, int endRow, std::vector<EntityId>& out) const {
+    if (firstCol >= endCol || firstRow >= endRow) {
+        return 0;
+    }
+
+    size_t found = 0;
+    for (int cy = cellOf(firstRow); cy <= cellOf(endRow - 1); cy++) {
+        for (int cx = cellOf(firstCol); cx <= cellOf(endCol - 1); cx++) {
+            auto cell = cells.find(cellKey(cx * CELL_SIZE, cy * CELL_SIZE));
+            if (cell == cells.end()) {
+                continue;
+            }
+
+            bool inside = cx * CELL_SIZE >= firstCol && (cx + 1) * CELL_SIZE <= endCol &&
+                          cy * CELL_SIZE >= firstRow && (cy + 1) * CELL_SIZE <= endRow;
+            for (const Entry& entry : cell->second) {
+                if (inside || (entry.col >= firstCol && entry.col < endCol && entry.row >= firstRow && entry.row < endRow)) {
+                    out.push_back(entry.entity);
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+size_t SpatialHash::queryNear(int col, int row, int radius, std::vector<EntityId>& out) const {
+    radius = std::max(radius, 0);
+    return queryRect(col - radius, row - radius, col + radius + 1, row + radius + 1, out);
+}
+
+EntityId SpatialHash::findOnTile(int col, int row) const {
+    auto cell = cells.find(cellKey(col, row));
+    if (cell == cells.end()) {
+        return NO_ENTITY;
+    }
+
+    for (auto entry = cell->second.rbegin(); entry != cell->second.rend(); ++entry) {
+        if (entry->col == col && entry->row == row) {
+            return entry->entity;
+        }
+    }
+    return NO_ENTITY;
+}
+
+size_t SpatialHash::size() const {
+    return count;
+}
+
+// The cell row fills the high half and the cell column the low half.
+uint64_t SpatialHash::cellKey(int col, int row) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellOf(row))) << 32) | static_cast<uint32_t>(cellOf(col));
+}
+
+// A slot's location only belongs to the entity if its entry still names that generation.
+SpatialHash::Location* SpatialHash::find(EntityId entity) {
+    uint32_t index = entityIndex(entity);
+    if (index >= locations.size() || locations[index].entry == ABSENT) {
+        return nullptr;
+    }
+
+    Location& location = locations[index];
+    return (*location.entries)[location.entry].entity == entity ? &location : nullptr;
+}
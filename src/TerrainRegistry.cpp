@@ -0,0 +1,79 @@
+#include "TerrainRegistry.h"
+#include <algorithm>
+
+namespace {
+    const std::string EMPTY_STRING;
+    const std::vector<TerrainId> EMPTY_TERRAIN_LIST;
+
+    // Strips trailing digits from an alias, e.g. "deadgrass2" -> "deadgrass".
+    std::string familyName(const std::string& alias) {
+        size_t end = alias.find_last_not_of("0123456789");
+        return end == std::string::npos ? alias : alias.substr(0, end + 1);
+    }
+}
+
+// Singleton instance: Ensures only one instance of TerrainRegistry exists.
+TerrainRegistry& TerrainRegistry::getInstance() {
+    static TerrainRegistry instance;
+    return instance;
+}
+
+// Constructor: Assigns IDs to every tile texture alias, sorted so IDs are stable between runs.
+TerrainRegistry::TerrainRegistry() {
+    const auto& textures = GlobalSettings::getInstance().getTileTextures();
+
+    for (const auto& pair : textures) {
+        aliases.push_back(pair.first);
+    }
+    std::sort(aliases.begin(), aliases.end());
+
+    if (aliases.size() >= INVALID_TERRAIN) {
+        std::cerr << "Error: Too many terrain types (" << aliases.size() << "). Extra types are ignored.\n";
+        aliases.resize(INVALID_TERRAIN);
+    }
+
+    std::vector<std::string> familyNames;
+    for (size_t i = 0; i < aliases.size(); i++) {
+        TerrainId id = static_cast<TerrainId>(i);
+        texturePaths.push_back(textures.at(aliases[i]));
+        idsByAlias[aliases[i]] = id;
+        allTerrains.push_back(id);
+
+        // Group variants that share a base name into one family.
+        std::string family = familyName(aliases[i]);
+        auto it = std::find(familyNames.begin(), familyNames.end(), family);
+        size_t index = static_cast<size_t>(it - familyNames.begin());
+        if (it == familyNames.end()) {
+            familyNames.push_back(family);
+            families.emplace_back();
+        }
+        families[index].push_back(id);
+        familyIndex.push_back(index);
+    }
+}
+
+size_t TerrainRegistry::size() const {
+    return aliases.size();
+}
+
+// Looks up an alias; only used at asset-loading and file boundaries.
+TerrainId TerrainRegistry::getId(const std::string& alias) const {
+    auto it = idsByAlias.find(alias);
+    return it != idsByAlias.end() ? it->second : INVALID_TERRAIN;
+}
+
+const std::string& TerrainRegistry::getAlias(TerrainId terrainId) const {
+    return terrainId < aliases.size() ? aliases[terrainId] : EMPTY_STRING;
+}
+
+const std::string& TerrainRegistry::getTexturePath(TerrainId terrainId) const {
+    return terrainId < texturePaths.size() ? texturePaths[terrainId] : EMPTY_STRING;
+}
+
+const std::vector<TerrainId>& TerrainRegistry::getAllTerrains() const {
+    return allTerrains;
+}
+
+const std::vector<TerrainId>& TerrainRegistry::getMatchingTerrain(TerrainId terrainId) const {
+    return terrainId < familyIndex.size() ? families[familyIndex[terrainId]] : EMPTY_TERRAIN_LIST;
+}
@@ -0,0 +1,208 @@
+#include "TerritoryIndex.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+// Summarizes each band of chunk rows as a job, then adds the summaries into the totals.
+void TerritoryIndex::build(const TerrainId* terrainIds, const int32_t* ownerIds, int numRows, int numCols) {
+    PROFILE_SCOPE("TerritoryIndex::build");
+    clear();
+    this->numRows = numRows;
+    this->numCols = numCols;
+    chunkCols = (numCols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const int chunkRows = (numRows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunks.assign(static_cast<size_t>(chunkCols) * chunkRows, {});
+
+    JobSystem::getInstance().parallelFor(0, static_cast<size_t>(chunkRows), 1, [&](size_t firstBand, size_t endBand) {
+        for (size_t band = firstBand; band < endBand; band++) {
+            int firstRow = static_cast<int>(band) * CHUNK_SIZE;
+            int endRow = std::min(numRows, firstRow + CHUNK_SIZE);
+            for (int row = firstRow; row < endRow; row++) {
+                size_t index = static_cast<size_t>(row) * numCols;
+                for (int col = 0; col < numCols; col++, index++) {
+                    addToChunk(chunks[band * chunkCols + col / CHUNK_SIZE], ownerIds[index], terrainIds[index], 1);
+                }
+            }
+        }
+    });
+
+    for (const std::vector<ChunkEntry>& entries : chunks) {
+        for (const ChunkEntry& entry : entries) {
+            addToTotals(entry.ownerId, entry.terrainId, entry.tiles);
+        }
+    }
+    built = true;
+}
+
+void TerritoryIndex::clear() {
+    built = false;
+    numRows = numCols = chunkCols = 0;
+    chunks.clear();
+    ownerTiles.clear();
+    pairTiles.clear();
+    terrainTiles.fill(0);
+}
+
+bool TerritoryIndex::isBuilt() const {
+    return built;
+}
+
+void TerritoryIndex::moveTile(size_t index, TerrainId oldTerrain, int32_t oldOwner, TerrainId newTerrain, int32_t newOwner) {
+    if (!built || (oldTerrain == newTerrain && oldOwner == newOwner)) {
+        return;
+    }
+
+    int col = static_cast<int>(index % static_cast<size_t>(numCols));
+    int row = static_cast<int>(index / static_cast<size_t>(numCols));
+    std::vector<ChunkEntry>& entries = chunks[static_cast<size_t>(row / CHUNK_SIZE) * chunkCols + col / CHUNK_SIZE];
+    addToChunk(entries, oldOwner, oldTerrain, -1);
+    addToChunk(entries, newOwner, newTerrain, 1);
+    addToTotals(oldOwner, oldTerrain, -1);
+    addToTotals(newOwner, newTerrain, 1);
+}
+
+uint64_t TerritoryIndex::countOwnerTiles(int32_t ownerId) const {
+    auto it = ownerTiles.find(ownerId);
+    return it != ownerTiles.end() ? it->second : 0;
+}
+
+uint64_t TerritoryIndex::countOwnerTiles(int32_t ownerId, TerrainId terrainId) const {
+    auto it = pairTiles.find(pairKey(ownerId, terrainId));
+    return it != pairTiles.end() ? it->second : 0;
+}
+
+uint64_t TerritoryIndex::countTerrainTiles(TerrainId terrainId) const {
+    return terrainTiles[terrainId];
+}
+
+std::vector<TerritoryIndex::OwnerCount> TerritoryIndex::getOwnerCounts() const {
+    std::vector<OwnerCount> counts;
+    counts.reserve(ownerTiles.size());
+    for (const auto& [ownerId, tiles] : ownerTiles) {
+        counts.push_back(OwnerCount{ownerId, tiles});
+    }
+    std::sort(counts.begin(), counts.end(), [](const OwnerCount& a, const OwnerCount& b) { return a.ownerId < b.ownerId; });
+    return counts;
+}
+
+std::vector<TerritoryIndex::TileCount> TerritoryIndex::getTileCounts() const {
+    std::vector<TileCount> counts;
+    counts.reserve(pairTiles.size());
+    for (const auto& [key, tiles] : pairTiles) {
+        counts.push_back(TileCount{static_cast<int32_t>(key >> 8), static_cast<TerrainId>(key & 0xFF), tiles});
+    }
+    std::sort(counts.begin(), counts.end(), [](const TileCount& a, const TileCount& b) {
+        return a.ownerId != b.ownerId ? a.ownerId < b.ownerId : a.terrainId < b.terrainId;
+    });
+    return counts;
+}
+
+// Whole chunks come from their summaries; chunks cut by the rectangle's edges are scanned.
+std::vector<TerritoryIndex::TileCount> TerritoryIndex::countRegion(const TerrainId* terrainIds, const int32_t* ownerIds,
+                                                                   int firstCol, int firstRow, int endCol, int endRow) const {
+    firstCol = std::max(firstCol, 0);
+    firstRow = std::max(firstRow, 0);
+    endCol = std::min(endCol, numCols);
+    endRow = std::min(endRow, numRows);
+    if (!built || firstCol >= endCol || firstRow >= endRow) {
+        return {};
+    }
+
+    std::unordered_map<uint64_t, uint64_t> totals;
+    for (int cy = firstRow / CHUNK_SIZE; cy * CHUNK_SIZE < endRow; cy++) {
+        for (int cx = firstCol / CHUNK_SIZE; cx * CHUNK_SIZE < endCol; cx++) {
+            int chunkFirstCol = cx * CHUNK_SIZE, chunkEndCol = std::min(numCols, chunkFirstCol + CHUNK_SIZE);
+            int chunkFirstRow = cy * CHUNK_SIZE, chunkEndRow = std::min(numRows, chunkFirstRow + CHUNK_SIZE);
+            if (chunkFirstCol >= firstCol && chunkEndCol <= endCol && chunkFirstRow >= firstRow && chunkEndRow <= endRow) {
+                for (const ChunkEntry& entry : chunks[static_cast<size_t>(cy) * chunkCols + cx]) {
+                    totals[pairKey(entry.ownerId, entry.terrainId)] += entry.tiles;
+                }
+                continue;
+            }
+
+            // Neighbouring tiles mostly match, so runs are counted before touching the map.
+            for (int row = std::max(firstRow, chunkFirstRow); row < std::min(endRow, chunkEndRow); row++) {
+                size_t index = static_cast<size_t>(row) * numCols + std::max(firstCol, chunkFirstCol);
+                size_t end = static_cast<size_t>(row) * numCols + std::min(endCol, chunkEndCol);
+                while (index < end) {
+                    size_t runEnd = index + 1;
+                    while (runEnd < end && ownerIds[runEnd] == ownerIds[index] && terrainIds[runEnd] == terrainIds[index]) {
+                        runEnd++;
+                    }
+                    totals[pairKey(ownerIds[index], terrainIds[index])] += runEnd - index;
+                    index = runEnd;
+                }
+            }
+        }
+    }
+
+    std::vector<TileCount> counts;
+    counts.reserve(totals.size());
+    for (const auto& [key, tiles] : totals) {
+        counts.push_back(TileCount{static_cast<int32_t>(key >> 8), static_cast<TerrainId>(key & 0xFF), tiles});
+    }
+    std::sort(counts.begin(), counts.end(), [](const TileCount& a, const TileCount& b) {
+        return a.ownerId != b.ownerId ? a.ownerId < b.ownerId : a.terrainId < b.terrainId;
+    });
+    return counts;
+}
+
+std::vector<TerritoryIndex::OwnerCount> TerritoryIndex::sumByOwner(const std::vector<TileCount>& counts) {
+    std::vector<OwnerCount> owners;
+    for (const TileCount& count : counts) {
+        if (owners.empty() || owners.back().ownerId != count.ownerId) {
+            owners.push_back(OwnerCount{count.ownerId, 0});
+        }
+        owners.back().tiles += count.tiles;
+    }
+    return owners;
+}
+
+size_t TerritoryIndex::getMemoryUsage() const {
+    size_t bytes = chunks.capacity() * sizeof(std::vector<ChunkEntry>);
+    for (const std::vector<ChunkEntry>& entries : chunks) {
+        bytes += entries.capacity() * sizeof(ChunkEntry);
+    }
+    return bytes + (ownerTiles.size() + pairTiles.size()) * 4 * sizeof(uint64_t); // Hash nodes: key, count, link and hash.
+}
+
+// The owner fills the high bits and the terrain the low byte.
+uint64_t TerritoryIndex::pairKey(int32_t ownerId, TerrainId terrainId) {
+    return (static_cast<uint64_t>(static_cast<int64_t>(ownerId)) << 8) | terrainId;
+}
+
+void TerritoryIndex::addToChunk(std::vector<ChunkEntry>& entries, int32_t ownerId, TerrainId terrainId, int delta) {
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].ownerId == ownerId && entries[i].terrainId == terrainId) {
+            entries[i].tiles = static_cast<uint16_t>(entries[i].tiles + delta);
+            if (entries[i].tiles == 0) {
+                entries[i] = entries.back();
+                entries.pop_back();
+            }
+            return;
+        }
+    }
+    entries.push_back(ChunkEntry{ownerId, terrainId, static_cast<uint16_t>(delta)});
+}
+
+void TerritoryIndex::addToTotals(int32_t ownerId, TerrainId terrainId, int64_t delta) {
+    terrainTiles[terrainId] += static_cast<uint64_t>(delta);
+
+    auto owner = ownerTiles.find(ownerId);
+    if (owner == ownerTiles.end()) {
+        owner = ownerTiles.emplace(ownerId, 0).first;
+    }
+    owner->second += static_cast<uint64_t>(delta);
+    if (owner->second == 0) {
+        ownerTiles.erase(owner);
+    }
+
+    auto pair = pairTiles.find(pairKey(ownerId, terrainId));
+    if (pair == pairTiles.end()) {
+        pair = pairTiles.emplace(pairKey(ownerId, terrainId), 0).first;
+    }
+    pair->second += static_cast<uint64_t>(delta);
+    if (pair->second == 0) {
+        pairTiles.erase(pair);
+    }
+}
@@ -0,0 +1,261 @@
+#include "TerritorySimulation.h"
+#include "GlobalSettings.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "TerrainRegistry.h"
+#include <algorithm>
+
+namespace {
+    constexpr uint64_t CAPTURE_STREAM = 0x43415054; ///< Hash stream of capture rolls.
+    constexpr uint64_t TRAIT_STREAM = 0x54524149;   ///< Hash stream of AI traits.
+
+    // How many updates of income a faction has saved.
+    int64_t reserveTicks(const TerritorySimulation::Faction& faction) {
+        return faction.resources / std::max<int64_t>(1, faction.income);
+    }
+}
+
+// Builds the faction list from one pass over the owner plane; runs of equal owners skip the lookup.
+void TerritorySimulation::reset(const TileMap& world) {
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    for (size_t terrainId = 0; terrainId < terrainYields.size(); terrainId++) {
+        const std::string& alias = registry.getAlias(static_cast<TerrainId>(terrainId));
+        terrainYields[terrainId] = alias.empty() ? 0 : settings.getTerrainYield(alias);
+    }
+
+    seed = world.getWorldSeed();
+    ticks = 0;
+    nextRow = 0;
+    contested = false;
+    factions.clear();
+    factionIndex.clear();
+    bandCaptures.clear();
+
+    // The territory index has every owner's tiles per terrain, which is all the income depends on.
+    std::unordered_map<int32_t, Faction> byOwner;
+    for (const TerritoryIndex::TileCount& count : world.getTerritoryIndex().getTileCounts()) {
+        Faction& faction = byOwner[count.ownerId];
+        faction.ownerId = count.ownerId;
+        faction.tiles += count.tiles;
+        faction.income += terrainYields[count.terrainId] * static_cast<int64_t>(count.tiles);
+    }
+
+    for (auto& [ownerId, faction] : byOwner) {
+        faction.ai = ownerId != NEUTRAL_OWNER && !settings.isPlayerId(ownerId);
+        faction.aggression = static_cast<uint8_t>(WorldGenerator::hashCoords(seed, ownerId, 0, TRAIT_STREAM));
+        factions.push_back(faction);
+    }
+    std::sort(factions.begin(), factions.end(), [](const Faction& a, const Faction& b) { return a.ownerId < b.ownerId; });
+    for (size_t i = 0; i < factions.size(); i++) {
+        factionIndex[factions[i].ownerId] = static_cast<uint32_t>(i);
+    }
+}
+
+// Runs both halves of an update back to back.
+void TerritorySimulation::tick(TileMap& world) {
+    PROFILE_SCOPE("TerritorySimulation::tick");
+    contest(world);
+    applyContest(world);
+}
+
+// Pays income and contests the window's bands (in parallel on large windows); only faction state changes.
+void TerritorySimulation::contest(const TileMap& world) {
+    PROFILE_SCOPE("TerritorySimulation::contest");
+    const int numRows = world.getNumRows();
+    const int numCols = world.getNumCols();
+    if (factions.empty() || numRows == 0 || numCols == 0) {
+        return;
+    }
+
+    if (ticks % DECISION_TICKS == 0) {
+        decide();
+    }
+    for (Faction& faction : factions) {
+        if (faction.ownerId == NEUTRAL_OWNER) {
+            continue;
+        }
+        faction.resources += faction.income;
+
+        int64_t reserve = reserveTicks(faction) / CAPTURE_COST_TICKS;
+        uint32_t strength = 1;
+        while (reserve > 0 && strength < 8) {
+            reserve >>= 1;
+            strength++;
+        }
+        faction.strength = strength;
+    }
+
+    size_t tilesPerTick = GlobalSettings::getInstance().getSimulationTilesPerTick();
+    int windowRows = static_cast<int>(std::clamp<size_t>(tilesPerTick / static_cast<size_t>(numCols), 1, static_cast<size_t>(numRows)));
+    int firstRow = nextRow < numRows ? nextRow : 0;
+    int endRow = std::min(numRows, firstRow + windowRows);
+    nextRow = endRow < numRows ? endRow : 0;
+
+    const size_t bands = static_cast<size_t>(endRow - firstRow + BAND_ROWS - 1) / BAND_ROWS;
+    const size_t bandsPerJob = static_cast<size_t>(endRow - firstRow) * numCols >= PARALLEL_SIMULATION_TILES ? 1 : bands;
+    bandCaptures.resize(bands);
+    JobSystem::getInstance().parallelFor(0, bands, bandsPerJob, [&](size_t firstBand, size_t endBand) {
+        for (size_t band = firstBand; band < endBand; band++) {
+            std::vector<Capture>& captures = bandCaptures[band];
+            captures.clear();
+            int bandRow = firstRow + static_cast<int>(band) * BAND_ROWS;
+            contestRows(world, bandRow, std::min(endRow, bandRow + BAND_ROWS), captures);
+        }
+    });
+    contested = true;
+}
+
+// Applies the rolled captures and counts the update.
+void TerritorySimulation::applyContest(TileMap& world) {
+    if (!contested) {
+        return;
+    }
+
+    PROFILE_SCOPE("TerritorySimulation::applyContest");
+    applyCaptures(world);
+    contested = false;
+    ticks++;
+}
+
+const std::vector<TerritorySimulation::Faction>& TerritorySimulation::getFactions() const {
+    return factions;
+}
+
+const TerritorySimulation::Faction* TerritorySimulation::getFaction(int32_t ownerId) const {
+    uint32_t index = findFaction(ownerId);
+    return index == NO_FACTION ? nullptr : &factions[index];
+}
+
+void TerritorySimulation::setPosture(int32_t ownerId, Posture posture) {
+    uint32_t index = findFaction(ownerId);
+    if (index != NO_FACTION) {
+        factions[index].posture = posture;
+    }
+}
+
+uint64_t TerritorySimulation::getTickCount() const {
+    return ticks;
+}
+
+// Rebuilds after spending down to one capture's worth of reserve; aggressive factions attack sooner.
+void TerritorySimulation::decide() {
+    for (Faction& faction : factions) {
+        if (!faction.ai || faction.tiles == 0) {
+            continue;
+        }
+
+        int64_t reserve = reserveTicks(faction);
+        int64_t attackReserve = CAPTURE_COST_TICKS * (2 + (255 - faction.aggression) / 64);
+        if (reserve < CAPTURE_COST_TICKS) {
+            faction.posture = HOLD;
+        } else if (reserve >= attackReserve) {
+            faction.posture = ATTACK;
+        } else {
+            faction.posture = EXPAND;
+        }
+    }
+}
+
+// Tiles whose four neighbours share their owner are skipped; most of the world takes that path.
+// A border tile is contested by the neighbouring owner with the most sides on it.
+void TerritorySimulation::contestRows(const TileMap& world, int firstRow, int endRow, std::vector<Capture>& captures) const {
+    const int numRows = world.getNumRows();
+    const int numCols = world.getNumCols();
+    const int32_t* ownerIds = world.getOwnerIds();
+
+    for (int row = firstRow; row < endRow; row++) {
+        size_t rowStart = static_cast<size_t>(row) * numCols;
+        const int32_t* here = ownerIds + rowStart;
+        const int32_t* above = row > 0 ? here - numCols : here; // Edge rows compare with themselves.
+        const int32_t* below = row + 1 < numRows ? here + numCols : here;
+        for (int col = 0; col < numCols; col++) {
+            int32_t owner = here[col];
+            int32_t left = col > 0 ? here[col - 1] : owner;
+            int32_t right = col + 1 < numCols ? here[col + 1] : owner;
+            if (((above[col] ^ owner) | (below[col] ^ owner) | (left ^ owner) | (right ^ owner)) == 0) {
+                continue;
+            }
+
+            // No capture is likelier than CAPTURE_CHANCE, so most border tiles stop at the roll.
+            size_t index = rowStart + col;
+            uint64_t roll = WorldGenerator::hashCoords(seed, static_cast<int64_t>(index), static_cast<int64_t>(ticks), CAPTURE_STREAM) & 0xFFFF;
+            if (roll >= CAPTURE_CHANCE) {
+                continue;
+            }
+
+            int32_t neighbours[4];
+            int count = 0;
+            if (row > 0) neighbours[count++] = above[col];
+            if (col > 0) neighbours[count++] = left;
+            if (col + 1 < numCols) neighbours[count++] = right;
+            if (row + 1 < numRows) neighbours[count++] = below[col];
+
+            int defenderSides = 0;
+            int attackerSides = 0;
+            int32_t attackerOwner = owner;
+            for (int i = 0; i < count; i++) {
+                if (neighbours[i] == owner) {
+                    defenderSides++;
+                    continue;
+                }
+                int sides = static_cast<int>(std::count(neighbours, neighbours + count, neighbours[i]));
+                if (sides > attackerSides) {
+                    attackerSides = sides;
+                    attackerOwner = neighbours[i];
+                }
+            }
+
+            uint32_t attacker = findFaction(attackerOwner);
+            uint32_t defender = findFaction(owner);
+            if (attacker == NO_FACTION || defender == NO_FACTION) {
+                continue;
+            }
+
+            const Faction& attacking = factions[attacker];
+            const Faction& defending = factions[defender];
+            bool willing = attacking.posture == ATTACK ||
+                           (attacking.posture == EXPAND && (owner == NEUTRAL_OWNER || defending.strength < attacking.strength));
+            if (!willing || attackerOwner == NEUTRAL_OWNER) {
+                continue;
+            }
+
+            uint64_t attack = static_cast<uint64_t>(attackerSides) * attacking.strength;
+            uint64_t defence = static_cast<uint64_t>(defenderSides + 1) * defending.strength;
+            uint64_t threshold = CAPTURE_CHANCE * attack / (attack + defence);
+            if (roll < threshold) {
+                captures.push_back(Capture{static_cast<uint32_t>(index), attacker, defender});
+            }
+        }
+    }
+}
+
+// Runs serially in band order, so resources are spent in the same order on every run.
+void TerritorySimulation::applyCaptures(TileMap& world) {
+    const int numCols = world.getNumCols();
+    const TerrainId* terrainIds = world.getTerrainIds();
+
+    for (const std::vector<Capture>& captures : bandCaptures) {
+        for (const Capture& capture : captures) {
+            Faction& attacking = factions[capture.attacker];
+            Faction& defending = factions[capture.defender];
+            int64_t yield = terrainYields[terrainIds[capture.index]];
+            int64_t cost = std::max<int64_t>(1, yield * CAPTURE_COST_TICKS);
+            if (attacking.resources < cost) {
+                continue;
+            }
+
+            attacking.resources -= cost;
+            world.setOwnerId(static_cast<int>(capture.index % numCols), static_cast<int>(capture.index / numCols), attacking.ownerId);
+            attacking.tiles++;
+            attacking.income += yield;
+            defending.tiles--;
+            defending.income -= yield;
+        }
+    }
+}
+
+uint32_t TerritorySimulation::findFaction(int32_t ownerId) const {
+    auto it = factionIndex.find(ownerId);
+    return it == factionIndex.end() ? NO_FACTION : it->second;
+}
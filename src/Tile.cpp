@@ -1,22 +1,34 @@
 #include "Tile.h"
 
-// Constructor: Initializes a tile with position, asset alias, and owner ID.
-Tile::Tile(int x, int y, const std::string& assetAlias, const int32_t ownerId)
-    : x(x), y(y), assetAlias(assetAlias), ownerId(ownerId) {}
+// Constructor: Initializes a tile view with grid position, terrain, and owner ID.
+Tile::Tile(int col, int row, int tileSize, TerrainId terrainId, int32_t ownerId, uint8_t flags)
+    : col(col), row(row), tileSize(tileSize), ownerId(ownerId), terrainId(terrainId), flags(flags) {}
 
 // Getters for tile properties.
-const std::string& Tile::getAssetAlias() const { 
-    return assetAlias; 
+TerrainId Tile::getTerrainId() const {
+    return terrainId;
 }
 
-int Tile::getX() const { 
-    return x; 
+int Tile::getX() const {
+    return col * tileSize;
 }
 
-int Tile::getY() const { 
-    return y; 
+int Tile::getY() const {
+    return row * tileSize;
 }
 
-const int32_t& Tile::getOwnerId() const { 
-    return ownerId; 
+int Tile::getCol() const {
+    return col;
+}
+
+int Tile::getRow() const {
+    return row;
+}
+
+const int32_t& Tile::getOwnerId() const {
+    return ownerId;
+}
+
+uint8_t Tile::getFlags() const {
+    return flags;
 }
@@ -1,74 +1,408 @@
 #include "TileMap.h"
+#include "JobSystem.h"
+#include "MapFormat.h"
+#include "WorldGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <filesystem>
+
+namespace {
+    std::atomic<uint64_t> revisionCounter{0}; ///< Source of map revisions, shared by every map.
+
+    // Returns a revision no map has used before.
+    uint64_t nextRevision() {
+        return ++revisionCounter;
+    }
+
+    constexpr size_t PARALLEL_GENERATION_TILES = 1 << 16; ///< Smallest map worth splitting into jobs.
+
+    static_assert(TerritoryIndex::CHUNK_SIZE == TileMap::CHUNK_SIZE, "Territory summaries must line up with world chunks");
+
+    constexpr uint64_t LEGACY_TILE_RECORD_SIZE = 2 * sizeof(int) + sizeof(size_t) + sizeof(int32_t); ///< Smallest legacy tile: an empty alias.
+
+    // Bytes left in a stream from its read position, so sizes from a header can be checked before allocating.
+    uint64_t remainingBytes(std::istream& stream) {
+        const std::streampos position = stream.tellg();
+        stream.seekg(0, std::ios::end);
+        const std::streampos end = stream.tellg();
+        stream.seekg(position);
+        if (position < 0 || end < position) {
+            return 0;
+        }
+        return static_cast<uint64_t>(end - position);
+    }
+}
 
 // Constructor: Initializes tile map settings from global configurations.
-TileMap::TileMap() {
-    numRows = GlobalSettings::getInstance().getWindowHeight()/GlobalSettings::getInstance().getTileSize();
-    numCols = GlobalSettings::getInstance().getWindowWidth()/GlobalSettings::getInstance().getTileSize();
+TileMap::TileMap() : revision(nextRevision()) {
+    numRows = GlobalSettings::getInstance().getWorldRows();
+    numCols = GlobalSettings::getInstance().getWorldCols();
 
     TILE_SIZE = GlobalSettings::getInstance().getTileSize();
 }
 
-// Generates a grid of tiles with random textures.
-void TileMap::generateTiles(int numRows, int numCols, int tileSize, const std::vector<std::string>& textures, bool isInner) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> dist(0, textures.size() - 1);
+// Copy constructor: Copies the tiles into heap storage, even if the source is mapped.
+TileMap::TileMap(const TileMap& other)
+    : numRows(other.numRows), numCols(other.numCols), TILE_SIZE(other.TILE_SIZE), worldSeed(other.worldSeed) {
+    terrainStore.assign(other.terrainIds, other.terrainIds + other.tileCount);
+    ownerStore.assign(other.ownerIds, other.ownerIds + other.tileCount);
+    flagStore.assign(other.tileFlags, other.tileFlags + other.tileCount);
+    bindHeapPlanes();
+
+    // Changes the source has not saved are not saved in the copy either.
+    dirtyBegin = other.dirtyBegin;
+    dirtyEnd = other.dirtyEnd;
+    revision = other.revision; // Same tiles, so caches of the source are valid for the copy.
+    chunkRevisions = other.chunkRevisions;
+    territoryIndex = other.territoryIndex;
+}
 
-    tileMap.clear();
-    tileMap.reserve(numRows * numCols);
+// Copy assignment: See the copy constructor.
+TileMap& TileMap::operator=(const TileMap& other) {
+    if (this != &other) {
+        TileMap copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
 
-    int owner = 1776;
+// Move constructor: Takes over the source's storage or mapping.
+TileMap::TileMap(TileMap&& other) noexcept {
+    *this = std::move(other);
+}
 
-    for (int i = 0; i < numRows; i++) {
-        for (int j = 0; j < numCols; j++) {
-            if (!isInner) { owner = dist(gen); }
-            tileMap.emplace_back(std::make_shared<Tile>(j * tileSize, i * tileSize, textures[dist(gen)], owner));
-        }
+// Move assignment: Takes over the source's storage or mapping and leaves it empty.
+TileMap& TileMap::operator=(TileMap&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    terrainStore = std::move(other.terrainStore);
+    ownerStore = std::move(other.ownerStore);
+    flagStore = std::move(other.flagStore);
+    mappedFile = std::move(other.mappedFile);
+    terrainIds = other.terrainIds;
+    ownerIds = other.ownerIds;
+    tileFlags = other.tileFlags;
+    tileCount = other.tileCount;
+    mappedHeader = other.mappedHeader;
+    dirtyBegin = other.dirtyBegin;
+    dirtyEnd = other.dirtyEnd;
+    numRows = other.numRows;
+    numCols = other.numCols;
+    TILE_SIZE = other.TILE_SIZE;
+    worldSeed = other.worldSeed;
+    trackChanges = other.trackChanges;
+    changedTiles = std::move(other.changedTiles);
+    other.trackChanges = false;
+    other.changedTiles.clear();
+
+    other.terrainIds = nullptr;
+    other.ownerIds = nullptr;
+    other.tileFlags = nullptr;
+    other.tileCount = 0;
+    other.numRows = 0;
+    other.numCols = 0;
+
+    // The tiles keep their revisions; the emptied source gets a new one.
+    revision = other.revision;
+    chunkRevisions = std::move(other.chunkRevisions);
+    chunkCols = other.chunkCols;
+    territoryIndex = std::move(other.territoryIndex);
+    other.revision = nextRevision();
+    other.resetChunkRevisions();
+    return *this;
+}
+
+// Unpacking constructor: Expands each plane into heap storage and restores the revisions.
+TileMap::TileMap(const PackedTileMap& packed)
+    : TILE_SIZE(packed.tileSize), worldSeed(packed.worldSeed) {
+    resize(packed.numRows, packed.numCols);
+    const uint8_t* in = packed.bytes.data();
+    unpackPlane(in, terrainIds, tileCount, sizeof(TerrainId));
+    unpackPlane(in, ownerIds, tileCount, sizeof(int32_t));
+    unpackPlane(in, tileFlags, tileCount, sizeof(uint8_t));
+
+    // Same tiles as when packed, so caches of the packed map are still valid.
+    revision = packed.revision;
+    chunkRevisions.resize(static_cast<size_t>(readVarint(in)));
+    for (uint64_t& chunkRevision : chunkRevisions) {
+        chunkRevision = revision - readVarint(in);
     }
+    dirtyBegin = packed.dirtyBegin;
+    dirtyEnd = packed.dirtyEnd;
 }
 
-// Accessor: Returns the tile map.
-const std::vector<std::shared_ptr<Tile>>& TileMap::getTileMap() const { 
-    return tileMap; 
+// Packs each plane and keeps everything needed to restore the map exactly.
+PackedTileMap TileMap::pack() const {
+    PackedTileMap packed;
+    packed.numRows = numRows;
+    packed.numCols = numCols;
+    packed.tileSize = TILE_SIZE;
+    packed.worldSeed = worldSeed;
+    packed.revision = revision;
+    packed.dirtyBegin = dirtyBegin;
+    packed.dirtyEnd = dirtyEnd;
+
+    packPlane(terrainIds, tileCount, sizeof(TerrainId), packed.bytes);
+    packPlane(ownerIds, tileCount, sizeof(int32_t), packed.bytes);
+    packPlane(tileFlags, tileCount, sizeof(uint8_t), packed.bytes);
+    appendVarint(packed.bytes, chunkRevisions.size());
+    for (uint64_t chunkRevision : chunkRevisions) {
+        appendVarint(packed.bytes, revision - chunkRevision); // Chunks never run ahead of the map.
+    }
+    packed.bytes.shrink_to_fit();
+    return packed;
+}
+
+// Generates the tiles from a seed; large maps run one job per band of chunk rows.
+void TileMap::generateTiles(int numRows, int numCols, int tileSize, const std::vector<TerrainId>& terrains, uint64_t seed, bool isInner) {
+    TILE_SIZE = tileSize;
+    resize(numRows, numCols);
+    worldSeed = seed;
+
+    const WorldGenerator generator(seed, terrains, isInner);
+    const size_t bands = (static_cast<size_t>(numRows) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const size_t bandsPerJob = tileCount >= PARALLEL_GENERATION_TILES ? 1 : bands;
+    JobSystem::getInstance().parallelFor(0, bands, bandsPerJob, [&](size_t firstBand, size_t endBand) {
+        int firstRow = static_cast<int>(firstBand) * CHUNK_SIZE;
+        int endRow = std::min(numRows, static_cast<int>(endBand) * CHUNK_SIZE);
+        generator.generateRows(numCols, firstRow, endRow, terrainIds, ownerIds);
+    });
 }
 
+// Accessors for grid dimensions and tile arrays.
+int TileMap::getNumRows() const {
+    return numRows;
+}
+
+int TileMap::getNumCols() const {
+    return numCols;
+}
+
+int TileMap::getTileSize() const {
+    return TILE_SIZE;
+}
+
+size_t TileMap::getTileCount() const {
+    return tileCount;
+}
+
+const TerrainId* TileMap::getTerrainIds() const {
+    return terrainIds;
+}
+
+const int32_t* TileMap::getOwnerIds() const {
+    return ownerIds;
+}
+
+const uint8_t* TileMap::getTileFlags() const {
+    return tileFlags;
+}
+
+uint64_t TileMap::getWorldSeed() const {
+    return worldSeed;
+}
+
+uint64_t TileMap::getRevision() const {
+    return revision;
+}
+
+uint64_t TileMap::getChunkRevision(int chunkCol, int chunkRow) const {
+    if (chunkCol < 0 || chunkCol >= chunkCols || chunkRow < 0) return 0;
+
+    size_t index = static_cast<size_t>(chunkRow) * chunkCols + chunkCol;
+    return index < chunkRevisions.size() ? chunkRevisions[index] : 0;
+}
+
+// Counts every tile the first time; tile changes keep the counts current after that.
+const TerritoryIndex& TileMap::getTerritoryIndex() const {
+    if (!territoryIndex.isBuilt()) {
+        territoryIndex.build(terrainIds, ownerIds, numRows, numCols);
+    }
+    return territoryIndex;
+}
+
+std::vector<TerritoryIndex::TileCount> TileMap::countRegion(int firstCol, int firstRow, int endCol, int endRow) const {
+    return getTerritoryIndex().countRegion(terrainIds, ownerIds, firstCol, firstRow, endCol, endRow);
+}
+
+bool TileMap::hasUnsavedChanges() const {
+    return dirtyBegin < dirtyEnd;
+}
+
+// Counts the object, the heap planes and the chunk revisions; mapped pages belong to the OS.
+size_t TileMap::getMemoryUsage() const {
+    size_t usage = sizeof(*this) + terrainStore.capacity() * sizeof(TerrainId) + ownerStore.capacity() * sizeof(int32_t) +
+                   flagStore.capacity() + chunkRevisions.capacity() * sizeof(uint64_t) + territoryIndex.getMemoryUsage();
+    if (mappedFile) {
+        usage += sizeof(MappedFile) + mappedFile->getPath().capacity();
+    }
+    return usage;
+}
+
+bool TileMap::isMapped() const {
+    return mappedFile != nullptr;
+}
+
+// Resizes the tile arrays and resets every tile.
+void TileMap::resize(int rows, int cols) {
+    numRows = rows;
+    numCols = cols;
+
+    size_t count = static_cast<size_t>(rows) * cols;
+    terrainStore.assign(count, 0);
+    ownerStore.assign(count, 0);
+    flagStore.assign(count, TILE_FLAG_NONE);
+    bindHeapPlanes();
+}
+
+// Points the tile arrays at heap storage, releasing any file mapping.
+void TileMap::bindHeapPlanes() {
+    mappedFile.reset();
+    terrainIds = terrainStore.data();
+    ownerIds = ownerStore.data();
+    tileFlags = flagStore.data();
+    tileCount = terrainStore.size();
+    dirtyBegin = dirtyEnd = 0;
+    revision = nextRevision();
+    resetChunkRevisions();
+}
+
+// Gives every chunk the map's current revision, so a new layout invalidates every cached chunk.
+void TileMap::resetChunkRevisions() {
+    chunkCols = (numCols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int chunkRows = (numRows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkRevisions.assign(static_cast<size_t>(chunkCols) * chunkRows, revision);
+    territoryIndex.clear();
+}
+
+// Saves the map: header and terrain dictionary, then each tile plane as one bulk write.
 void TileMap::saveToFile(const std::string& filename, const std::string& mapPathPrefix) const {
     std::string fullPath = mapPathPrefix + filename;
-    std::ofstream file(fullPath, std::ios::binary | std::ios::trunc);  // Truncate ensures file is cleared
+
+    // A mapped map already lives in its file; rewriting it would truncate the pages we serve from.
+    if (mappedFile && mappedFile->getPath() == fullPath) {
+        flush();
+        return;
+    }
+
+    // Write a temporary file and rename it over the map, so a crash mid-save leaves the old map intact.
+    std::string tempPath = fullPath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
 
     if (!file) { 
-        std::cerr << "Error: Failed to open file for saving: " << fullPath << std::endl;
+        std::cerr << "Error: Failed to open file for saving: " << tempPath << std::endl;
         return; 
     }
 
-    // Write map dimensions.
-    file.write(reinterpret_cast<const char*>(&numRows), sizeof(numRows));
-    file.write(reinterpret_cast<const char*>(&numCols), sizeof(numCols));
+    bool written = writeMapFile(file);
+    file.close();
+    std::error_code error;
+    if (!written || file.fail()) {
+        std::cerr << "Error: Failed to write map file: " << fullPath << std::endl;
+        std::filesystem::remove(tempPath, error);
+        return;
+    }
+
+    std::filesystem::rename(tempPath, fullPath, error);
+    if (error) {
+        std::cerr << "Error: Failed to replace map file: " << fullPath << " (" << error.message() << ")" << std::endl;
+        std::filesystem::remove(tempPath, error);
+    } else if (!mappedFile) {
+        dirtyBegin = dirtyEnd = 0; // The file now holds every change.
+    }
+}
+
+// Saves the map into an archive entry; a map mapped from that entry only needs flushing.
+bool TileMap::saveToArchive(WorldArchive& archive, const WorldArchive::Key& key, bool mappable) const {
+    WorldArchive::EntryInfo info;
+    if (mappedFile && mappedFile->getPath() == archive.getPath() && archive.getEntryInfo(key, info) &&
+        info.payloadOffset() == mappedFile->getOffset()) {
+        return flush();
+    }
+
+    std::ostringstream stream;
+    if (!writeMapFile(stream)) {
+        return false;
+    }
 
-    // Store tiles.
-    for (const auto& tile : tileMap) {
-        // Store values in local variables before writing
-        int x = tile->getX();
-        int y = tile->getY();
-        int32_t ownerId = tile->getOwnerId();
+    std::string bytes = stream.str();
+    bool saved = archive.write(key, bytes.data(), bytes.size(),
+                               mappable ? WorldArchive::STORE_MAPPABLE : WorldArchive::STORE_COMPRESSED);
+    if (saved && !mappedFile) {
+        dirtyBegin = dirtyEnd = 0; // The archive now holds every change.
+    }
+    return saved;
+}
 
-        file.write(reinterpret_cast<const char*>(&x), sizeof(x));
-        file.write(reinterpret_cast<const char*>(&y), sizeof(y));
+// Reads an archive entry: uncompressed entries straight from the file, compressed ones after decoding.
+bool TileMap::loadFromArchive(WorldArchive& archive, const WorldArchive::Key& key) {
+    WorldArchive::EntryInfo info;
+    if (!archive.getEntryInfo(key, info)) {
+        return false;
+    }
 
-        // Store asset alias safely
-        std::string alias = tile->getAssetAlias();
-        size_t aliasLen = alias.size();
-        file.write(reinterpret_cast<const char*>(&aliasLen), sizeof(aliasLen));
-        file.write(alias.data(), aliasLen);  // Use `.data()` instead of `.c_str()` (more explicit)
+    bool loaded = false;
+    if (info.codec == ARCHIVE_CODEC_NONE) {
+        std::ifstream file(archive.getPath(), std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(info.payloadOffset()));
+        loaded = file && readMapFile(file);
+    } else {
+        std::vector<char> data;
+        if (archive.read(key, data)) {
+            std::istringstream stream(std::string(data.begin(), data.end()));
+            loaded = readMapFile(stream);
+        }
+    }
 
-        // Store owner ID
-        file.write(reinterpret_cast<const char*>(&ownerId), sizeof(ownerId));
+    if (!loaded) {
+        std::cerr << "Error: Invalid or corrupt map in archive entry " << key.x << "," << key.y << "," << key.depth << ".\n";
     }
+    return loaded;
 }
 
+// Reads a map file of either format, reporting failure instead of generating a replacement.
+bool TileMap::importFile(const std::string& fullPath) {
+    std::ifstream file(fullPath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.clear();
+    file.seekg(0);
+
+    return (magic == MAP_FILE_MAGIC) ? readMapFile(file) : readLegacyMapFile(file);
+}
 
+// Writes the header and terrain dictionary, then each tile plane as one bulk write.
+bool TileMap::writeMapFile(std::ostream& file) const {
+    uint32_t tileCrc = computeCrc32(terrainIds, tileCount);
+    tileCrc = computeCrc32(ownerIds, tileCount * sizeof(int32_t), tileCrc);
+    tileCrc = computeCrc32(tileFlags, tileCount, tileCrc);
+
+    std::vector<char> prefix = encodeMapPrefix(numRows, numCols, tileCrc, worldSeed);
+    MapFileHeader header;
+    std::memcpy(&header, prefix.data(), sizeof(header));
+
+    // Padding keeps the owner plane aligned so it can be read (or mapped) in place.
+    const char padding[MAP_PLANE_ALIGNMENT] = {};
+    size_t ownerPadding = header.ownerOffset - (header.terrainOffset + tileCount);
+
+    file.write(prefix.data(), prefix.size());
+    file.write(reinterpret_cast<const char*>(terrainIds), tileCount);
+    file.write(padding, ownerPadding);
+    file.write(reinterpret_cast<const char*>(ownerIds), tileCount * sizeof(int32_t));
+    file.write(reinterpret_cast<const char*>(tileFlags), tileCount);
+    return static_cast<bool>(file);
+}
 
+// Loads a map, detecting the binary format from the file's magic number.
 void TileMap::loadFromFile(const std::string& filename, const std::string& mapPathPrefix) {
     std::string fullPath = mapPathPrefix + filename;
     std::ifstream file(fullPath, std::ios::binary);
@@ -77,41 +411,123 @@ void TileMap::loadFromFile(const std::string& filename, const std::string& mapPa
         std::cerr << "Warning: Map file not found: " << fullPath << ". Generating a new map.\n";
 
         // Generate and save a new map.
-        generateTiles(numRows, numCols, TILE_SIZE, 
-            {"medgrass2", "medgrass1", "darkgrass", "deadgrass1", "deadgrass2", "deadgrass3"});
+        generateTiles(numRows, numCols, TILE_SIZE, TerrainRegistry::getInstance().getAllTerrains(), WorldGenerator::randomSeed());
         saveToFile(filename, mapPathPrefix);
 
         std::cerr << "New map saved to: " << fullPath << "\n";
         return;
     }
 
+    if (!importFile(fullPath)) {
+        // Keep the damaged file for inspection instead of overwriting it with the replacement.
+        std::string keptPath = fullPath + ".corrupt";
+        file.close();
+        std::error_code error;
+        std::filesystem::rename(fullPath, keptPath, error);
+        std::cerr << "Error: Invalid or corrupt map file" << (error ? "" : ", kept as " + keptPath) << ". Generating a new map.\n";
+        generateTiles(numRows, numCols, TILE_SIZE, TerrainRegistry::getInstance().getAllTerrains(), WorldGenerator::randomSeed());
+        saveToFile(filename, mapPathPrefix);
+        return;
+    }
+
+    std::cout << "Successfully loaded map from: " << fullPath << "\n";
+}
+
+// Reads a map in the current format, bulk-reading each plane straight into the tile arrays.
+bool TileMap::readMapFile(std::istream& file) {
+    const std::streamoff base = file.tellg(); // Plane offsets are relative to the start of the map.
+    const uint64_t available = remainingBytes(file);
+
+    // Fields shared by every version come first; they give the size of the rest of the prefix.
+    MapFileHeader header;
+    std::vector<char> prefix(MAP_HEADER_SIZE_V1);
+    file.read(prefix.data(), prefix.size());
+    std::memcpy(&header, prefix.data(), MAP_HEADER_SIZE_V1);
+
+    if (file.fail() || header.terrainOffset < MAP_HEADER_SIZE_V1 || header.terrainOffset > MAP_MAX_PREFIX_SIZE) {
+        std::cerr << "Error: Map header is truncated or invalid.\n";
+        return false;
+    }
+
+    // Read the rest of the header and the terrain dictionary, then validate the whole prefix.
+    prefix.resize(header.terrainOffset);
+    file.read(prefix.data() + MAP_HEADER_SIZE_V1, prefix.size() - MAP_HEADER_SIZE_V1);
+
+    TerrainRemap terrainRemap;
+    bool identityRemap = true;
+    if (file.fail() || !decodeMapPrefix(prefix.data(), prefix.size(), header, terrainRemap, identityRemap)) {
+        return false;
+    }
+
+    // A damaged or hostile header must not size the tile arrays beyond what the stream holds.
+    if (header.fileSize > available) {
+        std::cerr << "Error: Map is truncated; the header describes " << header.fileSize << " bytes but only "
+                  << available << " remain.\n";
+        return false;
+    }
+
+    resize(static_cast<int>(header.numRows), static_cast<int>(header.numCols));
+    worldSeed = header.worldSeed;
+
+    file.read(reinterpret_cast<char*>(terrainIds), tileCount);
+    file.seekg(base + static_cast<std::streamoff>(header.ownerOffset));
+    file.read(reinterpret_cast<char*>(ownerIds), tileCount * sizeof(int32_t));
+    file.read(reinterpret_cast<char*>(tileFlags), tileCount);
+
+    if (file.fail()) {
+        std::cerr << "Error: Failed to read tile data. File may be corrupted.\n";
+        return false;
+    }
+
+    uint32_t tileCrc = computeCrc32(terrainIds, tileCount);
+    tileCrc = computeCrc32(ownerIds, tileCount * sizeof(int32_t), tileCrc);
+    tileCrc = computeCrc32(tileFlags, tileCount, tileCrc);
+    if (header.flags & MAP_FILE_FLAG_TILE_CRC_STALE) {
+        std::cerr << "Warning: Map was modified in place; tile checksum not verified.\n";
+    } else if (tileCrc != header.tileCrc) {
+        std::cerr << "Error: Map tile checksum mismatch.\n";
+        return false;
+    }
+
+    // Maps written with a different terrain set store different IDs; translate them.
+    if (!identityRemap) {
+        for (size_t i = 0; i < tileCount; i++) {
+            terrainIds[i] = terrainRemap[terrainIds[i]];
+        }
+    }
+
+    return true;
+}
+
+// Reads a map in the original per-tile format (dimensions, then x, y, alias and owner per tile).
+bool TileMap::readLegacyMapFile(std::istream& file) {
     // Read map dimensions safely.
     int loadedRows = 0, loadedCols = 0;
     file.read((char*)&loadedRows, sizeof(loadedRows));
     file.read((char*)&loadedCols, sizeof(loadedCols));
 
     if (file.fail() || loadedRows <= 0 || loadedCols <= 0) {
-        std::cerr << "Error: Invalid or corrupt map file. Generating a new map.\n";
-        generateTiles(numRows, numCols, TILE_SIZE, 
-            {"medgrass2", "medgrass1", "darkgrass", "deadgrass1", "deadgrass2", "deadgrass3"});
-        saveToFile(filename, mapPathPrefix);
-        return;
+        return false;
+    }
+
+    // Every tile takes at least one record, so the dimensions cannot exceed what the stream holds.
+    if (static_cast<uint64_t>(loadedRows) * static_cast<uint64_t>(loadedCols) > remainingBytes(file) / LEGACY_TILE_RECORD_SIZE) {
+        std::cerr << "Error: Legacy map is truncated or its dimensions are corrupt.\n";
+        return false;
     }
 
-    // Update internal dimensions
-    numRows = loadedRows;
-    numCols = loadedCols;
+    // Update internal dimensions and allocate the tile arrays.
+    resize(loadedRows, loadedCols);
+    worldSeed = 0; // Legacy files predate seeds.
 
-    // Clear and allocate memory for tiles.
-    tileMap.clear();
-    tileMap.reserve(numRows * numCols);
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
 
     // Load tiles safely.
-    for (int i = 0; i < numRows * numCols; i++) {
+    for (size_t i = 0; i < tileCount; i++) {
         int x = 0, y = 0;
         int32_t ownerId = 0;
 
-        // Read tile position
+        // Read tile position (redundant; derived from the tile index)
         file.read((char*)&x, sizeof(x));
         file.read((char*)&y, sizeof(y));
 
@@ -122,7 +538,7 @@ void TileMap::loadFromFile(const std::string& filename, const std::string& mapPa
         // Validate alias length (prevent corrupted/bad files)
         if (aliasLen > 100) {  
             std::cerr << "Error: Corrupt file detected (alias length too large). Stopping load.\n";
-            return;
+            return false;
         }
 
         // Read alias as a string
@@ -136,25 +552,266 @@ void TileMap::loadFromFile(const std::string& filename, const std::string& mapPa
         // Ensure all reads were successful
         if (file.fail()) {
             std::cerr << "Error: Failed to read tile data. File may be corrupted.\n";
-            return;
+            return false;
         }
 
         // Store tile
-        tileMap.emplace_back(std::make_shared<Tile>(x, y, alias, ownerId));
+        terrainIds[i] = registry.getId(alias);
+        ownerIds[i] = ownerId;
     }
 
-    std::cout << "Successfully loaded map from: " << fullPath << "\n";
+    std::cout << "Loaded legacy map format; it will be saved in the current format.\n";
+    return true;
 }
 
 // Retrieves a tile at the given pixel coordinates.
-const std::shared_ptr<Tile> TileMap::getTileAt(int x, int y) const {
-    int tileX = x / TILE_SIZE;
-    int tileY = y / TILE_SIZE;
+std::optional<Tile> TileMap::getTileAt(int x, int y) const {
+    if (x < 0 || y < 0) {
+        return std::nullopt; // Out of bounds.
+    }
+
+    return getTile(x / TILE_SIZE, y / TILE_SIZE);
+}
+
+// Retrieves the tile under a screen position, as seen through the camera.
+std::optional<Tile> TileMap::getTileAt(int screenX, int screenY, const Camera& camera) const {
+    int col, row;
+    camera.screenToTile(screenX, screenY, TILE_SIZE, col, row);
+    return getTile(col, row);
+}
+
+// Retrieves a tile at the given grid coordinates.
+std::optional<Tile> TileMap::getTile(int col, int row) const {
+    if (col >= 0 && col < numCols && row >= 0 && row < numRows) {
+        size_t index = static_cast<size_t>(row) * numCols + col; // Convert 2D coordinates to 1D index.
+        return Tile(col, row, TILE_SIZE, terrainIds[index], ownerIds[index], tileFlags[index]);
+    }
+
+    return std::nullopt; // Out of bounds.
+}
+
+// Changes a tile's owner and marks it dirty.
+void TileMap::setOwnerId(int col, int row, int32_t ownerId) {
+    if (col < 0 || col >= numCols || row < 0 || row >= numRows) return;
+
+    size_t index = static_cast<size_t>(row) * numCols + col;
+    if (!markDirty(index)) return;
+    territoryIndex.moveTile(index, terrainIds[index], ownerIds[index], terrainIds[index], ownerId);
+    ownerIds[index] = ownerId;
+}
+
+// Changes a tile's terrain and marks it dirty.
+void TileMap::setTerrainId(int col, int row, TerrainId terrainId) {
+    if (col < 0 || col >= numCols || row < 0 || row >= numRows) return;
+
+    size_t index = static_cast<size_t>(row) * numCols + col;
+    if (!markDirty(index)) return;
+    territoryIndex.moveTile(index, terrainIds[index], ownerIds[index], terrainId, ownerIds[index]);
+    terrainIds[index] = terrainId;
+}
+
+// Flags a tile as changed and widens the range flush() writes back.
+bool TileMap::markDirty(size_t index) {
+    if (mappedFile) {
+        if (!mappedFile->isWritable()) {
+            std::cerr << "Warning: Map is mapped read-only; tile change ignored.\n";
+            return false;
+        }
+
+        // The stored tile checksum no longer matches once tiles change in place.
+        if (!(mappedHeader.flags & MAP_FILE_FLAG_TILE_CRC_STALE)) {
+            mappedHeader.flags |= MAP_FILE_FLAG_TILE_CRC_STALE;
+            std::memcpy(mappedFile->data(), &mappedHeader, sizeof(mappedHeader));
+            mappedHeader.headerCrc = computeMapHeaderCrc(mappedFile->data());
+            std::memcpy(mappedFile->data(), &mappedHeader, sizeof(mappedHeader));
+        }
+    }
+
+    if (dirtyBegin >= dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+    }
+
+    tileFlags[index] |= TILE_FLAG_DIRTY;
+    bumpRevision(index);
+    if (trackChanges) {
+        changedTiles.push_back(static_cast<uint32_t>(index));
+    }
+    return true;
+}
+
+// Replays a saved tile; unlike the setters this leaves the unsaved-change range alone.
+void TileMap::restoreTile(size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags) {
+    if (index >= tileCount || mappedFile) return;
 
-    if (tileX >= 0 && tileX < numCols && tileY >= 0 && tileY < numRows) {
-        int index = tileY * numCols + tileX; // Convert 2D coordinates to 1D index.
-        return tileMap[index];
+    territoryIndex.moveTile(index, terrainIds[index], ownerIds[index], terrainId, ownerId);
+    terrainIds[index] = terrainId;
+    ownerIds[index] = ownerId;
+    tileFlags[index] = flags;
+    bumpRevision(index);
+}
+
+// Applies a journaled tile state through markDirty(), so mapped maps are changed in place.
+void TileMap::replayTile(size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags) {
+    if (index >= tileCount || !markDirty(index)) return;
+
+    territoryIndex.moveTile(index, terrainIds[index], ownerIds[index], terrainId, ownerId);
+    terrainIds[index] = terrainId;
+    ownerIds[index] = ownerId;
+    tileFlags[index] = flags | TILE_FLAG_DIRTY;
+}
+
+void TileMap::setChangeTracking(bool enabled) {
+    trackChanges = enabled;
+    if (!enabled) {
+        changedTiles.clear();
+    }
+}
+
+// Hands over the recorded tiles; a tile changed several times is reported once.
+std::vector<uint32_t> TileMap::takeChangedTiles() {
+    std::vector<uint32_t> changed;
+    changed.swap(changedTiles);
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+// Forgets the unsaved range of a heap map whose snapshot is on its way to disk.
+void TileMap::markSaved() {
+    if (!mappedFile) {
+        dirtyBegin = dirtyEnd = 0;
+    }
+}
+
+// Records a change to one tile in the map and chunk revisions.
+void TileMap::bumpRevision(size_t index) {
+    revision = nextRevision();
+
+    int col = static_cast<int>(index % numCols);
+    int row = static_cast<int>(index / numCols);
+    chunkRevisions[static_cast<size_t>(row / CHUNK_SIZE) * chunkCols + col / CHUNK_SIZE] = revision;
+}
+
+// Maps a map file and points the tile arrays at its planes.
+bool TileMap::openMapped(const std::string& filename, const std::string& mapPathPrefix, bool writable) {
+    std::string fullPath = mapPathPrefix + filename;
+
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->open(fullPath, writable)) {
+        return false;
+    }
+    return bindMapping(std::move(file));
+}
+
+// Maps a mappable archive entry; its payload is a complete map file image.
+bool TileMap::openMapped(WorldArchive& archive, const WorldArchive::Key& key, bool writable) {
+    WorldArchive::EntryInfo info;
+    if (!archive.getEntryInfo(key, info) || info.type != ARCHIVE_RECORD_MAPPABLE) {
+        return false;
+    }
+
+    std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+    if (!file->open(archive.getPath(), writable, info.payloadOffset(), static_cast<size_t>(info.rawSize))) {
+        return false;
+    }
+    return bindMapping(std::move(file));
+}
+
+// Validates a mapped map image and points the tile arrays at its planes.
+bool TileMap::bindMapping(std::unique_ptr<MappedFile> file) {
+    const std::string& fullPath = file->getPath();
+
+    // Legacy files cannot be mapped; leave them to loadFromFile() without reporting an error.
+    uint32_t magic = 0;
+    if (file->size() >= sizeof(magic)) {
+        std::memcpy(&magic, file->data(), sizeof(magic));
+    }
+    if (magic != MAP_FILE_MAGIC) {
+        return false;
+    }
+
+    MapFileHeader header;
+    TerrainRemap terrainRemap;
+    bool identityRemap = true;
+    if (!decodeMapPrefix(file->data(), file->size(), header, terrainRemap, identityRemap)) {
+        return false;
+    }
+
+    // Older versions have a smaller header that cannot be rewritten in place; loadFromFile() reads them.
+    if (header.version != MAP_FORMAT_VERSION) {
+        return false;
+    }
+
+    if (header.fileSize != file->size()) {
+        std::cerr << "Error: Mapped map file is truncated: " << fullPath << std::endl;
+        return false;
+    }
+
+    // Tiles are served in place, so the stored IDs must already match the registry.
+    if (!identityRemap) {
+        std::cerr << "Warning: Map " << fullPath << " uses a different terrain set; it cannot be mapped in place.\n";
+        return false;
     }
 
-    return nullptr; // Out of bounds.
+    // Release the heap copy, then serve every plane straight from the mapping.
+    std::vector<TerrainId>().swap(terrainStore);
+    std::vector<int32_t>().swap(ownerStore);
+    std::vector<uint8_t>().swap(flagStore);
+
+    numRows = static_cast<int>(header.numRows);
+    numCols = static_cast<int>(header.numCols);
+    tileCount = static_cast<size_t>(header.numRows) * header.numCols;
+    terrainIds = reinterpret_cast<TerrainId*>(file->data() + header.terrainOffset);
+    ownerIds = reinterpret_cast<int32_t*>(file->data() + header.ownerOffset);
+    tileFlags = reinterpret_cast<uint8_t*>(file->data() + header.flagsOffset);
+    mappedHeader = header;
+    worldSeed = header.worldSeed;
+    revision = nextRevision();
+    resetChunkRevisions();
+    territoryIndex.clear();
+    mappedFile = std::move(file);
+    dirtyBegin = dirtyEnd = 0;
+    return true;
+}
+
+// Writes the header and the changed range of each plane back to the mapped file.
+bool TileMap::flush() const {
+    if (!mappedFile || dirtyBegin >= dirtyEnd) {
+        return true;
+    }
+
+    size_t count = dirtyEnd - dirtyBegin;
+    bool ok = mappedFile->flush(0, mappedHeader.terrainOffset);
+    ok = mappedFile->flush(mappedHeader.terrainOffset + dirtyBegin, count) && ok;
+    ok = mappedFile->flush(mappedHeader.ownerOffset + dirtyBegin * sizeof(int32_t), count * sizeof(int32_t)) && ok;
+    ok = mappedFile->flush(mappedHeader.flagsOffset + dirtyBegin, count) && ok;
+
+    if (ok) {
+        dirtyBegin = dirtyEnd = 0;
+    }
+    return ok;
+}
+
+// Pages in each plane's bytes for a run of tiles.
+void TileMap::prefetchTiles(size_t firstIndex, size_t count) const {
+    if (!mappedFile || firstIndex >= tileCount) return;
+
+    count = std::min(count, tileCount - firstIndex);
+    mappedFile->prefetch(mappedHeader.terrainOffset + firstIndex, count);
+    mappedFile->prefetch(mappedHeader.ownerOffset + firstIndex * sizeof(int32_t), count * sizeof(int32_t));
+    mappedFile->prefetch(mappedHeader.flagsOffset + firstIndex, count);
+}
+
+// Releases the pages of each plane that lie entirely within a run of tiles.
+void TileMap::releaseTiles(size_t firstIndex, size_t count) const {
+    if (!mappedFile || firstIndex >= tileCount) return;
+
+    count = std::min(count, tileCount - firstIndex);
+    mappedFile->release(mappedHeader.terrainOffset + firstIndex, count);
+    mappedFile->release(mappedHeader.ownerOffset + firstIndex * sizeof(int32_t), count * sizeof(int32_t));
+    mappedFile->release(mappedHeader.flagsOffset + firstIndex, count);
 }
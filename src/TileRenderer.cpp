@@ -1,4 +1,20 @@
 #include "TileRenderer.h"
+#include "Profiler.h"
+#include "TerritorySimulation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Territory colour on the minimap: green for the player, a colour hashed from the owner ID otherwise.
+    SDL_Color ownerColor(int32_t ownerId) {
+        if (GlobalSettings::getInstance().isPlayerId(ownerId)) {
+            return SDL_Color{40, 200, 40, 255};
+        }
+        uint32_t hash = static_cast<uint32_t>(ownerId) * 2654435761u;
+        return SDL_Color{static_cast<Uint8>(80 + (hash >> 24) % 176), static_cast<Uint8>(80 + (hash >> 16) % 176),
+                         static_cast<Uint8>(80 + (hash >> 8) % 176), 255};
+    }
+}
 
 // Constructor: Initializes the tile renderer and loads textures.
 TileRenderer::TileRenderer(SDL_Renderer* renderer, const std::unordered_map<std::string, std::string>& assetMap)
@@ -11,55 +27,492 @@ TileRenderer::~TileRenderer() {
     cleanupTextures();
 }
 
-// Renders tiles to the screen.
-void TileRenderer::renderTiles(const TileMap& tileMap, int tileSize) {
-    const auto& tiles = tileMap.getTileMap();
+// Renders the visible tiles: one copy of the cached layer, after bringing it up to date.
+void TileRenderer::renderTiles(const TileMap& tileMap, int tileSize, const Camera& camera,
+                               const VisibilityLayer* visibility, int32_t viewerId, const MapPyramid* pyramid) {
+    PROFILE_SCOPE("TileRenderer::renderTiles");
+    if (!atlas) return;
+
+    updateFog(tileMap, visibility, viewerId);
+
+    // Tiles only a few pixels wide come from the pyramid, so the cost follows the screen size, not the map's.
+    if (pyramid && pyramid->describes(tileMap)) {
+        int level = std::min(MapPyramid::chooseLevel(tileSize * camera.getZoom()), pyramid->getLevelCount());
+        if (level > 0) {
+            renderOverview(tileMap, *pyramid, level, tileSize, camera);
+            return;
+        }
+    }
+
+    bool viewChanged = updateView(tileMap, tileSize, camera);
+    if (visibleFirstCol >= visibleEndCol || visibleFirstRow >= visibleEndRow) return;
+
+    if (!ensureLayer(camera.getViewportWidth(), camera.getViewportHeight())) {
+        // No render-target support: draw the batch straight to the screen, rebuilding it only on change.
+        if (viewChanged || tileMap.getRevision() != batchRevision || getFogRevision() != batchFogRevision) {
+            vertices.clear();
+            buildBatch(tileMap, visibleFirstCol, visibleFirstRow, visibleEndCol, visibleEndRow);
+            batchRevision = tileMap.getRevision();
+            batchFogRevision = getFogRevision();
+        }
+        drawBatch();
+        return;
+    }
+
+    if (viewChanged || !layerValid) {
+        redrawLayer(tileMap);
+    } else if (tileMap.getRevision() != layerRevision || getFogRevision() != layerFogRevision) {
+        redrawChangedChunks(tileMap);
+    }
+
+    SDL_RenderCopy(renderer, layer, nullptr, nullptr);
+}
+
+// Drops the cached layer so the next frame redraws it.
+void TileRenderer::invalidateCache() {
+    layerValid = false;
+    batchRevision = 0;
+    overview.level = 0;
+    minimap.level = 0;
+}
+
+// Draws the finest level that has no more cells than the area has pixels.
+void TileRenderer::renderMinimap(const TileMap& tileMap, const MapPyramid& pyramid, const SDL_Rect& area) {
+    PROFILE_SCOPE("TileRenderer::renderMinimap");
+    if (!pyramid.describes(tileMap) || pyramid.getLevelCount() == 0 || area.w <= 0 || area.h <= 0) return;
+
+    int level = 1;
+    while (level < pyramid.getLevelCount() && (pyramid.getLevelCols(level) > area.w || pyramid.getLevelRows(level) > area.h)) {
+        level++;
+    }
+    int cols = pyramid.getLevelCols(level);
+    int rows = pyramid.getLevelRows(level);
+    if (!updateImage(minimap, tileMap, pyramid, level, 0, 0, cols, rows, true)) return;
+
+    SDL_Rect source = {0, 0, cols, rows};
+    SDL_RenderCopy(renderer, minimap.texture, &source, &area);
+}
+
+// Uses the fog only when it covers this map; switching viewer or layer changes every tile's look.
+void TileRenderer::updateFog(const TileMap& tileMap, const VisibilityLayer* visibility, int32_t viewerId) {
+    if (visibility && (visibility->getNumCols() != tileMap.getNumCols() || visibility->getNumRows() != tileMap.getNumRows() ||
+                       !visibility->getVisibleBits(viewerId))) {
+        visibility = nullptr;
+    }
+    if (visibility != fog || (visibility && viewerId != fogViewerId)) {
+        invalidateCache();
+    }
+
+    fog = visibility;
+    fogViewerId = viewerId;
+    visibleBits = fog ? fog->getVisibleBits(viewerId) : nullptr;
+    exploredBits = fog ? fog->getExploredBits(viewerId) : nullptr;
+}
+
+uint64_t TileRenderer::getFogRevision() const {
+    return fog ? fog->getRevision() : 0;
+}
+
+void TileRenderer::setBackgroundColor() {
+    Uint8 shade = fog ? 0 : 255;
+    SDL_SetRenderDrawColor(renderer, shade, shade, shade, 255);
+}
+
+// Projects each visible tile edge once; neighbouring tiles share edges, so there are no seams.
+bool TileRenderer::updateView(const TileMap& tileMap, int tileSize, const Camera& camera) {
+    ViewKey key{camera.getX(), camera.getY(), camera.getZoom(), tileSize, tileMap.getNumCols(), tileMap.getNumRows()};
+    if (key == viewKey) {
+        return false;
+    }
+    viewKey = key;
+
+    camera.getVisibleTiles(tileSize, key.numCols, key.numRows, visibleFirstCol, visibleFirstRow, visibleEndCol, visibleEndRow);
+    if (visibleFirstCol >= visibleEndCol || visibleFirstRow >= visibleEndRow) {
+        return true;
+    }
+
+    columnEdges.resize(visibleEndCol - visibleFirstCol + 1);
+    rowEdges.resize(visibleEndRow - visibleFirstRow + 1);
+    for (int col = visibleFirstCol; col <= visibleEndCol; col++) {
+        float screenX, screenY;
+        camera.worldToScreen(static_cast<float>(col) * tileSize, 0.0f, screenX, screenY);
+        columnEdges[col - visibleFirstCol] = static_cast<int>(std::lround(screenX));
+    }
+    for (int row = visibleFirstRow; row <= visibleEndRow; row++) {
+        float screenX, screenY;
+        camera.worldToScreen(0.0f, static_cast<float>(row) * tileSize, screenX, screenY);
+        rowEdges[row - visibleFirstRow] = static_cast<int>(std::lround(screenY));
+    }
+    return true;
+}
+
+// Creates the layer on first use and whenever the viewport size changes.
+bool TileRenderer::ensureLayer(int width, int height) {
+    if (layer && layerWidth == width && layerHeight == height) {
+        return true;
+    }
+
+    if (layer) SDL_DestroyTexture(layer);
+    layer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    layerValid = false;
+    if (!layer) {
+        layerWidth = layerHeight = 0;
+        return false;
+    }
+
+    layerWidth = width;
+    layerHeight = height;
+    return true;
+}
+
+// Clears the layer to the background colour, draws every visible tile and records each chunk's revision.
+void TileRenderer::redrawLayer(const TileMap& tileMap) {
+    PROFILE_SCOPE("TileRenderer::redrawLayer");
+    SDL_SetRenderTarget(renderer, layer);
+    setBackgroundColor();
+    SDL_RenderClear(renderer);
+
+    vertices.clear();
+    buildBatch(tileMap, visibleFirstCol, visibleFirstRow, visibleEndCol, visibleEndRow);
+    drawBatch();
+    SDL_SetRenderTarget(renderer, nullptr);
+
+    layerFirstCx = visibleFirstCol / TileMap::CHUNK_SIZE;
+    layerFirstCy = visibleFirstRow / TileMap::CHUNK_SIZE;
+    layerEndCx = (visibleEndCol - 1) / TileMap::CHUNK_SIZE + 1;
+    layerEndCy = (visibleEndRow - 1) / TileMap::CHUNK_SIZE + 1;
+    layerChunkRevisions.clear();
+    layerFogChunkRevisions.clear();
+    for (int cy = layerFirstCy; cy < layerEndCy; cy++) {
+        for (int cx = layerFirstCx; cx < layerEndCx; cx++) {
+            layerChunkRevisions.push_back(tileMap.getChunkRevision(cx, cy));
+            layerFogChunkRevisions.push_back(fog ? fog->getChunkRevision(cx, cy) : 0);
+        }
+    }
+
+    layerRevision = tileMap.getRevision();
+    layerFogRevision = getFogRevision();
+    layerValid = true;
+    batchRevision = 0; // The vertex batch now holds the layer's tiles.
+}
+
+// Redraws the visible part of each chunk whose tiles or fog changed since it was last drawn, in one batch.
+void TileRenderer::redrawChangedChunks(const TileMap& tileMap) {
+    PROFILE_SCOPE("TileRenderer::redrawChangedChunks");
+    vertices.clear();
+    dirtyRects.clear();
+
+    size_t index = 0;
+    for (int cy = layerFirstCy; cy < layerEndCy; cy++) {
+        for (int cx = layerFirstCx; cx < layerEndCx; cx++, index++) {
+            uint64_t revision = tileMap.getChunkRevision(cx, cy);
+            uint64_t fogRevision = fog ? fog->getChunkRevision(cx, cy) : 0;
+            if (revision == layerChunkRevisions[index] && fogRevision == layerFogChunkRevisions[index]) continue;
+            layerChunkRevisions[index] = revision;
+            layerFogChunkRevisions[index] = fogRevision;
+
+            int firstCol = std::max(visibleFirstCol, cx * TileMap::CHUNK_SIZE);
+            int firstRow = std::max(visibleFirstRow, cy * TileMap::CHUNK_SIZE);
+            int endCol = std::min(visibleEndCol, (cx + 1) * TileMap::CHUNK_SIZE);
+            int endRow = std::min(visibleEndRow, (cy + 1) * TileMap::CHUNK_SIZE);
+
+            int left = columnEdges[firstCol - visibleFirstCol];
+            int top = rowEdges[firstRow - visibleFirstRow];
+            dirtyRects.push_back(SDL_Rect{left, top, columnEdges[endCol - visibleFirstCol] - left,
+                                          rowEdges[endRow - visibleFirstRow] - top});
+            buildBatch(tileMap, firstCol, firstRow, endCol, endRow);
+        }
+    }
+
+    if (!dirtyRects.empty()) {
+        SDL_SetRenderTarget(renderer, layer);
+        setBackgroundColor();
+        SDL_RenderFillRects(renderer, dirtyRects.data(), static_cast<int>(dirtyRects.size()));
+        drawBatch();
+        SDL_SetRenderTarget(renderer, nullptr);
+    }
+
+    layerRevision = tileMap.getRevision();
+    layerFogRevision = getFogRevision();
+    batchRevision = 0;
+}
+
+// Appends one textured quad per tile in the range, using the precomputed edges; fog tints or skips tiles.
+void TileRenderer::buildBatch(const TileMap& tileMap, int firstCol, int firstRow, int endCol, int endRow) {
+    const TerrainId* terrain = tileMap.getTerrainIds();
+    const int numCols = tileMap.getNumCols();
+    const SDL_Color white = {255, 255, 255, 255};
+    const float uScale = 1.0f / atlasWidth;
+    const float vScale = 1.0f / atlasHeight;
+    const size_t wordsPerRow = fog ? fog->getWordsPerRow() : 0;
+
+    for (int row = firstRow; row < endRow; row++) {
+        size_t index = static_cast<size_t>(row) * numCols + firstCol;
+        const uint64_t* visibleRow = visibleBits ? visibleBits + static_cast<size_t>(row) * wordsPerRow : nullptr;
+        const uint64_t* exploredRow = exploredBits ? exploredBits + static_cast<size_t>(row) * wordsPerRow : nullptr;
+        float top = static_cast<float>(rowEdges[row - visibleFirstRow]);
+        float bottom = static_cast<float>(rowEdges[row - visibleFirstRow + 1]);
+
+        for (int col = firstCol; col < endCol; col++, index++) {
+            const SDL_Rect& source = atlasRects[terrain[index]];
+            if (source.w == 0) continue; // Skip if texture is missing.
+            SDL_Color color = white;
+            if (exploredRow) {
+                if (!((exploredRow[col / 64] >> (col % 64)) & 1)) continue; // Never seen: left as background.
+                if (!((visibleRow[col / 64] >> (col % 64)) & 1)) color = FOG_COLOR;
+            }
+
+            float left = static_cast<float>(columnEdges[col - visibleFirstCol]);
+            float right = static_cast<float>(columnEdges[col - visibleFirstCol + 1]);
+            float u0 = source.x * uScale, v0 = source.y * vScale;
+            float u1 = (source.x + source.w) * uScale, v1 = (source.y + source.h) * vScale;
+
+            // Clockwise from the top-left corner.
+            vertices.push_back(SDL_Vertex{{left, top}, color, {u0, v0}});
+            vertices.push_back(SDL_Vertex{{right, top}, color, {u1, v0}});
+            vertices.push_back(SDL_Vertex{{right, bottom}, color, {u1, v1}});
+            vertices.push_back(SDL_Vertex{{left, bottom}, color, {u0, v1}});
+        }
+    }
+
+    // Every quad uses the same two-triangle pattern, so indices only need extending.
+    size_t quadCount = vertices.size() / 4;
+    for (size_t quad = indices.size() / 6; quad < quadCount; quad++) {
+        int base = static_cast<int>(quad * 4);
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+}
 
-    for (const auto& tile : tiles) {
-        auto it = textureCache.find(tile->getAssetAlias());
-        if (it == textureCache.end() || !it->second) continue; // Skip if texture is missing.
+// Draws the batch from the atlas to the current render target.
+void TileRenderer::drawBatch() {
+    if (vertices.empty()) return;
 
-        SDL_Rect dstRect = { tile->getX(), tile->getY(), tileSize, tileSize };
-        SDL_RenderCopy(renderer, it->second, nullptr, &dstRect);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int quadCount = static_cast<int>(vertices.size() / 4);
+    SDL_RenderGeometry(renderer, atlas, vertices.data(), static_cast<int>(vertices.size()), indices.data(), quadCount * 6);
+#else
+    // Older SDL has no geometry API: draw each quad, still from the single atlas texture, tinted by colour mod.
+    for (size_t i = 0; i < vertices.size(); i += 4) {
+        const SDL_Vertex& topLeft = vertices[i];
+        const SDL_Vertex& bottomRight = vertices[i + 2];
+        SDL_Rect srcRect = {
+            static_cast<int>(topLeft.tex_coord.x * atlasWidth), static_cast<int>(topLeft.tex_coord.y * atlasHeight),
+            static_cast<int>((bottomRight.tex_coord.x - topLeft.tex_coord.x) * atlasWidth),
+            static_cast<int>((bottomRight.tex_coord.y - topLeft.tex_coord.y) * atlasHeight)
+        };
+        SDL_Rect dstRect = {
+            static_cast<int>(topLeft.position.x), static_cast<int>(topLeft.position.y),
+            static_cast<int>(bottomRight.position.x - topLeft.position.x),
+            static_cast<int>(bottomRight.position.y - topLeft.position.y)
+        };
+        SDL_SetTextureColorMod(atlas, topLeft.color.r, topLeft.color.g, topLeft.color.b);
+        SDL_RenderCopy(renderer, atlas, &srcRect, &dstRect);
     }
+    SDL_SetTextureColorMod(atlas, 255, 255, 255);
+#endif
+}
+
+// Scales the cells in view onto the screen in one copy. Whole cells may overhang the map's edge, so drawing is clipped to the map.
+void TileRenderer::renderOverview(const TileMap& tileMap, const MapPyramid& pyramid, int level, int tileSize, const Camera& camera) {
+    PROFILE_SCOPE("TileRenderer::renderOverview");
+    int firstCol, firstRow, endCol, endRow;
+    camera.getVisibleTiles(tileSize, tileMap.getNumCols(), tileMap.getNumRows(), firstCol, firstRow, endCol, endRow);
+    if (firstCol >= endCol || firstRow >= endRow) return;
+
+    const int cellFirstCol = firstCol >> level, cellFirstRow = firstRow >> level;
+    const int cellEndCol = ((endCol - 1) >> level) + 1, cellEndRow = ((endRow - 1) >> level) + 1;
+    if (!updateImage(overview, tileMap, pyramid, level, cellFirstCol, cellFirstRow, cellEndCol, cellEndRow, false)) return;
+
+    float left, top, right, bottom, mapLeft, mapTop, mapRight, mapBottom;
+    const float cellSize = static_cast<float>(tileSize) * static_cast<float>(1 << level);
+    camera.worldToScreen(cellFirstCol * cellSize, cellFirstRow * cellSize, left, top);
+    camera.worldToScreen(cellEndCol * cellSize, cellEndRow * cellSize, right, bottom);
+    camera.worldToScreen(0.0f, 0.0f, mapLeft, mapTop);
+    camera.worldToScreen(static_cast<float>(tileMap.getNumCols()) * tileSize, static_cast<float>(tileMap.getNumRows()) * tileSize,
+                         mapRight, mapBottom);
+
+    SDL_Rect source = {0, 0, cellEndCol - cellFirstCol, cellEndRow - cellFirstRow};
+    SDL_Rect destination = {static_cast<int>(std::lround(left)), static_cast<int>(std::lround(top)),
+                            static_cast<int>(std::lround(right) - std::lround(left)), static_cast<int>(std::lround(bottom) - std::lround(top))};
+    SDL_Rect clip = {static_cast<int>(std::lround(mapLeft)), static_cast<int>(std::lround(mapTop)),
+                     static_cast<int>(std::lround(mapRight) - std::lround(mapLeft)), static_cast<int>(std::lround(mapBottom) - std::lround(mapTop))};
+    SDL_RenderSetClipRect(renderer, &clip);
+    SDL_RenderCopy(renderer, overview.texture, &source, &destination);
+    SDL_RenderSetClipRect(renderer, nullptr);
 }
 
-// Loads textures from the asset map.
+// Writes one pixel per cell and uploads them, unless the same cells, pyramid and fog were drawn last time.
+bool TileRenderer::updateImage(PyramidImage& image, const TileMap& tileMap, const MapPyramid& pyramid, int level,
+                               int firstCol, int firstRow, int endCol, int endRow, bool tintOwners) {
+    const int width = endCol - firstCol;
+    const int height = endRow - firstRow;
+    if (width > image.textureWidth || height > image.textureHeight) {
+        if (image.texture) SDL_DestroyTexture(image.texture);
+        image.textureWidth = std::max(width, image.textureWidth);
+        image.textureHeight = std::max(height, image.textureHeight);
+        image.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                          image.textureWidth, image.textureHeight);
+        image.level = 0;
+        if (!image.texture) {
+            SDL_Log("Failed to create map overview texture: %s", SDL_GetError());
+            image.textureWidth = image.textureHeight = 0;
+        }
+    }
+    if (!image.texture) return false;
+
+    const uint64_t fogRevision = getFogRevision();
+    if (image.level == level && image.firstCol == firstCol && image.firstRow == firstRow && image.endCol == endCol &&
+        image.endRow == endRow && image.pyramidRevision == pyramid.getRevision() && image.fog == fog && image.fogRevision == fogRevision) {
+        return true;
+    }
+
+    const TerrainId* terrain = pyramid.getTerrainIds(level);
+    const int32_t* owners = pyramid.getOwnerIds(level);
+    const int levelCols = pyramid.getLevelCols(level);
+    const size_t wordsPerRow = fog ? fog->getWordsPerRow() : 0;
+    const int half = (1 << level) / 2;
+    image.pixels.resize(static_cast<size_t>(width) * height);
+    SDL_Color* pixel = image.pixels.data();
+
+    for (int row = firstRow; row < endRow; row++) {
+        // Fog is sampled at the tile in the middle of each cell.
+        const int tileRow = std::min(tileMap.getNumRows() - 1, (row << level) + half);
+        for (int col = firstCol; col < endCol; col++, pixel++) {
+            size_t cell = static_cast<size_t>(row) * levelCols + col;
+            SDL_Color color = terrainColors[terrain[cell]];
+            if (tintOwners && owners[cell] != TerritorySimulation::NEUTRAL_OWNER) {
+                SDL_Color tint = ownerColor(owners[cell]);
+                color = SDL_Color{static_cast<Uint8>((color.r + tint.r) / 2), static_cast<Uint8>((color.g + tint.g) / 2),
+                                  static_cast<Uint8>((color.b + tint.b) / 2), 255};
+            }
+            if (exploredBits) {
+                const int tileCol = std::min(tileMap.getNumCols() - 1, (col << level) + half);
+                const size_t word = static_cast<size_t>(tileRow) * wordsPerRow + tileCol / 64;
+                const uint64_t bit = 1ull << (tileCol % 64);
+                if (!(exploredBits[word] & bit)) {
+                    color = SDL_Color{0, 0, 0, 255};
+                } else if (!(visibleBits[word] & bit)) {
+                    color = SDL_Color{static_cast<Uint8>(color.r * FOG_COLOR.r / 255), static_cast<Uint8>(color.g * FOG_COLOR.g / 255),
+                                      static_cast<Uint8>(color.b * FOG_COLOR.b / 255), 255};
+                }
+            }
+            *pixel = color;
+        }
+    }
+
+    SDL_Rect area = {0, 0, width, height};
+    SDL_UpdateTexture(image.texture, &area, image.pixels.data(), width * static_cast<int>(sizeof(SDL_Color)));
+    image.level = level;
+    image.firstCol = firstCol;
+    image.firstRow = firstRow;
+    image.endCol = endCol;
+    image.endRow = endRow;
+    image.pyramidRevision = pyramid.getRevision();
+    image.fog = fog;
+    image.fogRevision = fogRevision;
+    return true;
+}
+
+// Loads textures from the asset map and packs them into one atlas, one square cell per terrain.
 void TileRenderer::loadTextures() {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    std::vector<std::pair<TerrainId, SDL_Surface*>> surfaces;
+    int cellSize = 0;
+
     for (const auto& pair : assetMap) {
+        TerrainId terrainId = registry.getId(pair.first);
+        if (terrainId == TerrainRegistry::INVALID_TERRAIN) {
+            SDL_Log("Warning: Texture alias '%s' is not a registered terrain!", pair.first.c_str());
+            continue;
+        }
+
         SDL_Surface* surface = IMG_Load(pair.second.c_str());
         if (!surface) {
             SDL_Log("Failed to load texture: %s", IMG_GetError());
             continue;
         }
 
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_FreeSurface(surface);
+        cellSize = std::max({cellSize, surface->w, surface->h});
+        surfaces.emplace_back(terrainId, surface);
+    }
 
-        if (!texture) {
-            SDL_Log("Failed to create texture for: %s", pair.second.c_str());
-            continue;
+    if (surfaces.empty()) {
+        return;
+    }
+
+    // Lay the cells out in a near-square grid.
+    int cellsPerRow = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(surfaces.size()))));
+    int cellRows = (static_cast<int>(surfaces.size()) + cellsPerRow - 1) / cellsPerRow;
+    atlasWidth = cellsPerRow * cellSize;
+    atlasHeight = cellRows * cellSize;
+
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurface) {
+        SDL_Log("Failed to create texture atlas: %s", SDL_GetError());
+    }
+
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        SDL_Surface* surface = surfaces[i].second;
+        SDL_Rect cell = {static_cast<int>(i % cellsPerRow) * cellSize, static_cast<int>(i / cellsPerRow) * cellSize,
+                         cellSize, cellSize};
+
+        // Copy pixels as-is (including alpha) and stretch smaller textures to fill their cell.
+        if (atlasSurface) {
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            if (SDL_BlitScaled(surface, nullptr, atlasSurface, &cell) == 0) {
+                atlasRects[surfaces[i].first] = cell;
+            }
         }
+        SDL_FreeSurface(surface);
+    }
 
-        textureCache[pair.first] = texture;
+    if (!atlasSurface) {
+        return;
     }
-}
 
-// Retrieves a texture from the cache.
-SDL_Texture* TileRenderer::getTexture(const std::string& alias) const {
-    auto it = textureCache.find(alias);
-    if (it != textureCache.end()) {
-        return it->second;
+    // Each terrain's average colour stands in for it where cells are only a pixel on screen.
+    if (SDL_LockSurface(atlasSurface) == 0) {
+        for (size_t terrainId = 0; terrainId < atlasRects.size(); terrainId++) {
+            const SDL_Rect& cell = atlasRects[terrainId];
+            if (cell.w == 0) continue;
+
+            uint64_t red = 0, green = 0, blue = 0;
+            for (int y = cell.y; y < cell.y + cell.h; y++) {
+                const Uint8* pixel = static_cast<const Uint8*>(atlasSurface->pixels) + y * atlasSurface->pitch + cell.x * 4;
+                for (int x = 0; x < cell.w; x++, pixel += 4) {
+                    red += pixel[0];
+                    green += pixel[1];
+                    blue += pixel[2];
+                }
+            }
+            uint64_t count = static_cast<uint64_t>(cell.w) * cell.h;
+            terrainColors[terrainId] = SDL_Color{static_cast<Uint8>(red / count), static_cast<Uint8>(green / count),
+                                                 static_cast<Uint8>(blue / count), 255};
+        }
+        SDL_UnlockSurface(atlasSurface);
+    }
+
+    atlas = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+    SDL_FreeSurface(atlasSurface);
+
+    if (!atlas) {
+        SDL_Log("Failed to create texture atlas: %s", SDL_GetError());
+        atlasRects.fill(SDL_Rect{0, 0, 0, 0});
     }
-    
-    SDL_Log("Warning: Texture alias '%s' not found!", alias.c_str());
-    return nullptr;
 }
 
-// Cleans up all loaded textures.
+// Cleans up the atlas, the layer and the pyramid images.
 void TileRenderer::cleanupTextures() {
-    for (auto& pair : textureCache) {
-        SDL_DestroyTexture(pair.second);
+    for (PyramidImage* image : {&overview, &minimap}) {
+        if (image->texture) SDL_DestroyTexture(image->texture);
+        image->texture = nullptr;
+        image->textureWidth = image->textureHeight = 0;
+        image->level = 0;
     }
-    textureCache.clear();
+    if (layer) SDL_DestroyTexture(layer);
+    layer = nullptr;
+    layerValid = false;
+    if (atlas) SDL_DestroyTexture(atlas);
+    atlas = nullptr;
+    atlasRects.fill(SDL_Rect{0, 0, 0, 0});
 }
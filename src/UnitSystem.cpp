@@ -0,0 +1,169 @@
+#include "UnitSystem.h"
+#include "GlobalSettings.h"
+#include "Profiler.h"
+#include "TerrainRegistry.h"
+#include "TerritorySimulation.h"
+#include "WorldGenerator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr uint64_t SPAWN_STREAM = 0x5350574E;  ///< Hash stream of the starting unit scatter.
+    constexpr uint64_t PATROL_STREAM = 0x50415452; ///< Hash stream of destination picks.
+
+    // -1, 0 or 1 by the sign of a distance.
+    int stepToward(int distance) {
+        return (distance > 0) - (distance < 0);
+    }
+}
+
+void UnitSystem::reset(const TileMap& world) {
+    const GlobalSettings& settings = GlobalSettings::getInstance();
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    for (size_t terrainId = 0; terrainId < moveCosts.size(); terrainId++) {
+        const std::string& alias = registry.getAlias(static_cast<TerrainId>(terrainId));
+        moveCosts[terrainId] = static_cast<uint8_t>(alias.empty() ? 0 : std::clamp(settings.getTerrainMoveCost(alias), 0, 255));
+    }
+
+    seed = world.getWorldSeed();
+    ticks = 0;
+}
+
+// Visits the tiles once in a scattered order, so each faction's units spread over its territory.
+size_t UnitSystem::spawnStartingUnits(EntityRegistry& entities, const TileMap& world, int perFaction) {
+    PROFILE_SCOPE("UnitSystem::spawnStartingUnits");
+    const uint64_t tileCount = world.getTileCount();
+    if (perFaction <= 0 || tileCount == 0) {
+        return 0;
+    }
+
+    std::unordered_map<int32_t, int> remaining;
+    for (const TerritoryIndex::OwnerCount& count : world.getTerritoryIndex().getOwnerCounts()) {
+        if (count.ownerId != TerritorySimulation::NEUTRAL_OWNER) {
+            remaining[count.ownerId] = perFaction;
+        }
+    }
+
+    // A stride coprime with the tile count reaches every tile exactly once.
+    uint64_t index = WorldGenerator::hashCoords(seed, 0, 0, SPAWN_STREAM) % tileCount;
+    uint64_t stride = WorldGenerator::hashCoords(seed, 1, 0, SPAWN_STREAM) % tileCount;
+    while (std::gcd(stride, tileCount) != 1) {
+        stride = (stride + 1) % tileCount;
+    }
+
+    const TerrainId* terrainIds = world.getTerrainIds();
+    const int32_t* ownerIds = world.getOwnerIds();
+    size_t factionsLeft = remaining.size();
+    std::vector<std::pair<uint64_t, UnitKind>> picks;
+    for (uint64_t visited = 0; visited < tileCount && factionsLeft > 0; visited++, index = (index + stride) % tileCount) {
+        auto faction = remaining.find(ownerIds[index]);
+        if (faction == remaining.end() || faction->second == 0 || moveCosts[terrainIds[index]] == 0) {
+            continue;
+        }
+
+        int placed = perFaction - faction->second;
+        picks.emplace_back(index, placed == 0 ? UNIT_FORT : (placed % 4 == 0 ? UNIT_SCOUT : UNIT_SOLDIER));
+        if (--faction->second == 0) {
+            factionsLeft--;
+        }
+    }
+
+    // Created in map order, so the packed components of neighbours sit together and updates walk the map in order.
+    std::sort(picks.begin(), picks.end());
+    const int numCols = world.getNumCols();
+    size_t spawned = 0;
+    for (const auto& [tile, kind] : picks) {
+        if (entities.spawnUnit(ownerIds[tile], kind, static_cast<int>(tile % numCols), static_cast<int>(tile / numCols)) == NO_ENTITY) {
+            break;
+        }
+        spawned++;
+    }
+    return spawned;
+}
+
+// Walks the packed movements in order; a step only rewrites the position and its spatial hash entry.
+void UnitSystem::tick(EntityRegistry& entities, const TileMap& world) {
+    PROFILE_SCOPE("UnitSystem::tick");
+    ++ticks;
+    ComponentStore<Movement>& movements = entities.getMovements();
+    const ComponentStore<Position>& positions = entities.getPositions();
+    const ComponentStore<Unit>& units = entities.getUnits();
+    const TerrainId* terrainIds = world.getTerrainIds();
+    Movement* movement = movements.data();
+    const EntityId* movers = movements.entities();
+
+    for (size_t i = 0; i < movements.size(); i++) {
+        Movement& next = movement[i];
+        if (next.cooldown > 0) {
+            next.cooldown--;
+            continue;
+        }
+
+        EntityId entity = movers[i];
+        const Position* position = positions.get(entity);
+        if (!position) {
+            continue;
+        }
+        const Position from = *position;
+        int colStep = stepToward(next.targetCol - from.col);
+        int rowStep = stepToward(next.targetRow - from.row);
+        if (colStep == 0 && rowStep == 0) {
+            pickDestination(entity, units.get(entity), from, world, next);
+            next.cooldown = STEP_TICKS;
+            continue;
+        }
+
+        // Along the longer axis first, then the other if that tile is impassable.
+        const bool colFirst = std::abs(next.targetCol - from.col) >= std::abs(next.targetRow - from.row);
+        const Position first = colFirst ? Position{from.col + colStep, from.row} : Position{from.col, from.row + rowStep};
+        const Position second = colFirst ? Position{from.col, from.row + rowStep} : Position{from.col + colStep, from.row};
+        int col, row;
+        if ((first.col != from.col || first.row != from.row) && isPassable(world, first.col, first.row)) {
+            col = first.col;
+            row = first.row;
+        } else if ((second.col != from.col || second.row != from.row) && isPassable(world, second.col, second.row)) {
+            col = second.col;
+            row = second.row;
+        } else {
+            pickDestination(entity, units.get(entity), from, world, next);
+            next.cooldown = STEP_TICKS;
+            continue;
+        }
+
+        entities.setPosition(entity, col, row);
+        uint8_t cost = moveCosts[terrainIds[static_cast<size_t>(row) * world.getNumCols() + col]];
+        next.cooldown = static_cast<uint16_t>(cost * STEP_TICKS - 1); // This update counts as the first.
+    }
+}
+
+// Soldiers keep to their faction's land; scouts range further over any passable tile.
+void UnitSystem::pickDestination(EntityId entity, const Unit* unit, const Position& from, const TileMap& world, Movement& movement) const {
+    movement.targetCol = from.col;
+    movement.targetRow = from.row;
+
+    bool scout = unit && unit->kind == UNIT_SCOUT;
+    const int radius = scout ? SCOUT_RADIUS : PATROL_RADIUS;
+    uint64_t roll = WorldGenerator::hashCoords(seed, entity, static_cast<int64_t>(ticks), PATROL_STREAM);
+    int col = from.col + static_cast<int>((roll & 0xFFFF) % (2 * radius + 1)) - radius;
+    int row = from.row + static_cast<int>(((roll >> 16) & 0xFFFF) % (2 * radius + 1)) - radius;
+    if (!isPassable(world, col, row)) {
+        return;
+    }
+    if (!scout && unit && world.getOwnerIds()[static_cast<size_t>(row) * world.getNumCols() + col] != unit->ownerId) {
+        return;
+    }
+
+    movement.targetCol = col;
+    movement.targetRow = row;
+}
+
+bool UnitSystem::isPassable(const TileMap& world, int col, int row) const {
+    if (col < 0 || col >= world.getNumCols() || row < 0 || row >= world.getNumRows()) {
+        return false;
+    }
+    return moveCosts[world.getTerrainIds()[static_cast<size_t>(row) * world.getNumCols() + col]] != 0;
+}
@@ -0,0 +1,266 @@
+#include "VisibilityLayer.h"
+#include "GlobalSettings.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace {
+    static_assert(TileMap::CHUNK_SIZE == 32, "Owned bits are rescanned a half word per chunk");
+
+    thread_local std::vector<uint64_t> rowBits;    ///< Vision of the row being computed, or each viewer's owned bits of a chunk row.
+    thread_local std::vector<uint64_t> spreadBits; ///< Previous step of the sideways spread.
+}
+
+void VisibilityLayer::setViewers(const std::vector<int32_t>& ownerIds) {
+    viewers.clear();
+    for (int32_t ownerId : ownerIds) {
+        Viewer viewer;
+        viewer.ownerId = ownerId;
+        viewers.push_back(std::move(viewer));
+    }
+    built = false;
+}
+
+// Rescans the chunks whose map revision changed, then recomputes vision for every band they can reach.
+void VisibilityLayer::update(const TileMap& world) {
+    PROFILE_SCOPE("VisibilityLayer::update");
+    bool sameMap = built && world.getNumRows() == numRows && world.getNumCols() == numCols && world.getWorldSeed() == worldSeed;
+    if (!sameMap) {
+        numRows = world.getNumRows();
+        numCols = world.getNumCols();
+        worldSeed = world.getWorldSeed();
+        wordsPerRow = (static_cast<size_t>(numCols) + 63) / 64;
+        chunkCols = (numCols + CHUNK - 1) / CHUNK;
+        chunkRows = (numRows + CHUNK - 1) / CHUNK;
+        radius = std::clamp(GlobalSettings::getInstance().getVisionRadius(), 0, MAX_RADIUS);
+
+        size_t words = wordsPerRow * static_cast<size_t>(numRows);
+        for (Viewer& viewer : viewers) {
+            viewer.owned.assign(words, 0);
+            viewer.visible.assign(words, 0);
+            viewer.explored.assign(words, 0);
+        }
+        size_t chunkCount = static_cast<size_t>(chunkCols) * chunkRows;
+        mapChunkRevisions.assign(chunkCount, 0);
+        chunkRevisions.assign(chunkCount, ++revision);
+    }
+    built = true;
+    if (viewers.empty()) {
+        return;
+    }
+
+    std::vector<uint8_t> changedChunks(static_cast<size_t>(chunkCols) * chunkRows, 0);
+    std::vector<int> ownedBands;
+    bandOwnedChanged.assign(chunkRows, 0);
+    for (int cy = 0; cy < chunkRows; cy++) {
+        for (int cx = 0; cx < chunkCols; cx++) {
+            size_t chunk = static_cast<size_t>(cy) * chunkCols + cx;
+            uint64_t mapRevision = world.getChunkRevision(cx, cy);
+            if (sameMap && mapRevision == mapChunkRevisions[chunk]) {
+                continue;
+            }
+            mapChunkRevisions[chunk] = mapRevision;
+            changedChunks[chunk] = 1;
+            bandOwnedChanged[cy] = 1;
+        }
+        if (bandOwnedChanged[cy]) {
+            ownedBands.push_back(cy);
+        }
+    }
+    if (ownedBands.empty()) {
+        return;
+    }
+
+    JobSystem& jobs = JobSystem::getInstance();
+    jobs.parallelFor(0, ownedBands.size(), 1, [&](size_t first, size_t end) {
+        for (size_t i = first; i < end; i++) {
+            scanOwned(world, ownedBands[i], &changedChunks[static_cast<size_t>(ownedBands[i]) * chunkCols]);
+        }
+    });
+
+    // A band sees the owned rows up to the radius away, so changes reach that many bands further.
+    const int reach = (radius + CHUNK - 1) / CHUNK;
+    std::vector<int> visionBands;
+    for (int cy = 0; cy < chunkRows; cy++) {
+        for (int other = std::max(0, cy - reach); other <= std::min(chunkRows - 1, cy + reach); other++) {
+            if (bandOwnedChanged[other]) {
+                visionBands.push_back(cy);
+                break;
+            }
+        }
+    }
+
+    chunkVisionChanged.assign(static_cast<size_t>(chunkCols) * chunkRows, 0);
+    jobs.parallelFor(0, visionBands.size(), 1, [&](size_t first, size_t end) {
+        for (size_t i = first; i < end; i++) {
+            updateVision(visionBands[i]);
+        }
+    });
+
+    if (std::find(chunkVisionChanged.begin(), chunkVisionChanged.end(), 1) != chunkVisionChanged.end()) {
+        ++revision;
+        for (size_t chunk = 0; chunk < chunkVisionChanged.size(); chunk++) {
+            if (chunkVisionChanged[chunk]) {
+                chunkRevisions[chunk] = revision;
+            }
+        }
+    }
+}
+
+bool VisibilityLayer::isVisible(int32_t ownerId, int col, int row) const {
+    const uint64_t* bits = getVisibleBits(ownerId);
+    if (!bits || col < 0 || col >= numCols || row < 0 || row >= numRows) {
+        return false;
+    }
+    return (bits[static_cast<size_t>(row) * wordsPerRow + col / 64] >> (col % 64)) & 1;
+}
+
+bool VisibilityLayer::isExplored(int32_t ownerId, int col, int row) const {
+    const uint64_t* bits = getExploredBits(ownerId);
+    if (!bits || col < 0 || col >= numCols || row < 0 || row >= numRows) {
+        return false;
+    }
+    return (bits[static_cast<size_t>(row) * wordsPerRow + col / 64] >> (col % 64)) & 1;
+}
+
+const uint64_t* VisibilityLayer::getVisibleBits(int32_t ownerId) const {
+    const Viewer* viewer = findViewer(ownerId);
+    return viewer && built ? viewer->visible.data() : nullptr;
+}
+
+const uint64_t* VisibilityLayer::getExploredBits(int32_t ownerId) const {
+    const Viewer* viewer = findViewer(ownerId);
+    return viewer && built ? viewer->explored.data() : nullptr;
+}
+
+size_t VisibilityLayer::getWordsPerRow() const {
+    return wordsPerRow;
+}
+
+int VisibilityLayer::getNumRows() const {
+    return numRows;
+}
+
+int VisibilityLayer::getNumCols() const {
+    return numCols;
+}
+
+uint64_t VisibilityLayer::getRevision() const {
+    return revision;
+}
+
+uint64_t VisibilityLayer::getChunkRevision(int chunkCol, int chunkRow) const {
+    if (chunkCol < 0 || chunkCol >= chunkCols || chunkRow < 0 || chunkRow >= chunkRows) {
+        return 0;
+    }
+    return chunkRevisions[static_cast<size_t>(chunkRow) * chunkCols + chunkCol];
+}
+
+// A chunk is half a word wide, so each chunk row of a viewer is rewritten as one 32-bit half.
+void VisibilityLayer::scanOwned(const TileMap& world, int band, const uint8_t* changedChunks) {
+    const int32_t* ownerIds = world.getOwnerIds();
+    const int firstRow = band * CHUNK;
+    const int endRow = std::min(numRows, firstRow + CHUNK);
+    constexpr size_t NO_VIEWER = SIZE_MAX;
+    auto viewerOf = [this](int32_t ownerId) {
+        for (size_t v = 0; v < viewers.size(); v++) {
+            if (viewers[v].ownerId == ownerId) return v;
+        }
+        return NO_VIEWER;
+    };
+    rowBits.resize(viewers.size());
+
+    for (int cx = 0; cx < chunkCols; cx++) {
+        if (!changedChunks[cx]) {
+            continue;
+        }
+        const int firstCol = cx * CHUNK;
+        const int width = std::min(numCols - firstCol, CHUNK);
+        const size_t word = static_cast<size_t>(firstCol) / 64;
+        const int shift = firstCol % 64;
+        const uint64_t keep = ~(0xFFFFFFFFull << shift);
+
+        // Territories come in runs, so the viewer is only looked up where the owner changes.
+        for (int row = firstRow; row < endRow; row++) {
+            const int32_t* owners = ownerIds + static_cast<size_t>(row) * numCols + firstCol;
+            std::fill(rowBits.begin(), rowBits.end(), 0);
+            int32_t runOwner = owners[0];
+            size_t runViewer = viewerOf(runOwner);
+
+            for (int i = 0; i < width; i++) {
+                if (owners[i] != runOwner) {
+                    runOwner = owners[i];
+                    runViewer = viewerOf(runOwner);
+                }
+                if (runViewer != NO_VIEWER) {
+                    rowBits[runViewer] |= 1ull << i;
+                }
+            }
+
+            for (size_t v = 0; v < viewers.size(); v++) {
+                uint64_t& target = viewers[v].owned[static_cast<size_t>(row) * wordsPerRow + word];
+                target = (target & keep) | (rowBits[v] << shift);
+            }
+        }
+    }
+}
+
+// Vision of a row is the OR of the owned rows within the radius, spread sideways by the radius.
+void VisibilityLayer::updateVision(int band) {
+    const int firstRow = band * CHUNK;
+    const int endRow = std::min(numRows, firstRow + CHUNK);
+    const uint64_t lastWordMask = numCols % 64 ? (1ull << (numCols % 64)) - 1 : ~0ull;
+    rowBits.resize(wordsPerRow);
+    spreadBits.resize(wordsPerRow);
+    uint8_t* changed = &chunkVisionChanged[static_cast<size_t>(band) * chunkCols];
+
+    for (Viewer& viewer : viewers) {
+        for (int row = firstRow; row < endRow; row++) {
+            const int nearRow = std::max(0, row - radius);
+            const int farRow = std::min(numRows - 1, row + radius);
+            std::copy_n(&viewer.owned[static_cast<size_t>(nearRow) * wordsPerRow], wordsPerRow, rowBits.begin());
+            for (int other = nearRow + 1; other <= farRow; other++) {
+                const uint64_t* owned = &viewer.owned[static_cast<size_t>(other) * wordsPerRow];
+                for (size_t w = 0; w < wordsPerRow; w++) {
+                    rowBits[w] |= owned[w];
+                }
+            }
+
+            // Steps of 1, 2, 4... tiles, the last one cut short, grow a run by exactly the radius.
+            for (int remaining = radius, step = 1; remaining > 0; step *= 2) {
+                const int shift = std::min(step, remaining);
+                remaining -= shift;
+                rowBits.swap(spreadBits);
+                for (size_t w = 0; w < wordsPerRow; w++) {
+                    uint64_t toRight = spreadBits[w] << shift;
+                    uint64_t toLeft = spreadBits[w] >> shift;
+                    if (w > 0) toRight |= spreadBits[w - 1] >> (64 - shift);
+                    if (w + 1 < wordsPerRow) toLeft |= spreadBits[w + 1] << (64 - shift);
+                    rowBits[w] = spreadBits[w] | toRight | toLeft;
+                }
+            }
+            rowBits[wordsPerRow - 1] &= lastWordMask;
+
+            uint64_t* visible = &viewer.visible[static_cast<size_t>(row) * wordsPerRow];
+            uint64_t* explored = &viewer.explored[static_cast<size_t>(row) * wordsPerRow];
+            for (size_t w = 0; w < wordsPerRow; w++) {
+                uint64_t diff = visible[w] ^ rowBits[w];
+                if (diff) {
+                    if (diff & 0xFFFFFFFFull) changed[w * 2] = 1;
+                    if ((diff >> 32) && static_cast<int>(w * 2 + 1) < chunkCols) changed[w * 2 + 1] = 1;
+                    visible[w] = rowBits[w];
+                    explored[w] |= rowBits[w];
+                }
+            }
+        }
+    }
+}
+
+const VisibilityLayer::Viewer* VisibilityLayer::findViewer(int32_t ownerId) const {
+    for (const Viewer& viewer : viewers) {
+        if (viewer.ownerId == ownerId) {
+            return &viewer;
+        }
+    }
+    return nullptr;
+}
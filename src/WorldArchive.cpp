@@ -0,0 +1,573 @@
+#include "WorldArchive.h"
+#include "Compression.h"
+#include "MapFormat.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    constexpr size_t COPY_CHUNK = 1 << 20; ///< Bytes copied at a time when compacting.
+
+    // Fills in a record header's magic and checksum.
+    void sealRecordHeader(ArchiveRecordHeader& header) {
+        header.magic = ARCHIVE_RECORD_MAGIC;
+        header.headerCrc = 0;
+        header.headerCrc = computeCrc32(&header, sizeof(header));
+    }
+
+    // Size of the PAD payload needed so the next record's payload is aligned, or 0 if none is needed.
+    // A PAD record needs room for its own header, so a short gap is widened by a whole alignment step.
+    uint64_t paddingFor(uint64_t offset, bool& needed) {
+        const uint64_t headerSize = sizeof(ArchiveRecordHeader);
+        uint64_t payload = (offset + headerSize + ARCHIVE_MAP_ALIGNMENT - 1) & ~(ARCHIVE_MAP_ALIGNMENT - 1);
+        needed = payload != offset + headerSize;
+        if (!needed) {
+            return 0;
+        }
+        if (payload - headerSize - offset < headerSize) {
+            payload += ARCHIVE_MAP_ALIGNMENT;
+        }
+        return payload - headerSize - offset - headerSize;
+    }
+}
+
+// Destructor: Leaves an index checkpoint so the next open is fast.
+WorldArchive::~WorldArchive() {
+    close();
+}
+
+// Opens or creates an archive, recovering records written after the last checkpoint.
+bool WorldArchive::open(const std::string& archivePath, bool truncate) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::error_code error;
+    if (truncate || !std::filesystem::exists(archivePath, error)) {
+        std::ofstream created(archivePath, std::ios::binary | std::ios::trunc);
+        if (!writeHeader(created, 0, sizeof(ArchiveHeader))) {
+            std::cerr << "Error: Failed to create world archive: " << archivePath << std::endl;
+            return false;
+        }
+        created.close();
+        endOffset = sizeof(ArchiveHeader);
+        file.open(archivePath, std::ios::binary | std::ios::in | std::ios::out);
+        path = archivePath;
+        return static_cast<bool>(file);
+    }
+
+    PROFILE_SCOPE("WorldArchive::open");
+    file.open(archivePath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file || !readIndex()) {
+        std::cerr << "Error: Failed to open world archive: " << archivePath << std::endl;
+        file.close();
+        index.clear();
+        return false;
+    }
+    path = archivePath;
+
+    uint64_t fileSize = std::filesystem::file_size(archivePath, error);
+    if (!error && endOffset < fileSize) {
+        std::cerr << "Warning: Discarding " << (fileSize - endOffset) << " unreadable bytes at the end of " << archivePath << "\n";
+        file.close();
+        std::filesystem::resize_file(archivePath, endOffset, error);
+        file.open(archivePath, std::ios::binary | std::ios::in | std::ios::out);
+    }
+
+    // Replaced entries and old checkpoints are dead weight; drop them once they dominate.
+    if (isSparse()) {
+        compactLocked();
+    }
+    return true;
+}
+
+// Checkpoints the index if anything changed since the last one, then closes the file.
+void WorldArchive::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        if (indexDirty) {
+            writeCheckpoint();
+        }
+        file.close();
+    }
+
+    path.clear();
+    index.clear();
+    endOffset = liveBytes = 0;
+    indexDirty = false;
+}
+
+// Checkpoints the index without closing, so a save point costs one index record.
+bool WorldArchive::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.is_open()) {
+        return false;
+    }
+    return !indexDirty || writeCheckpoint();
+}
+
+bool WorldArchive::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.is_open();
+}
+
+const std::string& WorldArchive::getPath() const {
+    return path;
+}
+
+bool WorldArchive::contains(const Key& key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.count(key) != 0;
+}
+
+bool WorldArchive::getEntryInfo(const Key& key, EntryInfo& info) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
+
+// Reads a payload, checks it, and decompresses it if needed.
+bool WorldArchive::read(const Key& key, std::vector<char>& data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return false;
+    }
+
+    PROFILE_SCOPE("WorldArchive::read");
+    const EntryInfo& info = it->second;
+    std::vector<char> stored(info.storedSize);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(info.payloadOffset()));
+    file.read(stored.data(), stored.size());
+    if (!file) {
+        std::cerr << "Error: Failed to read archive entry " << key.x << "," << key.y << "," << key.depth << ".\n";
+        file.clear();
+        return false;
+    }
+
+    // Mappable payloads may have been changed in place; their own format carries checksums.
+    if (info.type != ARCHIVE_RECORD_MAPPABLE && computeCrc32(stored.data(), stored.size()) != info.payloadCrc) {
+        std::cerr << "Error: Archive entry " << key.x << "," << key.y << "," << key.depth << " checksum mismatch.\n";
+        return false;
+    }
+
+    if (info.codec == ARCHIVE_CODEC_NONE) {
+        data = std::move(stored);
+        return true;
+    }
+    if (info.codec == ARCHIVE_CODEC_LZ) {
+        data.resize(info.rawSize);
+        if (decompressBlock(stored.data(), stored.size(), data.data(), data.size())) {
+            return true;
+        }
+    }
+
+    std::cerr << "Error: Archive entry " << key.x << "," << key.y << "," << key.depth << " could not be decoded.\n";
+    return false;
+}
+
+// Appends a record for the payload, compressed or aligned as asked.
+bool WorldArchive::write(const Key& key, const char* data, size_t size, StoreMode mode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.is_open()) {
+        std::cerr << "Error: No world archive is open.\n";
+        return false;
+    }
+
+    PROFILE_SCOPE("WorldArchive::write");
+    ArchiveRecordHeader header{};
+    header.type = mode == STORE_MAPPABLE ? ARCHIVE_RECORD_MAPPABLE : ARCHIVE_RECORD_ENTRY;
+    header.x = key.x;
+    header.y = key.y;
+    header.depth = key.depth;
+    header.codec = ARCHIVE_CODEC_NONE;
+    header.storedSize = size;
+    header.rawSize = size;
+
+    const char* payload = data;
+    std::vector<char> compressed;
+    if (mode == STORE_COMPRESSED) {
+        compressed = compressBlock(data, size);
+        if (compressed.size() < size) {
+            payload = compressed.data();
+            header.codec = ARCHIVE_CODEC_LZ;
+            header.storedSize = compressed.size();
+        }
+    }
+
+    if (mode == STORE_MAPPABLE) {
+        bool needed = false;
+        uint64_t padding = paddingFor(endOffset, needed);
+        if (needed) {
+            ArchiveRecordHeader pad{};
+            pad.type = ARCHIVE_RECORD_PAD;
+            pad.storedSize = padding;
+            std::vector<char> zeros(padding, 0);
+            if (!appendRecord(pad, zeros.data())) {
+                return false;
+            }
+        }
+    }
+
+    header.payloadCrc = computeCrc32(payload, header.storedSize);
+    return appendRecord(header, payload);
+}
+
+// Appends a REMOVE record if the key exists.
+bool WorldArchive::remove(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!index.count(key)) {
+        return true;
+    }
+
+    ArchiveRecordHeader header{};
+    header.type = ARCHIVE_RECORD_REMOVE;
+    header.x = key.x;
+    header.y = key.y;
+    header.depth = key.depth;
+    return appendRecord(header, nullptr);
+}
+
+bool WorldArchive::compact() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return compactLocked();
+}
+
+bool WorldArchive::compactIfSparse() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return isSparse() && compactLocked();
+}
+
+size_t WorldArchive::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+uint64_t WorldArchive::getLiveBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return liveBytes;
+}
+
+uint64_t WorldArchive::getFileSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return endOffset;
+}
+
+// Strips ".dat" from the map file name and appends the archive extension.
+std::string WorldArchive::getArchiveFilename(const std::string& mapFile) {
+    std::string mapName = mapFile;
+    size_t pos = mapName.rfind(".dat");
+    if (pos != std::string::npos) {
+        mapName = mapName.substr(0, pos);
+    }
+
+    return mapName + ".wgar";
+}
+
+// Loads the last checkpoint if it is intact, then replays every record after it.
+bool WorldArchive::readIndex() {
+    ArchiveHeader header{};
+    file.clear();
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != ARCHIVE_MAGIC) {
+        std::cerr << "Error: Not a world archive.\n";
+        return false;
+    }
+
+    uint32_t storedCrc = header.headerCrc;
+    header.headerCrc = 0;
+    if (header.version != ARCHIVE_VERSION || header.headerSize != sizeof(header) ||
+        computeCrc32(&header, sizeof(header)) != storedCrc) {
+        std::cerr << "Error: Unsupported world archive version or corrupt header.\n";
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+
+    uint64_t offset = sizeof(ArchiveHeader);
+    ArchiveRecordHeader record;
+    if (header.indexOffset != 0) {
+        bool loaded = false;
+        if (readRecordHeader(file, header.indexOffset, fileSize, record) && record.type == ARCHIVE_RECORD_INDEX &&
+            record.storedSize % sizeof(ArchiveIndexEntry) == 0 && record.storedSize / sizeof(ArchiveIndexEntry) <= MAX_INDEX_ENTRIES) {
+            std::vector<ArchiveIndexEntry> entries(record.storedSize / sizeof(ArchiveIndexEntry));
+            file.read(reinterpret_cast<char*>(entries.data()), record.storedSize);
+            if (file && computeCrc32(entries.data(), record.storedSize) == record.payloadCrc) {
+                for (const ArchiveIndexEntry& entry : entries) {
+                    EntryInfo info{entry.type, entry.offset, entry.storedSize, entry.rawSize, entry.codec, entry.payloadCrc};
+                    index[Key{entry.x, entry.y, entry.depth}] = info;
+                    liveBytes += entrySize(info);
+                }
+                offset = header.scanOffset;
+                loaded = true;
+            }
+        }
+        if (!loaded) {
+            std::cerr << "Warning: World archive index is unreadable; rebuilding it from the records.\n";
+            index.clear();
+            liveBytes = 0;
+        }
+    }
+
+    // Records written after the checkpoint (or all of them, without one).
+    const uint64_t scanStart = offset;
+    while (readRecordHeader(file, offset, fileSize, record)) {
+        indexRecord(record, offset);
+        offset += sizeof(ArchiveRecordHeader) + record.storedSize;
+    }
+
+    endOffset = offset;
+    indexDirty = offset != scanStart;
+    file.clear();
+    return true;
+}
+
+// Writes a sealed header at the start of the stream.
+bool WorldArchive::writeHeader(std::ostream& out, uint64_t indexOffset, uint64_t scanOffset) {
+    ArchiveHeader header{};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.headerSize = sizeof(ArchiveHeader);
+    header.indexOffset = indexOffset;
+    header.scanOffset = scanOffset;
+    header.headerCrc = computeCrc32(&header, sizeof(header));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+// Reads a record header and checks that it is sealed and its payload fits in the file.
+bool WorldArchive::readRecordHeader(std::istream& in, uint64_t offset, uint64_t limit, ArchiveRecordHeader& header) {
+    if (offset + sizeof(header) > limit) {
+        return false;
+    }
+
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != ARCHIVE_RECORD_MAGIC) {
+        return false;
+    }
+
+    uint32_t storedCrc = header.headerCrc;
+    header.headerCrc = 0;
+    bool valid = computeCrc32(&header, sizeof(header)) == storedCrc;
+    header.headerCrc = storedCrc;
+    return valid && header.storedSize <= limit - offset - sizeof(header);
+}
+
+// Writes a record at the end; a failed write leaves endOffset alone so the next one overwrites it.
+bool WorldArchive::appendRecord(ArchiveRecordHeader header, const char* payload) {
+    sealRecordHeader(header);
+
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(endOffset));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (payload) {
+        file.write(payload, static_cast<std::streamsize>(header.storedSize));
+    }
+    file.flush();
+    if (!file) {
+        std::cerr << "Error: Failed to write world archive: " << path << std::endl;
+        file.clear();
+        return false;
+    }
+
+    indexRecord(header, endOffset);
+    endOffset += sizeof(ArchiveRecordHeader) + header.storedSize;
+    indexDirty = true;
+    return true;
+}
+
+// Appends the full index and points the header at it.
+bool WorldArchive::writeCheckpoint() {
+    std::vector<ArchiveIndexEntry> entries;
+    entries.reserve(index.size());
+    for (const auto& entry : index) {
+        const EntryInfo& info = entry.second;
+        entries.push_back(ArchiveIndexEntry{entry.first.x, entry.first.y, entry.first.depth, info.type,
+                                            info.offset, info.storedSize, info.rawSize, info.codec, info.payloadCrc});
+    }
+
+    ArchiveRecordHeader header{};
+    header.type = ARCHIVE_RECORD_INDEX;
+    header.storedSize = header.rawSize = entries.size() * sizeof(ArchiveIndexEntry);
+    header.payloadCrc = computeCrc32(entries.data(), header.storedSize);
+
+    uint64_t indexOffset = endOffset;
+    if (!appendRecord(header, reinterpret_cast<const char*>(entries.data()))) {
+        return false;
+    }
+
+    file.clear();
+    if (!writeHeader(file, indexOffset, endOffset)) {
+        std::cerr << "Error: Failed to update world archive header: " << path << std::endl;
+        file.clear();
+        return false;
+    }
+    indexDirty = false;
+    return true;
+}
+
+// Applies a record to the index; padding and checkpoints are not entries.
+void WorldArchive::indexRecord(const ArchiveRecordHeader& header, uint64_t offset) {
+    if (header.type != ARCHIVE_RECORD_ENTRY && header.type != ARCHIVE_RECORD_MAPPABLE &&
+        header.type != ARCHIVE_RECORD_REMOVE) {
+        return;
+    }
+
+    Key key{header.x, header.y, header.depth};
+    auto it = index.find(key);
+    if (it != index.end()) {
+        liveBytes -= entrySize(it->second);
+        index.erase(it);
+    }
+
+    if (header.type != ARCHIVE_RECORD_REMOVE) {
+        EntryInfo info{header.type, offset, header.storedSize, header.rawSize, header.codec, header.payloadCrc};
+        index.emplace(key, info);
+        liveBytes += entrySize(info);
+    }
+}
+
+// Copies live entries in file order into a new archive, checkpoints it, and renames it into place.
+bool WorldArchive::compactLocked() {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    PROFILE_SCOPE("WorldArchive::compact");
+    std::vector<std::pair<Key, EntryInfo>> entries(index.begin(), index.end());
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.second.offset < b.second.offset; });
+
+    std::string tempPath = path + ".tmp";
+    std::error_code error;
+    std::fstream out(tempPath, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!writeHeader(out, 0, sizeof(ArchiveHeader))) {
+        std::cerr << "Error: Failed to create compacted world archive: " << tempPath << std::endl;
+        out.close();
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    uint64_t offset = sizeof(ArchiveHeader);
+
+    std::vector<char> buffer;
+    for (auto& entry : entries) {
+        EntryInfo& info = entry.second;
+        ArchiveRecordHeader header{};
+        header.type = info.type;
+        header.x = entry.first.x;
+        header.y = entry.first.y;
+        header.depth = entry.first.depth;
+        header.codec = info.codec;
+        header.storedSize = info.storedSize;
+        header.rawSize = info.rawSize;
+        header.payloadCrc = info.payloadCrc;
+
+        if (info.type == ARCHIVE_RECORD_MAPPABLE) {
+            bool needed = false;
+            uint64_t padding = paddingFor(offset, needed);
+            if (needed) {
+                ArchiveRecordHeader pad{};
+                pad.type = ARCHIVE_RECORD_PAD;
+                pad.storedSize = padding;
+                sealRecordHeader(pad);
+                out.write(reinterpret_cast<const char*>(&pad), sizeof(pad));
+                buffer.assign(padding, 0);
+                out.write(buffer.data(), buffer.size());
+                offset += sizeof(pad) + padding;
+            }
+        }
+
+        sealRecordHeader(header);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Stream the payload across without decoding it.
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(info.payloadOffset()));
+        for (uint64_t copied = 0; copied < info.storedSize; copied += buffer.size()) {
+            buffer.resize(static_cast<size_t>(std::min<uint64_t>(COPY_CHUNK, info.storedSize - copied)));
+            file.read(buffer.data(), buffer.size());
+            out.write(buffer.data(), buffer.size());
+        }
+        if (!file) {
+            std::cerr << "Error: Failed to read world archive while compacting: " << path << std::endl;
+            file.clear();
+            out.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        info.offset = offset;
+        offset += sizeof(header) + info.storedSize;
+    }
+
+    // Swap the new file in and give it a checkpoint of its own.
+    std::fstream old = std::move(file);
+    file = std::move(out);
+    uint64_t oldEnd = endOffset;
+    uint64_t oldLiveBytes = liveBytes;
+    std::unordered_map<Key, EntryInfo, KeyHash> oldIndex = std::move(index);
+    index.clear();
+    liveBytes = 0;
+    for (const auto& entry : entries) {
+        index.emplace(entry.first, entry.second);
+        liveBytes += entrySize(entry.second);
+    }
+    endOffset = offset;
+
+    if (!file || !writeCheckpoint()) {
+        std::cerr << "Error: Failed to write compacted world archive: " << tempPath << std::endl;
+        file.close();
+        file = std::move(old);
+        index = std::move(oldIndex);
+        endOffset = oldEnd;
+        liveBytes = oldLiveBytes;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    file.close();
+    old.close();
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "Error: Failed to replace world archive " << path << ": " << error.message() << std::endl;
+    }
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (error) {
+        // The old file is still in place; reread it.
+        std::filesystem::remove(tempPath, error);
+        index.clear();
+        liveBytes = 0;
+        readIndex();
+        return false;
+    }
+    return true;
+}
+
+bool WorldArchive::isSparse() const {
+    return endOffset > MIN_COMPACT_SIZE && liveBytes * 2 < endOffset;
+}
+
+uint64_t WorldArchive::entrySize(const EntryInfo& info) {
+    return sizeof(ArchiveRecordHeader) + info.storedSize;
+}
+
+// Mixes the three key parts.
+size_t WorldArchive::KeyHash::operator()(const Key& key) const {
+    uint64_t h = static_cast<uint32_t>(key.x);
+    h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.y);
+    h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.depth);
+    return static_cast<size_t>(h ^ (h >> 29));
+}
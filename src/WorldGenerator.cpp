@@ -0,0 +1,211 @@
+#include "WorldGenerator.h"
+#include "TerrainRegistry.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+    // Hash streams, so the fields drawn from one seed are independent.
+    constexpr uint64_t BIOME_STREAM = 1;
+    constexpr uint64_t VARIANT_STREAM = 2;
+    constexpr uint64_t TERRITORY_STREAM = 3;
+    constexpr uint64_t OWNER_STREAM = 4;
+    constexpr uint64_t INNER_SEED_STREAM = 5;
+
+    // Key of one hash stream of a seed; hashing it with coordinates gives hashCoords().
+    inline uint64_t streamKey(uint64_t seed, uint64_t stream) {
+        return WorldGenerator::hash(seed ^ (stream * 0xD6E8FEB86659FD93ull));
+    }
+
+    // Hashes coordinates under a stream key.
+    inline uint64_t hashCell(uint64_t key, int64_t x, int64_t y) {
+        return WorldGenerator::hash(WorldGenerator::hash(key ^ static_cast<uint64_t>(x)) ^ static_cast<uint64_t>(y));
+    }
+
+    // Smoothstep on a 16-bit fraction: 3t^2 - 2t^3, keeping noise continuous across cells.
+    inline int64_t fade(int64_t t) {
+        return (t * t * (3 * 65536 - 2 * t)) >> 32;
+    }
+
+    // Linear interpolation by a 16-bit fraction.
+    inline int64_t lerp(int64_t a, int64_t b, int64_t t) {
+        return a + (((b - a) * t) >> 16);
+    }
+
+    // Maps noise in [0, 65535] to an index in [0, count), stretched around the middle
+    // because summed octaves rarely reach the extremes.
+    inline size_t pickIndex(uint32_t noise, size_t count) {
+        int64_t stretched = std::clamp<int64_t>(32768 + (static_cast<int64_t>(noise) - 32768) * 2, 0, 65535);
+        return static_cast<size_t>(stretched) * count >> 16;
+    }
+}
+
+// Constructor: Groups the terrains into families and picks feature sizes for the map kind.
+WorldGenerator::WorldGenerator(uint64_t seed, const std::vector<TerrainId>& terrains, bool isInner)
+    : seed(seed), isInner(isInner),
+      biomeShift(isInner ? 3 : 5), variantShift(isInner ? 2 : 3), territoryShift(3),
+      ownerCount(std::max<int32_t>(1, static_cast<int32_t>(terrains.size()))) {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+
+    for (TerrainId terrainId : terrains) {
+        const std::vector<TerrainId>& family = registry.getMatchingTerrain(terrainId);
+        auto it = std::find_if(families.begin(), families.end(), [&family](const std::vector<TerrainId>& group) {
+            return std::find(family.begin(), family.end(), group.front()) != family.end();
+        });
+        if (it == families.end()) {
+            families.push_back({terrainId});
+        } else {
+            it->push_back(terrainId);
+        }
+    }
+}
+
+// Generates a band row by row; every tile still depends only on its own coordinates.
+void WorldGenerator::generateRows(int numCols, int firstRow, int endRow, TerrainId* terrainIds, int32_t* ownerIds) const {
+    std::vector<uint32_t> biomeNoise;
+    std::vector<uint32_t> variantNoise;
+    std::vector<TerritoryCentre> centres;
+
+    for (int row = firstRow; row < endRow; row++) {
+        size_t rowStart = static_cast<size_t>(row) * numCols;
+
+        if (families.empty()) {
+            std::fill(terrainIds + rowStart, terrainIds + rowStart + numCols, TerrainId(0));
+        } else {
+            biomeNoise.assign(numCols, 0);
+            if (families.size() > 1) {
+                fractalNoiseRow(row, numCols, biomeShift, BIOME_STREAM, biomeNoise);
+            }
+            fractalNoiseRow(row, numCols, variantShift, VARIANT_STREAM, variantNoise);
+
+            for (int col = 0; col < numCols; col++) {
+                const std::vector<TerrainId>& family = families[pickIndex(biomeNoise[col], families.size())];
+                terrainIds[rowStart + col] = family[pickIndex(variantNoise[col], family.size())];
+            }
+        }
+
+        if (isInner) {
+            std::fill(ownerIds + rowStart, ownerIds + rowStart + numCols, INNER_OWNER);
+            continue;
+        }
+
+        // Nearest of the nine surrounding territory centres (Worley noise).
+        size_t perRow = territoryCentresRow(row, numCols, centres);
+        for (int col = 0; col < numCols; col++) {
+            size_t cell = static_cast<size_t>(col >> territoryShift) + 1;
+            int64_t bestDistance = INT64_MAX;
+            int32_t owner = 0;
+            for (size_t cellRow = 0; cellRow < 3; cellRow++) {
+                for (size_t index = cellRow * perRow + cell - 1; index <= cellRow * perRow + cell + 1; index++) {
+                    int64_t dx = centres[index].x - col;
+                    int64_t dy = centres[index].y - row;
+                    int64_t distance = dx * dx + dy * dy;
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        owner = centres[index].owner;
+                    }
+                }
+            }
+            ownerIds[rowStart + col] = owner;
+        }
+    }
+}
+
+// SplitMix64's output function.
+uint64_t WorldGenerator::hash(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// Chains the inputs through the hash so nearby coordinates give unrelated results.
+uint64_t WorldGenerator::hashCoords(uint64_t seed, int64_t x, int64_t y, uint64_t stream) {
+    return hashCell(streamKey(seed, stream), x, y);
+}
+
+// Inner maps are a pure function of the world seed and the tile they belong to.
+uint64_t WorldGenerator::deriveInnerSeed(uint64_t worldSeed, int col, int row) {
+    return hashCoords(worldSeed, col, row, INNER_SEED_STREAM);
+}
+
+// Seeds new worlds from the system's entropy source.
+uint64_t WorldGenerator::randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+// Sums octaves from the largest cell size down, each with half the weight of the last.
+// Cells are at least two tiles wide; single-tile cells would just be per-tile noise.
+void WorldGenerator::fractalNoiseRow(int row, int numCols, int cellShift, uint64_t stream, std::vector<uint32_t>& noise) const {
+    noise.assign(numCols, 0);
+    uint32_t weightSum = 0;
+    for (int octave = 0; octave < OCTAVES && cellShift - octave >= 1; octave++) {
+        uint32_t weight = 1u << (OCTAVES - octave);
+        addOctaveRow(row, cellShift - octave, (stream << 8) + octave, weight, noise);
+        weightSum += weight;
+    }
+
+    for (uint32_t& value : noise) {
+        value /= weightSum;
+    }
+}
+
+// Bilinear, smoothstep-weighted interpolation of hashed values at the corners of each cell.
+void WorldGenerator::addOctaveRow(int row, int cellShift, uint64_t stream, uint32_t weight, std::vector<uint32_t>& noise) const {
+    const uint64_t key = streamKey(seed, stream);
+    auto corner = [key](int64_t cx, int64_t cy) {
+        return static_cast<int64_t>(hashCell(key, cx, cy) >> 48);
+    };
+
+    // Samples are taken at tile centres, in 16-bit fixed point within the cell.
+    int64_t fy = ((2 * static_cast<int64_t>(row) + 1) << 15) >> cellShift;
+    int64_t cellY = fy >> 16;
+    int64_t ty = fade(fy & 0xFFFF);
+
+    int64_t currentCell = -1;
+    int64_t topLeft = 0, topRight = 0, bottomLeft = 0, bottomRight = 0;
+    for (size_t col = 0; col < noise.size(); col++) {
+        int64_t fx = ((2 * static_cast<int64_t>(col) + 1) << 15) >> cellShift;
+        int64_t cellX = fx >> 16;
+        if (cellX == currentCell + 1 && col > 0) {
+            // Moving one cell right: the right corners become the left ones.
+            currentCell = cellX;
+            topLeft = topRight;
+            bottomLeft = bottomRight;
+            topRight = corner(cellX + 1, cellY);
+            bottomRight = corner(cellX + 1, cellY + 1);
+        } else if (cellX != currentCell) {
+            currentCell = cellX;
+            topLeft = corner(cellX, cellY);
+            topRight = corner(cellX + 1, cellY);
+            bottomLeft = corner(cellX, cellY + 1);
+            bottomRight = corner(cellX + 1, cellY + 1);
+        }
+
+        int64_t tx = fade(fx & 0xFFFF);
+        int64_t value = lerp(lerp(topLeft, topRight, tx), lerp(bottomLeft, bottomRight, tx), ty);
+        noise[col] += static_cast<uint32_t>(value) * weight;
+    }
+}
+
+// Each territory cell has one centre jittered within it, owned by a hash of the cell.
+size_t WorldGenerator::territoryCentresRow(int row, int numCols, std::vector<TerritoryCentre>& centres) const {
+    const int64_t cellSize = int64_t(1) << territoryShift;
+    const int64_t cellY = static_cast<int64_t>(row) >> territoryShift;
+    const size_t perRow = static_cast<size_t>((numCols - 1) >> territoryShift) + 3;
+
+    const uint64_t territoryKey = streamKey(seed, TERRITORY_STREAM);
+    const uint64_t ownerKey = streamKey(seed, OWNER_STREAM);
+
+    centres.clear();
+    for (int64_t cy = cellY - 1; cy <= cellY + 1; cy++) {
+        for (size_t i = 0; i < perRow; i++) {
+            int64_t cx = static_cast<int64_t>(i) - 1;
+            uint64_t h = hashCell(territoryKey, cx, cy);
+            int32_t owner = static_cast<int32_t>(hashCell(ownerKey, cx, cy) % static_cast<uint64_t>(ownerCount));
+            centres.push_back(TerritoryCentre{cx * cellSize + static_cast<int64_t>(h & (cellSize - 1)),
+                                              cy * cellSize + static_cast<int64_t>((h >> 32) & (cellSize - 1)), owner});
+        }
+    }
+    return perRow;
+}
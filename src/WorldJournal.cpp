@@ -0,0 +1,295 @@
+#include "WorldJournal.h"
+#include "MapFormat.h"
+#include "TerrainRegistry.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Checksums a record's fields, excluding the checksum itself.
+    uint32_t recordCrc(const JournalRecord& record) {
+        return computeCrc32(&record, offsetof(JournalRecord, crc));
+    }
+
+    // Forces a file or directory's written data to the disk. Streams do not expose their
+    // descriptor, so the path is opened again; syncing any descriptor syncs the file.
+    bool syncPath(const std::string& syncedPath) {
+#if defined(_WIN32)
+        return true;
+#else
+        int fd = ::open(syncedPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+#endif
+    }
+}
+
+// Destructor: Keeps any queued records.
+WorldJournal::~WorldJournal() {
+    close();
+}
+
+// Opens a journal, keeping the intact records of this world and cutting off a torn tail.
+bool WorldJournal::open(const std::string& journalPath, uint64_t seed, bool truncate) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    path = journalPath;
+    worldSeed = seed;
+    recovered.clear();
+
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    if (truncate || fileSize == 0) {
+        return createFile();
+    }
+
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file || !readRecords(fileSize)) {
+        std::cerr << "Warning: Discarding journal that is unreadable or belongs to another world: " << path << "\n";
+        file.close();
+        recovered.clear();
+        return createFile();
+    }
+
+    uint64_t intactSize = headerEnd + fileRecords * sizeof(JournalRecord);
+    if (intactSize < fileSize) {
+        std::cerr << "Warning: Discarding " << (fileSize - intactSize) << " unreadable bytes at the end of " << path << "\n";
+        file.close();
+        std::filesystem::resize_file(path, intactSize, error);
+        file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    }
+    return static_cast<bool>(file);
+}
+
+// Writes what is queued, then lets go of the file.
+void WorldJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        commitLocked();
+        file.close();
+    }
+
+    pending.clear();
+    firstRecord = fileRecords = headerEnd = 0;
+}
+
+bool WorldJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.is_open();
+}
+
+const std::vector<JournalRecord>& WorldJournal::getRecovered() const {
+    return recovered;
+}
+
+void WorldJournal::clearRecovered() {
+    std::vector<JournalRecord>().swap(recovered);
+}
+
+// Queues a record; appends from a tick are written together by commit().
+void WorldJournal::append(const WorldArchive::Key& key, size_t index, TerrainId terrainId, int32_t ownerId, uint8_t flags) {
+    JournalRecord record{key.x, key.y, key.depth, static_cast<uint32_t>(index), ownerId, terrainId, flags, 0, 0};
+    record.crc = recordCrc(record);
+
+    // Without a file nothing would ever write the record; holding it would only grow the queue.
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.is_open()) {
+        pending.push_back(record);
+    }
+}
+
+bool WorldJournal::commit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return commitLocked();
+}
+
+uint64_t WorldJournal::mark() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.is_open() ? firstRecord + fileRecords + pending.size() : NO_JOURNAL;
+}
+
+// Copies the records after the position into a fresh journal, syncs it, then swaps it in.
+bool WorldJournal::trim(uint64_t position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.is_open() || position == NO_JOURNAL || position <= firstRecord) {
+        return true;
+    }
+    if (!commitLocked()) {
+        return false;
+    }
+
+    uint64_t dropped = std::min(position - firstRecord, fileRecords);
+    std::vector<char> kept(static_cast<size_t>((fileRecords - dropped) * sizeof(JournalRecord)));
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(headerEnd + dropped * sizeof(JournalRecord)));
+    file.read(kept.data(), static_cast<std::streamsize>(kept.size()));
+
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    uint64_t newHeaderEnd = writeHeader(out);
+    out.write(kept.data(), static_cast<std::streamsize>(kept.size()));
+    out.close();
+
+    std::error_code error;
+    if (!file || newHeaderEnd == 0 || out.fail() || !syncPath(tempPath)) {
+        std::cerr << "Error: Failed to write journal: " << tempPath << std::endl;
+        std::filesystem::remove(tempPath, error);
+        file.clear();
+        return false;
+    }
+
+    file.close();
+    std::filesystem::rename(tempPath, path, error);
+    bool replaced = !error;
+    if (replaced) {
+        // The trimmed file is in place whether or not it can be reopened below.
+        headerEnd = newHeaderEnd;
+        firstRecord += dropped;
+        fileRecords -= dropped;
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        syncPath(directory.empty() ? "." : directory);
+    } else {
+        std::cerr << "Error: Failed to replace journal " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(tempPath, error);
+    }
+
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+        std::cerr << "Error: Failed to reopen journal; changes are no longer journaled: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    return replaced;
+}
+
+uint64_t WorldJournal::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return headerEnd + (fileRecords + pending.size()) * sizeof(JournalRecord);
+}
+
+// Strips ".dat" from the map file name and appends the journal extension.
+std::string WorldJournal::getJournalFilename(const std::string& mapFile) {
+    std::string mapName = mapFile;
+    size_t pos = mapName.rfind(".dat");
+    if (pos != std::string::npos) {
+        mapName = mapName.substr(0, pos);
+    }
+
+    return mapName + ".wgj";
+}
+
+// Writes the header and dictionary, checksummed together.
+uint64_t WorldJournal::writeHeader(std::ostream& out) const {
+    std::vector<char> prefix(sizeof(JournalHeader));
+    JournalHeader header{JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(JournalHeader), worldSeed, appendTerrainDictionary(prefix), 0};
+    std::memcpy(prefix.data(), &header, sizeof(header));
+    header.headerCrc = computeCrc32(prefix.data(), prefix.size());
+    std::memcpy(prefix.data(), &header, sizeof(header));
+
+    out.write(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+    return out ? prefix.size() : 0;
+}
+
+// Validates the header, then keeps records until the first one that is torn or corrupt.
+bool WorldJournal::readRecords(uint64_t fileSize) {
+    std::vector<char> data(static_cast<size_t>(fileSize));
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file || data.size() < sizeof(JournalHeader)) {
+        return false;
+    }
+
+    JournalHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION || header.headerSize != sizeof(JournalHeader) ||
+        header.worldSeed != worldSeed || header.dictionaryCount > 256) {
+        return false;
+    }
+
+    TerrainRemap terrainRemap;
+    bool identityRemap = true;
+    size_t offset = sizeof(header);
+    if (!decodeTerrainDictionary(data.data(), data.size(), header.dictionaryCount, offset, terrainRemap, identityRemap)) {
+        return false;
+    }
+
+    uint32_t storedCrc = header.headerCrc;
+    header.headerCrc = 0;
+    std::memcpy(data.data(), &header, sizeof(header));
+    if (computeCrc32(data.data(), offset) != storedCrc) {
+        return false;
+    }
+    headerEnd = offset;
+
+    size_t dropped = 0;
+    for (; offset + sizeof(JournalRecord) <= data.size(); offset += sizeof(JournalRecord)) {
+        JournalRecord record;
+        std::memcpy(&record, data.data() + offset, sizeof(record));
+        if (record.crc != recordCrc(record)) {
+            break;
+        }
+
+        fileRecords++;
+        record.terrainId = terrainRemap[record.terrainId];
+        if (record.terrainId == TerrainRegistry::INVALID_TERRAIN) {
+            dropped++;
+            continue;
+        }
+        recovered.push_back(record);
+    }
+
+    if (dropped > 0) {
+        std::cerr << "Warning: Skipped " << dropped << " journaled tiles whose terrain no longer exists.\n";
+    }
+    return true;
+}
+
+// Truncates the file to a header for the current world and terrain set.
+bool WorldJournal::createFile() {
+    file.close();
+    {
+        std::ofstream created(path, std::ios::binary | std::ios::trunc);
+        headerEnd = writeHeader(created);
+    }
+    file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (headerEnd == 0 || !file) {
+        std::cerr << "Error: Failed to create journal: " << path << std::endl;
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+// Appends the queued records in one write and pushes them to the OS.
+bool WorldJournal::commitLocked() {
+    if (pending.empty()) {
+        return true;
+    }
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(headerEnd + fileRecords * sizeof(JournalRecord)));
+    file.write(reinterpret_cast<const char*>(pending.data()), static_cast<std::streamsize>(pending.size() * sizeof(JournalRecord)));
+    file.flush();
+    if (!file) {
+        std::cerr << "Error: Failed to write journal: " << path << std::endl;
+        file.clear();
+        return false;
+    }
+
+    fileRecords += pending.size();
+    pending.clear();
+    return true;
+}
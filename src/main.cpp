@@ -1,9 +1,38 @@
 #include "Game.h"
+#include "GameOptions.h"
+#include "ArchiveConverter.h"
 
 int main(int argc, char* argv[]) {
+    GameOptions options;
+    if (!GameOptions::parse(argc, argv, options)) {
+        GameOptions::printUsage(argv[0]);
+        return 1;
+    }
+    if (options.showHelp) {
+        GameOptions::printUsage(argv[0]);
+        return 0;
+    }
+
+    if (options.convert) {
+        const std::string& mapPathPrefix = GlobalSettings::getInstance().getMapPathPrefix();
+        if (!ArchiveConverter::hasLegacyWorld(options.mapFile, mapPathPrefix)) {
+            std::cerr << "Error: No map file to convert: " << mapPathPrefix << options.mapFile << "\n";
+            return 1;
+        }
+
+        std::error_code error; // A journal of the replaced archive must not be replayed onto the converted world.
+        std::filesystem::remove(mapPathPrefix + WorldJournal::getJournalFilename(options.mapFile), error);
+
+        WorldArchive archive; // Replaces any archive of the world; the map files are the saved state.
+        if (!archive.open(mapPathPrefix + WorldArchive::getArchiveFilename(options.mapFile), true)) {
+            return 1;
+        }
+        return ArchiveConverter::convert(options.mapFile, mapPathPrefix, archive) ? 0 : 1;
+    }
+
     Game game;
 
-    if (!game.init()) {
+    if (!game.init(options)) {
         return 1; // Exit if initialization fails
     }
 
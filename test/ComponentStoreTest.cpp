@@ -0,0 +1,93 @@
+#include "ComponentStore.h"
+#include "EntityRegistry.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+    // Builds the handle of a slot at a generation, as EntityRegistry does.
+    EntityId makeEntity(uint32_t index, uint32_t generation) {
+        return (generation << ENTITY_INDEX_BITS) | index;
+    }
+
+    // Checks a store against the components it should hold, and that its packed arrays agree.
+    void expectStore(const ComponentStore<int>& store, const std::map<EntityId, int>& expected, const std::vector<EntityId>& everyEntity) {
+        ASSERT_EQ(store.size(), expected.size());
+        for (EntityId entity : everyEntity) {
+            auto component = expected.find(entity);
+            if (component == expected.end()) {
+                EXPECT_FALSE(store.contains(entity)) << "entity " << entity;
+                EXPECT_EQ(store.get(entity), nullptr) << "entity " << entity;
+            } else {
+                ASSERT_TRUE(store.contains(entity)) << "entity " << entity;
+                EXPECT_EQ(*store.get(entity), component->second) << "entity " << entity;
+            }
+        }
+        for (size_t i = 0; i < store.size(); i++) {
+            EXPECT_EQ(store.data()[i], expected.at(store.entities()[i]));
+        }
+    }
+}
+
+// Inserts, replacements and removals in mixed order keep every lookup and the packed arrays right.
+TEST(ComponentStoreTest, MixedInsertsAndRemoves) {
+    std::vector<EntityId> everyEntity;
+    for (uint32_t index = 0; index < 200; index++) {
+        everyEntity.push_back(makeEntity(index, index % 3));
+    }
+
+    ComponentStore<int> store;
+    std::map<EntityId, int> expected;
+    std::mt19937 rng(17);
+    for (int step = 0; step < 5000; step++) {
+        EntityId entity = everyEntity[rng() % everyEntity.size()];
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(store.remove(entity), expected.erase(entity) == 1);
+        } else {
+            int value = static_cast<int>(rng());
+            EXPECT_EQ(store.insert(entity, value), value);
+            expected[entity] = value;
+        }
+        if (step % 500 == 0) {
+            expectStore(store, expected, everyEntity);
+        }
+    }
+    expectStore(store, expected, everyEntity);
+
+    // Remove everything, the last packed component first and then from the front.
+    while (store.size() > 0) {
+        EntityId entity = store.size() % 2 ? store.entities()[store.size() - 1] : store.entities()[0];
+        EXPECT_TRUE(store.remove(entity));
+        EXPECT_FALSE(store.remove(entity));
+        expected.erase(entity);
+    }
+    expectStore(store, expected, everyEntity);
+}
+
+// A handle from before its slot was reused names neither the old component nor the new one.
+TEST(ComponentStoreTest, StaleHandlesMissAfterReuse) {
+    EntityRegistry registry;
+    EntityId old = registry.create();
+    EntityId other = registry.create();
+    ComponentStore<int> store;
+    store.insert(old, 1);
+    store.insert(other, 2);
+
+    store.remove(old);
+    ASSERT_TRUE(registry.destroy(old));
+    EntityId reused = registry.create();
+    ASSERT_EQ(entityIndex(reused), entityIndex(old));
+    ASSERT_NE(reused, old);
+    store.insert(reused, 3);
+
+    EXPECT_FALSE(store.contains(old));
+    EXPECT_EQ(store.get(old), nullptr);
+    EXPECT_FALSE(store.remove(old));
+    EXPECT_EQ(*store.get(reused), 3);
+    EXPECT_EQ(*store.get(other), 2);
+
+    // Handles past every slot the store has seen are not found either.
+    EXPECT_FALSE(store.contains(makeEntity(1000, 0)));
+    EXPECT_FALSE(store.contains(NO_ENTITY));
+}
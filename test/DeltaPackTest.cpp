@@ -0,0 +1,121 @@
+#include "DeltaPack.h"
+#include "GlobalSettings.h"
+#include "MapFormat.h"
+#include "TerrainRegistry.h"
+#include "WorldGenerator.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    constexpr int PARENT_COL = 12;
+    constexpr int PARENT_ROW = 34;
+    constexpr uint64_t WORLD_SEED = 555;
+
+    // Each test works in its own directory under the system's temporary directory.
+    class DeltaPackTest : public ::testing::Test {
+    protected:
+        std::filesystem::path dir;
+        WorldArchive archive;
+
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() /
+                  ("wargame_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+            ASSERT_TRUE(archive.open((dir / "world.wgar").string(), true));
+        }
+
+        void TearDown() override {
+            archive.close();
+            std::filesystem::remove_all(dir);
+        }
+    };
+
+    // The inner map of the parent tile as the game generates it.
+    TileMap generateInnerMap() {
+        const GlobalSettings& settings = GlobalSettings::getInstance();
+        TileMap map;
+        map.generateTiles(settings.getInnerMapRows(), settings.getInnerMapCols(), settings.getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(),
+                          WorldGenerator::deriveInnerSeed(WORLD_SEED, PARENT_COL, PARENT_ROW), true);
+        return map;
+    }
+
+    void expectSameTiles(const TileMap& expected, const TileMap& actual) {
+        ASSERT_EQ(expected.getTileCount(), actual.getTileCount());
+        const size_t tiles = expected.getTileCount();
+        EXPECT_EQ(0, std::memcmp(expected.getTerrainIds(), actual.getTerrainIds(), tiles * sizeof(TerrainId)));
+        EXPECT_EQ(0, std::memcmp(expected.getOwnerIds(), actual.getOwnerIds(), tiles * sizeof(int32_t)));
+        EXPECT_EQ(0, std::memcmp(expected.getTileFlags(), actual.getTileFlags(), tiles));
+    }
+}
+
+// Changed tiles replayed onto a regenerated map reproduce the changed map.
+TEST_F(DeltaPackTest, ReplaysChangedTiles) {
+    TileMap changed = generateInnerMap();
+    const TerrainId terrain = TerrainRegistry::getInstance().getAllTerrains().back();
+    changed.setOwnerId(1, 2, 9);
+    changed.setOwnerId(changed.getNumCols() - 1, changed.getNumRows() - 1, 4);
+    changed.setTerrainId(3, 3, terrain);
+
+    DeltaPack deltaPack(archive);
+    EXPECT_FALSE(deltaPack.contains(PARENT_COL, PARENT_ROW));
+    ASSERT_TRUE(deltaPack.store(PARENT_COL, PARENT_ROW, changed));
+    EXPECT_TRUE(deltaPack.contains(PARENT_COL, PARENT_ROW));
+    EXPECT_FALSE(deltaPack.contains(PARENT_ROW, PARENT_COL));
+
+    // Only the three changed tiles are stored.
+    std::vector<char> dictionary;
+    appendTerrainDictionary(dictionary);
+    WorldArchive::EntryInfo info;
+    ASSERT_TRUE(archive.getEntryInfo(WorldArchive::Key{PARENT_COL, PARENT_ROW, WorldArchive::DEPTH_INNER}, info));
+    EXPECT_EQ(info.rawSize, sizeof(DeltaHeader) + dictionary.size() + 3 * sizeof(DeltaEntry));
+
+    TileMap replayed = generateInnerMap();
+    ASSERT_TRUE(deltaPack.apply(PARENT_COL, PARENT_ROW, replayed));
+    expectSameTiles(changed, replayed);
+
+    // Changes survive the archive being reopened.
+    std::string path = archive.getPath();
+    archive.close();
+    ASSERT_TRUE(archive.open(path));
+    DeltaPack reopened(archive);
+    TileMap reloaded = generateInnerMap();
+    ASSERT_TRUE(reopened.apply(PARENT_COL, PARENT_ROW, reloaded));
+    expectSameTiles(changed, reloaded);
+}
+
+// Storing every tile reproduces a map that was not generated from its seed.
+TEST_F(DeltaPackTest, StoresAllTiles) {
+    TileMap other = generateInnerMap();
+    for (int col = 0; col < other.getNumCols(); col++) {
+        other.setOwnerId(col, 0, col);
+    }
+    other.markSaved();
+
+    DeltaPack deltaPack(archive);
+    ASSERT_TRUE(deltaPack.store(PARENT_COL, PARENT_ROW, other, true));
+    TileMap replayed = generateInnerMap();
+    ASSERT_TRUE(deltaPack.apply(PARENT_COL, PARENT_ROW, replayed));
+    EXPECT_EQ(0, std::memcmp(other.getOwnerIds(), replayed.getOwnerIds(), other.getTileCount() * sizeof(int32_t)));
+    EXPECT_EQ(0, std::memcmp(other.getTerrainIds(), replayed.getTerrainIds(), other.getTileCount() * sizeof(TerrainId)));
+}
+
+// A map without changes removes its entry, and changes for a map of another size are ignored.
+TEST_F(DeltaPackTest, DropsUnchangedAndMismatchedMaps) {
+    TileMap changed = generateInnerMap();
+    changed.setOwnerId(0, 0, 3);
+    DeltaPack deltaPack(archive);
+    ASSERT_TRUE(deltaPack.store(PARENT_COL, PARENT_ROW, changed));
+
+    TileMap smaller;
+    smaller.generateTiles(8, 8, GlobalSettings::getInstance().getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(), 1, true);
+    EXPECT_FALSE(deltaPack.apply(PARENT_COL, PARENT_ROW, smaller));
+
+    ASSERT_TRUE(deltaPack.store(PARENT_COL, PARENT_ROW, generateInnerMap()));
+    EXPECT_FALSE(deltaPack.contains(PARENT_COL, PARENT_ROW));
+    TileMap untouched = generateInnerMap();
+    EXPECT_FALSE(deltaPack.apply(PARENT_COL, PARENT_ROW, untouched));
+}
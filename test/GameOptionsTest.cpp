@@ -0,0 +1,87 @@
+#include "GameOptions.h"
+#include <gtest/gtest.h>
+#include <climits>
+#include <string>
+#include <vector>
+
+namespace {
+    // Parses arguments as they would follow the program name on the command line.
+    bool parseArgs(std::vector<std::string> args, GameOptions& options) {
+        args.insert(args.begin(), "wargame");
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        return GameOptions::parse(static_cast<int>(args.size()), argv.data(), options);
+    }
+}
+
+// No arguments leave every default in place.
+TEST(GameOptionsTest, DefaultsWithoutArguments) {
+    GameOptions options;
+    ASSERT_TRUE(parseArgs({}, options));
+    EXPECT_FALSE(options.headless);
+    EXPECT_FALSE(options.newMap);
+    EXPECT_FALSE(options.showHelp);
+    EXPECT_FALSE(options.convert);
+    EXPECT_EQ(options.ticks, 10000);
+    EXPECT_EQ(options.mapFile, "starter_map.dat");
+    EXPECT_FALSE(options.seed.has_value());
+    EXPECT_TRUE(options.tracePath.empty());
+}
+
+// Every option is read, in any order, with seeds in decimal, hex or octal.
+TEST(GameOptionsTest, ParsesEveryOption) {
+    GameOptions options;
+    ASSERT_TRUE(parseArgs({"--ticks", "250", "--headless", "--map", "other.dat", "--new", "--seed", "18446744073709551615",
+                           "--trace", "trace.json", "--convert", "-h"}, options));
+    EXPECT_TRUE(options.headless);
+    EXPECT_TRUE(options.newMap);
+    EXPECT_TRUE(options.convert);
+    EXPECT_TRUE(options.showHelp);
+    EXPECT_EQ(options.ticks, 250);
+    EXPECT_EQ(options.mapFile, "other.dat");
+    EXPECT_EQ(options.seed, UINT64_MAX);
+    EXPECT_EQ(options.tracePath, "trace.json");
+
+    GameOptions hex;
+    ASSERT_TRUE(parseArgs({"--seed", "0x1F", "--help"}, hex));
+    EXPECT_EQ(hex.seed, 31u);
+    EXPECT_TRUE(hex.showHelp);
+    GameOptions octal;
+    ASSERT_TRUE(parseArgs({"--seed", "017", "--ticks", "0"}, octal));
+    EXPECT_EQ(octal.seed, 15u);
+    EXPECT_EQ(octal.ticks, 0);
+}
+
+// Empty, signed, partly numeric and out-of-range numbers are rejected instead of read as 0.
+TEST(GameOptionsTest, RejectsMalformedNumbers) {
+    for (const char* value : {"", "-1", "+5", " 7", "12abc", "abc", "0x", "99999999999999999999", "1.5"}) {
+        SCOPED_TRACE(testing::Message() << "\"" << value << "\"");
+        GameOptions seed;
+        EXPECT_FALSE(parseArgs({"--seed", value}, seed));
+        EXPECT_FALSE(seed.seed.has_value());
+        GameOptions ticks;
+        EXPECT_FALSE(parseArgs({"--ticks", value}, ticks));
+        EXPECT_EQ(ticks.ticks, 10000);
+    }
+
+    // Tick counts are decimal and must fit in a long long.
+    GameOptions options;
+    EXPECT_FALSE(parseArgs({"--ticks", "0x10"}, options));
+    EXPECT_FALSE(parseArgs({"--ticks", "9223372036854775808"}, options));
+    ASSERT_TRUE(parseArgs({"--ticks", "9223372036854775807"}, options));
+    EXPECT_EQ(options.ticks, LLONG_MAX);
+}
+
+// Unknown arguments and options missing their value are errors.
+TEST(GameOptionsTest, RejectsUnknownAndIncompleteArguments) {
+    GameOptions options;
+    EXPECT_FALSE(parseArgs({"--fast"}, options));
+    EXPECT_FALSE(parseArgs({"headless"}, options));
+    for (const char* option : {"--map", "--seed", "--ticks", "--trace"}) {
+        SCOPED_TRACE(option);
+        EXPECT_FALSE(parseArgs({"--headless", option}, options));
+    }
+}
@@ -0,0 +1,141 @@
+#include "JobSystem.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Counts how often parallelFor() visits each index of [0, count).
+    std::vector<int> countVisits(size_t count, size_t grainSize, size_t begin = 0) {
+        std::vector<std::atomic<int>> visits(count);
+        JobSystem::getInstance().parallelFor(begin, count, grainSize, [&](size_t first, size_t end) {
+            for (size_t i = first; i < end; i++) {
+                visits[i]++;
+            }
+        });
+
+        std::vector<int> result;
+        for (const std::atomic<int>& visit : visits) {
+            result.push_back(visit.load());
+        }
+        return result;
+    }
+}
+
+// Each job of a chain runs after the one it depends on, and a job waiting on two runs after both.
+TEST(JobSystemTest, DependenciesRunInOrder) {
+    JobSystem& jobs = JobSystem::getInstance();
+    std::mutex mutex;
+    std::vector<int> order;
+    auto record = [&](int step) {
+        return [&, step]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(step);
+        };
+    };
+
+    const int CHAIN_LENGTH = 50;
+    JobSystem::JobHandle previous;
+    for (int step = 0; step < CHAIN_LENGTH; step++) {
+        previous = jobs.schedule(record(step), {previous});
+    }
+    jobs.wait(previous);
+    EXPECT_TRUE(jobs.isDone(previous));
+    ASSERT_EQ(order.size(), static_cast<size_t>(CHAIN_LENGTH));
+    for (int step = 0; step < CHAIN_LENGTH; step++) {
+        EXPECT_EQ(order[step], step);
+    }
+
+    // A job depending on a finished job and on two running ones waits only for the running ones.
+    std::atomic<int> finishedBefore{0};
+    JobSystem::JobHandle left = jobs.schedule([&]() { finishedBefore++; });
+    JobSystem::JobHandle right = jobs.schedule([&]() { finishedBefore++; });
+    JobSystem::JobHandle joined = jobs.schedule([&]() { EXPECT_EQ(finishedBefore.load(), 2); }, {previous, left, nullptr, right});
+    jobs.wait(joined);
+    EXPECT_TRUE(jobs.isDone(left));
+    EXPECT_TRUE(jobs.isDone(right));
+    EXPECT_TRUE(jobs.isDone(nullptr));
+}
+
+// Every index is visited exactly once, whether or not the grain size divides the range.
+TEST(JobSystemTest, ParallelForCoversEveryIndexOnce) {
+    for (size_t grainSize : {size_t{1}, size_t{7}, size_t{64}, size_t{1000}, size_t{5000}}) {
+        SCOPED_TRACE(testing::Message() << "grain " << grainSize);
+        EXPECT_EQ(countVisits(1000, grainSize), std::vector<int>(1000, 1));
+    }
+
+    // Indexes before begin are left alone, and an empty range does nothing.
+    std::vector<int> expected(300, 1);
+    std::fill(expected.begin(), expected.begin() + 100, 0);
+    EXPECT_EQ(countVisits(300, 9, 100), expected);
+    EXPECT_EQ(countVisits(10, 3, 10), std::vector<int>(10, 0));
+}
+
+// A parallelFor inside a job, and one inside another parallelFor, still visits every index once.
+TEST(JobSystemTest, NestedParallelForCoversEveryIndexOnce) {
+    JobSystem& jobs = JobSystem::getInstance();
+    const size_t OUTER = 16, INNER = 500;
+    std::vector<std::atomic<int>> visits(OUTER * INNER);
+
+    std::vector<JobSystem::JobHandle> handles;
+    for (size_t outer = 0; outer < OUTER / 2; outer++) {
+        handles.push_back(jobs.schedule([&, outer]() {
+            jobs.parallelFor(0, INNER, 13, [&](size_t first, size_t end) {
+                for (size_t i = first; i < end; i++) {
+                    visits[outer * INNER + i]++;
+                }
+            });
+        }));
+    }
+    jobs.parallelFor(OUTER / 2, OUTER, 1, [&](size_t firstOuter, size_t endOuter) {
+        for (size_t outer = firstOuter; outer < endOuter; outer++) {
+            jobs.parallelFor(0, INNER, 29, [&](size_t first, size_t end) {
+                for (size_t i = first; i < end; i++) {
+                    visits[outer * INNER + i]++;
+                }
+            });
+        }
+    });
+    for (const JobSystem::JobHandle& handle : handles) {
+        jobs.wait(handle);
+    }
+
+    for (size_t i = 0; i < visits.size(); i++) {
+        ASSERT_EQ(visits[i].load(), 1) << "index " << i;
+    }
+}
+
+// With every worker blocked, the waiting main thread runs the queued job that unblocks them.
+TEST(JobSystemTest, WaitRunsJobsWhenWorkersAreBusy) {
+    JobSystem& jobs = JobSystem::getInstance();
+    const unsigned workerCount = jobs.getWorkerCount();
+    std::atomic<unsigned> started{0};
+    std::atomic<bool> released{false};
+
+    std::vector<JobSystem::JobHandle> blockers;
+    for (unsigned i = 0; i < workerCount; i++) {
+        blockers.push_back(jobs.schedule([&]() {
+            started++;
+            while (!released) {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    while (started < workerCount) {
+        std::this_thread::yield();
+    }
+
+    std::thread::id releaser;
+    JobSystem::JobHandle release = jobs.schedule([&]() {
+        releaser = std::this_thread::get_id();
+        released = true;
+    });
+    jobs.wait(release);
+    EXPECT_EQ(releaser, std::this_thread::get_id());
+    for (const JobSystem::JobHandle& blocker : blockers) {
+        jobs.wait(blocker);
+    }
+    EXPECT_EQ(started.load(), workerCount);
+}
@@ -0,0 +1,195 @@
+#include "GlobalSettings.h"
+#include "MapFormat.h"
+#include "TerrainRegistry.h"
+#include "TileMap.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    constexpr int MAP_ROWS = 40;
+    constexpr int MAP_COLS = 56;
+    constexpr uint64_t MAP_SEED = 1234;
+    const std::string MAP_FILE = "map.dat";
+
+    // Each test works in its own directory under the system's temporary directory.
+    class MapFormatTest : public ::testing::Test {
+    protected:
+        std::filesystem::path dir;
+
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() /
+                  ("wargame_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(dir);
+        }
+
+        std::string prefix() const {
+            return dir.string() + "/";
+        }
+
+        std::string mapPath() const {
+            return prefix() + MAP_FILE;
+        }
+    };
+
+    // A generated map with a changed owner and terrain, so no plane is all defaults.
+    TileMap makeMap() {
+        const TerrainRegistry& registry = TerrainRegistry::getInstance();
+        TileMap map;
+        map.generateTiles(MAP_ROWS, MAP_COLS, GlobalSettings::getInstance().getTileSize(), registry.getAllTerrains(), MAP_SEED);
+        map.setOwnerId(3, 4, 77);
+        map.setTerrainId(10, 20, registry.getAllTerrains().back());
+        return map;
+    }
+
+    std::vector<char> readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& path, const std::vector<char>& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void expectSameTiles(const TileMap& expected, const TileMap& actual) {
+        ASSERT_EQ(expected.getNumRows(), actual.getNumRows());
+        ASSERT_EQ(expected.getNumCols(), actual.getNumCols());
+        const size_t tiles = expected.getTileCount();
+        EXPECT_EQ(0, std::memcmp(expected.getTerrainIds(), actual.getTerrainIds(), tiles * sizeof(TerrainId)));
+        EXPECT_EQ(0, std::memcmp(expected.getOwnerIds(), actual.getOwnerIds(), tiles * sizeof(int32_t)));
+        EXPECT_EQ(0, std::memcmp(expected.getTileFlags(), actual.getTileFlags(), tiles));
+    }
+}
+
+// A saved map is written as version 2 with its seed and loads back tile for tile.
+TEST_F(MapFormatTest, RoundTripsVersion2) {
+    TileMap map = makeMap();
+    map.saveToFile(MAP_FILE, prefix());
+
+    std::vector<char> bytes = readFile(mapPath());
+    MapFileHeader header;
+    TerrainRemap terrainRemap;
+    bool identityRemap = false;
+    ASSERT_GE(bytes.size(), sizeof(header));
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    ASSERT_TRUE(decodeMapPrefix(bytes.data(), header.terrainOffset, header, terrainRemap, identityRemap));
+    EXPECT_EQ(header.version, MAP_FORMAT_VERSION);
+    EXPECT_EQ(header.worldSeed, MAP_SEED);
+    EXPECT_EQ(header.fileSize, bytes.size());
+    EXPECT_EQ(header.ownerOffset % MAP_PLANE_ALIGNMENT, 0u);
+    EXPECT_TRUE(identityRemap);
+
+    TileMap loaded;
+    ASSERT_TRUE(loaded.importFile(mapPath()));
+    EXPECT_EQ(loaded.getWorldSeed(), MAP_SEED);
+    expectSameTiles(map, loaded);
+}
+
+// A changed tile byte fails the tile checksum; a changed dictionary byte fails the header checksum.
+TEST_F(MapFormatTest, RejectsCorruption) {
+    makeMap().saveToFile(MAP_FILE, prefix());
+    const std::vector<char> bytes = readFile(mapPath());
+    MapFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    std::vector<char> damaged = bytes;
+    damaged[header.ownerOffset + 5] ^= 0x10;
+    writeFile(mapPath(), damaged);
+    TileMap tiles;
+    EXPECT_FALSE(tiles.importFile(mapPath()));
+
+    damaged = bytes;
+    damaged[sizeof(MapFileHeader) + 1] ^= 0x01;
+    writeFile(mapPath(), damaged);
+    TileMap dictionary;
+    EXPECT_FALSE(dictionary.importFile(mapPath()));
+
+    damaged.assign(bytes.begin(), bytes.end() - 1);
+    writeFile(mapPath(), damaged);
+    TileMap truncated;
+    EXPECT_FALSE(truncated.importFile(mapPath()));
+}
+
+// A version 1 file, whose header stops before the world seed, still loads, with a seed of 0.
+TEST_F(MapFormatTest, LoadsVersion1) {
+    TileMap map = makeMap();
+    map.saveToFile(MAP_FILE, prefix());
+    const std::vector<char> current = readFile(mapPath());
+    MapFileHeader header;
+    std::memcpy(&header, current.data(), sizeof(header));
+    const size_t tiles = map.getTileCount();
+
+    std::vector<char> bytes(MAP_HEADER_SIZE_V1);
+    appendTerrainDictionary(bytes);
+    bytes.resize(alignMapOffset(bytes.size()), 0);
+
+    MapFileHeader old = header;
+    old.version = MAP_FORMAT_VERSION_1;
+    old.headerSize = MAP_HEADER_SIZE_V1;
+    old.terrainOffset = bytes.size();
+    old.ownerOffset = alignMapOffset(old.terrainOffset + tiles);
+    old.flagsOffset = old.ownerOffset + tiles * sizeof(int32_t);
+    old.fileSize = old.flagsOffset + tiles;
+    old.headerCrc = 0;
+    std::memcpy(bytes.data(), &old, MAP_HEADER_SIZE_V1);
+    old.headerCrc = computeMapHeaderCrc(bytes.data());
+    std::memcpy(bytes.data(), &old, MAP_HEADER_SIZE_V1);
+
+    // The planes and their checksum are the same in both versions.
+    bytes.insert(bytes.end(), current.begin() + header.terrainOffset, current.begin() + header.terrainOffset + tiles);
+    bytes.resize(old.ownerOffset, 0);
+    bytes.insert(bytes.end(), current.begin() + header.ownerOffset, current.begin() + header.fileSize);
+    ASSERT_EQ(bytes.size(), old.fileSize);
+    writeFile(mapPath(), bytes);
+
+    TileMap loaded;
+    ASSERT_TRUE(loaded.importFile(mapPath()));
+    EXPECT_EQ(loaded.getWorldSeed(), 0u);
+    expectSameTiles(map, loaded);
+}
+
+// A file in the original per-tile format loads by terrain alias, with a seed of 0.
+TEST_F(MapFormatTest, LoadsLegacyFormat) {
+    TileMap map = makeMap();
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    {
+        std::ofstream out(mapPath(), std::ios::binary | std::ios::trunc);
+        int rows = MAP_ROWS, cols = MAP_COLS;
+        out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        out.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+        for (size_t i = 0; i < map.getTileCount(); i++) {
+            int x = static_cast<int>(i % MAP_COLS), y = static_cast<int>(i / MAP_COLS);
+            const std::string& alias = registry.getAlias(map.getTerrainIds()[i]);
+            size_t aliasLen = alias.size();
+            int32_t ownerId = map.getOwnerIds()[i];
+            out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+            out.write(reinterpret_cast<const char*>(&y), sizeof(y));
+            out.write(reinterpret_cast<const char*>(&aliasLen), sizeof(aliasLen));
+            out.write(alias.data(), static_cast<std::streamsize>(aliasLen));
+            out.write(reinterpret_cast<const char*>(&ownerId), sizeof(ownerId));
+        }
+    }
+
+    TileMap loaded;
+    ASSERT_TRUE(loaded.importFile(mapPath()));
+    EXPECT_EQ(loaded.getWorldSeed(), 0u);
+    ASSERT_EQ(loaded.getTileCount(), map.getTileCount());
+    EXPECT_EQ(0, std::memcmp(map.getTerrainIds(), loaded.getTerrainIds(), map.getTileCount() * sizeof(TerrainId)));
+    EXPECT_EQ(0, std::memcmp(map.getOwnerIds(), loaded.getOwnerIds(), map.getTileCount() * sizeof(int32_t)));
+
+    // Dimensions larger than the file can hold are refused before anything is allocated.
+    std::vector<char> bytes = readFile(mapPath());
+    int huge = 1 << 20;
+    std::memcpy(bytes.data(), &huge, sizeof(huge));
+    writeFile(mapPath(), bytes);
+    TileMap refused;
+    EXPECT_FALSE(refused.importFile(mapPath()));
+}
@@ -0,0 +1,131 @@
+#include "GlobalSettings.h"
+#include "MapPyramid.h"
+#include "TerrainRegistry.h"
+#include "TileMap.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace {
+    constexpr int MAP_ROWS = 150; // Neither dimension is a whole number of chunks or a power of two.
+    constexpr int MAP_COLS = 201;
+
+    TileMap makeMap() {
+        TileMap map;
+        map.generateTiles(MAP_ROWS, MAP_COLS, GlobalSettings::getInstance().getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(), 4321);
+        return map;
+    }
+
+    // Paints a square of tiles with one owner and terrain, enough to turn the cells above it.
+    void paintSquare(TileMap& map, int firstCol, int firstRow, int size, int32_t ownerId, TerrainId terrainId) {
+        for (int row = firstRow; row < std::min(firstRow + size, MAP_ROWS); row++) {
+            for (int col = firstCol; col < std::min(firstCol + size, MAP_COLS); col++) {
+                map.setOwnerId(col, row, ownerId);
+                map.setTerrainId(col, row, terrainId);
+            }
+        }
+    }
+
+    // Checks every level of an updated pyramid against one built from scratch.
+    void expectSameAsRebuilt(const MapPyramid& pyramid, const TileMap& map) {
+        MapPyramid rebuilt;
+        rebuilt.update(map);
+        ASSERT_EQ(pyramid.getLevelCount(), rebuilt.getLevelCount());
+        for (int level = 1; level <= rebuilt.getLevelCount(); level++) {
+            SCOPED_TRACE(testing::Message() << "level " << level);
+            ASSERT_EQ(pyramid.getLevelCols(level), rebuilt.getLevelCols(level));
+            ASSERT_EQ(pyramid.getLevelRows(level), rebuilt.getLevelRows(level));
+            const size_t cells = static_cast<size_t>(rebuilt.getLevelCols(level)) * rebuilt.getLevelRows(level);
+            EXPECT_EQ(0, std::memcmp(pyramid.getTerrainIds(level), rebuilt.getTerrainIds(level), cells * sizeof(TerrainId)));
+            EXPECT_EQ(0, std::memcmp(pyramid.getOwnerIds(level), rebuilt.getOwnerIds(level), cells * sizeof(int32_t)));
+        }
+    }
+}
+
+// Levels halve each dimension, rounding up, down to a single cell.
+TEST(MapPyramidTest, BuildsEveryLevel) {
+    TileMap map = makeMap();
+    MapPyramid pyramid;
+    EXPECT_FALSE(pyramid.describes(map));
+    pyramid.update(map);
+    EXPECT_TRUE(pyramid.describes(map));
+
+    int cols = MAP_COLS, rows = MAP_ROWS;
+    for (int level = 1; level <= pyramid.getLevelCount(); level++) {
+        cols = (cols + 1) / 2;
+        rows = (rows + 1) / 2;
+        EXPECT_EQ(pyramid.getLevelCols(level), cols);
+        EXPECT_EQ(pyramid.getLevelRows(level), rows);
+    }
+    EXPECT_EQ(cols, 1);
+    EXPECT_EQ(rows, 1);
+    EXPECT_EQ(pyramid.getTerrainIds(0), nullptr);
+    EXPECT_EQ(pyramid.getOwnerIds(pyramid.getLevelCount() + 1), nullptr);
+}
+
+// Noted tiles and chunks changed without noting both reach every level of the next update().
+TEST(MapPyramidTest, UpdatesMatchARebuild) {
+    TileMap map = makeMap();
+    MapPyramid pyramid;
+    pyramid.update(map);
+    const uint64_t builtRevision = pyramid.getRevision();
+
+    // Unchanged maps leave the pyramid as it was.
+    pyramid.update(map);
+    EXPECT_EQ(pyramid.getRevision(), builtRevision);
+
+    const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+    std::mt19937 rng(8);
+    for (int round = 0; round < 4; round++) {
+        SCOPED_TRACE(testing::Message() << "round " << round);
+
+        // Changes made with tracking off only show up in chunk revisions; they reach update() before
+        // any tile of the same chunk is noted.
+        map.setChangeTracking(false);
+        for (int i = 0; i < 6; i++) {
+            paintSquare(map, static_cast<int>(rng() % MAP_COLS), static_cast<int>(rng() % MAP_ROWS),
+                        1 + static_cast<int>(rng() % 9), static_cast<int32_t>(rng() % 5), terrains[rng() % terrains.size()]);
+        }
+        pyramid.update(map);
+        expectSameAsRebuilt(pyramid, map);
+
+        // Tracked changes are noted tile by tile, as the game does every tick.
+        map.setChangeTracking(true);
+        for (int i = 0; i < 10; i++) {
+            paintSquare(map, static_cast<int>(rng() % MAP_COLS), static_cast<int>(rng() % MAP_ROWS),
+                        1 + static_cast<int>(rng() % 9), static_cast<int32_t>(rng() % 5), terrains[rng() % terrains.size()]);
+            if (i % 3 == 0) {
+                pyramid.noteChangedTiles(map, map.takeChangedTiles());
+            }
+        }
+        pyramid.noteChangedTiles(map, map.takeChangedTiles());
+
+        // Then one more untracked change in a corner chunk nothing above was noted in.
+        map.setChangeTracking(false);
+        const uint64_t cornerRevision = map.getChunkRevision(0, 0);
+        paintSquare(map, 0, 0, 4, static_cast<int32_t>(700 + round), terrains[round % terrains.size()]);
+        EXPECT_NE(map.getChunkRevision(0, 0), cornerRevision);
+        pyramid.update(map);
+        expectSameAsRebuilt(pyramid, map);
+    }
+    EXPECT_GT(pyramid.getRevision(), builtRevision);
+}
+
+// A map of another size or seed is built from scratch instead of updated.
+TEST(MapPyramidTest, RebuildsForAnotherMap) {
+    TileMap map = makeMap();
+    MapPyramid pyramid;
+    pyramid.update(map);
+
+    TileMap other;
+    other.generateTiles(40, 70, GlobalSettings::getInstance().getTileSize(),
+                        TerrainRegistry::getInstance().getAllTerrains(), 99);
+    EXPECT_FALSE(pyramid.describes(other));
+    pyramid.noteChangedTiles(other, {0, 1, 2});
+    pyramid.update(other);
+    EXPECT_TRUE(pyramid.describes(other));
+    EXPECT_FALSE(pyramid.describes(map));
+    expectSameAsRebuilt(pyramid, other);
+}
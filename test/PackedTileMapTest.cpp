@@ -0,0 +1,104 @@
+#include "GlobalSettings.h"
+#include "PackedTileMap.h"
+#include "TerrainRegistry.h"
+#include "TileMap.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+
+namespace {
+    // Packs a plane and checks that it unpacks to the same values and consumes exactly its bytes.
+    template <typename T>
+    void expectPlaneRoundTrip(const std::vector<T>& values) {
+        std::vector<uint8_t> bytes;
+        packPlane(values.data(), values.size(), sizeof(T), bytes);
+        bytes.push_back(0xA5); // Whatever follows the plane must be left unread.
+
+        std::vector<T> unpacked(values.size());
+        const uint8_t* in = bytes.data();
+        unpackPlane(in, unpacked.data(), unpacked.size(), sizeof(T));
+        EXPECT_EQ(unpacked, values);
+        EXPECT_EQ(in, bytes.data() + bytes.size() - 1);
+    }
+}
+
+// Varints round-trip at every length, including the largest values.
+TEST(PackedTileMapTest, VarintsRoundTrip) {
+    const std::vector<uint64_t> values = {0, 1, 127, 128, 300, 16383, 16384, UINT32_MAX, (1ull << 56) + 3, UINT64_MAX};
+    std::vector<uint8_t> bytes;
+    for (uint64_t value : values) {
+        appendVarint(bytes, value);
+    }
+    EXPECT_EQ(bytes.size(), 1u + 1 + 1 + 2 + 2 + 2 + 3 + 5 + 9 + 10);
+
+    const uint8_t* in = bytes.data();
+    for (uint64_t value : values) {
+        EXPECT_EQ(readVarint(in), value);
+    }
+    EXPECT_EQ(in, bytes.data() + bytes.size());
+}
+
+// Planes of one value, long runs, a few noisy values and many distinct values all round-trip.
+TEST(PackedTileMapTest, PlanesRoundTrip) {
+    std::mt19937 rng(11);
+    const size_t count = 5000;
+
+    expectPlaneRoundTrip(std::vector<uint8_t>(count, 7));
+    expectPlaneRoundTrip(std::vector<int32_t>(count, -1));
+    expectPlaneRoundTrip(std::vector<uint8_t>());
+
+    std::vector<int32_t> runs(count);
+    for (size_t i = 0; i < count; i++) {
+        runs[i] = static_cast<int32_t>(i / 700) - 2;
+    }
+    expectPlaneRoundTrip(runs);
+
+    std::vector<uint8_t> fewValues(count);
+    for (uint8_t& value : fewValues) {
+        value = static_cast<uint8_t>(rng() % 5);
+    }
+    expectPlaneRoundTrip(fewValues);
+
+    std::vector<int32_t> manyValues(count);
+    for (int32_t& value : manyValues) {
+        value = static_cast<int32_t>(rng());
+    }
+    expectPlaneRoundTrip(manyValues);
+}
+
+// A packed map restores the same tiles, seed, revisions and unsaved range, and packs small.
+TEST(PackedTileMapTest, TileMapRoundTrips) {
+    const TerrainRegistry& registry = TerrainRegistry::getInstance();
+    TileMap map;
+    map.generateTiles(96, 80, GlobalSettings::getInstance().getTileSize(), registry.getAllTerrains(), 2024);
+    map.setOwnerId(5, 6, 42);
+    map.setTerrainId(70, 90, registry.getAllTerrains().front());
+
+    PackedTileMap packed = map.pack();
+    EXPECT_LT(packed.bytes.size(), map.getTileCount() * (sizeof(TerrainId) + sizeof(int32_t) + 1));
+    EXPECT_TRUE(packed.hasUnsavedChanges());
+
+    TileMap restored(packed);
+    ASSERT_EQ(restored.getNumRows(), map.getNumRows());
+    ASSERT_EQ(restored.getNumCols(), map.getNumCols());
+    EXPECT_EQ(restored.getTileSize(), map.getTileSize());
+    EXPECT_EQ(restored.getWorldSeed(), map.getWorldSeed());
+    EXPECT_EQ(restored.getRevision(), map.getRevision());
+    EXPECT_TRUE(restored.hasUnsavedChanges());
+    const size_t tiles = map.getTileCount();
+    EXPECT_EQ(0, std::memcmp(restored.getTerrainIds(), map.getTerrainIds(), tiles * sizeof(TerrainId)));
+    EXPECT_EQ(0, std::memcmp(restored.getOwnerIds(), map.getOwnerIds(), tiles * sizeof(int32_t)));
+    EXPECT_EQ(0, std::memcmp(restored.getTileFlags(), map.getTileFlags(), tiles));
+
+    const int chunkCols = (map.getNumCols() + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE;
+    const int chunkRows = (map.getNumRows() + TileMap::CHUNK_SIZE - 1) / TileMap::CHUNK_SIZE;
+    for (int chunkRow = 0; chunkRow < chunkRows; chunkRow++) {
+        for (int chunkCol = 0; chunkCol < chunkCols; chunkCol++) {
+            EXPECT_EQ(restored.getChunkRevision(chunkCol, chunkRow), map.getChunkRevision(chunkCol, chunkRow));
+        }
+    }
+
+    // Saved maps pack as saved.
+    map.markSaved();
+    EXPECT_FALSE(map.pack().hasUnsavedChanges());
+}
@@ -0,0 +1,172 @@
+#include "GlobalSettings.h"
+#include "Pathfinder.h"
+#include "TerrainRegistry.h"
+#include "TerritorySimulation.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+
+namespace {
+    constexpr int MAP_SIZE = 256;
+    constexpr uint64_t MAP_SEED = 42;
+
+    // Move cost of entering a tile for a mover, with the same rules as the pathfinder; 0 is impassable.
+    uint32_t stepCost(const TileMap& map, size_t index, int32_t ownerId) {
+        const std::string& alias = TerrainRegistry::getInstance().getAlias(map.getTerrainIds()[index]);
+        int cost = alias.empty() ? 0 : std::clamp(GlobalSettings::getInstance().getTerrainMoveCost(alias), 0, 255);
+        int32_t owner = map.getOwnerIds()[index];
+        if (cost > 0 && ownerId != Pathfinder::ANY_OWNER && owner != ownerId && owner != TerritorySimulation::NEUTRAL_OWNER) {
+            cost *= static_cast<int>(Pathfinder::FOREIGN_COST_FACTOR);
+        }
+        return static_cast<uint32_t>(cost);
+    }
+
+    // Cheapest cost over the whole map, or UINT32_MAX if the goal cannot be reached.
+    uint32_t dijkstra(const TileMap& map, const PathRequest& request) {
+        const int cols = map.getNumCols(), rows = map.getNumRows();
+        const size_t start = static_cast<size_t>(request.startRow) * cols + request.startCol;
+        const size_t goal = static_cast<size_t>(request.goalRow) * cols + request.goalCol;
+        if (stepCost(map, start, Pathfinder::ANY_OWNER) == 0 || stepCost(map, goal, Pathfinder::ANY_OWNER) == 0) {
+            return UINT32_MAX;
+        }
+
+        std::vector<uint32_t> distances(map.getTileCount(), UINT32_MAX);
+        using Entry = std::pair<uint32_t, size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        distances[start] = 0;
+        open.push({0, start});
+        static const int STEPS[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+        while (!open.empty()) {
+            auto [cost, index] = open.top();
+            open.pop();
+            if (index == goal) {
+                return cost;
+            }
+            if (cost != distances[index]) {
+                continue;
+            }
+            const int col = static_cast<int>(index % cols), row = static_cast<int>(index / cols);
+            for (const auto& step : STEPS) {
+                const int nextCol = col + step[0], nextRow = row + step[1];
+                if (nextCol < 0 || nextCol >= cols || nextRow < 0 || nextRow >= rows) {
+                    continue;
+                }
+                const size_t next = static_cast<size_t>(nextRow) * cols + nextCol;
+                const uint32_t nextCost = stepCost(map, next, request.ownerId);
+                if (nextCost != 0 && cost + nextCost < distances[next]) {
+                    distances[next] = cost + nextCost;
+                    open.push({cost + nextCost, next});
+                }
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    // A generated world whose territory has been contested for a while.
+    TileMap makeContestedMap() {
+        TileMap map;
+        map.generateTiles(MAP_SIZE, MAP_SIZE, GlobalSettings::getInstance().getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(), MAP_SEED);
+        TerritorySimulation simulation;
+        simulation.reset(map);
+        for (int tick = 0; tick < 400; tick++) {
+            simulation.tick(map);
+        }
+        return map;
+    }
+}
+
+// Paths must be walkable, cost what they claim, and never beat the cheapest path.
+TEST(PathfinderTest, PathsAreConnectedAndPricedCorrectly) {
+    TileMap map = makeContestedMap();
+    Pathfinder pathfinder;
+    pathfinder.refresh(map);
+
+    std::mt19937 rng(7);
+    for (int i = 0; i < 100; i++) {
+        PathRequest request;
+        request.startCol = static_cast<int>(rng() % MAP_SIZE);
+        request.startRow = static_cast<int>(rng() % MAP_SIZE);
+        request.goalCol = static_cast<int>(rng() % MAP_SIZE);
+        request.goalRow = static_cast<int>(rng() % MAP_SIZE);
+        request.ownerId = (i & 1) ? map.getOwnerIds()[static_cast<size_t>(request.startRow) * MAP_SIZE + request.startCol]
+                                  : Pathfinder::ANY_OWNER;
+
+        PathResult result = pathfinder.findPath(map, request);
+        uint32_t cheapest = dijkstra(map, request);
+        ASSERT_EQ(result.found, cheapest != UINT32_MAX);
+        if (!result.found) {
+            continue;
+        }
+
+        ASSERT_EQ(result.tiles.front(), static_cast<uint32_t>(request.startRow * MAP_SIZE + request.startCol));
+        ASSERT_EQ(result.tiles.back(), static_cast<uint32_t>(request.goalRow * MAP_SIZE + request.goalCol));
+        uint32_t cost = 0;
+        for (size_t step = 1; step < result.tiles.size(); step++) {
+            int dx = std::abs(static_cast<int>(result.tiles[step] % MAP_SIZE) - static_cast<int>(result.tiles[step - 1] % MAP_SIZE));
+            int dy = std::abs(static_cast<int>(result.tiles[step] / MAP_SIZE) - static_cast<int>(result.tiles[step - 1] / MAP_SIZE));
+            ASSERT_EQ(dx + dy, 1);
+            uint32_t tileCost = stepCost(map, result.tiles[step], request.ownerId);
+            ASSERT_GT(tileCost, 0u);
+            cost += tileCost;
+        }
+        EXPECT_EQ(result.cost, cost);
+        EXPECT_GE(result.cost, cheapest);
+    }
+}
+
+// Long paths through the abstract graph stay close to the cheapest path, with and without an owner.
+TEST(PathfinderTest, StaysNearDijkstraCost) {
+    TileMap map = makeContestedMap();
+    Pathfinder pathfinder;
+    pathfinder.refresh(map);
+
+    std::mt19937 rng(99);
+    double ratioSum[2] = {0.0, 0.0};
+    double worst[2] = {1.0, 1.0};
+    int count[2] = {0, 0};
+    for (int i = 0; i < 300; i++) {
+        PathRequest request;
+        request.startCol = static_cast<int>(rng() % MAP_SIZE);
+        request.startRow = static_cast<int>(rng() % MAP_SIZE);
+        request.goalCol = std::clamp(request.startCol + static_cast<int>(rng() % 256) - 128, 0, MAP_SIZE - 1);
+        request.goalRow = std::clamp(request.startRow + static_cast<int>(rng() % 256) - 128, 0, MAP_SIZE - 1);
+        const int kind = i & 1;
+        if (kind) {
+            request.ownerId = map.getOwnerIds()[static_cast<size_t>(request.startRow) * MAP_SIZE + request.startCol];
+        }
+
+        PathResult result = pathfinder.findPath(map, request);
+        uint32_t cheapest = dijkstra(map, request);
+        ASSERT_EQ(result.found, cheapest != UINT32_MAX);
+        if (!result.found || cheapest == 0) {
+            continue;
+        }
+        double ratio = static_cast<double>(result.cost) / cheapest;
+        ratioSum[kind] += ratio;
+        worst[kind] = std::max(worst[kind], ratio);
+        count[kind]++;
+    }
+
+    ASSERT_GT(count[0], 100);
+    ASSERT_GT(count[1], 100);
+    EXPECT_LE(ratioSum[0] / count[0], 1.02) << "ANY_OWNER paths";
+    EXPECT_LE(ratioSum[1] / count[1], 1.02) << "Owner paths";
+    EXPECT_LE(std::max(worst[0], worst[1]), 2.0);
+}
+
+// Queries with a tile off the map find nothing.
+TEST(PathfinderTest, RejectsTilesOffTheMap) {
+    TileMap map = makeContestedMap();
+    Pathfinder pathfinder;
+    pathfinder.refresh(map);
+
+    PathRequest request;
+    request.goalCol = MAP_SIZE;
+    EXPECT_FALSE(pathfinder.findPath(map, request).found);
+    request.goalCol = 0;
+    request.startRow = -1;
+    EXPECT_FALSE(pathfinder.findPath(map, request).found);
+}
@@ -0,0 +1,143 @@
+#include "SpatialHash.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr int MIN_COORDINATE = -40; // Entities stand on both sides of zero, across many cells.
+    constexpr int MAX_COORDINATE = 40;
+
+    using Tiles = std::map<EntityId, std::pair<int, int>>;
+
+    // Builds the handle of a slot at a generation, as EntityRegistry does.
+    EntityId makeEntity(uint32_t index, uint32_t generation) {
+        return (generation << ENTITY_INDEX_BITS) | index;
+    }
+
+    // Finds the entities inside a rectangle by checking every one of them.
+    std::vector<EntityId> scanRect(const Tiles& tiles, int firstCol, int firstRow, int endCol, int endRow) {
+        std::vector<EntityId> found;
+        for (const auto& [entity, tile] : tiles) {
+            if (tile.first >= firstCol && tile.first < endCol && tile.second >= firstRow && tile.second < endRow) {
+                found.push_back(entity);
+            }
+        }
+        return found;
+    }
+
+    std::vector<EntityId> sorted(std::vector<EntityId> entities) {
+        std::sort(entities.begin(), entities.end());
+        return entities;
+    }
+
+    // Checks rectangles on, across and between cell boundaries, squares around tiles and single tiles.
+    void expectQueries(const SpatialHash& hash, const Tiles& tiles, std::mt19937& rng) {
+        ASSERT_EQ(hash.size(), tiles.size());
+        const int span = MAX_COORDINATE - MIN_COORDINATE + 1;
+        for (int i = 0; i < 200; i++) {
+            int firstCol = MIN_COORDINATE - 4 + static_cast<int>(rng() % (span + 8));
+            int firstRow = MIN_COORDINATE - 4 + static_cast<int>(rng() % (span + 8));
+            int endCol = firstCol + static_cast<int>(rng() % 30);
+            int endRow = firstRow + static_cast<int>(rng() % 30);
+            if (i % 4 == 0) {
+                // Exactly whole cells, so the inside shortcut is taken.
+                firstCol -= ((firstCol % SpatialHash::CELL_SIZE) + SpatialHash::CELL_SIZE) % SpatialHash::CELL_SIZE;
+                firstRow -= ((firstRow % SpatialHash::CELL_SIZE) + SpatialHash::CELL_SIZE) % SpatialHash::CELL_SIZE;
+                endCol = firstCol + SpatialHash::CELL_SIZE * static_cast<int>(1 + rng() % 3);
+                endRow = firstRow + SpatialHash::CELL_SIZE * static_cast<int>(1 + rng() % 3);
+            }
+            SCOPED_TRACE(testing::Message() << firstCol << "," << firstRow << " to " << endCol << "," << endRow);
+
+            std::vector<EntityId> found;
+            size_t count = hash.queryRect(firstCol, firstRow, endCol, endRow, found);
+            EXPECT_EQ(count, found.size());
+            EXPECT_EQ(sorted(found), scanRect(tiles, firstCol, firstRow, endCol, endRow));
+
+            int radius = static_cast<int>(rng() % 12);
+            found.clear();
+            hash.queryNear(firstCol, firstRow, radius, found);
+            EXPECT_EQ(sorted(found), scanRect(tiles, firstCol - radius, firstRow - radius, firstCol + radius + 1, firstRow + radius + 1));
+
+            found.clear();
+            hash.queryTile(firstCol, firstRow, found);
+            std::vector<EntityId> onTile = scanRect(tiles, firstCol, firstRow, firstCol + 1, firstRow + 1);
+            EXPECT_EQ(sorted(found), onTile);
+            EXPECT_EQ(hash.findOnTile(firstCol, firstRow) != NO_ENTITY, !onTile.empty());
+        }
+    }
+}
+
+// Queries match a linear scan while entities are inserted, moved and removed in mixed order.
+TEST(SpatialHashTest, QueriesMatchALinearScan) {
+    std::vector<EntityId> everyEntity;
+    for (uint32_t index = 0; index < 300; index++) {
+        everyEntity.push_back(makeEntity(index, 1 + index % 4));
+    }
+
+    SpatialHash hash;
+    Tiles tiles;
+    std::mt19937 rng(23);
+    const int span = MAX_COORDINATE - MIN_COORDINATE + 1;
+    for (int step = 0; step < 4000; step++) {
+        EntityId entity = everyEntity[rng() % everyEntity.size()];
+        if (rng() % 4 == 0) {
+            EXPECT_EQ(hash.remove(entity), tiles.erase(entity) == 1);
+        } else {
+            // Short moves mostly stay inside a cell; long ones change cells.
+            auto tile = tiles.find(entity);
+            int col = MIN_COORDINATE + static_cast<int>(rng() % span);
+            int row = MIN_COORDINATE + static_cast<int>(rng() % span);
+            if (tile != tiles.end() && rng() % 2) {
+                col = std::clamp(tile->second.first + static_cast<int>(rng() % 3) - 1, MIN_COORDINATE, MAX_COORDINATE);
+                row = std::clamp(tile->second.second + static_cast<int>(rng() % 3) - 1, MIN_COORDINATE, MAX_COORDINATE);
+            }
+            hash.insert(entity, col, row);
+            tiles[entity] = {col, row};
+        }
+        if (step % 1000 == 999) {
+            expectQueries(hash, tiles, rng);
+        }
+    }
+
+    std::vector<EntityId> found;
+    EXPECT_EQ(hash.queryRect(5, 5, 5, 9, found), 0u) << "Empty rectangles find nothing";
+    hash.clear();
+    EXPECT_EQ(hash.size(), 0u);
+    EXPECT_EQ(hash.queryRect(MIN_COORDINATE, MIN_COORDINATE, MAX_COORDINATE + 1, MAX_COORDINATE + 1, found), 0u);
+}
+
+// The last entity put on a tile is found first, on either side of zero.
+TEST(SpatialHashTest, FindsTheNewestEntityOnATile) {
+    SpatialHash hash;
+    const EntityId first = makeEntity(3, 0), second = makeEntity(9, 0);
+    for (int coordinate : {-9, -8, -1, 0, 7, 8}) {
+        SCOPED_TRACE(testing::Message() << "tile " << coordinate);
+        hash.insert(first, coordinate, coordinate);
+        hash.insert(second, coordinate, coordinate);
+        EXPECT_EQ(hash.findOnTile(coordinate, coordinate), second);
+        std::vector<EntityId> found;
+        ASSERT_EQ(hash.queryTile(coordinate, coordinate, found), 2u);
+        EXPECT_EQ(found[0], second);
+        EXPECT_EQ(found[1], first);
+        EXPECT_EQ(hash.findOnTile(coordinate + 1, coordinate), NO_ENTITY);
+    }
+}
+
+// A handle from before its slot was reused neither moves nor removes the new entity.
+TEST(SpatialHashTest, StaleHandlesMissAfterReuse) {
+    SpatialHash hash;
+    const EntityId old = makeEntity(5, 0), reused = makeEntity(5, 1);
+    hash.insert(old, 2, 2);
+    ASSERT_TRUE(hash.remove(old));
+    hash.insert(reused, -20, 14);
+
+    EXPECT_FALSE(hash.remove(old));
+    EXPECT_EQ(hash.size(), 1u);
+    EXPECT_EQ(hash.findOnTile(-20, 14), reused);
+    EXPECT_EQ(hash.findOnTile(2, 2), NO_ENTITY);
+    EXPECT_TRUE(hash.remove(reused));
+    EXPECT_EQ(hash.size(), 0u);
+}
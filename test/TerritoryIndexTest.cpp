@@ -0,0 +1,142 @@
+#include "GlobalSettings.h"
+#include "TerrainRegistry.h"
+#include "TerritoryIndex.h"
+#include "TileMap.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+
+namespace {
+    constexpr int MAP_ROWS = 150; // Neither dimension is a whole number of chunks.
+    constexpr int MAP_COLS = 201;
+
+    using PairCounts = std::map<std::pair<int32_t, TerrainId>, uint64_t>;
+
+    // Counts every (owner, terrain) pair in a rectangle tile by tile.
+    PairCounts countTiles(const TileMap& map, int firstCol, int firstRow, int endCol, int endRow) {
+        PairCounts counts;
+        for (int row = firstRow; row < endRow; row++) {
+            for (int col = firstCol; col < endCol; col++) {
+                size_t index = static_cast<size_t>(row) * map.getNumCols() + col;
+                counts[{map.getOwnerIds()[index], map.getTerrainIds()[index]}]++;
+            }
+        }
+        return counts;
+    }
+
+    PairCounts toPairCounts(const std::vector<TerritoryIndex::TileCount>& tileCounts) {
+        PairCounts counts;
+        for (const TerritoryIndex::TileCount& count : tileCounts) {
+            counts[{count.ownerId, count.terrainId}] += count.tiles;
+        }
+        return counts;
+    }
+
+    // Checks every total of the index against a full count of the map.
+    void expectTotals(const TileMap& map) {
+        const TerritoryIndex& index = map.getTerritoryIndex();
+        const PairCounts expected = countTiles(map, 0, 0, map.getNumCols(), map.getNumRows());
+        EXPECT_EQ(toPairCounts(index.getTileCounts()), expected);
+
+        std::map<int32_t, uint64_t> owners;
+        std::map<TerrainId, uint64_t> terrains;
+        for (const auto& [pair, tiles] : expected) {
+            owners[pair.first] += tiles;
+            terrains[pair.second] += tiles;
+            EXPECT_EQ(index.countOwnerTiles(pair.first, pair.second), tiles);
+        }
+        for (const auto& [ownerId, tiles] : owners) {
+            EXPECT_EQ(index.countOwnerTiles(ownerId), tiles);
+        }
+        for (const auto& [terrainId, tiles] : terrains) {
+            EXPECT_EQ(index.countTerrainTiles(terrainId), tiles);
+        }
+
+        std::vector<TerritoryIndex::OwnerCount> ownerCounts = index.getOwnerCounts();
+        ASSERT_EQ(ownerCounts.size(), owners.size());
+        auto owner = owners.begin();
+        for (const TerritoryIndex::OwnerCount& count : ownerCounts) {
+            EXPECT_EQ(count.ownerId, owner->first);
+            EXPECT_EQ(count.tiles, owner->second);
+            ++owner;
+        }
+    }
+
+    TileMap makeMap() {
+        TileMap map;
+        map.generateTiles(MAP_ROWS, MAP_COLS, GlobalSettings::getInstance().getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(), 31337);
+        return map;
+    }
+}
+
+// A freshly built index matches a full count of the map.
+TEST(TerritoryIndexTest, CountsMatchTheMap) {
+    TileMap map = makeMap();
+    expectTotals(map);
+    EXPECT_EQ(map.getTerritoryIndex().countOwnerTiles(-12345), 0u);
+}
+
+// Tile changes keep every total current without a rebuild, including owners that run out of tiles.
+TEST(TerritoryIndexTest, FollowsTileChanges) {
+    TileMap map = makeMap();
+    map.getTerritoryIndex();
+
+    const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+    std::mt19937 rng(5);
+    for (int i = 0; i < 3000; i++) {
+        int col = static_cast<int>(rng() % MAP_COLS), row = static_cast<int>(rng() % MAP_ROWS);
+        if (rng() & 1) {
+            map.setOwnerId(col, row, static_cast<int32_t>(900 + rng() % 4));
+        } else {
+            map.setTerrainId(col, row, terrains[rng() % terrains.size()]);
+        }
+    }
+    expectTotals(map);
+
+    // Hand one new owner's only tile back and check it disappears.
+    map.setOwnerId(0, 0, 4242);
+    EXPECT_EQ(map.getTerritoryIndex().countOwnerTiles(4242), 1u);
+    map.setOwnerId(0, 0, 900);
+    EXPECT_EQ(map.getTerritoryIndex().countOwnerTiles(4242), 0u);
+    expectTotals(map);
+}
+
+// Region counts match a tile-by-tile count for rectangles on and off chunk boundaries, clamped to the map.
+TEST(TerritoryIndexTest, CountsRegions) {
+    TileMap map = makeMap();
+    map.setOwnerId(40, 40, 7);
+
+    const int chunk = TerritoryIndex::CHUNK_SIZE;
+    const int rects[][4] = {
+        {0, 0, MAP_COLS, MAP_ROWS},
+        {chunk, chunk, 3 * chunk, 2 * chunk},
+        {5, 7, 150, 120},
+        {chunk - 1, chunk - 1, chunk + 1, chunk + 1},
+        {-20, -20, 10, 10},
+        {190, 140, 500, 500},
+        {60, 60, 60, 90},
+    };
+    for (const auto& rect : rects) {
+        SCOPED_TRACE(testing::Message() << rect[0] << "," << rect[1] << " to " << rect[2] << "," << rect[3]);
+        std::vector<TerritoryIndex::TileCount> counts = map.countRegion(rect[0], rect[1], rect[2], rect[3]);
+        EXPECT_EQ(toPairCounts(counts), countTiles(map, std::max(rect[0], 0), std::max(rect[1], 0),
+                                                   std::min(rect[2], MAP_COLS), std::min(rect[3], MAP_ROWS)));
+
+        // Counts come ordered by owner, then terrain, and sum by owner.
+        EXPECT_TRUE(std::is_sorted(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+            return std::make_pair(a.ownerId, a.terrainId) < std::make_pair(b.ownerId, b.terrainId);
+        }));
+        uint64_t total = 0;
+        for (const TerritoryIndex::OwnerCount& owner : TerritoryIndex::sumByOwner(counts)) {
+            total += owner.tiles;
+        }
+        uint64_t expected = 0;
+        for (const TerritoryIndex::TileCount& count : counts) {
+            expected += count.tiles;
+        }
+        EXPECT_EQ(total, expected);
+    }
+}
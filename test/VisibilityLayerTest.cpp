@@ -0,0 +1,137 @@
+#include "GlobalSettings.h"
+#include "TerrainRegistry.h"
+#include "TileMap.h"
+#include "VisibilityLayer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    constexpr int MAP_ROWS = 150; // Five bands of chunk rows, the last one short.
+    constexpr int MAP_COLS = 201; // Four words per row, the last one holding 9 tiles.
+    constexpr int32_t VIEWER_A = 901;
+    constexpr int32_t VIEWER_B = 902;
+
+    // The radius the layer clamps the configured vision radius to.
+    int visionRadius() {
+        return std::clamp(GlobalSettings::getInstance().getVisionRadius(), 0, 63);
+    }
+
+    // Sets the owner of every tile of a rectangle, clipped to the map.
+    void claim(TileMap& map, int firstCol, int firstRow, int endCol, int endRow, int32_t ownerId) {
+        for (int row = std::max(firstRow, 0); row < std::min(endRow, MAP_ROWS); row++) {
+            for (int col = std::max(firstCol, 0); col < std::min(endCol, MAP_COLS); col++) {
+                map.setOwnerId(col, row, ownerId);
+            }
+        }
+    }
+
+    // Marks every tile within the Chebyshev radius of a tile the owner holds, tile by tile.
+    std::vector<bool> bruteForceVision(const TileMap& map, int32_t ownerId) {
+        const int radius = visionRadius();
+        std::vector<bool> visible(static_cast<size_t>(MAP_ROWS) * MAP_COLS, false);
+        for (int row = 0; row < MAP_ROWS; row++) {
+            for (int col = 0; col < MAP_COLS; col++) {
+                if (map.getOwnerIds()[static_cast<size_t>(row) * MAP_COLS + col] != ownerId) {
+                    continue;
+                }
+                for (int seenRow = std::max(0, row - radius); seenRow <= std::min(MAP_ROWS - 1, row + radius); seenRow++) {
+                    for (int seenCol = std::max(0, col - radius); seenCol <= std::min(MAP_COLS - 1, col + radius); seenCol++) {
+                        visible[static_cast<size_t>(seenRow) * MAP_COLS + seenCol] = true;
+                    }
+                }
+            }
+        }
+        return visible;
+    }
+
+    // Checks a bitset tile by tile, and that the bits past the last column stay clear.
+    void expectBits(const VisibilityLayer& layer, const uint64_t* bits, const std::vector<bool>& expected) {
+        ASSERT_NE(bits, nullptr);
+        const size_t wordsPerRow = layer.getWordsPerRow();
+        for (int row = 0; row < MAP_ROWS; row++) {
+            const uint64_t* rowBits = bits + static_cast<size_t>(row) * wordsPerRow;
+            for (int col = 0; col < MAP_COLS; col++) {
+                bool bit = (rowBits[col / 64] >> (col % 64)) & 1;
+                ASSERT_EQ(bit, expected[static_cast<size_t>(row) * MAP_COLS + col]) << "col " << col << ", row " << row;
+            }
+            EXPECT_EQ(rowBits[wordsPerRow - 1] >> (MAP_COLS % 64), 0u) << "row " << row;
+        }
+    }
+
+    // Checks both viewers against a brute-force scan and folds what they see into what they explored.
+    void expectVision(const VisibilityLayer& layer, const TileMap& map, std::vector<bool> (&explored)[2]) {
+        const int32_t viewers[2] = {VIEWER_A, VIEWER_B};
+        for (int i = 0; i < 2; i++) {
+            SCOPED_TRACE(testing::Message() << "viewer " << viewers[i]);
+            std::vector<bool> visible = bruteForceVision(map, viewers[i]);
+            explored[i].resize(visible.size(), false);
+            for (size_t tile = 0; tile < visible.size(); tile++) {
+                if (visible[tile]) {
+                    explored[i][tile] = true;
+                }
+            }
+            expectBits(layer, layer.getVisibleBits(viewers[i]), visible);
+            expectBits(layer, layer.getExploredBits(viewers[i]), explored[i]);
+        }
+    }
+}
+
+// Vision matches a brute-force scan, across word boundaries and after an incremental update.
+TEST(VisibilityLayerTest, MatchesBruteForce) {
+    ASSERT_EQ(MAP_COLS % 64, 9) << "The map must end part way through a word";
+    TileMap map;
+    map.generateTiles(MAP_ROWS, MAP_COLS, GlobalSettings::getInstance().getTileSize(),
+                      TerrainRegistry::getInstance().getAllTerrains(), 2718);
+
+    // Territory straddling word boundaries, single tiles just left and right of one, the last column and corners.
+    claim(map, 60, 10, 68, 14, VIEWER_A);
+    claim(map, 127, 40, 129, 41, VIEWER_A);
+    claim(map, 200, 70, 201, 71, VIEWER_A);
+    claim(map, 0, 149, 1, 150, VIEWER_A);
+    claim(map, 31, 90, 34, 97, VIEWER_B);
+    claim(map, 190, 0, 201, 3, VIEWER_B);
+    map.setOwnerId(64, 120, VIEWER_B);
+    map.setOwnerId(63, 30, VIEWER_A);
+    map.setOwnerId(192, 110, VIEWER_B);
+
+    VisibilityLayer layer;
+    layer.setViewers({VIEWER_A, VIEWER_B});
+    EXPECT_EQ(layer.getVisibleBits(VIEWER_A), nullptr);
+    layer.update(map);
+    EXPECT_EQ(layer.getNumCols(), MAP_COLS);
+    EXPECT_EQ(layer.getNumRows(), MAP_ROWS);
+    EXPECT_EQ(layer.getWordsPerRow(), 4u);
+    EXPECT_EQ(layer.getVisibleBits(12345), nullptr);
+
+    std::vector<bool> explored[2];
+    expectVision(layer, map, explored);
+
+    // Change owners in the middle band only: the layer rescans it, and recomputes vision within reach.
+    const int band = 2;
+    const int bandRow = band * TileMap::CHUNK_SIZE;
+    ASSERT_LT(visionRadius(), TileMap::CHUNK_SIZE) << "Vision must not reach past the neighbouring bands";
+    const uint64_t revision = layer.getRevision();
+    const uint64_t firstBand = layer.getChunkRevision(2, 0);
+    const uint64_t lastBand = layer.getChunkRevision(2, 4);
+    claim(map, 31, 90, 34, 97, 0);
+    claim(map, 100, bandRow, 140, bandRow + 2, VIEWER_A);
+    claim(map, 63, bandRow + 6, 65, bandRow + 8, VIEWER_B);
+    layer.update(map);
+    EXPECT_GT(layer.getRevision(), revision);
+    EXPECT_EQ(layer.getChunkRevision(2, 0), firstBand);
+    EXPECT_EQ(layer.getChunkRevision(2, 4), lastBand);
+    EXPECT_EQ(layer.getChunkRevision(1, band), layer.getRevision());
+    expectVision(layer, map, explored);
+
+    // Territory given up stays explored but is no longer seen.
+    EXPECT_TRUE(layer.isExplored(VIEWER_B, 32, 93));
+    EXPECT_FALSE(layer.isVisible(VIEWER_B, 32, 93));
+    EXPECT_FALSE(layer.isVisible(VIEWER_B, MAP_COLS, 0));
+
+    // Updating an unchanged map changes nothing.
+    const uint64_t settled = layer.getRevision();
+    layer.update(map);
+    EXPECT_EQ(layer.getRevision(), settled);
+    expectVision(layer, map, explored);
+}
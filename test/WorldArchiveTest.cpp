@@ -0,0 +1,183 @@
+#include "WorldArchive.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+    // Each test works in its own directory under the system's temporary directory.
+    class WorldArchiveTest : public ::testing::Test {
+    protected:
+        std::filesystem::path dir;
+
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() /
+                  ("wargame_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(dir);
+        }
+
+        std::string archivePath() const {
+            return (dir / "world.wgar").string();
+        }
+    };
+
+    // Bytes that do not compress.
+    std::vector<char> noise(size_t size, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<char> bytes(size);
+        for (char& byte : bytes) {
+            byte = static_cast<char>(rng());
+        }
+        return bytes;
+    }
+
+    // Bytes that compress well.
+    std::vector<char> text(size_t size) {
+        static const std::string LINE = "darkgrass medgrass1 deadgrass2 ";
+        std::vector<char> bytes(size);
+        for (size_t i = 0; i < size; i++) {
+            bytes[i] = LINE[i % LINE.size()];
+        }
+        return bytes;
+    }
+
+    std::vector<char> readEntry(WorldArchive& archive, const WorldArchive::Key& key) {
+        std::vector<char> data;
+        EXPECT_TRUE(archive.read(key, data));
+        return data;
+    }
+
+    const WorldArchive::Key INNER_A{3, 4, WorldArchive::DEPTH_INNER};
+    const WorldArchive::Key INNER_B{-2, 7, WorldArchive::DEPTH_INNER};
+}
+
+// Entries of every store mode read back after the archive is closed and reopened from its index.
+TEST_F(WorldArchiveTest, StoresAndReopens) {
+    const std::vector<char> raw = noise(1000, 1);
+    const std::vector<char> compressible = text(20000);
+    const std::vector<char> world = noise(5000, 2);
+    {
+        WorldArchive archive;
+        ASSERT_TRUE(archive.open(archivePath(), true));
+        ASSERT_TRUE(archive.write(INNER_A, raw.data(), raw.size(), WorldArchive::STORE_RAW));
+        ASSERT_TRUE(archive.write(INNER_B, compressible.data(), compressible.size(), WorldArchive::STORE_COMPRESSED));
+        ASSERT_TRUE(archive.write(WorldArchive::WORLD_KEY, world.data(), world.size(), WorldArchive::STORE_MAPPABLE));
+
+        WorldArchive::EntryInfo info;
+        ASSERT_TRUE(archive.getEntryInfo(INNER_B, info));
+        EXPECT_EQ(info.codec, ARCHIVE_CODEC_LZ);
+        EXPECT_LT(info.storedSize, info.rawSize);
+        ASSERT_TRUE(archive.getEntryInfo(WorldArchive::WORLD_KEY, info));
+        EXPECT_EQ(info.type, ARCHIVE_RECORD_MAPPABLE);
+        EXPECT_EQ(info.payloadOffset() % ARCHIVE_MAP_ALIGNMENT, 0u);
+        archive.close();
+    }
+
+    WorldArchive archive;
+    ASSERT_TRUE(archive.open(archivePath()));
+    EXPECT_EQ(archive.getEntryCount(), 3u);
+    EXPECT_EQ(readEntry(archive, INNER_A), raw);
+    EXPECT_EQ(readEntry(archive, INNER_B), compressible);
+    EXPECT_EQ(readEntry(archive, WorldArchive::WORLD_KEY), world);
+}
+
+// The newest copy of a key wins and a removed key stays removed across a reopen.
+TEST_F(WorldArchiveTest, ReplacesAndRemoves) {
+    const std::vector<char> first = noise(3000, 3);
+    const std::vector<char> second = noise(2000, 4);
+    {
+        WorldArchive archive;
+        ASSERT_TRUE(archive.open(archivePath(), true));
+        ASSERT_TRUE(archive.write(INNER_A, first.data(), first.size(), WorldArchive::STORE_RAW));
+        ASSERT_TRUE(archive.write(INNER_A, second.data(), second.size(), WorldArchive::STORE_RAW));
+        ASSERT_TRUE(archive.write(INNER_B, first.data(), first.size(), WorldArchive::STORE_RAW));
+        ASSERT_TRUE(archive.remove(INNER_B));
+        EXPECT_FALSE(archive.contains(INNER_B));
+        EXPECT_EQ(archive.getEntryCount(), 1u);
+        EXPECT_LT(archive.getLiveBytes(), archive.getFileSize());
+    }
+
+    WorldArchive archive;
+    ASSERT_TRUE(archive.open(archivePath()));
+    EXPECT_EQ(readEntry(archive, INNER_A), second);
+    EXPECT_FALSE(archive.contains(INNER_B));
+    std::vector<char> data;
+    EXPECT_FALSE(archive.read(INNER_B, data));
+}
+
+// Records appended after the last index checkpoint are found by scanning, and a torn record
+// at the end is dropped without losing the records before it.
+TEST_F(WorldArchiveTest, RecoversRecordsAfterTheIndex) {
+    const std::vector<char> indexed = noise(4000, 5);
+    const std::vector<char> scanned = noise(6000, 6);
+    const std::string crashPath = (dir / "crashed.wgar").string();
+    {
+        WorldArchive archive;
+        ASSERT_TRUE(archive.open(archivePath(), true));
+        ASSERT_TRUE(archive.write(INNER_A, indexed.data(), indexed.size(), WorldArchive::STORE_RAW));
+        ASSERT_TRUE(archive.sync());
+        ASSERT_TRUE(archive.write(INNER_B, scanned.data(), scanned.size(), WorldArchive::STORE_RAW));
+
+        // Copy the file as a crash would leave it: no index for the last record, half of another.
+        std::filesystem::copy_file(archivePath(), crashPath);
+        std::ofstream torn(crashPath, std::ios::binary | std::ios::app);
+        ArchiveRecordHeader header{ARCHIVE_RECORD_MAGIC, ARCHIVE_RECORD_ENTRY, 9, 9, WorldArchive::DEPTH_INNER,
+                                   ARCHIVE_CODEC_NONE, 100, 100, 0, 0};
+        torn.write(reinterpret_cast<const char*>(&header), sizeof(header) / 2);
+    }
+
+    WorldArchive archive;
+    ASSERT_TRUE(archive.open(crashPath));
+    EXPECT_EQ(archive.getEntryCount(), 2u);
+    EXPECT_EQ(readEntry(archive, INNER_A), indexed);
+    EXPECT_EQ(readEntry(archive, INNER_B), scanned);
+
+    // New records go where the torn one started.
+    const std::vector<char> later = noise(500, 7);
+    const WorldArchive::Key key{9, 9, WorldArchive::DEPTH_INNER};
+    ASSERT_TRUE(archive.write(key, later.data(), later.size(), WorldArchive::STORE_RAW));
+    archive.close();
+    ASSERT_TRUE(archive.open(crashPath));
+    EXPECT_EQ(archive.getEntryCount(), 3u);
+    EXPECT_EQ(readEntry(archive, key), later);
+}
+
+// Compaction drops replaced copies once they fill most of the file and keeps every live entry.
+TEST_F(WorldArchiveTest, CompactsWhenSparse) {
+    const std::vector<char> small = noise(1000, 8);
+    std::vector<char> world;
+    WorldArchive archive;
+    ASSERT_TRUE(archive.open(archivePath(), true));
+    ASSERT_TRUE(archive.write(INNER_A, small.data(), small.size(), WorldArchive::STORE_RAW));
+    EXPECT_FALSE(archive.compactIfSparse()) << "Small archives are left alone";
+
+    for (uint32_t copy = 0; copy < 8; copy++) {
+        world = noise(256 * 1024, 100 + copy);
+        ASSERT_TRUE(archive.write(WorldArchive::WORLD_KEY, world.data(), world.size(), WorldArchive::STORE_MAPPABLE));
+    }
+    const uint64_t sparseSize = archive.getFileSize();
+    ASSERT_GT(sparseSize, 4 * archive.getLiveBytes());
+
+    ASSERT_TRUE(archive.compactIfSparse());
+    EXPECT_LT(archive.getFileSize(), sparseSize / 4);
+    EXPECT_LT(archive.getFileSize(), 2 * archive.getLiveBytes());
+    EXPECT_FALSE(archive.compactIfSparse());
+    EXPECT_EQ(readEntry(archive, WorldArchive::WORLD_KEY), world);
+    EXPECT_EQ(readEntry(archive, INNER_A), small);
+
+    WorldArchive::EntryInfo info;
+    ASSERT_TRUE(archive.getEntryInfo(WorldArchive::WORLD_KEY, info));
+    EXPECT_EQ(info.payloadOffset() % ARCHIVE_MAP_ALIGNMENT, 0u);
+
+    archive.close();
+    ASSERT_TRUE(archive.open(archivePath()));
+    EXPECT_EQ(archive.getEntryCount(), 2u);
+    EXPECT_EQ(readEntry(archive, WorldArchive::WORLD_KEY), world);
+    EXPECT_EQ(readEntry(archive, INNER_A), small);
+    EXPECT_EQ(std::filesystem::file_size(archivePath()), archive.getFileSize());
+}
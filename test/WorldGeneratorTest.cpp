@@ -0,0 +1,75 @@
+#include "GlobalSettings.h"
+#include "TerrainRegistry.h"
+#include "TileMap.h"
+#include "WorldGenerator.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace {
+    constexpr int MAP_ROWS = 130;
+    constexpr int MAP_COLS = 170;
+
+    TileMap generate(uint64_t seed, bool isInner = false) {
+        TileMap map;
+        map.generateTiles(MAP_ROWS, MAP_COLS, GlobalSettings::getInstance().getTileSize(),
+                          TerrainRegistry::getInstance().getAllTerrains(), seed, isInner);
+        return map;
+    }
+
+    bool sameTerrain(const TileMap& a, const TileMap& b) {
+        return std::memcmp(a.getTerrainIds(), b.getTerrainIds(), a.getTileCount() * sizeof(TerrainId)) == 0;
+    }
+
+    bool sameOwners(const TileMap& a, const TileMap& b) {
+        return std::memcmp(a.getOwnerIds(), b.getOwnerIds(), a.getTileCount() * sizeof(int32_t)) == 0;
+    }
+}
+
+// The same seed always generates the same planes; another seed generates different ones.
+// Inner maps have no territories, so only their terrain depends on the seed.
+TEST(WorldGeneratorTest, SeedDeterminesThePlanes) {
+    for (bool isInner : {false, true}) {
+        SCOPED_TRACE(isInner ? "inner" : "world");
+        TileMap first = generate(1234, isInner);
+        TileMap again = generate(1234, isInner);
+        TileMap other = generate(1235, isInner);
+        EXPECT_TRUE(sameTerrain(first, again));
+        EXPECT_TRUE(sameOwners(first, again));
+        EXPECT_FALSE(sameTerrain(first, other));
+        EXPECT_NE(sameOwners(first, other), !isInner);
+    }
+}
+
+// Rows come out the same however the map is cut into bands, so the number of threads does not matter.
+TEST(WorldGeneratorTest, BandsDoNotChangeTheRows) {
+    const WorldGenerator generator(99, TerrainRegistry::getInstance().getAllTerrains(), false);
+    const size_t tiles = static_cast<size_t>(MAP_ROWS) * MAP_COLS;
+    std::vector<TerrainId> wholeTerrain(tiles), bandTerrain(tiles);
+    std::vector<int32_t> wholeOwners(tiles), bandOwners(tiles);
+    generator.generateRows(MAP_COLS, 0, MAP_ROWS, wholeTerrain.data(), wholeOwners.data());
+
+    // Bands of uneven heights, generated last first.
+    const int cuts[] = {MAP_ROWS, 97, 64, 63, 1, 0};
+    for (size_t i = 0; i + 1 < std::size(cuts); i++) {
+        generator.generateRows(MAP_COLS, cuts[i + 1], cuts[i], bandTerrain.data(), bandOwners.data());
+    }
+    EXPECT_EQ(bandTerrain, wholeTerrain);
+    EXPECT_EQ(bandOwners, wholeOwners);
+
+    // The map generator hands the same planes to a TileMap.
+    TileMap map = generate(99);
+    EXPECT_EQ(0, std::memcmp(map.getTerrainIds(), wholeTerrain.data(), tiles * sizeof(TerrainId)));
+    EXPECT_EQ(0, std::memcmp(map.getOwnerIds(), wholeOwners.data(), tiles * sizeof(int32_t)));
+}
+
+// Inner seeds are fixed by the world seed and tile, and differ between neighbouring tiles and worlds.
+TEST(WorldGeneratorTest, InnerSeedsDependOnTheTile) {
+    const uint64_t seed = WorldGenerator::deriveInnerSeed(7, 10, 20);
+    EXPECT_EQ(WorldGenerator::deriveInnerSeed(7, 10, 20), seed);
+    EXPECT_NE(WorldGenerator::deriveInnerSeed(7, 11, 20), seed);
+    EXPECT_NE(WorldGenerator::deriveInnerSeed(7, 10, 21), seed);
+    EXPECT_NE(WorldGenerator::deriveInnerSeed(7, 20, 10), seed);
+    EXPECT_NE(WorldGenerator::deriveInnerSeed(8, 10, 20), seed);
+}
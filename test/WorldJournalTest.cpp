@@ -0,0 +1,166 @@
+#include "TerrainRegistry.h"
+#include "WorldJournal.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    constexpr uint64_t WORLD_SEED = 77;
+    const WorldArchive::Key INNER_KEY{5, 6, WorldArchive::DEPTH_INNER};
+
+    // Each test works in its own directory under the system's temporary directory.
+    class WorldJournalTest : public ::testing::Test {
+    protected:
+        std::filesystem::path dir;
+
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() /
+                  ("wargame_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+        }
+
+        void TearDown() override {
+            std::filesystem::remove_all(dir);
+        }
+
+        std::string journalPath() const {
+            return (dir / "world.wgj").string();
+        }
+
+        std::string crashPath() const {
+            return (dir / "crashed.wgj").string();
+        }
+    };
+
+    // Appends records numbered from first; odd ones belong to an inner map.
+    void appendRecords(WorldJournal& journal, uint32_t first, uint32_t count) {
+        const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+        for (uint32_t i = first; i < first + count; i++) {
+            journal.append(i & 1 ? INNER_KEY : WorldArchive::WORLD_KEY, i * 3, terrains[i % terrains.size()],
+                           static_cast<int32_t>(i + 100), static_cast<uint8_t>(i & 1));
+        }
+    }
+
+    // Checks that recovered records are the ones appendRecords() wrote, numbered from first.
+    void expectRecords(const std::vector<JournalRecord>& records, uint32_t first, uint32_t count) {
+        const std::vector<TerrainId>& terrains = TerrainRegistry::getInstance().getAllTerrains();
+        ASSERT_EQ(records.size(), count);
+        for (uint32_t i = 0; i < count; i++) {
+            const JournalRecord& record = records[i];
+            const uint32_t n = first + i;
+            const WorldArchive::Key& key = n & 1 ? INNER_KEY : WorldArchive::WORLD_KEY;
+            EXPECT_EQ(record.x, key.x);
+            EXPECT_EQ(record.y, key.y);
+            EXPECT_EQ(record.depth, key.depth);
+            EXPECT_EQ(record.index, n * 3);
+            EXPECT_EQ(record.terrainId, terrains[n % terrains.size()]);
+            EXPECT_EQ(record.ownerId, static_cast<int32_t>(n + 100));
+            EXPECT_EQ(record.flags, n & 1);
+        }
+    }
+}
+
+// Committed records survive a crash and are recovered in order; uncommitted ones are lost.
+TEST_F(WorldJournalTest, RecoversCommittedRecords) {
+    WorldJournal journal;
+    ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED, true));
+    const uint64_t headerSize = journal.getSize();
+    appendRecords(journal, 0, 20);
+    ASSERT_TRUE(journal.commit());
+    appendRecords(journal, 20, 5);
+    EXPECT_EQ(journal.getSize(), headerSize + 25 * sizeof(JournalRecord));
+
+    // Copy the file as a crash would leave it, with the last records still queued.
+    std::filesystem::copy_file(journalPath(), crashPath());
+    WorldJournal recovered;
+    ASSERT_TRUE(recovered.open(crashPath(), WORLD_SEED));
+    expectRecords(recovered.getRecovered(), 0, 20);
+    EXPECT_EQ(recovered.mark(), 20u);
+
+    recovered.clearRecovered();
+    EXPECT_TRUE(recovered.getRecovered().empty());
+}
+
+// A torn or corrupt record ends the journal; the records before it are kept.
+TEST_F(WorldJournalTest, StopsAtDamagedRecords) {
+    uint64_t headerSize = 0;
+    {
+        WorldJournal journal;
+        ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED, true));
+        headerSize = journal.getSize();
+        appendRecords(journal, 0, 20);
+    }
+
+    std::filesystem::copy_file(journalPath(), crashPath());
+    std::filesystem::resize_file(crashPath(), headerSize + 20 * sizeof(JournalRecord) - 10);
+    WorldJournal torn;
+    ASSERT_TRUE(torn.open(crashPath(), WORLD_SEED));
+    expectRecords(torn.getRecovered(), 0, 19);
+    EXPECT_EQ(std::filesystem::file_size(crashPath()), headerSize + 19 * sizeof(JournalRecord));
+    torn.close();
+
+    {
+        std::fstream file(journalPath(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(headerSize + 10 * sizeof(JournalRecord) + offsetof(JournalRecord, ownerId)));
+        file.put('\x7F');
+    }
+    WorldJournal corrupt;
+    ASSERT_TRUE(corrupt.open(journalPath(), WORLD_SEED));
+    expectRecords(corrupt.getRecovered(), 0, 10);
+}
+
+// A journal written for another world is discarded, and the journal starts over.
+TEST_F(WorldJournalTest, DiscardsOtherWorlds) {
+    {
+        WorldJournal journal;
+        ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED, true));
+        appendRecords(journal, 0, 8);
+    }
+
+    WorldJournal journal;
+    ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED + 1));
+    EXPECT_TRUE(journal.getRecovered().empty());
+    EXPECT_EQ(journal.mark(), 0u);
+    EXPECT_TRUE(journal.isOpen());
+}
+
+// Trimming drops the records before a position and keeps the rest for replay.
+TEST_F(WorldJournalTest, TrimKeepsLaterRecords) {
+    uint64_t headerSize = 0;
+    {
+        WorldJournal journal;
+        ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED, true));
+        headerSize = journal.getSize();
+        appendRecords(journal, 0, 10);
+        ASSERT_TRUE(journal.commit());
+        const uint64_t position = journal.mark();
+        EXPECT_EQ(position, 10u);
+        appendRecords(journal, 10, 5);
+
+        ASSERT_TRUE(journal.trim(position));
+        EXPECT_EQ(journal.mark(), 15u) << "Positions stay valid across a trim";
+        EXPECT_EQ(journal.getSize(), headerSize + 5 * sizeof(JournalRecord));
+        EXPECT_TRUE(journal.trim(position)) << "Nothing left to trim";
+        EXPECT_TRUE(journal.trim(WorldJournal::NO_JOURNAL));
+        EXPECT_FALSE(std::filesystem::exists(journalPath() + ".tmp"));
+
+        appendRecords(journal, 15, 3);
+    }
+
+    WorldJournal journal;
+    ASSERT_TRUE(journal.open(journalPath(), WORLD_SEED));
+    expectRecords(journal.getRecovered(), 10, 8);
+}
+
+// Without a file, records are dropped instead of queued.
+TEST_F(WorldJournalTest, DropsRecordsWhileClosed) {
+    WorldJournal journal;
+    EXPECT_FALSE(journal.isOpen());
+    appendRecords(journal, 0, 100);
+    EXPECT_EQ(journal.getSize(), 0u);
+    EXPECT_EQ(journal.mark(), WorldJournal::NO_JOURNAL);
+    EXPECT_TRUE(journal.commit());
+    EXPECT_TRUE(journal.trim(WorldJournal::NO_JOURNAL));
+}